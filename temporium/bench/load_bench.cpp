@@ -0,0 +1,190 @@
+// Бенчмарк выделений памяти при загрузке коллекции.
+// Сравнивает прежний путь (getAllGames: readGameRowBinary и std::string на
+// каждое поле) с потоковой загрузкой в компактную коллекцию (streamGames:
+// readGameFields и CompactGameCollection::append на аренах). Оба пути
+// читают один и тот же результат из PostgreSQL; считаются все обращения
+// к operator new, включая libpqxx, и время вместе с запросом.
+//
+// Коллекция пользователя load_bench создаётся при первом запуске и
+// дополняется до нужного числа строк. Параметры подключения — те же
+// переменные окружения, что у приложения (DB_HOST, DB_PORT, DB_NAME,
+// DB_USER, DB_PASSWORD).
+//
+// Сборка: cmake -DTEMPORIUM_BUILD_BENCH=ON .. && make temporium-load-bench
+// Запуск:  ./temporium-load-bench [число строк]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include "compact_game.h"
+#include "database_manager.h"
+#include "hash_utils.h"
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+std::atomic<size_t> g_bytes{0};
+
+} // namespace
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    g_bytes += size;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// Без встраивания: иначе GCC видит free() на указателе из operator new
+// в месте вызова и выдаёт -Wmismatched-new-delete
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using namespace Temporium;
+
+// Порции как у GameLoader
+constexpr size_t FIRST_CHUNK = 100;
+constexpr size_t CHUNK = 2000;
+
+const char* const BENCH_USER = "load_bench";
+const char* const BENCH_PASSWORD = "load_bench";
+
+std::string env(const char* name, const char* fallback) {
+    const char* value = std::getenv(name);
+    return value && *value ? value : fallback;
+}
+
+Game makeGame(size_t i) {
+    static const char* const TAGS[] = {
+        "RPG, Open World", "Co-op, Shooter", "Indie", "Souls-like, RPG, Dark Fantasy", ""
+    };
+
+    Game game;
+    game.name = "Game Title Number " + std::to_string(i);
+    game.genre = GENRES[i % GENRES.size()];
+    game.disk_space = 1.5 + static_cast<double>(i % 150);
+    game.ram_usage = 2 + static_cast<double>(i % 31);
+    game.vram_required = 0.5 + static_cast<double>(i % 16);
+    game.url = (i % 3) ? "https://store.steampowered.com/app/" + std::to_string(100000 + i) : "";
+    game.notes = (i % 10 == 0) ? "Пройти на максимальной сложности, собрать все достижения" : "";
+    game.tags = TAGS[i % 5];
+    game.rating = static_cast<int>(i % 12) - 1;
+    return game;
+}
+
+// Пользователь бенчмарка с коллекцией не меньше count игр; 0 — ошибка
+int prepareUser(DatabaseManager& db, size_t count) {
+    std::string hash = HashUtils::hashPassword(BENCH_PASSWORD, BENCH_USER);
+    if (!db.userExists(BENCH_USER) && !db.registerUser(BENCH_USER, hash)) {
+        return 0;
+    }
+    User user = db.authenticateUser(BENCH_USER, hash);
+    if (user.id <= 0) {
+        return 0;
+    }
+
+    size_t existing = static_cast<size_t>(std::max(db.getUserGamesCount(user.id), 0));
+    if (existing < count) {
+        std::vector<Game> games;
+        games.reserve(count - existing);
+        for (size_t i = existing; i < count; ++i) {
+            games.push_back(makeGame(i));
+        }
+        if (!db.importGames(games, user.id)) {
+            return 0;
+        }
+    }
+    return user.id;
+}
+
+struct Measurement {
+    size_t allocations;
+    size_t bytes;
+    double ms;
+    size_t rows;
+};
+
+template <typename Body>
+Measurement measure(Body body) {
+    size_t allocations = g_allocations;
+    size_t bytes = g_bytes;
+    auto start = std::chrono::steady_clock::now();
+    size_t rows = body();
+    auto end = std::chrono::steady_clock::now();
+    return {g_allocations - allocations, g_bytes - bytes,
+            std::chrono::duration<double, std::milli>(end - start).count(), rows};
+}
+
+// Прежний путь: вся выборка в std::vector<Game>
+Measurement loadAsGames(DatabaseManager& db, int userId) {
+    return measure([&db, userId]() {
+        std::vector<Game> collection = db.getAllGames(userId);
+        return collection.size();
+    });
+}
+
+// Новый путь: порции-арены присоединяются к коллекции без копирования строк
+Measurement loadCompact(DatabaseManager& db, int userId) {
+    return measure([&db, userId]() {
+        CompactGameCollection collection;
+        bool ok = db.streamGames(userId, nullptr, nullptr, FIRST_CHUNK, CHUNK,
+                                 [&collection](CompactGameCollection&& chunk) {
+                                     collection.append(std::move(chunk));
+                                     return true;
+                                 });
+        return ok ? collection.size() : 0;
+    });
+}
+
+void report(const char* label, const Measurement& m) {
+    size_t rows = m.rows ? m.rows : 1;
+    std::printf("%-28s %10zu выделений  %8.3f на строку  %10zu КБ  %8.2f мс\n",
+                label, m.allocations, double(m.allocations) / rows, m.bytes / 1024, m.ms);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    if (count == 0) count = 1;
+
+    DatabaseManager db;
+    if (!db.connect(env("DB_HOST", "localhost"), std::atoi(env("DB_PORT", "5432").c_str()),
+                    env("DB_NAME", "gamedb"), env("DB_USER", "postgres"), env("DB_PASSWORD", "postgres"))) {
+        std::fprintf(stderr, "Ошибка подключения: %s\n", db.getLastError().c_str());
+        return 1;
+    }
+    int userId = prepareUser(db, count);
+    if (userId == 0) {
+        std::fprintf(stderr, "Ошибка подготовки данных: %s\n", db.getLastError().c_str());
+        return 1;
+    }
+
+    // Прогрев: страницы таблицы в кэше PostgreSQL для обоих путей
+    loadAsGames(db, userId);
+
+    Measurement games = loadAsGames(db, userId);
+    Measurement compact = loadCompact(db, userId);
+    if (games.rows == 0 || compact.rows != games.rows) {
+        std::fprintf(stderr, "Ошибка загрузки: %s\n", db.getLastError().c_str());
+        return 1;
+    }
+
+    std::printf("Строк: %zu (первая порция %zu, далее по %zu)\n", games.rows, FIRST_CHUNK, CHUNK);
+    report("std::vector<Game> (до)", games);
+    report("CompactGameCollection (после)", compact);
+    return 0;
+}
@@ -0,0 +1,150 @@
+#ifndef COMPACT_GAME_H
+#define COMPACT_GAME_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+#include "load_arena.h"
+
+namespace Temporium {
+
+// Поля игры в виде ссылок на чужие буферы (строка результата запроса,
+// запись бинарного файла) — позволяют добавить игру без создания Game
+struct GameFields {
+    int id = 0;
+    int user_id = 0;
+    double disk_space = 0;
+    double ram_usage = 0;
+    double vram_required = 0;
+    int rating = -1;
+    bool completed = false;
+    bool is_favorite = false;
+    bool is_installed = false;
+    std::string_view name;
+    std::string_view genre;
+    std::string_view url;
+    std::string_view notes;
+    std::string_view tags;
+};
+
+// Ссылки на поля Game (действительны, пока жива игра)
+GameFields gameFields(const Game& game);
+// Обратное преобразование: Game с копиями строк
+Game gameFromFields(const GameFields& fields);
+
+// Интернирование повторяющихся строк (теги, нестандартные жанры):
+// каждая уникальная строка хранится один раз в арене и получает номер
+class StringPool {
+public:
+    uint32_t intern(std::string_view text, LoadArena& arena);
+    std::string_view at(uint32_t id) const { return strings_[id]; }
+    size_t size() const { return strings_.size(); }
+
+    void clear();
+    size_t bytes() const;
+
+private:
+    std::vector<std::string_view> strings_;
+    std::unordered_map<std::string_view, uint32_t> ids_;
+};
+
+// Компактная запись игры для массовых коллекций (64 байта против ~200
+// у Game без учёта строк). Жанр — индекс в GENRES, теги — номера в
+// пуле тегов, название, ссылка и заметки лежат подряд в арене загрузки.
+// Требования хранятся точно, как в столбцах DOUBLE PRECISION: локальный
+// фильтр и SQL отбирают одни и те же строки.
+struct CompactGame {
+    int32_t id;
+    int32_t user_id;
+    double disk_space;
+    double ram_usage;
+    double vram_required;
+    int8_t rating;              // -1 = отсутствует
+    uint8_t flags;              // FLAG_COMPLETED | FLAG_FAVORITE | FLAG_INSTALLED
+    uint16_t genre;             // < GENRES.size() — стандартный, иначе пул жанров
+    const char* text;           // name, url, notes подряд (без нулей)
+    uint16_t name_length;
+    uint16_t url_length;
+    uint32_t notes_length;
+    uint32_t tags_offset;       // Начало списка тегов в CompactGameCollection
+    uint16_t tags_count;
+
+    static constexpr uint8_t FLAG_COMPLETED = 1 << 0;
+    static constexpr uint8_t FLAG_FAVORITE = 1 << 1;
+    static constexpr uint8_t FLAG_INSTALLED = 1 << 2;
+
+    bool completed() const { return flags & FLAG_COMPLETED; }
+    bool isFavorite() const { return flags & FLAG_FAVORITE; }
+    bool isInstalled() const { return flags & FLAG_INSTALLED; }
+};
+
+// Загруженная коллекция игр в компактном виде.
+// Строки выделяются из арен загрузки (LoadArena): порции, пришедшие из
+// фонового загрузчика, присоединяются вместе со своими аренами без
+// копирования, а очистка коллекции освобождает арены целиком.
+// Преобразование в Game и обратно — для существующих API.
+class CompactGameCollection {
+public:
+    CompactGameCollection();
+    CompactGameCollection(CompactGameCollection&&) = default;
+    CompactGameCollection& operator=(CompactGameCollection&&) = default;
+
+    void clear();
+    void reserve(size_t count);
+
+    void append(const GameFields& fields);
+    void append(const Game& game);
+    void append(const std::vector<Game>& games);
+
+    // Присоединение порции: арены переходят к этой коллекции,
+    // номера тегов и жанров пересчитываются
+    void append(CompactGameCollection&& chunk);
+
+    size_t size() const { return games_.size(); }
+    bool empty() const { return games_.empty(); }
+    const CompactGame& at(size_t index) const { return games_[index]; }
+
+    // Доступ к строковым полям без создания Game
+    std::string_view name(size_t index) const;
+    std::string_view url(size_t index) const;
+    std::string_view notes(size_t index) const;
+    std::string_view genre(size_t index) const;
+    std::string tags(size_t index) const;
+    void tags(size_t index, std::string& out) const;
+    std::string_view tag(size_t index, size_t i) const;     // i < at(index).tags_count
+
+    // Все поля строки; теги собираются в tags_buffer (переиспользуется вызывающим)
+    GameFields fields(size_t index, std::string& tags_buffer) const;
+
+    void setNotes(size_t index, const std::string& notes);
+
+    // Замена и удаление одной строки. Прежние строки и теги остаются
+    // в арене до очистки коллекции
+    void replace(size_t index, const Game& game);
+    void erase(size_t index);
+
+    Game toGame(size_t index) const;
+    std::vector<Game> toGames() const;
+
+    // Оценка занимаемой памяти и число системных выделений под строки
+    size_t memoryUsage() const;
+    size_t arenaAllocations() const;
+
+private:
+    LoadArena& arena() { return *arenas_.back(); }
+    CompactGame makeCompact(const GameFields& fields);
+
+    std::vector<CompactGame> games_;
+    std::vector<uint32_t> tagIds_;      // Списки тегов всех игр подряд
+    std::vector<std::unique_ptr<LoadArena>> arenas_;
+    StringPool tags_;
+    StringPool customGenres_;           // Жанры не из GENRES (старые импорты)
+};
+
+}
+
+#endif
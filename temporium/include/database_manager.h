@@ -4,11 +4,21 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <functional>
 #include <pqxx/pqxx>
 #include "types.h"
+#include "compact_game.h"
+#include "filter_expression.h"
+#include "sketches.h"
 
 namespace Temporium {
 
+class RpcClient;
+enum class RpcOp : uint16_t;
+
 // Результат проверки файла при импорте
 enum class FileVerificationResult {
     OK,
@@ -19,17 +29,6 @@ enum class FileVerificationResult {
     READ_ERROR
 };
 
-// Статистика игр для отображения в статусбаре
-struct GameStats {
-    int total_games = 0;
-    int favorites_count = 0;
-    int completed_count = 0;
-    int no_rating_count = 0;
-    int installed_count = 0;
-    double installed_disk_space = 0.0;  
-    int no_url_count = 0;
-};
-
 class DatabaseManager {
 public:
     DatabaseManager();
@@ -41,11 +40,42 @@ public:
                  const std::string& user, 
                  const std::string& password);
     
+    // Подключение по готовой строке без инициализации таблиц
+    // (дополнительные соединения фоновых загрузчиков)
+    bool connectSecondary(const std::string& conn_str);
+    
+    // Подключение к temporium-server вместо PostgreSQL ("unix:/путь" или
+    // "tcp:хост:порт"). Все операции с базой уходят на сервер, файлы
+    // читаются и пишутся на месте. Строка подключения после входа содержит
+    // ключ сеанса — по ней connectSecondary присоединяется к тому же сеансу
+    bool connectRemote(const std::string& address);
+    bool isRemote() const { return remote_ != nullptr; }
+    
     void disconnect();
     bool isConnected() const;
+    std::string getConnectionString() const;
+    
+    // Ограничение времени одного оператора SQL на этом соединении
+    // (statement_timeout PostgreSQL), 0 — без ограничения. Сохраняется
+    // при переподключении. Через temporium-server действует ограничение
+    // сервера (--statement-timeout-ms)
+    void setStatementTimeout(int ms);
+    int statementTimeout() const { return statement_timeout_ms_; }
+    static constexpr int DEFAULT_STATEMENT_TIMEOUT_MS = 60000;
+    
+    // Прервать выполняющийся запрос. Вызывается из другого потока, пока
+    // соединение занято: PostgreSQL останавливает запрос (PQcancel),
+    // соединение с temporium-server разрывается, и сервер прерывает
+    // запрос этого клиента в PostgreSQL. Прерванный вызов
+    // возвращает ошибку, и wasCancelled() — true
+    bool cancelQuery();
+    bool wasCancelled() const { return cancelled_; }
+    // Забыть отмену, не заставшую запрос (соединение пула перед выдачей)
+    void clearCancelRequest() { cancel_requested_ = false; }
     
-    // Инициализация таблиц
+    // Инициализация таблиц (DDL выполняется, только если схема устарела)
     bool initializeTables();
+    int getSchemaVersion();
     
     // Операции с пользователями
     bool registerUser(const std::string& username, const std::string& password_hash, bool is_admin = false);
@@ -57,35 +87,88 @@ public:
     bool deleteUser(int user_id);
     bool isAdmin(int user_id);
     int getUserGamesCount(int user_id);
+    // Число игр нескольких пользователей (counts[i] — для user_ids[i]):
+    // локально — один запрос, через сервер — один вызов
+    bool getUserGamesCounts(const std::vector<int>& user_ids, std::vector<int>& counts);
+    
+    // Число игр каждого пользователя, подходящих профилю компьютера
+    std::vector<MachineFitCount> getMachineFitCounts(const MachineProfile& profile);
+    
+    // Игры всех пользователей в компактном виде (поиск похожих для администратора)
+    bool loadAllUsersGames(CompactGameCollection& games);
+    
+    // Приближённая сводка названий всех пользователей для администратора.
+    // Применяет к сохранённой сводке изменения из журнала game_name_changes
+    // (его ведёт триггер на games); если сводки ещё нет, строит её по таблице.
+    // rebuilt_at — время последнего полного пересчёта
+    bool refreshNameSketch(GameNameSketch& sketch, std::string* rebuilt_at = nullptr);
+    // Точный пересчёт сводки по всей таблице (офлайн: temporium-sketch-rebuild)
+    bool rebuildNameSketch(GameNameSketch& sketch);
     bool changeUsername(int user_id, const std::string& new_username, const std::string& current_password);
     bool changePassword(int user_id, const std::string& new_password_hash);
     bool resetAdminCredentials(); 
     
     // CRUD операции с играми
-    bool addGame(const Game& game);
+    bool addGame(const Game& game, int* new_id = nullptr);   // new_id — id добавленной игры
     bool updateGame(const Game& game);
     bool deleteGame(int game_id, int user_id);
     bool deleteGameByName(const std::string& name, int user_id);
     
-    // Получение игр
+    // Получение игр копиями Game (std::string на каждое поле) — для
+    // протокола сервера и небольших выборок. Загрузка таблицы, экспорт
+    // и подбор по компьютеру идут через streamGames в компактные коллекции
     std::vector<Game> getAllGames(int user_id);
     std::vector<Game> getFilteredGames(int user_id, const GameFilter& filter);
+    std::vector<Game> getFilteredGames(int user_id, const FilterExpression& expression);
     Game getGameById(int game_id, int user_id);
     Game getGameByName(const std::string& name, int user_id);
     
+    // Потоковая выборка игр порциями через серверный курсор.
+    // Первая порция маленькая (экран таблицы), остальные крупнее.
+    // Каждая порция — компактная коллекция со своей ареной: строки
+    // копируются из результата запроса напрямую, без std::string на поле.
+    // Если callback возвращает false, выборка прерывается.
+    // Условие — filter или expression (оба nullptr — все игры пользователя).
+    using GameChunkCallback = std::function<bool(CompactGameCollection&& chunk)>;
+    bool streamGames(int user_id, const GameFilter* filter,
+                     const FilterExpression* expression,
+                     size_t first_chunk, size_t chunk_size,
+                     const GameChunkCallback& callback);
+    
     // Получение списка уникальных тегов пользователя
     std::vector<std::string> getUserTags(int user_id);
     
+    // Теги пользователя с числом вхождений (разбор строк на сервере)
+    std::map<std::string, int> getUserTagCounts(int user_id);
+    
     // Обновление заметок для игры
     bool updateGameNotes(int game_id, int user_id, const std::string& notes);
     
     // Получение статистики игр
     GameStats getGameStats(int user_id);
     
+    // Группированная аналитика на сервере (GROUPING SETS): показатели по
+    // каждому разрезу из group_by и итог по всем играм, с учётом фильтра
+    // или выражения. Результат кэшируется до изменения данных (dataVersion)
+    AggregateResult aggregate(int user_id, const std::vector<AggregateGroup>& group_by,
+                              const std::vector<AggregateMetric>& metrics,
+                              const GameFilter* filter = nullptr,
+                              const FilterExpression* expression = nullptr);
+    
+    // Число игр пользователя, подходящих каждому профилю (один запрос на все)
+    std::vector<int> countFittingGames(int user_id, const std::vector<MachineProfile>& profiles);
+    
+    // Номер версии данных: растёт при каждом изменении через этот экземпляр
+    uint64_t dataVersion() const { return data_version_; }
+    // Данные изменены в обход этого экземпляра (другое соединение пула сервера)
+    void markDataChanged() { ++data_version_; }
+    
     // Экспорт в бинарный файл (с хешем для проверки целостности)
     bool exportToBinaryFile(const std::string& filename, int user_id);
     bool exportFilteredToBinaryFile(const std::string& filename, int user_id, 
                                      const GameFilter& filter);
+    bool exportFilteredToBinaryFile(const std::string& filename, int user_id, 
+                                     const FilterExpression& expression);
     
     // Верификация файла перед импортом
     FileVerificationResult verifyBinaryFile(const std::string& filename);
@@ -93,27 +176,89 @@ public:
     // Импорт из бинарного файла (с проверкой хеша)
     bool importFromBinaryFile(const std::string& filename, int user_id);
     
-    // Чтение бинарного файла (для просмотра)
-    std::vector<Game> readBinaryFile(const std::string& filename);
+    // Импорт прочитанных записей одной транзакцией. Игры, название которых
+    // уже есть у пользователя, пропускаются; inserted — число добавленных
+    bool importGames(const std::vector<Game>& games, int user_id, size_t* inserted = nullptr);
+    
+    // Названия игр пользователя (проверка похожих названий при импорте)
+    std::vector<std::string> getGameNames(int user_id);
+    
+    // Чтение бинарного файла. С verification файл заодно проверяется
+    // (как verifyBinaryFile, но за одно чтение: контрольная сумма считается
+    // параллельно с разбором записей). Записи разбираются в Game: импорт
+    // передаёт каждое поле параметром запроса и без того копией строки
+    std::vector<Game> readBinaryFile(const std::string& filename,
+                                     FileVerificationResult* verification = nullptr);
     
     // Получение последней ошибки
     std::string getLastError() const;
+    // Сброс перед операцией: сервер отдаёт клиенту ошибку именно его вызова
+    void clearLastError() { last_error_.clear(); }
     
     // Получение текстового описания ошибки верификации
     static std::string getVerificationErrorText(FileVerificationResult result);
     
 private:
     std::unique_ptr<pqxx::connection> conn_;
+    std::string conn_str_;
     std::string last_error_;
+    bool statements_prepared_;
+    
+    int statement_timeout_ms_;
+    bool cancelled_;
+    std::atomic<bool> cancel_requested_;
+    // Соединения заменяются под этой блокировкой: cancelQuery() из другого
+    // потока не застанет удаляемое соединение
+    std::mutex connection_mutex_;
+    
+    static constexpr size_t MAX_AGGREGATE_CACHE = 64;
+    uint64_t data_version_;
+    uint64_t aggregate_cache_version_;
+    std::map<std::string, AggregateResult> aggregate_cache_;
+    
+    // Соединение с temporium-server (connectRemote) и ключ сеанса
+    std::unique_ptr<RpcClient> remote_;
+    std::string remote_session_;
     
-    // Построение WHERE условия для фильтра
-    std::string buildFilterCondition(const GameFilter& filter, int user_id);
+    // Вызов операции на сервере. false — ошибка обмена или операции
+    // (текст в last_error_); result заполняется и при ошибке операции
+    template <typename Result, typename... Args>
+    bool remoteCall(RpcOp op, Result& result, const Args&... args);
+    template <typename Result>
+    bool remoteReply(Result& result);
     
-    // Запись игр в файл
-    bool writeGamesToFile(const std::string& filename, const std::vector<Game>& games);
+    // Списки игр читаются в двоичном формате (pg_binary.h): столбцы
+    // GAME_COLUMNS по порядку, результат проверен checkGameColumns()
+    static Game readGameRowBinary(const pqxx::row& row);
+    
+    // То же без копирования строк (ссылки действительны, пока жив результат)
+    static GameFields readGameFields(const pqxx::row& row);
+    void lockNameSketch(pqxx::transaction_base& txn);
+    void buildNameSketch(pqxx::transaction_base& txn, GameNameSketch& sketch);
+    
+    // Построение WHERE условия для фильтра или выражения (оба nullptr —
+    // все игры пользователя). Значения условий дописываются в params
+    std::string buildFilterCondition(const GameFilter* filter, const FilterExpression* expression,
+                                     int user_id, pqxx::params& params);
+    
+    std::vector<Game> selectGames(int user_id, const GameFilter* filter,
+                                  const FilterExpression* expression);
+    
+    // Экспорт: выборка (filter или expression, оба nullptr — все игры) и запись
+    bool exportGames(const std::string& filename, int user_id, const GameFilter* filter,
+                     const FilterExpression* expression);
+    bool writeGamesToFile(const std::string& filename, const CompactGameCollection& games);
+    
+    void setConnection(std::unique_ptr<pqxx::connection> conn, std::unique_ptr<RpcClient> remote);
+    void applyStatementTimeout();
+    // Прерывание по statement_timeout или cancelQuery() (SQLSTATE 57014)
+    void reportCanceled(const char* operation, const pqxx::query_canceled& e);
     
     // Создание администратора по умолчанию
     void ensureAdminExists();
+    
+    // Подготовка запросов пути входа на сервере
+    void prepareStatements();
 };
 
 } 
@@ -0,0 +1,70 @@
+#ifndef EXPORT_WRITER_H
+#define EXPORT_WRITER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Temporium {
+
+// Запись файла экспорта без порчи старого файла при сбое. Данные пишутся
+// во временный файл рядом с целевым асинхронно: пока заполненный буфер
+// уходит на диск, вызывающий готовит следующий. commit() записывает
+// заголовок в начало файла, сбрасывает файл на диск (fsync) и атомарно
+// заменяет целевой файл; без commit() временный файл удаляется.
+//
+// Запись идёт через io_uring (если сборка нашла liburing и ядро его
+// поддерживает), иначе — pwrite в отдельном потоке.
+class ExportWriter {
+public:
+    // Размер и выравнивание буфера, число буферов в полёте
+    static constexpr size_t BUFFER_SIZE = 4u << 20;
+    static constexpr size_t BUFFER_ALIGNMENT = 4096;
+    static constexpr size_t BUFFER_COUNT = 4;
+
+    explicit ExportWriter(const std::string& path);
+    ~ExportWriter();
+
+    ExportWriter(const ExportWriter&) = delete;
+    ExportWriter& operator=(const ExportWriter&) = delete;
+
+    // Создать временный файл; первые headerSize байт оставляются под заголовок
+    bool open(size_t headerSize);
+
+    // Свободный буфер на BUFFER_SIZE байт; ждёт, если все буферы ещё пишутся.
+    // nullptr — ошибка записи
+    char* buffer();
+    // Записать первые size байт буфера, полученного buffer(), следом за
+    // предыдущими
+    bool write(size_t size);
+
+    // Дождаться записи, записать заголовок, fsync и переименовать
+    bool commit(const void* header, size_t headerSize);
+
+    const std::string& lastError() const { return lastError_; }
+    // "io_uring" или "pwrite"
+    const char* backendName() const;
+
+    class Backend;
+
+private:
+    struct Buffer;
+
+    bool fail(const std::string& error);
+    bool waitAll();
+    void discard();
+
+    std::string path_;
+    std::string tempPath_;
+    int fd_;
+    size_t offset_;
+    size_t next_;
+    std::vector<Buffer> buffers_;
+    std::unique_ptr<Backend> backend_;
+    std::string lastError_;
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef FILTER_CACHE_H
+#define FILTER_CACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "types.h"
+#include "compact_game.h"
+#include "filter_compiler.h"
+
+namespace Temporium {
+
+// Кэш результатов фильтрации загруженной коллекции.
+// Ключ — 64-битный хэш нормализованной записи условия (RowPredicate::cacheKey),
+// значение — отсортированный список индексов строк в коллекции модели,
+// а не копии игр. Вытеснение — LRU в пределах бюджета памяти.
+//
+// Изменения коллекции применяются к записям точечно: правка строки
+// затрагивает только записи, условие которых читает изменённые поля,
+// и для них перепроверяется одна эта строка; добавленная строка
+// проверяется всеми записями; удаление сдвигает индексы.
+class FilterResultCache {
+public:
+    static constexpr size_t DEFAULT_BUDGET = 16 * 1024 * 1024;
+
+    explicit FilterResultCache(size_t budget_bytes = DEFAULT_BUDGET);
+
+    // Строки, прошедшие условие, или nullptr (запись становится самой свежей)
+    const std::vector<uint32_t>* find(const RowPredicate& predicate);
+    void insert(std::shared_ptr<const RowPredicate> predicate, std::vector<uint32_t> rows);
+
+    // Строка row изменилась (changed_fields — биты GameFieldBit)
+    void rowUpdated(const CompactGameCollection& games, uint32_t row, uint32_t changed_fields);
+    // В конец коллекции добавлена строка row
+    void rowAppended(const CompactGameCollection& games, uint32_t row);
+    // Строка row удалена, следующие сдвинулись на одну позицию
+    void rowRemoved(uint32_t row);
+
+    void clear();
+
+    size_t size() const { return entries_.size(); }
+    size_t bytes() const { return bytes_; }
+    size_t hits() const { return hits_; }
+    size_t misses() const { return misses_; }
+
+    // Поля, значения которых различаются у двух версий игры
+    static uint32_t changedFields(const Game& before, const Game& after);
+
+private:
+    struct Entry {
+        uint64_t hash;
+        std::string key;
+        uint32_t fields;
+        std::shared_ptr<const RowPredicate> predicate;
+        std::vector<uint32_t> rows;
+        size_t bytes;
+    };
+
+    static uint64_t hashKey(const std::string& key);
+    static size_t entryBytes(const Entry& entry);
+    void resize(Entry& entry);
+    void evict();
+
+    size_t budget_;
+    size_t bytes_;
+    size_t hits_;
+    size_t misses_;
+    std::list<Entry> entries_;      // Начало — самые свежие
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef FILTER_COMPILER_H
+#define FILTER_COMPILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "compact_game.h"
+
+namespace Temporium {
+
+// Поля игры, от которых зависит условие (биты маски полей)
+enum GameFieldBit : uint32_t {
+    FIELD_NAME          = 1u << 0,
+    FIELD_GENRE         = 1u << 1,
+    FIELD_TAGS          = 1u << 2,
+    FIELD_NOTES         = 1u << 3,
+    FIELD_URL           = 1u << 4,
+    FIELD_RATING        = 1u << 5,
+    FIELD_DISK_SPACE    = 1u << 6,
+    FIELD_RAM_USAGE     = 1u << 7,
+    FIELD_VRAM_REQUIRED = 1u << 8,
+    FIELD_COMPLETED     = 1u << 9,
+    FIELD_FAVORITE      = 1u << 10,
+    FIELD_INSTALLED     = 1u << 11
+};
+
+// Условие отбора строк загруженной коллекции (фильтрация на клиенте)
+class RowPredicate {
+public:
+    virtual ~RowPredicate() = default;
+    virtual bool matches(const CompactGameCollection& games, size_t index) const = 0;
+
+    // Нормализованная запись условия: равные по смыслу условия дают
+    // одинаковый ключ (используется как ключ кэша результатов)
+    virtual std::string cacheKey() const = 0;
+
+    // Поля, которые читает условие (биты GameFieldBit)
+    virtual uint32_t fieldMask() const = 0;
+};
+
+// Фильтр, скомпилированный из GameFilter в короткую программу.
+// В программу попадают только включённые условия: флаги (пройдено,
+// избранное, установлено) сливаются в одну проверку маски, ограничения
+// одного столбца — в один диапазон, противоречивые условия сворачиваются
+// в "ложь". Инструкции упорядочены от дешёвых к дорогим (флаги, числа,
+// жанр, подстрока тегов), поэтому строка отсеивается как можно раньше.
+// Из той же программы строится параметризованное SQL-условие.
+class CompiledFilter : public RowPredicate {
+public:
+    enum class Op : uint8_t {
+        False,          // Условия противоречат друг другу
+        Flags,          // (flags & mask) == expected
+        Range,          // low <= поле <= high
+        GenreEquals,
+        TagContains     // Подстрока в строке тегов (как LIKE '%...%')
+    };
+
+    enum class Field : uint8_t {
+        DiskSpace,
+        RamUsage,
+        VramRequired,
+        Rating
+    };
+
+    struct Instruction {
+        Op op = Op::False;
+        Field field = Field::DiskSpace;
+        uint8_t mask = 0;               // Биты CompactGame::FLAG_*
+        uint8_t expected = 0;
+        bool has_low = false;
+        bool has_high = false;
+        double low = 0.0;
+        double high = 0.0;
+        uint16_t genre_index = 0;       // Индекс в GENRES (GENRES.size() — нестандартный)
+        std::string text;
+    };
+
+    // Значение параметра SQL-запроса ($1, $2, ...)
+    struct SqlParam {
+        enum class Type { Bool, Int, Double, Text } type;
+        bool bool_value = false;
+        int int_value = 0;
+        double double_value = 0.0;
+        std::string text_value;
+    };
+
+    static CompiledFilter compile(const GameFilter& filter);
+
+    // Пустая программа пропускает все строки
+    bool matchesAll() const { return code_.empty(); }
+    bool matchesNone() const { return !code_.empty() && code_.front().op == Op::False; }
+
+    bool matches(const Game& game) const;
+    bool matches(const CompactGameCollection& games, size_t index) const override;
+
+    std::string cacheKey() const override;
+    uint32_t fieldMask() const override;
+
+    // Условие WHERE с плейсхолдерами начиная с $first_placeholder;
+    // значения дописываются в params в порядке плейсхолдеров.
+    // Пустая строка — ограничений нет.
+    std::string sqlCondition(int first_placeholder, std::vector<SqlParam>& params) const;
+
+    const std::vector<Instruction>& code() const { return code_; }
+
+    // Экранирование спецсимволов LIKE (символ экранирования по умолчанию — '\')
+    static std::string escapeLike(const std::string& text);
+
+private:
+    std::vector<Instruction> code_;
+};
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef FILTER_EXPRESSION_H
+#define FILTER_EXPRESSION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "types.h"
+#include "compact_game.h"
+#include "filter_compiler.h"
+
+namespace Temporium {
+
+// Выражение расширенного фильтра: условия над полями игры, связанные
+// AND, OR, NOT и скобками, например
+//
+//     genre in (RPG, Strategy) and (tag = Co-op or tag in (Indie, Roguelike))
+//     name ^= "The " and not completed and rating >= 7
+//
+// Поля: name, genre, tag, notes, url, rating, disk, ram, vram,
+// completed, favorite, installed (есть русские синонимы: название,
+// жанр, тег, ...). Операторы: = != < <= > >=, ~ (содержит),
+// ^= (начинается с), in (...) (любое из). Логическое поле без
+// оператора означает "= true". Сравнения строк учитывают регистр.
+// Порядковые сравнения оценки (< <= > >=) не включают игры без оценки.
+//
+// Приоритет: not, затем and, затем or. Условия, записанные подряд без
+// оператора, связываются через and: "favorite not completed" — то же,
+// что "favorite and not completed", а "favorite installed or completed" —
+// "(favorite and installed) or completed".
+//
+// Одно дерево и проверяется на клиенте, и превращается в
+// параметризованное SQL-условие по индексируемым выражениям. Пустые
+// значения в БД (NULL) в SQL заменяются тем же, что получает загруженная
+// игра (пустая строка, без оценки, false), поэтому not и != отбирают
+// на сервере те же строки, что и на клиенте.
+class FilterExpression : public RowPredicate {
+public:
+    enum class Field : uint8_t {
+        Name,
+        Genre,
+        Tag,
+        Notes,
+        Url,
+        Rating,
+        DiskSpace,
+        RamUsage,
+        VramRequired,
+        Completed,
+        Favorite,
+        Installed
+    };
+
+    enum class Op : uint8_t {
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Contains,
+        Prefix,
+        In
+    };
+
+    enum class NodeType : uint8_t {
+        And,
+        Or,
+        Not,
+        Compare
+    };
+
+    // Узлы лежат в одном векторе, потомки — индексы в нём
+    struct Node {
+        NodeType type = NodeType::Compare;
+        Field field = Field::Name;
+        Op op = Op::Equal;
+        std::vector<int> children;
+        double number = 0.0;                // Числовые поля
+        bool flag = false;                  // Логические поля
+        std::vector<std::string> values;    // Строковые поля (несколько для in)
+        std::vector<uint16_t> genres;       // Индексы values в GENRES (GENRES.size() — нестандартный)
+    };
+
+    // Разбор текста выражения. При ошибке возвращает false,
+    // error содержит описание и позицию
+    static bool parse(const std::string& text, FilterExpression& out, std::string& error);
+
+    bool empty() const { return nodes_.empty(); }
+
+    bool matches(const Game& game) const;
+    bool matches(const CompactGameCollection& games, size_t index) const override;
+
+    std::string cacheKey() const override { return "expression:" + toString(); }
+    uint32_t fieldMask() const override;
+
+    // Условие WHERE с плейсхолдерами начиная с $first_placeholder
+    std::string sqlCondition(int first_placeholder, std::vector<CompiledFilter::SqlParam>& params) const;
+
+    // Нормализованная запись выражения (одинакова для равных выражений)
+    std::string toString() const;
+
+    // Разбор строки тегов на сервере, как TagDictionary::forEachTag: пробелы
+    // по краям обрезаются, пустые теги и NULL дают пустой массив.
+    // По этому выражению построен GIN-индекс
+    static const char* const TAGS_ARRAY_SQL;
+
+private:
+    template <typename Row>
+    bool evaluate(int node, const Row& row) const;
+    std::string sql(int node, int& placeholder, std::vector<CompiledFilter::SqlParam>& params) const;
+    std::string text(int node) const;
+
+    std::vector<Node> nodes_;
+    int root_ = -1;
+};
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef GAME_LOADER_H
+#define GAME_LOADER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMetaType>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "database_manager.h"
+
+// Порция передаётся между потоками по указателю: строки остаются в её арене
+Q_DECLARE_METATYPE(std::shared_ptr<Temporium::CompactGameCollection>)
+
+namespace Temporium {
+
+// Фоновая потоковая загрузка коллекции в таблицу игр.
+// Работает в отдельном потоке со своим соединением с БД и отдаёт строки
+// порциями: первая порция (экран таблицы) приходит сразу, остальные
+// дописываются, не блокируя интерфейс. Новый запуск и cancel() прерывают
+// выполняющийся запрос на сервере, а не только перестают ждать его.
+class GameLoader : public QObject {
+    Q_OBJECT
+
+public:
+    // Первая порция — примерно один экран таблицы
+    static constexpr size_t FIRST_CHUNK_SIZE = 100;
+    static constexpr size_t CHUNK_SIZE = 2000;
+
+    explicit GameLoader(QObject* parent = nullptr);
+    ~GameLoader();
+
+    void setConnectionString(const std::string& conn_str);
+    // Предел одного запроса загрузки, мс (0 — без предела)
+    void setStatementTimeout(int ms);
+    
+    // Заранее открыть соединение загрузчика, чтобы первая загрузка
+    // после входа не ждала подключения
+    void preconnect();
+
+    // Возвращают номер загрузки, которым помечаются сигналы
+    quint64 loadAll(int user_id);
+    quint64 loadFiltered(int user_id, const GameFilter& filter);
+    quint64 loadFiltered(int user_id, std::shared_ptr<const FilterExpression> expression);
+
+    void cancel();
+
+signals:
+    void chunkLoaded(quint64 generation, std::shared_ptr<Temporium::CompactGameCollection> games);
+    void loadFinished(quint64 generation, bool ok, const QString& error);
+
+private:
+    quint64 start(int user_id, bool filtered, const GameFilter& filter,
+                  std::shared_ptr<const FilterExpression> expression);
+    bool ensureConnected(const std::string& conn_str);
+    void run(quint64 generation, const std::string& conn_str,
+             int user_id, bool filtered, const GameFilter& filter,
+             const FilterExpression* expression);
+    void interruptRunning();
+
+    QThread thread_;
+    QObject* worker_;               // Контекст выполнения в потоке thread_
+    DatabaseManager db_;            // Используется только в потоке thread_
+    std::string conn_str_;
+    std::atomic<quint64> generation_;
+    std::atomic<quint64> running_;      // Номер выполняющейся загрузки, 0 — нет
+    std::atomic<int> statementTimeout_;
+};
+
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef GAME_SORTER_H
+#define GAME_SORTER_H
+
+#include <deque>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <QCollator>
+#include "types.h"
+#include "compact_game.h"
+
+namespace Temporium {
+
+// Столбцы, по которым возможна клиентская сортировка
+// (порядок совпадает с колонками таблицы игр)
+enum class SortColumn {
+    Id = 0,
+    Name,
+    DiskSpace,
+    RamUsage,
+    VramRequired,
+    Genre,
+    Completed,
+    Rating,
+    Favorite,
+    Installed,
+    Tags,
+    Count
+};
+
+// Один ключ многоколоночной сортировки
+struct SortKey {
+    SortColumn column;
+    bool ascending;
+
+    SortKey(SortColumn c = SortColumn::Name, bool asc = true) : column(c), ascending(asc) {}
+};
+
+// Клиентская сортировка загруженной коллекции без обращения к БД.
+// При добавлении строк для каждого столбца заранее вычисляется
+// 32-битный ключ; строковые столбцы (название, жанр, теги) ранжируются
+// по ключам сравнения QCollator с учётом локали (кириллица и латиница
+// вперемешку). Сама пересортировка сравнивает только целые числа и
+// выполняется стабильной параллельной сортировкой слиянием.
+class GameSorter {
+public:
+    GameSorter();
+
+    void clear();
+    void reserve(size_t count);
+
+    // Добавление строк (ключи вычисляются один раз при загрузке)
+    void append(const Game& game);
+    void append(const std::vector<Game>& games);
+
+    // Строки компактной коллекции начиная с first (порция потоковой загрузки)
+    void append(const CompactGameCollection& games, size_t first = 0);
+
+    // Правка и удаление одной строки (индексы следующих сдвигаются)
+    void update(size_t row, const Game& game);
+    void erase(size_t row);
+
+    size_t size() const { return count_; }
+
+    // Перестановка индексов строк по заданным ключам.
+    // Пустой список ключей — исходный порядок (ORDER BY name с сервера)
+    std::vector<int> sort(const std::vector<SortKey>& keys) const;
+
+private:
+    static constexpr size_t COLUMN_COUNT = static_cast<size_t>(SortColumn::Count);
+
+    // Столбец с повторяющимися значениями (жанр, теги): ключ сравнения
+    // вычисляется один раз на уникальное значение, а не на строку
+    struct DistinctKeys {
+        std::deque<std::string> texts;  // Хранилище ключей ids (адреса не меняются)
+        std::unordered_map<std::string_view, uint32_t> ids;
+        std::vector<QCollatorSortKey> keys;
+        std::vector<uint32_t> rows;     // Номер значения для каждой строки
+
+        void clear();
+    };
+
+    void appendRow(const GameFields& fields);
+    void writeRow(size_t row, const GameFields& fields);
+    uint32_t distinctId(DistinctKeys& column, std::string_view text);
+    static void rankDistinct(const DistinctKeys& column, std::vector<uint32_t>& ranks);
+
+    // Пересчёт рангов строковых столбцов после добавления строк
+    void ensureRanks() const;
+    static void rankKeys(const std::vector<QCollatorSortKey>& keys, std::vector<uint32_t>& ranks);
+
+    QCollator collator_;
+    size_t count_;
+
+    // Ключи сравнения строковых столбцов
+    std::vector<QCollatorSortKey> nameKeys_;
+    DistinctKeys genres_;
+    DistinctKeys tags_;
+
+    // Столбцовое представление: по одному вектору ключей на столбец
+    mutable std::array<std::vector<uint32_t>, COLUMN_COUNT> columns_;
+    mutable bool ranksDirty_;
+};
+
+}
+
+#endif
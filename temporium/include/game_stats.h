@@ -0,0 +1,72 @@
+#ifndef GAME_STATS_H
+#define GAME_STATS_H
+
+#include <vector>
+#include "types.h"
+#include "compact_game.h"
+
+namespace Temporium {
+
+// Подсчёт GameStats по загруженной коллекции без запроса к БД.
+// Поддерживается инкрементально (add/remove) по мере изменения строк;
+// каждый счётчик — сумма флагов без ветвлений, поэтому проход по
+// коллекции сводится к одному линейному циклу.
+class GameStatsAccumulator {
+public:
+    void reset() {
+        stats_ = GameStats();
+    }
+
+    void add(const Game& game) {
+        apply(1, game.completed, game.is_favorite, game.is_installed,
+              game.rating, game.disk_space, !game.url.empty());
+    }
+
+    void remove(const Game& game) {
+        apply(-1, game.completed, game.is_favorite, game.is_installed,
+              game.rating, game.disk_space, !game.url.empty());
+    }
+
+    void add(const std::vector<Game>& games) {
+        for (const Game& game : games) {
+            add(game);
+        }
+    }
+
+    void add(const CompactGameCollection& games) {
+        for (size_t i = 0; i < games.size(); ++i) {
+            const CompactGame& game = games.at(i);
+            apply(1, game.completed(), game.isFavorite(), game.isInstalled(),
+                  game.rating, game.disk_space, game.url_length > 0);
+        }
+    }
+
+    const GameStats& stats() const { return stats_; }
+
+    // Статистика коллекции за один проход
+    static GameStats compute(const std::vector<Game>& games) {
+        GameStatsAccumulator accumulator;
+        accumulator.add(games);
+        return accumulator.stats();
+    }
+
+private:
+    void apply(int sign, bool completed, bool favorite, bool is_installed,
+               int rating, double disk_space, bool has_url) {
+        int installed = is_installed ? 1 : 0;
+
+        stats_.total_games += sign;
+        stats_.favorites_count += sign * (favorite ? 1 : 0);
+        stats_.completed_count += sign * (completed ? 1 : 0);
+        stats_.no_rating_count += sign * (rating == -1 ? 1 : 0);
+        stats_.installed_count += sign * installed;
+        stats_.installed_disk_space += sign * installed * disk_space;
+        stats_.no_url_count += sign * (has_url ? 0 : 1);
+    }
+
+    GameStats stats_;
+};
+
+}
+
+#endif
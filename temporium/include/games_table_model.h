@@ -0,0 +1,119 @@
+#ifndef GAMES_TABLE_MODEL_H
+#define GAMES_TABLE_MODEL_H
+
+#include <QAbstractTableModel>
+#include <memory>
+#include <vector>
+#include "types.h"
+#include "game_sorter.h"
+#include "game_stats.h"
+#include "compact_game.h"
+#include "filter_compiler.h"
+#include "filter_cache.h"
+#include "machine_index.h"
+#include "similar_games.h"
+
+namespace Temporium {
+
+// Модель таблицы игр: хранит загруженную коллекцию и порядок строк.
+// Ячейки формируются лениво в data(), поэтому пересортировка сводится
+// к перестановке индексов без пересоздания элементов таблицы.
+class GamesTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        COL_ID = 0,
+        COL_NAME,
+        COL_DISK,
+        COL_RAM,
+        COL_VRAM,
+        COL_GENRE,
+        COL_COMPLETED,
+        COL_RATING,
+        COL_FAVORITE,
+        COL_INSTALLED,
+        COL_TAGS,
+        COL_URL,
+        COLUMN_COUNT
+    };
+
+    enum Role {
+        UrlRole = Qt::UserRole,         // Ссылка (колонка COL_URL)
+        NotesRole = Qt::UserRole + 1    // Заметки (колонка COL_ID)
+    };
+
+    explicit GamesTableModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    void setGames(const std::vector<Game>& games);
+    void clear();
+
+    // Потоковая загрузка: порции дописываются в конец таблицы,
+    // сортировка применяется после получения последней порции
+    void appendGames(CompactGameCollection&& games);
+    void finishLoading();
+
+    // Игра в строке представления (с учётом сортировки).
+    // Собирается из компактного представления — только для одиночных строк
+    Game gameAt(int row) const;
+    void setGameNotes(int row, const std::string& notes);
+
+    // Изменения коллекции без перезагрузки (после успешной записи в БД)
+    void addGame(const Game& game);
+    void updateGame(int row, const Game& game);
+    void removeGame(int row);
+
+    // Статистика по всем загруженным строкам (ведётся при загрузке)
+    const GameStats& stats() const { return stats_.stats(); }
+
+    // Многоколоночная сортировка на клиенте (без запроса к БД)
+    void setSortKeys(const std::vector<SortKey>& keys);
+    const std::vector<SortKey>& sortKeys() const { return sortKeys_; }
+
+    // Столбец модели, по которому возможна сортировка
+    static bool isSortable(int column);
+
+    // Фильтрация загруженной коллекции на клиенте (nullptr — без фильтра).
+    // Скрытые строки остаются в коллекции и в статистике
+    void setRowFilter(std::shared_ptr<const RowPredicate> filter);
+    bool hasRowFilter() const { return rowFilter_ != nullptr; }
+    const FilterResultCache& filterCache() const { return filterCache_; }
+
+    // Индекс подбора игр по параметрам компьютера над всей загруженной
+    // коллекцией (строится при первом обращении после изменения строк)
+    const MachineFitIndex& machineIndex();
+    // Индекс похожих игр (по тегам, жанру и требованиям), строится так же лениво
+    const SimilarGamesIndex& similarIndex();
+    // Вся загруженная коллекция (строки индексов — её индексы)
+    const CompactGameCollection& collection() const { return games_; }
+
+private:
+    void applySort();
+    void relayout(std::vector<int> newOrder);
+    std::vector<int> visibleOrder();
+    void invalidateOrder();
+
+    CompactGameCollection games_;
+    std::vector<int> order_;      // Строка представления -> индекс в games_
+    GameSorter sorter_;
+    std::vector<SortKey> sortKeys_;
+    std::vector<int> sorted_;       // Все строки в порядке sortKeys_ (без фильтра)
+    bool sortedValid_ = false;
+    std::shared_ptr<const RowPredicate> rowFilter_;
+    FilterResultCache filterCache_; // Строки, прошедшие недавние фильтры
+    MachineFitIndex machineIndex_;
+    bool machineIndexValid_ = false;
+    SimilarGamesIndex similarIndex_;
+    bool similarIndexValid_ = false;
+    GameStatsAccumulator stats_;
+};
+
+}
+
+#endif
@@ -1,9 +1,12 @@
 #ifndef HASH_UTILS_H
 #define HASH_UTILS_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <iomanip>
+#include <vector>
 #include <openssl/sha.h>
 
 namespace Temporium {
@@ -44,6 +47,68 @@ public:
         return bytesToHex(hash, SHA256_DIGEST_LENGTH);
     }
     
+    // Потоковое SHA-256: данные подаются частями, результат тот же,
+    // что у sha256() от их объединения
+    class Sha256 {
+    public:
+        Sha256() { SHA256_Init(&context_); }
+        
+        void update(const char* data, size_t length) {
+            if (data != nullptr && length > 0) {
+                SHA256_Update(&context_, data, length);
+            }
+        }
+        
+        std::string hex() {
+            unsigned char hash[SHA256_DIGEST_LENGTH];
+            SHA256_Final(hash, &context_);
+            return bytesToHex(hash, SHA256_DIGEST_LENGTH);
+        }
+        
+    private:
+        SHA256_CTX context_;
+    };
+    
+    // Перемешивание 64-битного значения (splitmix64): соседние входы дают
+    // независимые на вид хэши
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+    
+    // FNV-1a. seed разделяет пространства ключей; с seed = 0 — обычный FNV-1a
+    // (сохранённые сводки названий опираются на эти значения)
+    static uint64_t fnv1a(std::string_view text, uint64_t seed = 0) {
+        uint64_t hash = 14695981039346656037ull ^ seed;
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+    
+    // Коэффициент Жаккара двух отсортированных наборов без повторов
+    static double jaccard(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+        size_t common = 0;
+        auto i = a.begin();
+        auto j = b.begin();
+        while (i != a.end() && j != b.end()) {
+            if (*i < *j) {
+                ++i;
+            } else if (*j < *i) {
+                ++j;
+            } else {
+                ++common;
+                ++i;
+                ++j;
+            }
+        }
+        size_t total = a.size() + b.size() - common;
+        return total == 0 ? 0.0 : static_cast<double>(common) / static_cast<double>(total);
+    }
+    
     // Преобразование байтов в hex-строку
     static std::string bytesToHex(const unsigned char* data, size_t length) {
         std::stringstream ss;
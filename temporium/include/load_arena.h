@@ -0,0 +1,80 @@
+#ifndef LOAD_ARENA_H
+#define LOAD_ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+
+namespace Temporium {
+
+// Ресурс-счётчик: пропускает выделения к вышестоящему ресурсу
+// и считает их число и объём (для диагностики и бенчмарка)
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream_(upstream), allocations_(0), bytes_(0) {}
+
+    size_t allocations() const { return allocations_; }
+    size_t bytes() const { return bytes_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations_;
+        bytes_ += bytes;
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        upstream_->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* upstream_;
+    size_t allocations_;
+    size_t bytes_;
+};
+
+// Арена одной загрузки коллекции: монотонный ресурс, из которого
+// строки выделяются сдвигом указателя. Блоки растут геометрически,
+// поэтому на тысячи строк приходится несколько системных выделений,
+// а освобождение всей загрузки — удаление арены.
+class LoadArena {
+public:
+    static constexpr size_t INITIAL_BLOCK = 64 * 1024;
+
+    LoadArena() : resource_(INITIAL_BLOCK, &counter_) {}
+
+    LoadArena(const LoadArena&) = delete;
+    LoadArena& operator=(const LoadArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &resource_; }
+
+    // Копия строки в арене (без завершающего нуля)
+    const char* copy(std::string_view text) {
+        if (text.empty()) return nullptr;
+        char* data = static_cast<char*>(resource_.allocate(text.size(), 1));
+        std::memcpy(data, text.data(), text.size());
+        return data;
+    }
+
+    // Несколько строк подряд одним выделением
+    char* allocate(size_t bytes) {
+        return bytes == 0 ? nullptr : static_cast<char*>(resource_.allocate(bytes, 1));
+    }
+
+    // Число обращений к системному аллокатору и выделенный объём
+    size_t systemAllocations() const { return counter_.allocations(); }
+    size_t bytes() const { return counter_.bytes(); }
+
+private:
+    CountingResource counter_;      // Объявлен до resource_: используется им
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef MACHINE_INDEX_H
+#define MACHINE_INDEX_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "types.h"
+#include "compact_game.h"
+
+namespace Temporium {
+
+// Индекс "пойдёт ли на компьютере": k-d дерево по трём требованиям
+// игры (ОЗУ, видеопамять, место на диске). Запрос — все игры, у которых
+// каждое требование не больше параметра компьютера (запрос доминирования).
+// Требования сравниваются точно, как в DatabaseManager::countFittingGames:
+// игра на 7.5 ГБ не помещается в профиль с 7 ГБ.
+//
+// Узел хранит границы своего поддерева: поддерево, целиком помещающееся
+// в профиль, выдаётся без проверки строк, поддерево, где минимум хотя бы
+// одного требования больше параметра, отбрасывается. Проверяются только
+// строки листьев на границе области.
+//
+// Пакетный запрос обходит дерево один раз для всех профилей: в каждом
+// узле профили делятся на принявшие поддерево целиком, отбросившие его
+// и требующие спуска ниже.
+class MachineFitIndex {
+public:
+    void build(const CompactGameCollection& games);
+    void clear();
+
+    bool empty() const { return points_.empty(); }
+    size_t size() const { return points_.size(); }
+
+    // Индексы строк коллекции (по возрастанию), подходящих профилю
+    std::vector<uint32_t> fits(const MachineProfile& profile) const;
+    size_t count(const MachineProfile& profile) const;
+
+    // По результату на каждый профиль, в порядке profiles
+    std::vector<std::vector<uint32_t>> fits(const std::vector<MachineProfile>& profiles) const;
+    std::vector<size_t> count(const std::vector<MachineProfile>& profiles) const;
+
+private:
+    static constexpr uint32_t LEAF_SIZE = 16;
+    static constexpr int DIMENSIONS = 3;
+
+    using Point = std::array<double, DIMENSIONS>;
+
+    struct Entry {
+        Point point;
+        uint32_t row;
+    };
+
+    struct Node {
+        Point min;
+        Point max;
+        uint32_t begin;
+        uint32_t end;
+        int32_t left = -1;     // -1 — лист
+        int32_t right = -1;
+    };
+
+    static Point limits(const MachineProfile& profile);
+    int32_t buildNode(uint32_t begin, uint32_t end, int depth);
+
+    // rows == nullptr — только подсчёт в counts
+    void query(int32_t node, std::vector<uint32_t>& active, const std::vector<Point>& limits,
+               std::vector<std::vector<uint32_t>>* rows, std::vector<size_t>& counts) const;
+
+    std::vector<Entry> points_;
+    std::vector<Node> nodes_;
+};
+
+}
+
+#endif
@@ -3,7 +3,9 @@
 
 #include <QMainWindow>
 #include <QTableWidget>
+#include <QTableView>
 #include <QPushButton>
+#include <QToolButton>
 #include <QLineEdit>
 #include <QComboBox>
 #include <QCheckBox>
@@ -29,13 +31,22 @@
 #include <QScrollArea>
 #include <QSettings>
 #include <QKeyEvent>
+#include <QMap>
 #include <QDesktopServices>
 #include <QUrl>
 #include <QTextEdit>
 #include <QSpinBox>
+#include <QCompleter>
+#include <QThread>
+#include <functional>
 
 #include "database_manager.h"
+#include "games_table_model.h"
+#include "game_loader.h"
+#include "tag_dictionary.h"
 #include "hash_utils.h"
+#include "name_dedup.h"
+#include "stall_watchdog.h"
 
 namespace Temporium {
 
@@ -68,13 +79,23 @@ private slots:
     void onViewExportedFile();
     
     void onTableSelectionChanged();
-    void onTableCellClicked(int row, int column);
-    void onTableCellDoubleClicked(int row, int column);
+    void onTableCellClicked(const QModelIndex& index);
+    void onTableCellDoubleClicked(const QModelIndex& index);
+    void onSortColumnClicked(int column);
+    void onGamesChunkLoaded(quint64 generation, std::shared_ptr<Temporium::CompactGameCollection> games);
+    void onGamesLoadFinished(quint64 generation, bool ok, const QString& error);
     void onToggleNotesPanel();
     void onSaveNotes();
     void onAbout();
     
     void onAdminPanel();
+    void onShowAnalytics();
+    void onMachineFit();
+    void onShowSimilar();
+    void onShowDiagnostics();
+    void onSaveTrace();
+    void onDatabaseConnectFinished();
+    void onCancelLoading();
 
 private:
     void setupUI();
@@ -82,20 +103,26 @@ private:
     void setupToolBar();
     void setupLoginPage();
     void setupMainPage();
+    void ensureMainPage();
     void setupConnections();
+    void setupMainPageConnections();
     void applyDarkTheme();
     
     void showLoginPage();
     void showMainPage();
     void updateGamesTable();
-    void updateGamesTable(const std::vector<Game>& games);
+    void readFilterControls();
     void updateStatusBar();
     void updateButtonStates();
     void resetTableColumnWidths();
     void updateTagsCombo();
+    void reloadTags();
+    void applyTagChange(const std::string& old_tags, const std::string& new_tags);
+    QStringList tagSuggestions() const;
     void updateStats();
     
     void connectToDatabase();
+    bool ensureDatabaseReady(std::function<void()> retry);
     void saveLastUsername();
     void loadLastUsername();
     
@@ -111,7 +138,8 @@ private:
     
     // Главная страница
     QWidget* mainPage_;
-    QTableWidget* gamesTable_;
+    QTableView* gamesTable_;
+    GamesTableModel* gamesModel_;
     QLabel* userInfoLabel_;
     
     // Панель фильтров
@@ -143,6 +171,8 @@ private:
     QCheckBox* filterRatingCheck_;
     QComboBox* filterRatingModeCombo_;  
     QSpinBox* filterRatingSpin_;       
+    QCheckBox* filterExpressionCheck_;
+    QLineEdit* filterExpressionEdit_;
     
     QPushButton* applyFilterButton_;
     QPushButton* resetFilterButton_;
@@ -171,18 +201,41 @@ private:
     QAction* addAction_;
     QAction* editAction_;
     QAction* deleteAction_;
+    QAction* similarAction_;
     QAction* exportAction_;
     QAction* exportFilteredAction_;
     QAction* importAction_;
     QAction* viewExportedAction_;
+    QAction* analyticsAction_;
+    QAction* machineFitAction_;
     QAction* aboutAction_;
+    QAction* diagnosticsAction_;
+    QAction* traceAction_;
+    QAction* saveTraceAction_;
     QAction* adminAction_;
     QMenu* adminMenu_;
     
     DatabaseManager dbManager_;
     User currentUser_;
     
+    // Фоновая потоковая загрузка таблицы игр
+    GameLoader* gameLoader_;
+    quint64 loadGeneration_;
+    bool gamesLoading_;
+    bool fullCollectionLoaded_;     // В модели вся коллекция (фильтр применяется на клиенте)
+    QLabel* loadingLabel_;
+    QLabel* collectionCountLabel_;  // Число строк в таблице, не затирается сообщениями
+    QToolButton* cancelLoadButton_;
+    
+    // Фоновое подключение к БД при запуске
+    QThread* dbConnectThread_;
+    bool dbConnecting_;
+    std::function<void()> pendingDbAction_;
+    
     GameFilter currentFilter_;
+    std::shared_ptr<const FilterExpression> currentExpression_;  // Расширенный фильтр (вместо currentFilter_)
+    TagDictionary tagDictionary_;   // Теги пользователя, ведутся локально
+    
     bool filterActive_;
     
     QString lastExportedFile_;
@@ -190,6 +243,18 @@ private:
     int lastClickedRow_;
     
     QSettings settings_;
+    StallWatchdog* stallWatchdog_;    // nullptr, если сторож отключён
+};
+
+// Автодополнение последнего тега в строке "тег1, тег2, ..."
+class TagCompleter : public QCompleter {
+    Q_OBJECT
+
+public:
+    explicit TagCompleter(const QStringList& tags, QObject* parent = nullptr);
+    
+    QStringList splitPath(const QString& path) const override;
+    QString pathFromIndex(const QModelIndex& index) const override;
 };
 
 // Диалог редактирования игры
@@ -199,6 +264,9 @@ class GameEditDialog : public QDialog {
 public:
     explicit GameEditDialog(QWidget* parent = nullptr, const Game* game = nullptr);
     Game getGame() const;
+    
+    // Подсказки для поля тегов (из словаря тегов пользователя)
+    void setTagSuggestions(const QStringList& tags);
 
 private:
     QLineEdit* nameEdit_;
@@ -233,6 +301,54 @@ private:
     QTableWidget* table_;
 };
 
+// Похожие игры для выбранной: по коллекции пользователя, а для
+// администратора — и по играм всех пользователей
+class SimilarGamesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    SimilarGamesDialog(DatabaseManager* dbManager, int userId, bool isAdmin,
+                       const Game& target, GamesTableModel* model, QWidget* parent = nullptr);
+
+private slots:
+    void onScopeChanged();
+
+private:
+    void showSimilar(const CompactGameCollection& games, const SimilarGamesIndex& index);
+
+    DatabaseManager* dbManager_;
+    int userId_;
+    Game target_;
+    GamesTableModel* model_;        // nullptr, если в модели не вся коллекция
+    QComboBox* scopeCombo_;         // Только для администратора
+    QTableWidget* table_;
+    QLabel* statusLabel_;
+    CompactGameCollection ownGames_;
+    SimilarGamesIndex ownIndex_;
+    int ownScope_;                  // Для какого режима загружен ownGames_ (-1 — ни для какого)
+    QMap<int, QString> usernames_;
+};
+
+// Похожие названия перед импортом: пары "импортируемая игра — похожая
+// (в коллекции или в том же файле)"; отмеченные игры не импортируются
+class NearDuplicatesDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    NearDuplicatesDialog(const std::vector<NearDuplicate>& pairs,
+                         const std::vector<std::string>& existingNames,
+                         const std::vector<Game>& imported,
+                         QWidget* parent = nullptr);
+
+    // По флагу на каждую импортируемую игру
+    std::vector<bool> skipped() const;
+
+private:
+    std::vector<size_t> importIndexes_;     // Строка таблицы -> индекс в imported
+    size_t importCount_;
+    QTableWidget* table_;
+};
+
 // Админская панель
 class AdminPanelDialog : public QDialog {
     Q_OBJECT
@@ -248,9 +364,11 @@ private slots:
     void onChangeUsername();
     void onChangePassword();
     void onResetAdmin();
+    void onRefreshSummary();
 
 private:
     void updateUsersList();
+    void updateSummary();
     
     DatabaseManager* dbManager_;
     int adminUserId_;
@@ -261,6 +379,69 @@ private:
     QPushButton* changePasswordButton_;
     QPushButton* resetAdminButton_;
     QString newUsername_;
+    
+    GameNameSketch nameSketch_;
+    QLabel* summaryLabel_;
+    QTableWidget* commonTable_;
+};
+
+// Подбор игр под параметры компьютера: число подходящих игр для каждого
+// профиля; с загруженной коллекцией считается по локальному индексу,
+// иначе одним запросом к серверу
+class MachineFitDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    MachineFitDialog(DatabaseManager* dbManager, int userId, bool isAdmin, GamesTableModel* model,
+                     const std::vector<MachineProfile>& profiles, QWidget* parent = nullptr);
+
+    const std::vector<MachineProfile>& profiles() const { return profiles_; }
+    // Профиль, игры которого нужно показать в таблице (после accept)
+    const MachineProfile& shownProfile() const { return profiles_[shownProfile_]; }
+
+private slots:
+    void onAddProfile();
+    void onRemoveProfile();
+    void onShowInTable();
+    void onProfileSelected();
+
+private:
+    void updateCounts();
+
+    DatabaseManager* dbManager_;
+    int userId_;
+    GamesTableModel* model_;
+    std::vector<MachineProfile> profiles_;
+    size_t shownProfile_;
+    QLineEdit* nameEdit_;
+    QSpinBox* ramSpin_;
+    QSpinBox* vramSpin_;
+    QSpinBox* diskSpin_;
+    QTableWidget* profilesTable_;
+    QTableWidget* usersTable_;     // Только для администратора
+    QPushButton* removeButton_;
+    QPushButton* showButton_;
+};
+
+// Аналитика коллекции: показатели по выбранному разрезу (считаются на сервере)
+class AnalyticsDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    AnalyticsDialog(DatabaseManager* dbManager, int userId, const GameFilter* filter,
+                    std::shared_ptr<const FilterExpression> expression, QWidget* parent = nullptr);
+
+private slots:
+    void onGroupChanged();
+
+private:
+    DatabaseManager* dbManager_;
+    int userId_;
+    bool hasFilter_;
+    GameFilter filter_;
+    std::shared_ptr<const FilterExpression> expression_;
+    QComboBox* groupCombo_;
+    QTableWidget* table_;
 };
 
 } 
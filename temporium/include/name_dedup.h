@@ -0,0 +1,69 @@
+#ifndef NAME_DEDUP_H
+#define NAME_DEDUP_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Temporium {
+
+// Пара похожих названий: индексы в порядке добавления (first < second)
+struct NearDuplicate {
+    uint32_t first;
+    uint32_t second;
+    double similarity;      // Коэффициент Жаккара по триграммам, 0..1
+};
+
+// Поиск почти одинаковых названий игр ("The Witcher 3",
+// "Witcher 3: Wild Hunt", "witcher3").
+//
+// Название нормализуется (регистр, пунктуация, пробелы, артикль "the",
+// римские цифры), у названия с подзаголовком отдельно берётся основная
+// часть. Для каждого ключа считается MinHash-подпись по триграммам, подпись
+// режется на полосы (LSH): названия с совпавшей полосой попадают в одну
+// корзину. Попарно сравниваются только названия внутри корзин, точное
+// сходство проверяется по множествам триграмм.
+class NearDuplicateDetector {
+public:
+    explicit NearDuplicateDetector(double threshold = DEFAULT_THRESHOLD);
+
+    // Возвращает индекс названия
+    uint32_t add(const std::string& name);
+    void reserve(size_t count);
+    size_t size() const { return names_; }
+
+    // Пары с сходством не ниже порога, в которых хотя бы одно название
+    // добавлено под индексом >= first_checked (0 — все пары)
+    std::vector<NearDuplicate> findPairs(uint32_t first_checked = 0) const;
+
+    // Нормализованное название без пробелов
+    static std::string normalize(const std::string& name);
+
+    static constexpr double DEFAULT_THRESHOLD = 0.6;
+
+private:
+    static constexpr int HASHES = 64;
+    static constexpr int BANDS = 16;
+    static constexpr int ROWS = HASHES / BANDS;
+    // Корзины больше этого размера пропускаются (остальные полосы
+    // всё равно сводят действительно похожие названия)
+    static constexpr size_t MAX_BUCKET = 256;
+
+    struct Key {
+        uint32_t name;
+        std::vector<uint64_t> trigrams;     // Отсортированы, без повторов
+        std::array<uint64_t, HASHES> signature;
+    };
+
+    static void keys(const std::string& name, std::string& full, std::string& main);
+    void addKey(uint32_t name, const std::string& key);
+
+    double threshold_;
+    uint32_t names_;
+    std::vector<Key> keys_;
+};
+
+}
+
+#endif
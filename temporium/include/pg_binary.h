@@ -0,0 +1,84 @@
+#ifndef PG_BINARY_H
+#define PG_BINARY_H
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <pqxx/pqxx>
+
+namespace Temporium {
+
+// Разбор полей результата в двоичном формате PostgreSQL (выборка через
+// BINARY CURSOR). Числа приходят в сетевом порядке байт: сервер не
+// печатает их в текст, клиент не разбирает текст обратно. Строки
+// (text, varchar) в двоичном формате те же байты, что и в текстовом.
+//
+// Размер поля проверяется: если тип столбца изменили (например,
+// disk_space стал numeric), выборка завершится ошибкой, а не мусором.
+class PgBinary {
+public:
+    // OID встроенных типов (pg_type.oid)
+    static constexpr pqxx::oid BOOL_OID = 16;
+    static constexpr pqxx::oid INT4_OID = 23;
+    static constexpr pqxx::oid FLOAT8_OID = 701;
+
+    static int int4(const pqxx::field& field) {
+        return int4(field.c_str(), field.size());
+    }
+
+    static double float8(const pqxx::field& field) {
+        return float8(field.c_str(), field.size());
+    }
+
+    static bool boolean(const pqxx::field& field) {
+        return boolean(field.c_str(), field.size());
+    }
+
+    // Те же разборы по байтам поля (data, size) — без результата запроса
+    static int int4(const char* data, size_t size) {
+        return static_cast<int32_t>(static_cast<uint32_t>(bigEndian(data, size, 4)));
+    }
+
+    static double float8(const char* data, size_t size) {
+        uint64_t bits = bigEndian(data, size, 8);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static bool boolean(const char* data, size_t size) {
+        return bigEndian(data, size, 1) != 0;
+    }
+
+    static std::string_view text(const pqxx::field& field) {
+        return std::string_view(field.c_str(), field.size());
+    }
+
+    // Тип столбца результата совпадает с ожидаемым разбором
+    static void expectType(const pqxx::result& result, int column, pqxx::oid type) {
+        if (result.column_type(column) != type) {
+            throw std::runtime_error("unexpected type of column " + std::to_string(column) +
+                                     " in binary result: oid " + std::to_string(result.column_type(column)));
+        }
+    }
+
+private:
+    static uint64_t bigEndian(const char* data, size_t actual, size_t size) {
+        if (actual != size) {
+            throw std::runtime_error("binary field of " + std::to_string(actual) +
+                                     " bytes, expected " + std::to_string(size));
+        }
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; ++i) {
+            value = (value << 8) | bytes[i];
+        }
+        return value;
+    }
+};
+
+}
+
+#endif
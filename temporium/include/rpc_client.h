@@ -0,0 +1,83 @@
+#ifndef RPC_CLIENT_H
+#define RPC_CLIENT_H
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include "rpc_protocol.h"
+
+namespace Temporium {
+
+// Соединение с temporium-server. Как и pqxx::connection, используется
+// одним потоком: у каждого DatabaseManager своё. Из другого потока можно
+// только прервать ожидание ответа (abort).
+//
+//     client.begin();
+//     client.add(RpcOp::GetUserGamesCount, 1);
+//     client.add(RpcOp::GetUserGamesCount, 2);    // Пакет — один обмен
+//     if (client.call()) {
+//         while (client.nextReply(error)) client.reply() >> count >> error;
+//     }
+class RpcClient {
+public:
+    RpcClient() = default;
+    ~RpcClient();
+
+    RpcClient(const RpcClient&) = delete;
+    RpcClient& operator=(const RpcClient&) = delete;
+
+    // Подключение и проверка версии протокола
+    bool connect(const std::string& address);
+    void close();
+    // Разрыв соединения из другого потока: ожидающий вызов завершается
+    // ошибкой, сервер перестаёт отправлять порции потоковой выборки
+    void abort();
+    bool isConnected() const { return fd_ >= 0; }
+    const std::string& address() const { return address_; }
+    const std::string& lastError() const { return lastError_; }
+
+    // Сборка кадра: begin() и вызовы add() с аргументами операции
+    void begin();
+
+    template <typename... Args>
+    void add(RpcOp op, const Args&... args) {
+        request_ << op;
+        ((request_ << args), ...);
+        ++calls_;
+    }
+
+    // Отправка кадра и ожидание ответа. Кадр больше RPC_MAX_BATCH
+    // вызовов не отправляется: сервер разорвал бы соединение
+    bool call();
+
+    // Потоковый вызов (кадр из одного вызова): порции со статусом More
+    // передаются onChunk, затем итоговый ответ читается как обычно.
+    // Если onChunk вернул false, остальные порции пропускаются
+    bool callStream(const std::function<bool(RpcReader& chunk)>& onChunk);
+
+    // Переход к следующему ответу. При отказе сервера или исчерпании
+    // ответов возвращает false, error — текст отказа
+    bool nextReply(std::string& error);
+    RpcReader& reply() { return reply_; }
+
+private:
+    bool readResponse(uint16_t expected);
+    bool fail(const std::string& error);
+
+    int fd_ = -1;
+    std::mutex fdMutex_;        // Смена fd_ и abort()
+    std::string address_;
+    std::string lastError_;
+
+    RpcWriter request_;
+    uint32_t nextId_ = 0;
+    size_t calls_ = 0;          // Не больше RPC_MAX_BATCH на кадр
+
+    std::string response_;
+    RpcReader reply_;
+    uint16_t replies_ = 0;      // Непрочитанные ответы
+};
+
+}
+
+#endif
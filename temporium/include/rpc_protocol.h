@@ -0,0 +1,235 @@
+#ifndef RPC_PROTOCOL_H
+#define RPC_PROTOCOL_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "types.h"
+#include "compact_game.h"
+#include "filter_expression.h"
+
+namespace Temporium {
+
+// Двоичный протокол temporium-server.
+//
+// Кадр запроса: длина (u32, без самого поля), номер запроса (u32), число
+// вызовов (u16) и вызовы подряд: код операции (u16) и её аргументы.
+// Кадр ответа: длина, тот же номер, число ответов и ответы по порядку:
+// статус (u8), результат операции и текст ошибки DatabaseManager.
+// Несколько вызовов в одном кадре — пакет: сервер выполняет их по порядку
+// за один обмен. Потоковая выборка (StreamGames) идёт в кадре одна; её
+// порции приходят отдельными кадрами со статусом More.
+//
+// Числа — little-endian, строки и векторы — длина (u32) и содержимое,
+// выражение фильтра — нормализованный текст (FilterExpression::toString).
+
+constexpr uint16_t RPC_VERSION = 3;
+constexpr uint32_t RPC_MAX_FRAME = 256u << 20;
+constexpr uint16_t RPC_MAX_BATCH = 1024;
+
+// Адрес по умолчанию; вид адреса: "unix:/путь" или "tcp:хост:порт"
+constexpr const char* RPC_DEFAULT_ADDRESS = "unix:/tmp/temporium.sock";
+
+// Строка подключения DatabaseManager к серверу: "rpc:" + адрес,
+// после входа — ещё "#" + ключ сеанса (к нему присоединяются
+// дополнительные соединения фоновых загрузчиков)
+constexpr const char* RPC_SCHEME = "rpc:";
+
+enum class RpcOp : uint16_t {
+    Hello = 1,              // Версия протокола
+    Attach,                 // Присоединение к сеансу по ключу
+    RegisterUser,
+    AuthenticateUser,       // Открывает сеанс, возвращает и ключ
+    UserExists,
+    GetAllUsers,
+    DeleteUser,
+    IsAdmin,
+    GetUserGamesCount,
+    GetMachineFitCounts,
+    LoadAllUsersGames,
+    RefreshNameSketch,
+    ChangeUsername,
+    ChangePassword,
+    ResetAdminCredentials,
+    AddGame,
+    UpdateGame,
+    DeleteGame,
+    DeleteGameByName,
+    GetAllGames,
+    GetFilteredGames,
+    GetFilteredGamesExpression,
+    GetGameById,
+    GetGameByName,
+    StreamGames,
+    GetUserTags,
+    GetUserTagCounts,
+    UpdateGameNotes,
+    GetGameStats,
+    Aggregate,
+    CountFittingGames,
+    ImportGames,
+    GetGameNames,
+    GetUserGamesCounts      // Число игр сразу для списка пользователей
+};
+
+enum class RpcStatus : uint8_t {
+    Ok = 0,
+    More,                   // Порция потоковой выборки, за ней будут ещё кадры
+    Denied,                 // Нет сеанса или прав; дальше — текст ошибки
+    BadRequest              // Неизвестная операция или испорченные аргументы
+};
+
+const char* rpcOpName(RpcOp op);
+
+// Запись значений в буфер кадра
+class RpcWriter {
+public:
+    void u8(uint8_t value) { buffer_.push_back(static_cast<char>(value)); }
+    void u16(uint16_t value);
+    void u32(uint32_t value);
+    void u64(uint64_t value);
+    void f64(double value);
+    void bytes(std::string_view value);     // Длина и содержимое
+
+    // Кадр: место под длину и заголовок; finishFrame() проставляет длину
+    void beginFrame(uint32_t id, uint16_t count);
+    void setFrameCount(uint16_t count);
+    void finishFrame();
+
+    std::string& buffer() { return buffer_; }
+    size_t size() const { return buffer_.size(); }
+    void clear() { buffer_.clear(); }
+
+private:
+    std::string buffer_;
+};
+
+// Чтение значений из буфера. Выход за границу или неверные данные
+// сбрасывают ok(), дальнейшие значения читаются нулевыми
+class RpcReader {
+public:
+    RpcReader() = default;
+    RpcReader(const char* data, size_t size) : data_(data), size_(size) {}
+    explicit RpcReader(std::string_view data) : data_(data.data()), size_(data.size()) {}
+
+    uint8_t u8();
+    uint16_t u16();
+    uint32_t u32();
+    uint64_t u64();
+    double f64();
+    std::string_view bytes();               // Ссылка в буфер
+
+    // Число элементов вектора: каждый занимает хотя бы байт,
+    // поэтому испорченная длина не приводит к огромному выделению
+    uint32_t count();
+
+    bool ok() const { return ok_; }
+    void fail() { ok_ = false; }
+    size_t position() const { return position_; }
+    bool atEnd() const { return position_ == size_; }
+    const char* data() const { return data_; }
+
+private:
+    bool need(size_t count);
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;
+    bool ok_ = true;
+};
+
+RpcWriter& operator<<(RpcWriter& out, bool value);
+RpcWriter& operator<<(RpcWriter& out, int value);
+RpcWriter& operator<<(RpcWriter& out, unsigned int value);
+RpcWriter& operator<<(RpcWriter& out, uint64_t value);
+RpcWriter& operator<<(RpcWriter& out, double value);
+RpcWriter& operator<<(RpcWriter& out, const std::string& value);
+RpcWriter& operator<<(RpcWriter& out, RpcOp value);
+RpcWriter& operator<<(RpcWriter& out, AggregateGroup value);
+RpcWriter& operator<<(RpcWriter& out, AggregateMetric value);
+RpcWriter& operator<<(RpcWriter& out, const Game& game);
+RpcWriter& operator<<(RpcWriter& out, const GameFields& fields);
+RpcWriter& operator<<(RpcWriter& out, const User& user);
+RpcWriter& operator<<(RpcWriter& out, const GameStats& stats);
+RpcWriter& operator<<(RpcWriter& out, const GameFilter& filter);
+RpcWriter& operator<<(RpcWriter& out, const FilterExpression& expression);
+RpcWriter& operator<<(RpcWriter& out, const MachineProfile& profile);
+RpcWriter& operator<<(RpcWriter& out, const MachineFitCount& count);
+RpcWriter& operator<<(RpcWriter& out, const AggregateRow& row);
+RpcWriter& operator<<(RpcWriter& out, const AggregateResult& result);
+RpcWriter& operator<<(RpcWriter& out, const CompactGameCollection& games);
+RpcWriter& operator<<(RpcWriter& out, const std::map<std::string, int>& counts);
+// Необязательное условие: признак наличия и значение
+RpcWriter& operator<<(RpcWriter& out, const GameFilter* filter);
+RpcWriter& operator<<(RpcWriter& out, const FilterExpression* expression);
+
+RpcReader& operator>>(RpcReader& in, bool& value);
+RpcReader& operator>>(RpcReader& in, int& value);
+RpcReader& operator>>(RpcReader& in, unsigned int& value);
+RpcReader& operator>>(RpcReader& in, uint64_t& value);
+RpcReader& operator>>(RpcReader& in, double& value);
+RpcReader& operator>>(RpcReader& in, std::string& value);
+RpcReader& operator>>(RpcReader& in, AggregateGroup& value);
+RpcReader& operator>>(RpcReader& in, AggregateMetric& value);
+RpcReader& operator>>(RpcReader& in, Game& game);
+RpcReader& operator>>(RpcReader& in, User& user);
+RpcReader& operator>>(RpcReader& in, GameStats& stats);
+RpcReader& operator>>(RpcReader& in, GameFilter& filter);
+RpcReader& operator>>(RpcReader& in, FilterExpression& expression);
+RpcReader& operator>>(RpcReader& in, MachineProfile& profile);
+RpcReader& operator>>(RpcReader& in, MachineFitCount& count);
+RpcReader& operator>>(RpcReader& in, AggregateRow& row);
+RpcReader& operator>>(RpcReader& in, AggregateResult& result);
+RpcReader& operator>>(RpcReader& in, std::map<std::string, int>& counts);
+// Строки копируются в арену коллекции прямо из кадра
+RpcReader& operator>>(RpcReader& in, CompactGameCollection& games);
+
+template <typename T>
+RpcWriter& operator<<(RpcWriter& out, const std::vector<T>& values) {
+    out.u32(static_cast<uint32_t>(values.size()));
+    for (const T& value : values) {
+        out << value;
+    }
+    return out;
+}
+
+template <typename T>
+RpcReader& operator>>(RpcReader& in, std::vector<T>& values) {
+    uint32_t count = in.count();
+    values.clear();
+    values.reserve(count);
+    for (uint32_t i = 0; i < count && in.ok(); ++i) {
+        values.emplace_back();
+        in >> values.back();
+    }
+    return in;
+}
+
+// Несколько результатов одной операции (например, успех и id новой игры)
+template <typename... T>
+RpcWriter& operator<<(RpcWriter& out, const std::tuple<T...>& values) {
+    std::apply([&out](const auto&... value) { (out << ... << value); }, values);
+    return out;
+}
+
+template <typename... T>
+RpcReader& operator>>(RpcReader& in, std::tuple<T...>& values) {
+    std::apply([&in](auto&... value) { (in >> ... >> value); }, values);
+    return in;
+}
+
+// Сокеты. При ошибке возвращается -1, описание — в error
+int rpcListen(const std::string& address, std::string& error);
+int rpcConnect(const std::string& address, std::string& error);
+
+// Отправка кадра целиком и чтение следующего кадра (без поля длины).
+// readFrame возвращает false и при закрытии соединения (error пуст)
+bool rpcSendFrame(int fd, const std::string& frame, std::string& error);
+bool rpcReadFrame(int fd, std::string& frame, std::string& error);
+
+}
+
+#endif
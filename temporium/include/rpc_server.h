@@ -0,0 +1,224 @@
+#ifndef RPC_SERVER_H
+#define RPC_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "database_manager.h"
+#include "rpc_protocol.h"
+#include "single_flight.h"
+
+namespace Temporium {
+
+// Сервер temporium-server: операции DatabaseManager по протоколу
+// rpc_protocol.h для многих клиентов через общий пул соединений
+// с PostgreSQL и общий кэш результатов.
+//
+// Каждое клиентское соединение обслуживает свой поток; соединение пула
+// берётся только на время кадра (пакет выполняется на одном соединении)
+// и только если ответа нет в кэше. Клиентов может быть сколько угодно
+// больше, чем соединений с базой. Одинаковые одновременные чтения
+// объединяются (single_flight.h): к базе идёт только первое.
+//
+// Клиент, отключившийся во время своего кадра, не ждёт statement_timeout:
+// его запрос прерывается в PostgreSQL (watchHangups).
+//
+// Права проверяет сервер: до входа доступны только регистрация, вход
+// и проверка имени; операции над играми — только со своим user_id,
+// операции панели администратора — только администратору.
+class RpcServer {
+public:
+    struct Options {
+        std::string address = RPC_DEFAULT_ADDRESS;
+        std::string host = "localhost";
+        int port = 5432;
+        std::string dbname = "gamedb";
+        std::string user = "postgres";
+        std::string password = "postgres";
+        size_t pool_size = DEFAULT_POOL_SIZE;
+        size_t cache_bytes = DEFAULT_CACHE_BYTES;
+        int statement_timeout_ms = DEFAULT_STATEMENT_TIMEOUT_MS;
+    };
+
+    struct Stats {
+        uint64_t connections = 0;   // Принято за всё время
+        uint64_t frames = 0;
+        uint64_t calls = 0;
+        uint64_t cache_hits = 0;
+        uint64_t cache_misses = 0;
+        size_t cache_bytes = 0;
+        uint64_t coalesced = 0;     // Чтений, получивших ответ одинакового одновременного
+    };
+
+    explicit RpcServer(const Options& options);
+    ~RpcServer();
+
+    // Подключение пула к PostgreSQL и открытие сокета
+    bool start();
+    // Приём соединений до stop(); возвращает, когда все соединения закрыты
+    void run();
+    // Можно вызывать из обработчика сигнала
+    void stop() { stopping_.store(true); }
+
+    const std::string& lastError() const { return lastError_; }
+    Stats stats() const;
+
+    static constexpr size_t DEFAULT_POOL_SIZE = 8;
+    static constexpr size_t DEFAULT_CACHE_BYTES = 64u << 20;
+    // Предел одного запроса к PostgreSQL на соединении пула
+    static constexpr int DEFAULT_STATEMENT_TIMEOUT_MS = DatabaseManager::DEFAULT_STATEMENT_TIMEOUT_MS;
+    // Изменения в обход сервера (другие клиенты PostgreSQL) видны не позже
+    static constexpr int CACHE_TTL_SECONDS = 30;
+    static constexpr uint64_t MAX_STREAM_CHUNK = 65536;
+    // Сколько завершённый ответ отдаётся одинаковым запросам, пришедшим
+    // почти одновременно с ним (в том числе потоковым выборкам вне кэша)
+    static constexpr int COALESCE_TTL_MS = 500;
+
+private:
+    struct Session {
+        int user_id = 0;
+        bool is_admin = false;
+        std::string token;      // Ключ, выданный этим соединением при входе
+    };
+
+    struct PooledConnection {
+        std::unique_ptr<DatabaseManager> db;
+        uint64_t seen_writes = 0;
+    };
+
+    // Соединение пула на время кадра клиента fd. Пока оно выдано, клиент
+    // числится занятым: его отключение прерывает запрос на этом соединении
+    class Lease {
+    public:
+        Lease(RpcServer& server, int fd) : server_(server), fd_(fd) {}
+        ~Lease();
+        DatabaseManager& db();
+        // Вернуть соединение в пул до конца кадра (следующий db() возьмёт снова)
+        void release();
+
+    private:
+        RpcServer& server_;
+        int fd_;
+        PooledConnection* connection_ = nullptr;
+    };
+
+    // Клиент, чей кадр выполняется на соединении пула
+    struct BusyClient {
+        DatabaseManager* db;
+        uint64_t serial;        // Номер выдачи: номер сокета мог достаться новому клиенту
+    };
+
+    // Закодированные ответы на чтения. Запись пользователя делает
+    // устаревшими его ответы и общие ответы панели администратора
+    class ResultCache {
+    public:
+        static constexpr int GLOBAL = -1;
+
+        explicit ResultCache(size_t budget) : budget_(budget) {}
+
+        uint64_t generation(int scope);
+        bool find(const std::string& key, std::string& body);
+        void store(const std::string& key, int scope, uint64_t generation, const std::string& body);
+        void invalidate(int user_id);
+        size_t bytes() const;
+
+    private:
+        struct Entry {
+            std::string body;
+            int scope;
+            uint64_t generation;
+            std::chrono::steady_clock::time_point stored;
+            std::list<std::string>::iterator order;
+        };
+
+        mutable std::mutex mutex_;
+        size_t budget_;
+        size_t bytes_ = 0;
+        uint64_t global_ = 0;
+        std::unordered_map<int, uint64_t> users_;
+        std::unordered_map<std::string, Entry> entries_;
+        std::list<std::string> order_;      // От недавно использованных к давним
+    };
+
+    // Один вызов кадра
+    struct Call {
+        RpcOp op;
+        RpcReader& in;
+        size_t args_start;
+        RpcWriter& out;
+        Session& session;
+        Lease& lease;
+    };
+
+    void serve(int fd);
+    // Следит за сокетами занятых клиентов и прерывает запрос (cancelQuery)
+    // того, кто отключился, не дождавшись ответа
+    void watchHangups();
+    bool handleFrame(int fd, Session& session, const std::string& frame, RpcWriter& out);
+    bool dispatch(Call& call);
+    bool streamGames(int fd, uint32_t id, Call& call);
+
+    // Ответы: выполнение, выполнение через кэш и изменение данных.
+    // fn(db, body) пишет результат операции
+    template <typename Fn>
+    void execute(Call& call, Fn&& fn);
+    template <typename Fn>
+    void cached(Call& call, int scope, Fn&& fn);
+    template <typename Fn>
+    void mutate(Call& call, int user_id, Fn&& fn);
+    void deny(Call& call, const std::string& reason);
+
+    bool allowUser(const Session& session, int user_id) const;
+
+    std::string openSession(Session& session, const User& user);
+    void closeSession(Session& session);
+    bool attachSession(Session& session, const std::string& token);
+
+    Options options_;
+    std::string lastError_;
+    int listenFd_;
+    std::atomic<bool> stopping_;
+
+    std::vector<PooledConnection> pool_;
+    std::vector<PooledConnection*> idle_;
+    std::mutex poolMutex_;
+    std::condition_variable poolReleased_;
+    std::atomic<uint64_t> writes_;      // Изменений через сервер
+
+    std::mutex busyMutex_;
+    std::condition_variable busyAdded_;
+    std::map<int, BusyClient> busy_;
+    uint64_t busySerial_;
+    std::thread hangupWatcher_;
+
+    ResultCache cache_;
+    SingleFlight flights_;
+    std::chrono::milliseconds followerWait_;    // Дольше ведущий не выполняется
+
+    std::mutex sessionsMutex_;
+    std::map<std::string, Session> sessions_;
+
+    std::mutex clientsMutex_;
+    std::condition_variable clientsClosed_;
+    std::set<int> clients_;
+
+    std::atomic<uint64_t> connections_;
+    std::atomic<uint64_t> frames_;
+    std::atomic<uint64_t> calls_;
+    std::atomic<uint64_t> cacheHits_;
+    std::atomic<uint64_t> cacheMisses_;
+};
+
+}
+
+#endif
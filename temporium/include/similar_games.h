@@ -0,0 +1,70 @@
+#ifndef SIMILAR_GAMES_H
+#define SIMILAR_GAMES_H
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "compact_game.h"
+
+namespace Temporium {
+
+// Похожая игра: строка коллекции индекса и оценки сходства
+struct SimilarGame {
+    uint32_t row;
+    double score;           // Итоговая оценка, 0..1
+    double tags_similarity; // Коэффициент Жаккара по тегам и жанру
+};
+
+// Индекс "похожие игры". Признаки игры — её теги и жанр; по ним строится
+// MinHash-подпись, подпись режется на полосы (LSH). Кандидаты для запроса —
+// игры, у которых совпала хотя бы одна полоса; только они сравниваются
+// точно: сходство множеств признаков плюс близость системных требований.
+class SimilarGamesIndex {
+public:
+    void build(const CompactGameCollection& games);
+    void clear();
+
+    bool empty() const { return rows_.empty(); }
+
+    // До k самых похожих на игру в строке row (без неё самой), по убыванию оценки
+    std::vector<SimilarGame> similar(uint32_t row, size_t k) const;
+
+    // Строка игры с данным id или -1
+    int rowOf(int game_id) const;
+
+    static constexpr size_t DEFAULT_RESULTS = 10;
+
+private:
+    static constexpr int HASHES = 32;
+    static constexpr int BANDS = 16;
+    static constexpr int ROWS = HASHES / BANDS;
+    // Сколько кандидатов проверяется точно за один запрос: у игр без тегов
+    // подпись определяется одним жанром, и их корзины очень велики
+    static constexpr size_t MAX_CANDIDATES = 4096;
+    // Вес совпадения тегов и жанра в оценке (остальное — требования)
+    static constexpr double TAGS_WEIGHT = 0.75;
+
+    struct Row {
+        int id;
+        double ram;
+        double vram;
+        double disk;
+        std::vector<uint64_t> features;     // Отсортированы, без повторов
+        std::array<uint64_t, BANDS> bands;  // Ключи корзин по полосам
+    };
+
+    // Строк на одну задачу пула при построении
+    static constexpr size_t ROWS_PER_TASK = 4096;
+
+    static void buildRow(const CompactGameCollection& games, size_t i, Row& row);
+    static double hardwareSimilarity(const Row& a, const Row& b);
+
+    std::vector<Row> rows_;
+    std::vector<std::unordered_map<uint64_t, std::vector<uint32_t>>> buckets_;  // По полосе
+    std::unordered_map<int, uint32_t> ids_;
+};
+
+}
+
+#endif
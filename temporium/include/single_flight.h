@@ -0,0 +1,89 @@
+#ifndef SINGLE_FLIGHT_H
+#define SINGLE_FLIGHT_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Temporium {
+
+// Объединение одинаковых одновременных чтений (single flight). Первый
+// запрос с данным ключом выполняется (ведущий), остальные с тем же ключом
+// ждут его ответа вместо своего обращения к базе. Ключ включает операцию,
+// аргументы и версию данных, поэтому запрос после записи не присоединится
+// к начатому до неё.
+//
+// Ответ может идти частями (потоковая выборка): присоединившиеся получают
+// части по мере готовности, в том числе уже отправленные. Завершённый
+// успешный ответ ещё ttl отдаётся почти одновременным повторам.
+class SingleFlight {
+public:
+    class Flight {
+    public:
+        enum class Wait { Ready, Finished, TimedOut };
+
+        // Часть с номером index; ждёт, пока она появится, не дольше timeout.
+        // Finished — частей больше не будет
+        Wait part(size_t index, std::string& out, std::chrono::milliseconds timeout);
+        // Итог; ждёт завершения не дольше timeout
+        bool result(std::string& out, std::chrono::milliseconds timeout);
+
+    private:
+        friend class SingleFlight;
+
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::vector<std::string> parts_;
+        std::string result_;
+        size_t bytes_ = 0;
+        bool finished_ = false;
+        bool retaining_ = true;             // Части хранятся для присоединившихся
+        std::atomic<int> followers_{0};
+        std::chrono::steady_clock::time_point finishedAt_;
+    };
+
+    // maxRetainedBytes — предел хранимых частей и итога одного запроса:
+    // сверх него к запросу больше нельзя присоединиться
+    SingleFlight(std::chrono::milliseconds ttl, size_t maxRetainedBytes);
+
+    // Присоединение к запросу с ключом key. leader = true — вызывающий
+    // выполняет запрос сам и обязан вызвать finish()
+    std::shared_ptr<Flight> join(const std::string& key, bool& leader);
+
+    // Ведущий: очередная часть ответа и итог. reusable = false — ответ
+    // (например, ошибку) не отдавать повторам после завершения
+    void append(const std::string& key, const std::shared_ptr<Flight>& flight, std::string part);
+    void finish(const std::string& key, const std::shared_ptr<Flight>& flight, std::string result,
+                bool reusable);
+
+    // Ведущий больше не нужен своему клиенту. true — никто не присоединился
+    // и уже не присоединится: запрос можно прервать (finish() всё равно
+    // вызывается). false — запрос нужно довести до конца для ждущих
+    bool abandon(const std::string& key, const std::shared_ptr<Flight>& flight);
+
+    // Присоединившийся перестал ждать (истёк срок) и выполняет запрос сам
+    void leave(const std::shared_ptr<Flight>& flight);
+
+    // Запросов, получивших чужой ответ
+    uint64_t coalesced() const { return coalesced_.load(std::memory_order_relaxed); }
+
+private:
+    // Вызывается под mutex_
+    void detach(const std::string& key, const std::shared_ptr<Flight>& flight);
+
+    std::chrono::milliseconds ttl_;
+    size_t maxRetainedBytes_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Flight>> flights_;
+    std::atomic<uint64_t> coalesced_;
+};
+
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SKETCHES_H
+#define SKETCHES_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Temporium {
+
+// Count-min sketch: оценка частоты ключа в потоке с удалениями.
+// С вероятностью не меньше 1 - delta() оценка превышает истинную
+// частоту не более чем на epsilon() * total() (пока частоты неотрицательны)
+class CountMinSketch {
+public:
+    CountMinSketch(uint32_t width = DEFAULT_WIDTH, uint32_t depth = DEFAULT_DEPTH);
+
+    void add(uint64_t hash, int64_t delta = 1);
+    int64_t estimate(uint64_t hash) const;
+    int64_t total() const { return total_; }
+
+    double epsilon() const;
+    double delta() const;
+
+    void clear();
+    void serialize(std::string& out) const;
+    bool deserialize(const std::string& in, size_t& offset);
+
+    static constexpr uint32_t DEFAULT_WIDTH = 2048;
+    static constexpr uint32_t DEFAULT_DEPTH = 5;
+
+private:
+    uint32_t width_;
+    uint32_t depth_;
+    int64_t total_;
+    std::vector<int32_t> counters_;     // depth_ строк по width_
+};
+
+// HyperLogLog: оценка числа различных ключей по 2^precision регистрам.
+// Удаления не поддерживаются — удалённые ключи учитываются до пересчёта
+class HyperLogLog {
+public:
+    explicit HyperLogLog(uint8_t precision = DEFAULT_PRECISION);
+
+    void add(uint64_t hash);
+    double estimate() const;
+    // Относительная стандартная ошибка оценки
+    double standardError() const;
+
+    void clear();
+    void serialize(std::string& out) const;
+    bool deserialize(const std::string& in, size_t& offset);
+
+    static constexpr uint8_t DEFAULT_PRECISION = 14;
+
+private:
+    uint8_t precision_;
+    std::vector<uint8_t> registers_;
+};
+
+// Приближённая сводка названий игр всех пользователей: частоты (count-min),
+// число различных названий (HyperLogLog) и кандидаты в самые частые.
+// Названия сравниваются в нормализованном виде ("The Witcher 3" = "witcher 3")
+class GameNameSketch {
+public:
+    struct Frequent {
+        std::string name;       // Название в том виде, в каком встретилось первым
+        int64_t estimate;
+    };
+
+    void add(const std::string& name, int64_t delta = 1);
+    void clear();
+
+    // До k самых частых названий по убыванию оценки
+    std::vector<Frequent> mostCommon(size_t k) const;
+
+    const CountMinSketch& counts() const { return counts_; }
+    const HyperLogLog& distinct() const { return distinct_; }
+
+    std::string serialize() const;
+    bool deserialize(const std::string& data);
+
+    static constexpr size_t CANDIDATES = 64;
+
+private:
+    static uint64_t hashName(const std::string& normalized);
+
+    CountMinSketch counts_;
+    HyperLogLog distinct_;
+    std::map<std::string, std::string> candidates_;     // Нормализованное -> исходное
+    int64_t rarestEstimate_ = 0;
+};
+
+}
+
+#endif
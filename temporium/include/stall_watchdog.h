@@ -0,0 +1,76 @@
+#ifndef STALL_WATCHDOG_H
+#define STALL_WATCHDOG_H
+
+#include <QObject>
+#include <QTimer>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Temporium {
+
+// Сторож зависаний интерфейса. Таймер в потоке GUI отмечает пульс цикла
+// событий; отдельный поток проверяет, давно ли была отметка. Если поток GUI
+// заблокирован дольше порога, в журнал зависаний пишется, какой слот окна и
+// какой вызов DatabaseManager выполнялись (открытые интервалы трассировки,
+// см. Tracer::activity), сколько они уже идут, и стек вызовов потока GUI.
+// Когда цикл событий оживает, в журнал дописывается общая длительность.
+class StallWatchdog : public QObject {
+    Q_OBJECT
+
+public:
+    // Итог по одному виду зависаний за сеанс
+    struct Summary {
+        std::string call;       // Вызов БД, а без него — слот окна
+        int count = 0;
+        uint64_t total_ms = 0;
+        uint64_t max_ms = 0;
+    };
+
+    // Создаётся в потоке GUI — он и становится наблюдаемым
+    StallWatchdog(const std::string& logPath, int thresholdMs, QObject* parent = nullptr);
+    ~StallWatchdog();
+
+    const std::string& logPath() const { return logPath_; }
+    int thresholdMs() const { return thresholdMs_; }
+
+    // Зависания сеанса по убыванию суммарной длительности
+    std::vector<Summary> summary() const;
+
+    static constexpr int DEFAULT_THRESHOLD_MS = 500;
+    static constexpr int HEARTBEAT_MS = 100;
+
+private:
+    void watch();
+    void stallStarted(uint64_t beat, uint64_t now);
+    void stallFinished(uint64_t beat);
+    static std::vector<std::string> guiBacktrace();
+    void appendLog(const std::string& text);
+
+    std::string logPath_;
+    int thresholdMs_;
+    QTimer heartbeat_;
+    std::atomic<uint64_t> lastBeat_;    // Микросекунды, Tracer::now()
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    bool stopping_;
+
+    // Текущее зависание (только в потоке сторожа)
+    bool stalled_;
+    uint64_t stallBeat_;
+    std::string stallCall_;
+
+    mutable std::mutex summaryMutex_;
+    std::map<std::string, Summary> summary_;
+};
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef STARTUP_PROFILER_H
+#define STARTUP_PROFILER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+#include <vector>
+
+namespace Temporium {
+
+// Замер фаз запуска приложения: от старта процесса до интерактивного
+// окна входа и далее (подключение к БД, построение главной страницы).
+// Фазы пишутся в лог и доступны в окне диагностики.
+class StartupProfiler {
+public:
+    struct Phase {
+        QString name;
+        qint64 started_ms;      // Начало фазы от старта процесса
+        qint64 duration_ms;     // Длительность фазы (-1 — отметка момента)
+    };
+
+    static StartupProfiler& instance() {
+        static StartupProfiler profiler;
+        return profiler;
+    }
+
+    // Вызывается первой строкой main()
+    void start() {
+        QMutexLocker lock(&mutex_);
+        timer_.start();
+        phases_.clear();
+    }
+
+    qint64 elapsed() const {
+        QMutexLocker lock(&mutex_);
+        return timer_.isValid() ? timer_.elapsed() : 0;
+    }
+
+    void record(const QString& name, qint64 started_ms, qint64 duration_ms) {
+        QMutexLocker lock(&mutex_);
+        phases_.push_back({name, started_ms, duration_ms});
+        if (duration_ms < 0) {
+            qInfo().noquote() << QString("[startup] %1: t=%2 мс").arg(name).arg(started_ms);
+        } else {
+            qInfo().noquote() << QString("[startup] %1: %2 мс (t=%3 мс)")
+                                     .arg(name).arg(duration_ms).arg(started_ms + duration_ms);
+        }
+    }
+
+    // Отметка момента без длительности (например, "окно входа интерактивно")
+    void mark(const QString& name) {
+        record(name, elapsed(), -1);
+    }
+
+    std::vector<Phase> phases() const {
+        QMutexLocker lock(&mutex_);
+        return phases_;
+    }
+
+    QString report() const {
+        QStringList lines;
+        for (const auto& phase : phases()) {
+            if (phase.duration_ms >= 0) {
+                lines << QString("%1 — %2 мс (с %3 по %4 мс)")
+                             .arg(phase.name).arg(phase.duration_ms)
+                             .arg(phase.started_ms).arg(phase.started_ms + phase.duration_ms);
+            } else {
+                lines << QString("%1 — на %2 мс").arg(phase.name).arg(phase.started_ms);
+            }
+        }
+        return lines.join("\n");
+    }
+
+private:
+    StartupProfiler() { timer_.start(); }
+
+    mutable QMutex mutex_;
+    QElapsedTimer timer_;
+    std::vector<Phase> phases_;
+};
+
+// Замер фазы в пределах области видимости
+class StartupPhase {
+public:
+    explicit StartupPhase(const QString& name)
+        : name_(name), started_ms_(StartupProfiler::instance().elapsed()) {}
+
+    ~StartupPhase() {
+        StartupProfiler& profiler = StartupProfiler::instance();
+        profiler.record(name_, started_ms_, profiler.elapsed() - started_ms_);
+    }
+
+private:
+    QString name_;
+    qint64 started_ms_;
+};
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef TAG_DICTIONARY_H
+#define TAG_DICTIONARY_H
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Temporium {
+
+// Локальный словарь тегов пользователя со счётчиками ссылок.
+// Загружается один раз при входе, дальше обновляется по разнице
+// тегов изменённой игры, без повторной выборки из БД.
+class TagDictionary {
+public:
+    void clear() {
+        counts_.clear();
+    }
+
+    // Полная загрузка: тег -> число игр с этим тегом
+    void assign(const std::map<std::string, int>& counts) {
+        counts_.clear();
+        for (const auto& entry : counts) {
+            if (entry.second > 0) {
+                counts_.insert(entry);
+            }
+        }
+    }
+
+    // Учёт изменения игры: old_tags -> new_tags (пустая строка для
+    // добавленной или удалённой игры). Возвращает true, если изменился
+    // сам набор тегов, а не только счётчики.
+    bool applyChange(const std::string& old_tags, const std::string& new_tags) {
+        // Сначала новые теги: тег, оставшийся у игры, не удаляется
+        // и не добавляется заново, набор для него не меняется
+        bool changed = false;
+        for (const std::string& tag : split(new_tags)) {
+            if (++counts_[tag] == 1) {
+                changed = true;
+            }
+        }
+        for (const std::string& tag : split(old_tags)) {
+            auto it = counts_.find(tag);
+            if (it != counts_.end() && --it->second <= 0) {
+                counts_.erase(it);
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    bool contains(const std::string& tag) const {
+        return counts_.count(tag) > 0;
+    }
+
+    int count(const std::string& tag) const {
+        auto it = counts_.find(tag);
+        return it == counts_.end() ? 0 : it->second;
+    }
+
+    // Теги в алфавитном порядке
+    std::vector<std::string> tags() const {
+        std::vector<std::string> result;
+        result.reserve(counts_.size());
+        for (const auto& entry : counts_) {
+            result.push_back(entry.first);
+        }
+        return result;
+    }
+
+    // Разбор строки тегов через запятую (как в DatabaseManager::getUserTags)
+    static std::vector<std::string> split(std::string_view tags) {
+        std::vector<std::string> result;
+        forEachTag(tags, [&result](std::string_view tag) {
+            result.emplace_back(tag);
+        });
+        return result;
+    }
+
+    // Каноническая форма строки тегов: теги без пробелов по краям и без
+    // пустых, через ", ". В такой форме теги хранятся в БД и собираются
+    // из компактной коллекции, поэтому поиск подстроки локально и через
+    // LIKE на сервере видит одну и ту же строку
+    static void canonical(std::string_view tags, std::string& result) {
+        result.clear();
+        forEachTag(tags, [&result](std::string_view tag) {
+            if (!result.empty()) result += ", ";
+            result.append(tag.data(), tag.size());
+        });
+    }
+
+    static std::string canonical(std::string_view tags) {
+        std::string result;
+        canonical(tags, result);
+        return result;
+    }
+
+    // То же без выделения памяти: visit(std::string_view) для каждого тега
+    template <typename Visitor>
+    static void forEachTag(std::string_view tags, Visitor visit) {
+        size_t pos = 0;
+        while (pos <= tags.size()) {
+            size_t comma = tags.find(',', pos);
+            if (comma == std::string_view::npos) comma = tags.size();
+
+            size_t start = tags.find_first_not_of(" \t", pos);
+            if (start != std::string_view::npos && start < comma) {
+                size_t end = tags.find_last_not_of(" \t", comma - 1);
+                visit(tags.substr(start, end - start + 1));
+            }
+            pos = comma + 1;
+        }
+    }
+
+private:
+    std::map<std::string, int> counts_;
+};
+
+}
+
+#endif
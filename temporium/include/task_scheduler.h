@@ -0,0 +1,191 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Temporium {
+
+// Приоритет задачи: интерактивные (сортировка и фильтр таблицы) выполняются
+// раньше фоновых (экспорт, импорт, построение индексов)
+enum class TaskPriority {
+    Interactive = 0,
+    Background = 1
+};
+
+class TaskScheduler;
+
+// Группа задач, которую можно дождаться. Ожидающий поток не простаивает:
+// он выполняет задачи из очередей с приоритетом не ниже приоритета группы,
+// поэтому вложенные группы (параллельная сортировка внутри задачи) не
+// блокируют пул
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskPriority priority = TaskPriority::Interactive);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+
+    // Ждёт завершения всех задач группы; первое исключение из задач
+    // пробрасывается дальше
+    void wait();
+
+    TaskPriority priority() const { return priority_; }
+
+private:
+    friend class TaskScheduler;
+
+    void finished(std::exception_ptr error);
+
+    TaskScheduler& scheduler_;
+    TaskPriority priority_;
+    std::atomic<size_t> pending_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::exception_ptr error_;
+};
+
+// Общий для процесса пул потоков по числу ядер. У каждого рабочего потока
+// своя очередь на каждый приоритет: свои задачи он берёт с конца (свежие
+// данные ещё в кэше), а простаивая, крадёт у других с начала
+class TaskScheduler {
+public:
+    static TaskScheduler& instance();
+
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    size_t threadCount() const { return workers_.size(); }
+
+    // Задача без ожидания результата
+    void submit(std::function<void()> task, TaskPriority priority = TaskPriority::Background);
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        std::function<void()> function;
+        TaskGroup* group;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> queues[2];     // По приоритету
+        std::thread thread;
+    };
+
+    explicit TaskScheduler(size_t threads);
+
+    void push(Task task, TaskPriority priority);
+    // Берёт задачу с приоритетом не ниже lowest: сначала из своей
+    // очереди, затем крадёт у остальных
+    bool take(Task& task, TaskPriority lowest);
+    void execute(Task& task);
+    void workerLoop(size_t index);
+    // Выполняет одну задачу, если она есть (для ожидающих групп)
+    bool runOne(TaskPriority lowest);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> nextQueue_;
+    std::atomic<size_t> queued_;
+    std::mutex sleepMutex_;
+    std::condition_variable wakeUp_;
+    bool stopping_;
+};
+
+// Параллельный цикл по [begin, end) кусками не меньше grain элементов:
+// body(lo, hi) вызывается для каждого куска. Вызывающий поток участвует
+// в работе; при малом объёме всё выполняется в нём же
+template <typename Body>
+void parallelFor(size_t begin, size_t end, size_t grain, Body body,
+                 TaskPriority priority = TaskPriority::Interactive) {
+    if (end <= begin) return;
+    const size_t n = end - begin;
+    grain = std::max<size_t>(grain, 1);
+    size_t threads = TaskScheduler::instance().threadCount() + 1;
+    // Несколько кусков на поток, чтобы кражей выравнивалась нагрузка
+    size_t chunks = std::min((n + grain - 1) / grain, threads * 4);
+    if (chunks < 2) {
+        body(begin, end);
+        return;
+    }
+
+    TaskGroup group(priority);
+    for (size_t i = 1; i < chunks; ++i) {
+        size_t lo = begin + n * i / chunks;
+        size_t hi = begin + n * (i + 1) / chunks;
+        group.run([&body, lo, hi]() { body(lo, hi); });
+    }
+    try {
+        body(begin, begin + n / chunks);
+    } catch (...) {
+        group.wait();
+        throw;
+    }
+    group.wait();
+}
+
+// Стабильная параллельная сортировка: куски сортируются параллельно,
+// затем попарно сливаются (inplace_merge сохраняет порядок равных
+// элементов, поэтому результат стабилен)
+template <typename T, typename Compare>
+void parallelStableSort(std::vector<T>& data, Compare comp,
+                        TaskPriority priority = TaskPriority::Interactive) {
+    // Меньше этого размера куска распараллеливание не окупается
+    constexpr size_t PARALLEL_SORT_CHUNK = 32768;
+
+    const size_t n = data.size();
+    size_t threads = TaskScheduler::instance().threadCount() + 1;
+    size_t chunks = std::min(threads, n / PARALLEL_SORT_CHUNK);
+
+    if (chunks < 2) {
+        std::stable_sort(data.begin(), data.end(), comp);
+        return;
+    }
+
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t i = 0; i <= chunks; ++i) {
+        bounds[i] = n * i / chunks;
+    }
+
+    {
+        TaskGroup group(priority);
+        for (size_t i = 0; i < chunks; ++i) {
+            group.run([&data, &bounds, &comp, i]() {
+                std::stable_sort(data.begin() + bounds[i], data.begin() + bounds[i + 1], comp);
+            });
+        }
+        group.wait();
+    }
+
+    for (size_t width = 1; width < chunks; width *= 2) {
+        TaskGroup group(priority);
+        for (size_t i = 0; i + width < chunks; i += 2 * width) {
+            size_t lo = bounds[i];
+            size_t mid = bounds[i + width];
+            size_t hi = bounds[std::min(i + 2 * width, chunks)];
+            group.run([&data, &comp, lo, mid, hi]() {
+                std::inplace_merge(data.begin() + lo, data.begin() + mid, data.begin() + hi, comp);
+            });
+        }
+        group.wait();
+    }
+}
+
+}
+
+#endif
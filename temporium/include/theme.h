@@ -0,0 +1,21 @@
+#ifndef THEME_H
+#define THEME_H
+
+#include <QString>
+
+namespace Temporium {
+
+// Цвета темы
+const QString DARK_BG = "#303030";
+const QString DARK_LIGHTER = "#404040";
+const QString DARK_BORDER = "#505050";
+const QString ACCENT_COLOR = "#03fce8";
+const QString ACCENT_DARKER = "#02d4c4";
+const QString TEXT_COLOR = "#ffffff";
+const QString TEXT_SECONDARY = "#b0b0b0";
+const QString TEXT_PRIMARY  = "#ffffff";
+const QString BORDER_COLOR  = "#444444";
+
+}
+
+#endif
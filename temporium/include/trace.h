@@ -0,0 +1,141 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Temporium {
+
+// Запись интервалов выполнения (слоты окна, запросы к БД, работа с файлами)
+// для разбора "что именно тормозит". Интервалы пишутся в кольцевой буфер
+// без блокировок: при переполнении старые затираются. Выгружаются в формате
+// Chrome trace (открывается в chrome://tracing и ui.perfetto.dev).
+// Пока запись выключена, интервал стоит одной проверки флага.
+class Tracer {
+public:
+    enum Mode : uint32_t {
+        RECORD = 1,     // Запись интервалов в буфер
+        WATCH = 2       // Учёт открытых интервалов наблюдаемого потока
+    };
+
+    // Открытый интервал наблюдаемого потока
+    struct Activity {
+        const char* name;
+        const char* category;
+        uint64_t start_us;
+    };
+
+    static Tracer& instance();
+
+    uint32_t mode() const { return mode_.load(std::memory_order_relaxed); }
+    bool enabled() const { return mode() & RECORD; }
+    void setEnabled(bool enabled);
+
+    // Текущий поток становится наблюдаемым: его открытые интервалы видны
+    // из других потоков через activity() (сторож зависаний GUI)
+    void watchCurrentThread();
+    static bool onWatchedThread();
+    void enter(const char* name, const char* category, uint64_t start_us);
+    void leave();
+    // Открытые интервалы наблюдаемого потока, от внешнего к вложенному
+    std::vector<Activity> activity() const;
+
+    // Микросекунды от старта процесса
+    static uint64_t now();
+
+    // name, category и key — строковые литералы: в буфер пишутся только указатели
+    void record(const char* name, const char* category, uint64_t start_us, uint64_t duration_us,
+                const char* key = nullptr, int64_t value = 0);
+
+    // Число интервалов в буфере и очистка
+    size_t size() const;
+    void clear();
+
+    // Запись буфера в JSON-файл формата Chrome trace
+    bool exportChromeTrace(const std::string& filename, std::string* error = nullptr) const;
+
+    static constexpr size_t CAPACITY = 1 << 16;
+    static constexpr size_t ACTIVITY_DEPTH = 32;
+
+private:
+    Tracer();
+
+    // Слот буфера. seq = 2 * номер + 2 у записанного слота и нечётен
+    // во время записи: читатель пропускает недописанные и затёртые
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<const char*> category{nullptr};
+        std::atomic<const char*> key{nullptr};
+        std::atomic<uint64_t> start{0};
+        std::atomic<uint64_t> duration{0};
+        std::atomic<int64_t> value{0};
+        std::atomic<uint32_t> thread{0};
+    };
+
+    struct ActivitySlot {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<const char*> category{nullptr};
+        std::atomic<uint64_t> start{0};
+    };
+
+    std::atomic<uint32_t> mode_;
+    std::atomic<uint64_t> head_;        // Номер следующей записи
+    std::atomic<uint64_t> cleared_;     // Записи с меньшими номерами очищены
+    std::unique_ptr<Slot[]> slots_;
+    ActivitySlot activity_[ACTIVITY_DEPTH];
+    std::atomic<uint32_t> depth_;       // Может превышать ACTIVITY_DEPTH
+};
+
+// Интервал в пределах области видимости
+class TraceSpan {
+public:
+    TraceSpan(const char* name, const char* category)
+        : name_(name)
+        , category_(category)
+    {
+        uint32_t mode = Tracer::instance().mode();
+        if (mode == 0) return;
+        recording_ = (mode & Tracer::RECORD) != 0;
+        watched_ = (mode & Tracer::WATCH) && Tracer::onWatchedThread();
+        start_ = Tracer::now();
+        if (watched_) {
+            Tracer::instance().enter(name_, category_, start_);
+        }
+    }
+
+    ~TraceSpan() {
+        if (watched_) {
+            Tracer::instance().leave();
+        }
+        if (recording_) {
+            Tracer::instance().record(name_, category_, start_, Tracer::now() - start_, key_, value_);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    // Одно числовое значение интервала (например, число строк)
+    void setValue(const char* key, int64_t value) {
+        key_ = key;
+        value_ = value;
+    }
+
+private:
+    const char* name_;
+    const char* category_;
+    bool recording_ = false;
+    bool watched_ = false;
+    uint64_t start_ = 0;
+    const char* key_ = nullptr;
+    int64_t value_ = 0;
+};
+
+}
+
+#endif
@@ -21,9 +21,9 @@ constexpr double MIN_VRAM_REQUIRED = 0.5;
 struct Game {
     int id;
     std::string name;           // Название игры
-    unsigned int disk_space;          // Место на диске (ГБ)
-    unsigned int ram_usage;           // Потребление ОЗУ (ГБ)
-    unsigned int  vram_required;       // Требуемая видеопамять (ГБ)
+    double disk_space;                // Место на диске (ГБ)
+    double ram_usage;                 // Потребление ОЗУ (ГБ)
+    double vram_required;             // Требуемая видеопамять (ГБ)
     std::string genre;          // Жанр игры
     bool completed;             // Пройдено (да/нет)
     std::string url;            // Ссылка на игру (Steam, GOG и т.д.)
@@ -49,6 +49,66 @@ struct User {
     User() : id(0), is_admin(false) {}
 };
 
+// Статистика игр для отображения в статусбаре
+struct GameStats {
+    int total_games = 0;
+    int favorites_count = 0;
+    int completed_count = 0;
+    int no_rating_count = 0;
+    int installed_count = 0;
+    double installed_disk_space = 0.0;  
+    int no_url_count = 0;
+};
+
+// Параметры компьютера для подбора игр (ГБ): игра подходит,
+// если каждое её требование не больше соответствующего параметра
+struct MachineProfile {
+    std::string name;
+    unsigned int ram = 0;
+    unsigned int vram = 0;
+    unsigned int disk = 0;
+};
+
+// Число подходящих профилю игр у пользователя (панель администратора)
+struct MachineFitCount {
+    int user_id = 0;
+    std::string username;
+    int games = 0;
+};
+
+// Разрезы и показатели аналитики коллекции
+enum class AggregateGroup {
+    Genre,
+    Rating,
+    Tag,
+    Completed,
+    Favorite,
+    Installed
+};
+
+enum class AggregateMetric {
+    Count,
+    DiskSpaceTotal,
+    InstalledDiskSpace,
+    AverageRating,          // Только игры с оценкой
+    CompletionRate,         // Доля пройденных (0..1)
+    AverageRam,
+    AverageVram
+};
+
+// Строка результата: одна группа одного разреза или итог по всем играм
+struct AggregateRow {
+    bool is_total = false;
+    AggregateGroup group = AggregateGroup::Genre;
+    std::string key;                // Значение группы ("true"/"false" для логических)
+    std::vector<double> values;     // По показателю на столбец; NaN — нет данных
+};
+
+struct AggregateResult {
+    std::vector<AggregateMetric> metrics;
+    std::vector<AggregateRow> rows;
+};
+
 // Структура фильтра для поиска игр
 struct GameFilter {
     bool filter_completed;
@@ -57,7 +57,13 @@ PQXX_PKG=$(dpkg -l | grep -oP 'libpqxx-\d+\.\d+' | head -1)
 if [ -n "$PQXX_PKG" ]; then
     echo -e "${YELLOW}Обнаружен пакет: $PQXX_PKG${NC}"
     # Добавляем текущую версию первой в список зависимостей
-    sed -i "s/libpqxx-7.9 | libpqxx-7.8 | libpqxx-6.4/$PQXX_PKG | libpqxx-7.9 | libpqxx-7.8 | libpqxx-6.4/" "$PKG_DIR/DEBIAN/control"
+    sed -i "s/libpqxx-7.10 | /$PQXX_PKG | libpqxx-7.10 | /" "$PKG_DIR/DEBIAN/control"
+fi
+
+# liburing — только если сборка его нашла (иначе экспорт пишет через pwrite)
+URING_SO=$(ldd "$BUILD_DIR/Temporium" 2>/dev/null | grep -oP 'liburing\.so\.\d+' | head -1)
+if [ -n "$URING_SO" ]; then
+    sed -i "s/^Depends: .*/&, liburing${URING_SO##*.so.}/" "$PKG_DIR/DEBIAN/control"
 fi
 
 # Копирование исполняемого файла
@@ -50,6 +50,9 @@ show_help() {
     echo "  db-shell    - Подключиться к БД через psql"
     echo "  desktop     - Пересоздать ярлык на рабочем столе"
     echo "  reset-admin - Сбросить админа к admin/admin123"
+    echo "  sketch-rebuild - Пересчитать сводку по всем пользователям (для cron)"
+    echo "  server      - Запустить temporium-server (пул соединений и кэш для клиентов)"
+    echo "  loadgen     - Нагрузочный тест: сеансы многих пользователей (--help — параметры)"
     echo "  deb         - Создать DEB-пакет для установки"
     echo "  clean       - Удалить сборку и данные БД"
     echo "  help        - Показать эту справку"
@@ -72,6 +75,7 @@ install_deps() {
         qtbase5-dev \
         libqt5svg5-dev \
         libpqxx-dev \
+        liburing-dev \
         libssl-dev \
         libpq-dev
     
@@ -84,7 +88,7 @@ build_app() {
     # Проверка зависимостей
     MISSING=""
     command -v cmake &> /dev/null || MISSING="$MISSING cmake"
-    pkg-config --exists libpqxx 2>/dev/null || MISSING="$MISSING libpqxx-dev"
+    pkg-config --exists "libpqxx >= 7.7" 2>/dev/null || MISSING="$MISSING libpqxx-dev(>=7.7)"
     pkg-config --exists Qt5Widgets 2>/dev/null || MISSING="$MISSING qtbase5-dev"
     pkg-config --exists openssl 2>/dev/null || MISSING="$MISSING libssl-dev"
     
@@ -330,6 +334,33 @@ reset_admin() {
     echo "Пароль: admin123"
 }
 
+sketch_rebuild() {
+    if [ ! -x "${SCRIPT_DIR}/build/temporium-sketch-rebuild" ]; then
+        echo -e "${RED}Утилита не собрана. Выполните: $0 build${NC}"
+        exit 1
+    fi
+    
+    "${SCRIPT_DIR}/build/temporium-sketch-rebuild"
+}
+
+run_server() {
+    if [ ! -x "${SCRIPT_DIR}/build/temporium-server" ]; then
+        echo -e "${RED}Сервер не собран. Выполните: $0 build${NC}"
+        exit 1
+    fi
+    
+    "${SCRIPT_DIR}/build/temporium-server" "$@"
+}
+
+run_loadgen() {
+    if [ ! -x "${SCRIPT_DIR}/build/temporium-loadgen" ]; then
+        echo -e "${RED}Нагрузочный тест не собран. Выполните: $0 build${NC}"
+        exit 1
+    fi
+    
+    "${SCRIPT_DIR}/build/temporium-loadgen" "$@"
+}
+
 # Обработка команд
 case "${1:-help}" in
     install)
@@ -359,6 +390,17 @@ case "${1:-help}" in
     reset-admin)
         reset_admin
         ;;
+    sketch-rebuild)
+        sketch_rebuild
+        ;;
+    server)
+        shift
+        run_server "$@"
+        ;;
+    loadgen)
+        shift
+        run_loadgen "$@"
+        ;;
     deb)
         build_deb
         ;;
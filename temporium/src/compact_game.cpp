@@ -0,0 +1,323 @@
+#include "compact_game.h"
+#include "tag_dictionary.h"
+#include <algorithm>
+#include <limits>
+
+namespace Temporium {
+
+namespace {
+
+// Индекс жанра в GENRES или GENRES.size() для нестандартного
+uint16_t standardGenreIndex(std::string_view genre) {
+    auto it = std::find(GENRES.begin(), GENRES.end(), genre);
+    return static_cast<uint16_t>(it - GENRES.begin());
+}
+
+// Длины полей ограничены схемой БД (VARCHAR(255), VARCHAR(512)),
+// обрезка — только защита от переполнения счётчика
+template <typename T>
+T clampLength(size_t length) {
+    return static_cast<T>(std::min<size_t>(length, std::numeric_limits<T>::max()));
+}
+
+// Резерв под добавление порции с геометрическим ростом: точный
+// reserve(size + n) на каждой порции копировал бы весь вектор каждый раз
+template <typename Vector>
+void reserveMore(Vector& vector, size_t extra) {
+    size_t needed = vector.size() + extra;
+    if (needed > vector.capacity()) {
+        vector.reserve(std::max(needed, vector.capacity() * 2));
+    }
+}
+
+} // namespace
+
+GameFields gameFields(const Game& game) {
+    GameFields fields;
+    fields.id = game.id;
+    fields.user_id = game.user_id;
+    fields.disk_space = game.disk_space;
+    fields.ram_usage = game.ram_usage;
+    fields.vram_required = game.vram_required;
+    fields.rating = game.rating;
+    fields.completed = game.completed;
+    fields.is_favorite = game.is_favorite;
+    fields.is_installed = game.is_installed;
+    fields.name = game.name;
+    fields.genre = game.genre;
+    fields.url = game.url;
+    fields.notes = game.notes;
+    fields.tags = game.tags;
+    return fields;
+}
+
+Game gameFromFields(const GameFields& fields) {
+    Game game;
+    game.id = fields.id;
+    game.user_id = fields.user_id;
+    game.name = std::string(fields.name);
+    game.disk_space = fields.disk_space;
+    game.ram_usage = fields.ram_usage;
+    game.vram_required = fields.vram_required;
+    game.genre = std::string(fields.genre);
+    game.completed = fields.completed;
+    game.url = std::string(fields.url);
+    game.rating = fields.rating;
+    game.is_favorite = fields.is_favorite;
+    game.is_installed = fields.is_installed;
+    game.notes = std::string(fields.notes);
+    game.tags = std::string(fields.tags);
+    return game;
+}
+
+uint32_t StringPool::intern(std::string_view text, LoadArena& arena) {
+    auto it = ids_.find(text);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(strings_.size());
+    std::string_view stored(arena.copy(text), text.size());
+    strings_.push_back(stored);
+    ids_.emplace(stored, id);
+    return id;
+}
+
+void StringPool::clear() {
+    ids_.clear();
+    strings_.clear();
+}
+
+size_t StringPool::bytes() const {
+    return strings_.capacity() * sizeof(std::string_view) +
+           ids_.size() * (sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void*)) +
+           ids_.bucket_count() * sizeof(void*);
+}
+
+CompactGameCollection::CompactGameCollection() {
+    arenas_.push_back(std::make_unique<LoadArena>());
+}
+
+void CompactGameCollection::clear() {
+    // Пулы ссылаются на строки в аренах — очищаются первыми
+    tags_.clear();
+    customGenres_.clear();
+    games_ = std::vector<CompactGame>();
+    tagIds_ = std::vector<uint32_t>();
+    arenas_.clear();
+    arenas_.push_back(std::make_unique<LoadArena>());
+}
+
+void CompactGameCollection::reserve(size_t count) {
+    games_.reserve(count);
+}
+
+void CompactGameCollection::append(const GameFields& fields) {
+    games_.push_back(makeCompact(fields));
+}
+
+CompactGame CompactGameCollection::makeCompact(const GameFields& fields) {
+    CompactGame compact;
+    compact.id = fields.id;
+    compact.user_id = fields.user_id;
+    compact.disk_space = fields.disk_space;
+    compact.ram_usage = fields.ram_usage;
+    compact.vram_required = fields.vram_required;
+    compact.rating = static_cast<int8_t>(fields.rating);
+    compact.flags = (fields.completed ? CompactGame::FLAG_COMPLETED : 0) |
+                    (fields.is_favorite ? CompactGame::FLAG_FAVORITE : 0) |
+                    (fields.is_installed ? CompactGame::FLAG_INSTALLED : 0);
+
+    compact.genre = standardGenreIndex(fields.genre);
+    if (compact.genre == GENRES.size()) {
+        compact.genre = static_cast<uint16_t>(GENRES.size() + customGenres_.intern(fields.genre, arena()));
+    }
+
+    // Название, ссылка и заметки — одним выделением из арены
+    compact.name_length = clampLength<uint16_t>(fields.name.size());
+    compact.url_length = clampLength<uint16_t>(fields.url.size());
+    compact.notes_length = clampLength<uint32_t>(fields.notes.size());
+    char* text = arena().allocate(size_t(compact.name_length) + compact.url_length + compact.notes_length);
+    compact.text = text;
+    if (text) {
+        std::copy_n(fields.name.data(), compact.name_length, text);
+        std::copy_n(fields.url.data(), compact.url_length, text + compact.name_length);
+        std::copy_n(fields.notes.data(), compact.notes_length,
+                    text + compact.name_length + compact.url_length);
+    }
+
+    compact.tags_offset = static_cast<uint32_t>(tagIds_.size());
+    TagDictionary::forEachTag(fields.tags, [this](std::string_view tag) {
+        tagIds_.push_back(tags_.intern(tag, arena()));
+    });
+    compact.tags_count = static_cast<uint16_t>(tagIds_.size() - compact.tags_offset);
+    return compact;
+}
+
+void CompactGameCollection::append(const Game& game) {
+    append(gameFields(game));
+}
+
+void CompactGameCollection::append(const std::vector<Game>& games) {
+    reserveMore(games_, games.size());
+    for (const auto& game : games) {
+        append(gameFields(game));
+    }
+}
+
+void CompactGameCollection::append(CompactGameCollection&& chunk) {
+    if (chunk.empty()) return;
+
+    // Строки порции остаются на месте: забираем её арены целиком.
+    // Текущей (для новых строк) остаётся собственная арена коллекции.
+    arenas_.insert(arenas_.begin(),
+                   std::make_move_iterator(chunk.arenas_.begin()),
+                   std::make_move_iterator(chunk.arenas_.end()));
+
+    std::vector<uint32_t> tagMap(chunk.tags_.size());
+    for (uint32_t id = 0; id < tagMap.size(); ++id) {
+        tagMap[id] = tags_.intern(chunk.tags_.at(id), arena());
+    }
+    std::vector<uint16_t> genreMap(chunk.customGenres_.size());
+    for (uint32_t id = 0; id < genreMap.size(); ++id) {
+        genreMap[id] = static_cast<uint16_t>(GENRES.size() + customGenres_.intern(chunk.customGenres_.at(id), arena()));
+    }
+
+    uint32_t tagBase = static_cast<uint32_t>(tagIds_.size());
+    reserveMore(tagIds_, chunk.tagIds_.size());
+    for (uint32_t id : chunk.tagIds_) {
+        tagIds_.push_back(tagMap[id]);
+    }
+
+    reserveMore(games_, chunk.games_.size());
+    for (CompactGame game : chunk.games_) {
+        game.tags_offset += tagBase;
+        if (game.genre >= GENRES.size()) {
+            game.genre = genreMap[game.genre - GENRES.size()];
+        }
+        games_.push_back(game);
+    }
+
+    chunk.clear();
+}
+
+std::string_view CompactGameCollection::name(size_t index) const {
+    const CompactGame& game = games_[index];
+    return std::string_view(game.text, game.name_length);
+}
+
+std::string_view CompactGameCollection::url(size_t index) const {
+    const CompactGame& game = games_[index];
+    return std::string_view(game.text + game.name_length, game.url_length);
+}
+
+std::string_view CompactGameCollection::notes(size_t index) const {
+    const CompactGame& game = games_[index];
+    return std::string_view(game.text + game.name_length + game.url_length, game.notes_length);
+}
+
+std::string_view CompactGameCollection::genre(size_t index) const {
+    uint16_t genre = games_[index].genre;
+    if (genre < GENRES.size()) {
+        return GENRES[genre];
+    }
+    return customGenres_.at(genre - static_cast<uint16_t>(GENRES.size()));
+}
+
+std::string CompactGameCollection::tags(size_t index) const {
+    std::string result;
+    tags(index, result);
+    return result;
+}
+
+void CompactGameCollection::tags(size_t index, std::string& out) const {
+    const CompactGame& game = games_[index];
+    out.clear();
+    for (uint16_t i = 0; i < game.tags_count; ++i) {
+        if (i > 0) out += ", ";
+        out += tags_.at(tagIds_[game.tags_offset + i]);
+    }
+}
+
+std::string_view CompactGameCollection::tag(size_t index, size_t i) const {
+    return tags_.at(tagIds_[games_[index].tags_offset + i]);
+}
+
+GameFields CompactGameCollection::fields(size_t index, std::string& tags_buffer) const {
+    const CompactGame& game = games_[index];
+    tags(index, tags_buffer);
+
+    GameFields fields;
+    fields.id = game.id;
+    fields.user_id = game.user_id;
+    fields.disk_space = game.disk_space;
+    fields.ram_usage = game.ram_usage;
+    fields.vram_required = game.vram_required;
+    fields.rating = game.rating;
+    fields.completed = game.completed();
+    fields.is_favorite = game.isFavorite();
+    fields.is_installed = game.isInstalled();
+    fields.name = name(index);
+    fields.genre = genre(index);
+    fields.url = url(index);
+    fields.notes = notes(index);
+    fields.tags = tags_buffer;
+    return fields;
+}
+
+void CompactGameCollection::setNotes(size_t index, const std::string& notes) {
+    CompactGame& game = games_[index];
+
+    // Старый текст остаётся в арене до очистки коллекции
+    uint32_t notesLength = clampLength<uint32_t>(notes.size());
+    size_t prefix = size_t(game.name_length) + game.url_length;
+    char* text = arena().allocate(prefix + notesLength);
+    if (text) {
+        std::copy_n(game.text, prefix, text);
+        std::copy_n(notes.data(), notesLength, text + prefix);
+    }
+    game.text = text;
+    game.notes_length = notesLength;
+}
+
+void CompactGameCollection::replace(size_t index, const Game& game) {
+    games_[index] = makeCompact(gameFields(game));
+}
+
+void CompactGameCollection::erase(size_t index) {
+    games_.erase(games_.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+Game CompactGameCollection::toGame(size_t index) const {
+    std::string tags;
+    return gameFromFields(fields(index, tags));
+}
+
+std::vector<Game> CompactGameCollection::toGames() const {
+    std::vector<Game> games;
+    games.reserve(games_.size());
+    for (size_t i = 0; i < games_.size(); ++i) {
+        games.push_back(toGame(i));
+    }
+    return games;
+}
+
+size_t CompactGameCollection::memoryUsage() const {
+    size_t total = games_.capacity() * sizeof(CompactGame) +
+                   tagIds_.capacity() * sizeof(uint32_t) +
+                   tags_.bytes() + customGenres_.bytes();
+    for (const auto& arena : arenas_) {
+        total += arena->bytes();
+    }
+    return total;
+}
+
+size_t CompactGameCollection::arenaAllocations() const {
+    size_t total = 0;
+    for (const auto& arena : arenas_) {
+        total += arena->systemAllocations();
+    }
+    return total;
+}
+
+}
@@ -1,15 +1,172 @@
 #include "database_manager.h"
 #include "hash_utils.h"
+#include "rpc_client.h"
+#include "export_writer.h"
+#include "filter_compiler.h"
+#include "filter_expression.h"
+#include "pg_binary.h"
+#include "tag_dictionary.h"
+#include "task_scheduler.h"
+#include "trace.h"
 #include <fstream>
 #include <cstring>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <set>
+#include <cmath>
+#include <limits>
+#include <iterator>
+#include <tuple>
 
 namespace Temporium {
 
-DatabaseManager::DatabaseManager() : conn_(nullptr) {}
+namespace {
+
+// Версия схемы, которую создаёт initializeTables(). Увеличивается
+// при каждом изменении DDL, чтобы миграция выполнилась повторно.
+constexpr int SCHEMA_VERSION = 8;
+
+// Запросы пути входа, подготавливаются заранее при подключении
+const char* const SQL_AUTHENTICATE_USER =
+    "SELECT id, username, password_hash, is_admin FROM users WHERE username = $1 AND password_hash = $2";
+const char* const SQL_USER_EXISTS =
+    "SELECT COUNT(*) FROM users WHERE username = $1";
+
+// Столбцы игры для списков; порядок — GameColumn
+const char* const GAME_COLUMNS =
+    "id, name, disk_space, ram_usage, vram_required, genre, completed, url, user_id, "
+    "rating, is_favorite, is_installed, notes, tags";
+
+enum GameColumn {
+    COL_ID, COL_NAME, COL_DISK_SPACE, COL_RAM_USAGE, COL_VRAM_REQUIRED, COL_GENRE, COL_COMPLETED,
+    COL_URL, COL_USER_ID, COL_RATING, COL_IS_FAVORITE, COL_IS_INSTALLED, COL_NOTES, COL_TAGS
+};
+
+void checkGameColumns(const pqxx::result& r) {
+    PgBinary::expectType(r, COL_ID, PgBinary::INT4_OID);
+    PgBinary::expectType(r, COL_DISK_SPACE, PgBinary::FLOAT8_OID);
+    PgBinary::expectType(r, COL_RAM_USAGE, PgBinary::FLOAT8_OID);
+    PgBinary::expectType(r, COL_VRAM_REQUIRED, PgBinary::FLOAT8_OID);
+    PgBinary::expectType(r, COL_COMPLETED, PgBinary::BOOL_OID);
+    PgBinary::expectType(r, COL_USER_ID, PgBinary::INT4_OID);
+    PgBinary::expectType(r, COL_RATING, PgBinary::INT4_OID);
+    PgBinary::expectType(r, COL_IS_FAVORITE, PgBinary::BOOL_OID);
+    PgBinary::expectType(r, COL_IS_INSTALLED, PgBinary::BOOL_OID);
+}
+
+// Выборка игр в двоичном формате: результат запроса читается через
+// BINARY CURSOR (exec_params libpqxx всегда просит текст). Курсор
+// закрывается вместе с транзакцией
+pqxx::result fetchGamesBinary(pqxx::work& txn, const std::string& query, const pqxx::params& params) {
+    txn.exec_params("DECLARE games_binary BINARY NO SCROLL CURSOR FOR " + query, params);
+    pqxx::result r = txn.exec("FETCH ALL FROM games_binary");
+    checkGameColumns(r);
+    return r;
+}
+
+// Записей бинарного файла на одну задачу пула (запись ~2 КБ)
+constexpr size_t RECORDS_PER_TASK = 2048;
+// При экспорте: буфер записи вмещает меньше RECORDS_PER_TASK записей
+constexpr size_t EXPORT_RECORDS_PER_TASK = 256;
+// Строк в порции выборки для экспорта
+constexpr size_t EXPORT_FETCH_ROWS = 10000;
+
+// Строка в поле записи фиксированной длины (с нулём в конце, как strncpy)
+template <size_t N>
+void copyText(char (&field)[N], std::string_view text) {
+    std::memcpy(field, text.data(), std::min(text.size(), N - 1));
+}
+
+void encodeRecord(const GameFields& game, BinaryGameRecord& record) {
+    std::memset(&record, 0, sizeof(record));
+    
+    record.id = game.id;
+    copyText(record.name, game.name);
+    record.disk_space = game.disk_space;
+    record.ram_usage = game.ram_usage;
+    record.vram_required = game.vram_required;
+    copyText(record.genre, game.genre);
+    record.completed = game.completed ? 1 : 0;
+    copyText(record.url, game.url);
+    record.user_id = game.user_id;
+    record.rating = game.rating;
+    record.is_favorite = game.is_favorite ? 1 : 0;
+    record.is_installed = game.is_installed ? 1 : 0;
+    copyText(record.notes, game.notes);
+    copyText(record.tags, game.tags);
+}
+
+void decodeRecord(const BinaryGameRecord& record, Game& game) {
+    game.id = record.id;
+    game.name = record.name;
+    game.disk_space = record.disk_space;
+    game.ram_usage = record.ram_usage;
+    game.vram_required = record.vram_required;
+    game.genre = record.genre;
+    game.completed = record.completed != 0;
+    game.url = record.url;
+    game.user_id = record.user_id;
+    game.rating = record.rating;
+    game.is_favorite = record.is_favorite != 0;
+    game.is_installed = record.is_installed != 0;
+    game.notes = record.notes;
+    game.tags = record.tags;
+}
+
+// Сбрасывает запрос отмены по окончании локального запроса: cancelQuery(),
+// пришедший, когда запрос уже закончился, не относится к следующему
+class CancelRequestReset {
+public:
+    explicit CancelRequestReset(std::atomic<bool>& flag) : flag_(flag) {}
+    ~CancelRequestReset() { flag_ = false; }
+
+private:
+    std::atomic<bool>& flag_;
+};
+
+} // namespace
+
+template <typename Result>
+bool DatabaseManager::remoteReply(Result& result) {
+    std::string error;
+    if (!remote_->nextReply(error)) {
+        last_error_ = error;
+        return false;
+    }
+    RpcReader& in = remote_->reply();
+    in >> result >> error;
+    if (!in.ok()) {
+        last_error_ = "Malformed server reply";
+        return false;
+    }
+    if (!error.empty()) {
+        last_error_ = error;
+        return false;
+    }
+    return true;
+}
+
+template <typename Result, typename... Args>
+bool DatabaseManager::remoteCall(RpcOp op, Result& result, const Args&... args) {
+    TraceSpan span(rpcOpName(op), "rpc");
+    cancelled_ = false;
+    remote_->begin();
+    remote_->add(op, args...);
+    if (!remote_->call()) {
+        // cancelQuery() разрывает соединение — это не ошибка сервера.
+        // Флаг не сбрасывается перед вызовом: отмена, пришедшая между
+        // вызовами, уже разорвала соединение и обрывает следующий
+        cancelled_ = cancel_requested_.exchange(false);
+        last_error_ = cancelled_ ? std::string(rpcOpName(op)) + " cancelled" : remote_->lastError();
+        return false;
+    }
+    return remoteReply(result);
+}
+
+DatabaseManager::DatabaseManager()
+    : conn_(nullptr), statements_prepared_(false), statement_timeout_ms_(0), cancelled_(false),
+      cancel_requested_(false), data_version_(0), aggregate_cache_version_(0) {}
 
 DatabaseManager::~DatabaseManager() {
     disconnect();
@@ -27,11 +184,18 @@ bool DatabaseManager::connect(const std::string& host, int port,
                  << " user=" << user 
                  << " password=" << password;
         
-        conn_ = std::make_unique<pqxx::connection>(conn_str.str());
+        conn_str_ = conn_str.str();
+        statements_prepared_ = false;
+        ++data_version_;
+        setConnection(std::make_unique<pqxx::connection>(conn_str_), nullptr);
         
         if (conn_->is_open()) {
+            if (statement_timeout_ms_ > 0) {
+                applyStatementTimeout();
+            }
             if (initializeTables()) {
                 ensureAdminExists();
+                prepareStatements();
                 return true;
             }
         }
@@ -44,17 +208,159 @@ bool DatabaseManager::connect(const std::string& host, int port,
     }
 }
 
+bool DatabaseManager::connectSecondary(const std::string& conn_str) {
+    const size_t scheme = std::strlen(RPC_SCHEME);
+    if (conn_str.compare(0, scheme, RPC_SCHEME) == 0) {
+        std::string address = conn_str.substr(scheme);
+        std::string session;
+        size_t hash = address.find('#');
+        if (hash != std::string::npos) {
+            session = address.substr(hash + 1);
+            address.resize(hash);
+        }
+        
+        // К тому же серверу не переподключаемся — меняется только сеанс
+        if (!remote_ || !remote_->isConnected() || remote_->address() != address) {
+            if (!connectRemote(address)) {
+                return false;
+            }
+        }
+        if (session.empty()) {
+            return true;
+        }
+        
+        bool attached = false;
+        remoteCall(RpcOp::Attach, attached, session);
+        if (!attached) {
+            return false;
+        }
+        remote_session_ = session;
+        conn_str_ = conn_str;
+        return true;
+    }
+    
+    try {
+        conn_str_ = conn_str;
+        statements_prepared_ = false;
+        setConnection(std::make_unique<pqxx::connection>(conn_str_), nullptr);
+        
+        if (conn_->is_open()) {
+            if (statement_timeout_ms_ > 0) {
+                applyStatementTimeout();
+            }
+            return true;
+        }
+        
+        last_error_ = "Failed to open database connection";
+        return false;
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Connection error: ") + e.what();
+        return false;
+    }
+}
+
+bool DatabaseManager::connectRemote(const std::string& address) {
+    disconnect();
+    conn_str_ = RPC_SCHEME + address;
+    statements_prepared_ = false;
+    ++data_version_;
+    
+    // Схемой и администратором по умолчанию занимается сервер
+    setConnection(nullptr, std::make_unique<RpcClient>());
+    if (!remote_->connect(address)) {
+        last_error_ = "Connection error: " + remote_->lastError();
+        return false;
+    }
+    return true;
+}
+
 void DatabaseManager::disconnect() {
-    if (conn_) {
-        conn_.reset();
+    setConnection(nullptr, nullptr);
+    remote_session_.clear();
+}
+
+void DatabaseManager::setConnection(std::unique_ptr<pqxx::connection> conn, std::unique_ptr<RpcClient> remote) {
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+    conn_ = std::move(conn);
+    remote_ = std::move(remote);
+    cancel_requested_ = false;
+}
+
+void DatabaseManager::setStatementTimeout(int ms) {
+    statement_timeout_ms_ = std::max(ms, 0);
+    if (!remote_ && conn_ && conn_->is_open()) {
+        applyStatementTimeout();
+    }
+}
+
+void DatabaseManager::applyStatementTimeout() {
+    try {
+        pqxx::nontransaction txn(*conn_);
+        txn.exec("SET statement_timeout = " + std::to_string(statement_timeout_ms_));
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Statement timeout error: ") + e.what();
+    }
+}
+
+bool DatabaseManager::cancelQuery() {
+    std::lock_guard<std::mutex> lock(connection_mutex_);
+    cancel_requested_ = true;
+    if (remote_) {
+        // Сервер видит разрыв и прерывает запрос этого соединения
+        // (RpcServer::watchHangups)
+        remote_->abort();
+        return true;
+    }
+    if (!conn_) {
+        return false;
+    }
+    try {
+        conn_->cancel_query();
+        return true;
+    } catch (const std::exception&) {
+        return false;
     }
 }
 
+void DatabaseManager::reportCanceled(const char* operation, const pqxx::query_canceled& e) {
+    // Оба случая приходят одним SQLSTATE, а текст сервера переводится
+    // (lc_messages): отмену отличает только собственный флаг
+    cancelled_ = cancel_requested_.exchange(false);
+    last_error_ = std::string(operation) + (cancelled_ ? " cancelled: " : " timed out: ") + e.what();
+}
+
 bool DatabaseManager::isConnected() const {
+    if (remote_) {
+        return remote_->isConnected();
+    }
     return conn_ && conn_->is_open();
 }
 
+std::string DatabaseManager::getConnectionString() const {
+    return conn_str_;
+}
+
+int DatabaseManager::getSchemaVersion() {
+    try {
+        pqxx::nontransaction txn(*conn_);
+        pqxx::result r = txn.exec("SELECT MAX(version) FROM schema_version");
+        return r[0][0].is_null() ? 0 : r[0][0].as<int>();
+    } catch (const std::exception& e) {
+        // Таблицы версий ещё нет — база создаётся с нуля или до версионирования
+        return 0;
+    }
+}
+
 bool DatabaseManager::initializeTables() {
+    if (remote_) {
+        return true;
+    }
+    
+    // Схема актуальна — один запрос вместо полного набора DDL
+    if (getSchemaVersion() >= SCHEMA_VERSION) {
+        return true;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -136,6 +442,91 @@ bool DatabaseManager::initializeTables() {
         txn.exec("CREATE INDEX IF NOT EXISTS idx_games_rating ON games(rating)");
         txn.exec("CREATE INDEX IF NOT EXISTS idx_games_installed ON games(is_installed)");
         
+        // Индексы расширенного фильтра: префикс названия и массив тегов
+        txn.exec("CREATE INDEX IF NOT EXISTS idx_games_name_pattern ON games(user_id, name text_pattern_ops)");
+        // Выражение разбора тегов изменилось: старый индекс по нему не подходит
+        txn.exec("DROP INDEX IF EXISTS idx_games_tags_array");
+        txn.exec(std::string("CREATE INDEX IF NOT EXISTS idx_games_tag_list ON games USING GIN ((") +
+                 FilterExpression::TAGS_ARRAY_SQL + "))");
+        
+        // Подбор игр по параметрам компьютера: все столбцы запроса есть
+        // в индексе (сканирование только индекса, в том числе по всем
+        // пользователям для панели администратора)
+        txn.exec("CREATE INDEX IF NOT EXISTS idx_games_requirements "
+                 "ON games(user_id, ram_usage, vram_required, disk_space)");
+        
+        // Журнал изменений названий для сводки администратора: одна строка
+        // на название с суммой +1 за каждое появление и -1 за исчезновение.
+        // Размер ограничен числом различных названий, даже если сводку
+        // долго не обновляют. Журнал прежнего вида (строка на изменение)
+        // сворачивается в суммы
+        txn.exec(
+            "DO $$ BEGIN "
+            "    IF EXISTS (SELECT 1 FROM information_schema.columns "
+            "               WHERE table_name = 'game_name_changes' AND column_name = 'seq') THEN "
+            "        CREATE TEMP TABLE game_name_totals ON COMMIT DROP AS "
+            "            SELECT name, SUM(delta)::INTEGER AS delta FROM game_name_changes GROUP BY name; "
+            "        DROP TABLE game_name_changes; "
+            "        CREATE TABLE game_name_changes (name VARCHAR(255) PRIMARY KEY, delta INTEGER NOT NULL); "
+            "        INSERT INTO game_name_changes SELECT name, delta FROM game_name_totals WHERE delta <> 0; "
+            "    END IF; "
+            "END $$"
+        );
+        txn.exec(
+            "CREATE TABLE IF NOT EXISTS game_name_changes ("
+            "    name VARCHAR(255) PRIMARY KEY,"
+            "    delta INTEGER NOT NULL"
+            ")"
+        );
+        txn.exec(
+            "CREATE TABLE IF NOT EXISTS game_name_sketch ("
+            "    id INTEGER PRIMARY KEY CHECK (id = 1),"
+            "    data BYTEA NOT NULL,"
+            "    rebuilt_at TIMESTAMP NOT NULL,"
+            "    updated_at TIMESTAMP NOT NULL"
+            ")"
+        );
+        // Записи журнала удаляются при применении — отметка last_seq не нужна
+        txn.exec("ALTER TABLE game_name_sketch DROP COLUMN IF EXISTS last_seq");
+        txn.exec(
+            "CREATE OR REPLACE FUNCTION games_name_feed() RETURNS trigger AS $$ "
+            "BEGIN "
+            "    IF TG_OP IN ('UPDATE', 'DELETE') THEN "
+            "        INSERT INTO game_name_changes AS c (name, delta) VALUES (OLD.name, -1) "
+            "        ON CONFLICT (name) DO UPDATE SET delta = c.delta - 1; "
+            "    END IF; "
+            "    IF TG_OP IN ('UPDATE', 'INSERT') THEN "
+            "        INSERT INTO game_name_changes AS c (name, delta) VALUES (NEW.name, 1) "
+            "        ON CONFLICT (name) DO UPDATE SET delta = c.delta + 1; "
+            "    END IF; "
+            "    RETURN NULL; "
+            "END $$ LANGUAGE plpgsql"
+        );
+        txn.exec("DROP TRIGGER IF EXISTS games_name_feed ON games");
+        txn.exec("DROP TRIGGER IF EXISTS games_name_feed_update ON games");
+        txn.exec("CREATE TRIGGER games_name_feed AFTER INSERT OR DELETE ON games "
+                 "FOR EACH ROW EXECUTE FUNCTION games_name_feed()");
+        txn.exec("CREATE TRIGGER games_name_feed_update AFTER UPDATE OF name ON games "
+                 "FOR EACH ROW WHEN (OLD.name IS DISTINCT FROM NEW.name) EXECUTE FUNCTION games_name_feed()");
+        
+        // Теги в канонической форме (TagDictionary::canonical): подстрока
+        // в фильтре ищется одинаково в БД и в загруженной коллекции
+        txn.exec(
+            "WITH canonical AS ("
+            "    SELECT id, array_to_string(ARRAY("
+            "        SELECT btrim(t, E' \\t') FROM unnest(string_to_array(tags, ',')) WITH ORDINALITY AS u(t, n)"
+            "        WHERE btrim(t, E' \\t') <> '' ORDER BY n), ', ') AS tags"
+            "    FROM games WHERE tags IS NOT NULL"
+            ") "
+            "UPDATE games SET tags = canonical.tags FROM canonical "
+            "WHERE games.id = canonical.id AND games.tags <> canonical.tags"
+        );
+        
+        // Отмечаем применённую версию схемы
+        txn.exec("CREATE TABLE IF NOT EXISTS schema_version (version INTEGER NOT NULL)");
+        txn.exec("DELETE FROM schema_version");
+        txn.exec_params("INSERT INTO schema_version (version) VALUES ($1)", SCHEMA_VERSION);
+        
         txn.commit();
         return true;
     } catch (const std::exception& e) {
@@ -166,7 +557,24 @@ void DatabaseManager::ensureAdminExists() {
     }
 }
 
+void DatabaseManager::prepareStatements() {
+    try {
+        conn_->prepare("authenticate_user", SQL_AUTHENTICATE_USER);
+        conn_->prepare("user_exists", SQL_USER_EXISTS);
+        statements_prepared_ = true;
+    } catch (const std::exception& e) {
+        // Не критично: запросы выполнятся без подготовки
+        statements_prepared_ = false;
+    }
+}
+
 bool DatabaseManager::registerUser(const std::string& username, const std::string& password_hash, bool is_admin) {
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::RegisterUser, ok, username, password_hash, is_admin);
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -184,14 +592,28 @@ bool DatabaseManager::registerUser(const std::string& username, const std::strin
 }
 
 User DatabaseManager::authenticateUser(const std::string& username, const std::string& password_hash) {
+    TraceSpan span("DatabaseManager::authenticateUser", "db");
     User user;
+    if (remote_) {
+        // Вход открывает сеанс на сервере; ключ попадает в строку
+        // подключения, по ней к сеансу присоединяются фоновые загрузчики
+        std::tuple<User, std::string> reply;
+        remoteCall(RpcOp::AuthenticateUser, reply, username, password_hash);
+        user = std::get<0>(reply);
+        if (user.id > 0) {
+            remote_session_ = std::get<1>(reply);
+            conn_str_ = RPC_SCHEME + remote_->address() + "#" + remote_session_;
+        }
+        return user;
+    }
+    
     try {
-        pqxx::work txn(*conn_);
+        // Чтение без транзакции: один обмен с сервером вместо BEGIN/SELECT/COMMIT
+        pqxx::nontransaction txn(*conn_);
         
-        pqxx::result r = txn.exec_params(
-            "SELECT id, username, password_hash, is_admin FROM users WHERE username = $1 AND password_hash = $2",
-            username, password_hash
-        );
+        pqxx::result r = statements_prepared_ ?
+            txn.exec_prepared("authenticate_user", username, password_hash) :
+            txn.exec_params(SQL_AUTHENTICATE_USER, username, password_hash);
         
         if (!r.empty()) {
             user.id = r[0]["id"].as<int>();
@@ -199,8 +621,6 @@ User DatabaseManager::authenticateUser(const std::string& username, const std::s
             user.password_hash = r[0]["password_hash"].as<std::string>();
             user.is_admin = r[0]["is_admin"].as<bool>();
         }
-        
-        txn.commit();
     } catch (const std::exception& e) {
         last_error_ = std::string("Authentication error: ") + e.what();
     }
@@ -209,15 +629,19 @@ User DatabaseManager::authenticateUser(const std::string& username, const std::s
 }
 
 bool DatabaseManager::userExists(const std::string& username) {
+    if (remote_) {
+        bool exists = false;
+        remoteCall(RpcOp::UserExists, exists, username);
+        return exists;
+    }
+    
     try {
-        pqxx::work txn(*conn_);
+        pqxx::nontransaction txn(*conn_);
         
-        pqxx::result r = txn.exec_params(
-            "SELECT COUNT(*) FROM users WHERE username = $1",
-            username
-        );
+        pqxx::result r = statements_prepared_ ?
+            txn.exec_prepared("user_exists", username) :
+            txn.exec_params(SQL_USER_EXISTS, username);
         
-        txn.commit();
         return r[0][0].as<int>() > 0;
     } catch (const std::exception& e) {
         last_error_ = std::string("User check error: ") + e.what();
@@ -227,6 +651,11 @@ bool DatabaseManager::userExists(const std::string& username) {
 
 std::vector<User> DatabaseManager::getAllUsers() {
     std::vector<User> users;
+    if (remote_) {
+        remoteCall(RpcOp::GetAllUsers, users);
+        return users;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -252,6 +681,13 @@ std::vector<User> DatabaseManager::getAllUsers() {
 }
 
 bool DatabaseManager::deleteUser(int user_id) {
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::DeleteUser, ok, user_id);
+        if (ok) ++data_version_;
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -268,6 +704,7 @@ bool DatabaseManager::deleteUser(int user_id) {
         
         txn.exec_params("DELETE FROM users WHERE id = $1", user_id);
         txn.commit();
+        ++data_version_;
         return true;
     } catch (const std::exception& e) {
         last_error_ = std::string("Delete user error: ") + e.what();
@@ -276,6 +713,12 @@ bool DatabaseManager::deleteUser(int user_id) {
 }
 
 bool DatabaseManager::isAdmin(int user_id) {
+    if (remote_) {
+        bool admin = false;
+        remoteCall(RpcOp::IsAdmin, admin, user_id);
+        return admin;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -292,6 +735,12 @@ bool DatabaseManager::isAdmin(int user_id) {
 }
 
 int DatabaseManager::getUserGamesCount(int user_id) {
+    if (remote_) {
+        int count = 0;
+        remoteCall(RpcOp::GetUserGamesCount, count, user_id);
+        return count;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -307,7 +756,262 @@ int DatabaseManager::getUserGamesCount(int user_id) {
     }
 }
 
+bool DatabaseManager::getUserGamesCounts(const std::vector<int>& user_ids, std::vector<int>& counts) {
+    counts.assign(user_ids.size(), 0);
+    if (user_ids.empty()) {
+        return true;
+    }
+    
+    if (remote_) {
+        // Один вызов и один запрос GROUP BY на сервере, сколько бы ни было пользователей
+        std::vector<int> reply;
+        if (!remoteCall(RpcOp::GetUserGamesCounts, reply, user_ids)) {
+            return false;
+        }
+        if (reply.size() != counts.size()) {
+            last_error_ = "Get games count error: server returned " + std::to_string(reply.size()) +
+                          " counts for " + std::to_string(counts.size()) + " users";
+            return false;
+        }
+        counts = std::move(reply);
+        return true;
+    }
+    
+    try {
+        pqxx::work txn(*conn_);
+        
+        // Считаются только запрошенные пользователи (индекс по user_id)
+        pqxx::result r = txn.exec_params(
+            "SELECT user_id, COUNT(*) FROM games WHERE user_id = ANY($1::int[]) GROUP BY user_id",
+            user_ids
+        );
+        
+        std::map<int, int> byUser;
+        for (const auto& row : r) {
+            byUser[row[0].as<int>()] = row[1].as<int>();
+        }
+        for (size_t i = 0; i < user_ids.size(); ++i) {
+            auto found = byUser.find(user_ids[i]);
+            if (found != byUser.end()) {
+                counts[i] = found->second;
+            }
+        }
+        
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Get games count error: ") + e.what();
+        return false;
+    }
+}
+
+std::vector<MachineFitCount> DatabaseManager::getMachineFitCounts(const MachineProfile& profile) {
+    std::vector<MachineFitCount> counts;
+    if (remote_) {
+        remoteCall(RpcOp::GetMachineFitCounts, counts, profile);
+        return counts;
+    }
+    
+    try {
+        pqxx::work txn(*conn_);
+        
+        pqxx::result r = txn.exec_params(
+            "SELECT u.id, u.username, COUNT(g.id) FROM users u "
+            "LEFT JOIN games g ON g.user_id = u.id AND g.ram_usage <= $1 "
+            "AND g.vram_required <= $2 AND g.disk_space <= $3 "
+            "GROUP BY u.id, u.username ORDER BY u.username",
+            static_cast<double>(profile.ram), static_cast<double>(profile.vram),
+            static_cast<double>(profile.disk)
+        );
+        
+        for (const auto& row : r) {
+            MachineFitCount count;
+            count.user_id = row[0].as<int>();
+            count.username = row[1].as<std::string>();
+            count.games = row[2].as<int>();
+            counts.push_back(count);
+        }
+        
+        txn.commit();
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Machine fit counts error: ") + e.what();
+    }
+    
+    return counts;
+}
+
+bool DatabaseManager::loadAllUsersGames(CompactGameCollection& games) {
+    TraceSpan span("DatabaseManager::loadAllUsersGames", "db");
+    if (remote_) {
+        games.clear();
+        std::tuple<bool, CompactGameCollection&> reply(false, games);
+        remoteCall(RpcOp::LoadAllUsersGames, reply);
+        return std::get<0>(reply);
+    }
+    
+    try {
+        pqxx::work txn(*conn_);
+        
+        pqxx::result r = fetchGamesBinary(
+            txn, std::string("SELECT ") + GAME_COLUMNS + " FROM games ORDER BY user_id, name", pqxx::params()
+        );
+        
+        games.clear();
+        games.reserve(r.size());
+        for (const auto& row : r) {
+            games.append(readGameFields(row));
+        }
+        
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Load all games error: ") + e.what();
+        return false;
+    }
+}
+
+void DatabaseManager::lockNameSketch(pqxx::transaction_base& txn) {
+    // Блокировка до первого запроса: снимок берётся после неё, поэтому
+    // все обновления сводки видят журнал уже применённым.
+    // Запись в games (триггер пишет в game_name_changes) она не задерживает
+    txn.exec("LOCK TABLE game_name_sketch IN SHARE ROW EXCLUSIVE MODE");
+}
+
+void DatabaseManager::buildNameSketch(pqxx::transaction_base& txn, GameNameSketch& sketch) {
+    sketch.clear();
+    txn.exec("DECLARE names_scan NO SCROLL CURSOR FOR SELECT name FROM games");
+    while (true) {
+        pqxx::result r = txn.exec("FETCH 10000 FROM names_scan");
+        for (const auto& row : r) {
+            sketch.add(row[0].as<std::string>());
+        }
+        if (r.size() < 10000) break;
+    }
+    txn.exec("CLOSE names_scan");
+    
+    // Суммы журнала в том же снимке уже вошли в проход по games: они
+    // вычитаются из сохраняемой сводки, а не удаляются из журнала (строку
+    // могла изменить транзакция, зафиксированная после снимка). Следующее
+    // обновление прибавит журнал целиком, и каждое изменение будет учтено
+    // один раз. Вызывающему возвращается точная сводка по снимку
+    GameNameSketch stored = sketch;
+    pqxx::result changes = txn.exec("SELECT name, delta FROM game_name_changes");
+    for (const auto& row : changes) {
+        stored.add(row[0].as<std::string>(), -row[1].as<int64_t>());
+    }
+    
+    std::string data = stored.serialize();
+    txn.exec_params(
+        "INSERT INTO game_name_sketch (id, data, rebuilt_at, updated_at) "
+        "VALUES (1, $1, CURRENT_TIMESTAMP, CURRENT_TIMESTAMP) "
+        "ON CONFLICT (id) DO UPDATE SET data = EXCLUDED.data, "
+        "rebuilt_at = EXCLUDED.rebuilt_at, updated_at = EXCLUDED.updated_at",
+        std::basic_string<std::byte>(reinterpret_cast<const std::byte*>(data.data()), data.size())
+    );
+}
+
+bool DatabaseManager::refreshNameSketch(GameNameSketch& sketch, std::string* rebuilt_at) {
+    TraceSpan span("DatabaseManager::refreshNameSketch", "db");
+    if (remote_) {
+        // Сводку ведёт сервер, клиенту приходит её копия
+        std::tuple<bool, std::string, std::string> reply;
+        remoteCall(RpcOp::RefreshNameSketch, reply);
+        if (!std::get<0>(reply)) {
+            return false;
+        }
+        if (!sketch.deserialize(std::get<1>(reply))) {
+            last_error_ = "Refresh name sketch error: malformed sketch from server";
+            return false;
+        }
+        if (rebuilt_at) {
+            *rebuilt_at = std::get<2>(reply);
+        }
+        return true;
+    }
+    
+    auto readRebuiltAt = [rebuilt_at](pqxx::transaction_base& txn) {
+        if (rebuilt_at) {
+            pqxx::result time = txn.exec("SELECT to_char(rebuilt_at, 'DD.MM.YYYY HH24:MI') FROM game_name_sketch WHERE id = 1");
+            *rebuilt_at = time.empty() ? "" : time[0][0].as<std::string>();
+        }
+    };
+    
+    try {
+        {
+            pqxx::work txn(*conn_);
+            // Одновременное обновление из другого окна ждёт здесь
+            lockNameSketch(txn);
+            
+            pqxx::result r = txn.exec("SELECT data FROM game_name_sketch WHERE id = 1");
+            bool loaded = false;
+            if (!r.empty()) {
+                auto bytes = r[0][0].as<std::basic_string<std::byte>>();
+                loaded = sketch.deserialize(std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+            }
+            
+            if (loaded) {
+                // Только накопленная дельта вместо полного прохода по games.
+                // Строки забираются из журнала в READ COMMITTED: строка,
+                // которую триггер меняет одновременно, удаляется с последней
+                // суммой, а вставленная после удаления применится в следующий раз
+                pqxx::result changes = txn.exec("DELETE FROM game_name_changes RETURNING name, delta");
+                for (const auto& row : changes) {
+                    sketch.add(row[0].as<std::string>(), row[1].as<int64_t>());
+                }
+                
+                if (!changes.empty()) {
+                    std::string data = sketch.serialize();
+                    txn.exec_params(
+                        "UPDATE game_name_sketch SET data = $1, updated_at = CURRENT_TIMESTAMP WHERE id = 1",
+                        std::basic_string<std::byte>(reinterpret_cast<const std::byte*>(data.data()), data.size())
+                    );
+                }
+                
+                readRebuiltAt(txn);
+                txn.commit();
+                return true;
+            }
+        }
+        
+        // Сводки ещё нет: полный проход по games в одном снимке
+        pqxx::transaction<pqxx::isolation_level::repeatable_read> txn(*conn_);
+        lockNameSketch(txn);
+        buildNameSketch(txn, sketch);
+        readRebuiltAt(txn);
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Refresh name sketch error: ") + e.what();
+        return false;
+    }
+}
+
+bool DatabaseManager::rebuildNameSketch(GameNameSketch& sketch) {
+    if (remote_) {
+        last_error_ = "Rebuild name sketch error: not available through temporium-server";
+        return false;
+    }
+    
+    try {
+        pqxx::transaction<pqxx::isolation_level::repeatable_read> txn(*conn_);
+        lockNameSketch(txn);
+        buildNameSketch(txn, sketch);
+        txn.commit();
+        return true;
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Rebuild name sketch error: ") + e.what();
+        return false;
+    }
+}
+
 bool DatabaseManager::changeUsername(int user_id, const std::string& new_username, const std::string& current_password) {
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::ChangeUsername, ok, user_id, new_username, current_password);
+        if (ok) ++data_version_;
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -355,6 +1059,13 @@ bool DatabaseManager::changeUsername(int user_id, const std::string& new_usernam
 }
 
 bool DatabaseManager::changePassword(int user_id, const std::string& new_password_hash) {
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::ChangePassword, ok, user_id, new_password_hash);
+        if (ok) ++data_version_;
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -372,6 +1083,13 @@ bool DatabaseManager::changePassword(int user_id, const std::string& new_passwor
 }
 
 bool DatabaseManager::resetAdminCredentials() {
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::ResetAdminCredentials, ok);
+        if (ok) ++data_version_;
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -390,19 +1108,38 @@ bool DatabaseManager::resetAdminCredentials() {
     }
 }
 
-bool DatabaseManager::addGame(const Game& game) {
+bool DatabaseManager::addGame(const Game& game, int* new_id) {
+    TraceSpan span("DatabaseManager::addGame", "db");
+    if (remote_) {
+        std::tuple<bool, int> reply(false, 0);
+        remoteCall(RpcOp::AddGame, reply, game);
+        if (!std::get<0>(reply)) {
+            return false;
+        }
+        ++data_version_;
+        if (new_id) {
+            *new_id = std::get<1>(reply);
+        }
+        return true;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
-        txn.exec_params(
+        pqxx::result r = txn.exec_params(
             "INSERT INTO games (name, disk_space, ram_usage, vram_required, genre, completed, url, user_id, rating, is_favorite, is_installed, notes, tags) "
-            "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13)",
+            "VALUES ($1, $2, $3, $4, $5, $6, $7, $8, $9, $10, $11, $12, $13) RETURNING id",
             game.name, game.disk_space, game.ram_usage, game.vram_required,
             game.genre, game.completed, game.url, game.user_id,
-            game.rating, game.is_favorite, game.is_installed, game.notes, game.tags
+            game.rating, game.is_favorite, game.is_installed, game.notes,
+            TagDictionary::canonical(game.tags)
         );
         
         txn.commit();
+        ++data_version_;
+        if (new_id) {
+            *new_id = r[0][0].as<int>();
+        }
         return true;
     } catch (const std::exception& e) {
         last_error_ = std::string("Add game error: ") + e.what();
@@ -411,6 +1148,14 @@ bool DatabaseManager::addGame(const Game& game) {
 }
 
 bool DatabaseManager::updateGame(const Game& game) {
+    TraceSpan span("DatabaseManager::updateGame", "db");
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::UpdateGame, ok, game);
+        if (ok) ++data_version_;
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -421,11 +1166,12 @@ bool DatabaseManager::updateGame(const Game& game) {
             "WHERE id = $13 AND user_id = $14",
             game.name, game.disk_space, game.ram_usage, game.vram_required,
             game.genre, game.completed, game.url,
-            game.rating, game.is_favorite, game.is_installed, game.notes, game.tags,
-            game.id, game.user_id
+            game.rating, game.is_favorite, game.is_installed, game.notes,
+            TagDictionary::canonical(game.tags), game.id, game.user_id
         );
         
         txn.commit();
+        ++data_version_;
         return true;
     } catch (const std::exception& e) {
         last_error_ = std::string("Update game error: ") + e.what();
@@ -434,6 +1180,14 @@ bool DatabaseManager::updateGame(const Game& game) {
 }
 
 bool DatabaseManager::deleteGame(int game_id, int user_id) {
+    TraceSpan span("DatabaseManager::deleteGame", "db");
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::DeleteGame, ok, game_id, user_id);
+        if (ok) ++data_version_;
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -443,6 +1197,7 @@ bool DatabaseManager::deleteGame(int game_id, int user_id) {
         );
         
         txn.commit();
+        ++data_version_;
         return true;
     } catch (const std::exception& e) {
         last_error_ = std::string("Delete game error: ") + e.what();
@@ -451,6 +1206,14 @@ bool DatabaseManager::deleteGame(int game_id, int user_id) {
 }
 
 bool DatabaseManager::deleteGameByName(const std::string& name, int user_id) {
+    TraceSpan span("DatabaseManager::deleteGameByName", "db");
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::DeleteGameByName, ok, name, user_id);
+        if (ok) ++data_version_;
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -460,6 +1223,7 @@ bool DatabaseManager::deleteGameByName(const std::string& name, int user_id) {
         );
         
         txn.commit();
+        ++data_version_;
         return true;
     } catch (const std::exception& e) {
         last_error_ = std::string("Delete game by name error: ") + e.what();
@@ -467,39 +1231,56 @@ bool DatabaseManager::deleteGameByName(const std::string& name, int user_id) {
     }
 }
 
+Game DatabaseManager::readGameRowBinary(const pqxx::row& row) {
+    return gameFromFields(readGameFields(row));
+}
+
+GameFields DatabaseManager::readGameFields(const pqxx::row& row) {
+    GameFields fields;
+    fields.id = PgBinary::int4(row[COL_ID]);
+    fields.name = PgBinary::text(row[COL_NAME]);
+    fields.disk_space = PgBinary::float8(row[COL_DISK_SPACE]);
+    fields.ram_usage = PgBinary::float8(row[COL_RAM_USAGE]);
+    fields.vram_required = PgBinary::float8(row[COL_VRAM_REQUIRED]);
+    fields.genre = PgBinary::text(row[COL_GENRE]);
+    fields.completed = !row[COL_COMPLETED].is_null() && PgBinary::boolean(row[COL_COMPLETED]);
+    fields.url = row[COL_URL].is_null() ? std::string_view() : PgBinary::text(row[COL_URL]);
+    fields.user_id = row[COL_USER_ID].is_null() ? 0 : PgBinary::int4(row[COL_USER_ID]);
+    fields.rating = row[COL_RATING].is_null() ? -1 : PgBinary::int4(row[COL_RATING]);
+    fields.is_favorite = !row[COL_IS_FAVORITE].is_null() && PgBinary::boolean(row[COL_IS_FAVORITE]);
+    fields.is_installed = !row[COL_IS_INSTALLED].is_null() && PgBinary::boolean(row[COL_IS_INSTALLED]);
+    fields.notes = row[COL_NOTES].is_null() ? std::string_view() : PgBinary::text(row[COL_NOTES]);
+    fields.tags = row[COL_TAGS].is_null() ? std::string_view() : PgBinary::text(row[COL_TAGS]);
+    return fields;
+}
+
 std::vector<Game> DatabaseManager::getAllGames(int user_id) {
     std::vector<Game> games;
+    cancelled_ = false;
     
+    if (remote_) {
+        remoteCall(RpcOp::GetAllGames, games, user_id);
+        return games;
+    }
+    
+    CancelRequestReset resetCancel(cancel_requested_);
     try {
-        pqxx::work txn(*conn_);
-        
-        pqxx::result r = txn.exec_params(
-            "SELECT id, name, disk_space, ram_usage, vram_required, genre, completed, url, user_id, "
-            "rating, is_favorite, is_installed, notes, tags "
-            "FROM games WHERE user_id = $1 ORDER BY name",
-            user_id
+        pqxx::work txn(*conn_);
+        
+        pqxx::params params;
+        params.append(user_id);
+        pqxx::result r = fetchGamesBinary(
+            txn, std::string("SELECT ") + GAME_COLUMNS + " FROM games WHERE user_id = $1 ORDER BY name", params
         );
         
+        games.reserve(r.size());
         for (const auto& row : r) {
-            Game game;
-            game.id = row["id"].as<int>();
-            game.name = row["name"].as<std::string>();
-            game.disk_space = row["disk_space"].as<double>();
-            game.ram_usage = row["ram_usage"].as<double>();
-            game.vram_required = row["vram_required"].as<double>();
-            game.genre = row["genre"].as<std::string>();
-            game.completed = row["completed"].as<bool>();
-            game.url = row["url"].is_null() ? "" : row["url"].as<std::string>();
-            game.user_id = row["user_id"].as<int>();
-            game.rating = row["rating"].is_null() ? -1 : row["rating"].as<int>();
-            game.is_favorite = row["is_favorite"].is_null() ? false : row["is_favorite"].as<bool>();
-            game.is_installed = row["is_installed"].is_null() ? false : row["is_installed"].as<bool>();
-            game.notes = row["notes"].is_null() ? "" : row["notes"].as<std::string>();
-            game.tags = row["tags"].is_null() ? "" : row["tags"].as<std::string>();
-            games.push_back(game);
+            games.push_back(readGameRowBinary(row));
         }
         
         txn.commit();
+    } catch (const pqxx::query_canceled& e) {
+        reportCanceled("Get all games", e);
     } catch (const std::exception& e) {
         last_error_ = std::string("Get all games error: ") + e.what();
     }
@@ -507,116 +1288,192 @@ std::vector<Game> DatabaseManager::getAllGames(int user_id) {
     return games;
 }
 
-std::string DatabaseManager::buildFilterCondition(const GameFilter& filter, int user_id) {
-    std::stringstream ss;
-    ss << "user_id = " << user_id;
-    
-    if (filter.filter_completed) {
-        ss << " AND completed = " << (filter.completed_value ? "TRUE" : "FALSE");
-    }
-    
-    if (filter.filter_genre && !filter.genre_value.empty()) {
-        ss << " AND genre = '" << conn_->esc(filter.genre_value) << "'";
-    }
-    
-    if (filter.filter_disk_space_min) {
-        ss << " AND disk_space >= " << filter.disk_space_min;
-    }
-    
-    if (filter.filter_disk_space_max) {
-        ss << " AND disk_space <= " << filter.disk_space_max;
-    }
-    
-    if (filter.filter_ram_min) {
-        ss << " AND ram_usage >= " << filter.ram_min;
-    }
-    
-    if (filter.filter_ram_max) {
-        ss << " AND ram_usage <= " << filter.ram_max;
-    }
-    
-    if (filter.filter_vram_min) {
-        ss << " AND vram_required >= " << filter.vram_min;
-    }
+std::string DatabaseManager::buildFilterCondition(const GameFilter* filter,
+                                                  const FilterExpression* expression,
+                                                  int user_id, pqxx::params& params) {
+    TraceSpan span("DatabaseManager::buildFilterCondition", "db");
+    params.append(user_id);
+    std::string condition = "user_id = $1";
     
-    if (filter.filter_vram_max) {
-        ss << " AND vram_required <= " << filter.vram_max;
+    // Значения передаются параметрами, а не вставляются в текст запроса
+    std::vector<CompiledFilter::SqlParam> values;
+    std::string filterCondition;
+    if (filter) {
+        filterCondition = CompiledFilter::compile(*filter).sqlCondition(2, values);
+    } else if (expression) {
+        filterCondition = expression->sqlCondition(2, values);
     }
-    
-    if (filter.filter_tag && !filter.tag_value.empty()) {
-        ss << " AND (tags LIKE '%" << conn_->esc(filter.tag_value) << "%')";
-    }
-    
-    if (filter.filter_favorite) {
-        ss << " AND is_favorite = " << (filter.favorite_value ? "TRUE" : "FALSE");
-    }
-    
-    if (filter.filter_installed) {
-        ss << " AND is_installed = " << (filter.installed_value ? "TRUE" : "FALSE");
+    for (const auto& value : values) {
+        switch (value.type) {
+            case CompiledFilter::SqlParam::Type::Bool:   params.append(value.bool_value); break;
+            case CompiledFilter::SqlParam::Type::Int:    params.append(value.int_value); break;
+            case CompiledFilter::SqlParam::Type::Double: params.append(value.double_value); break;
+            case CompiledFilter::SqlParam::Type::Text:   params.append(value.text_value); break;
+        }
     }
     
-    if (filter.filter_rating_min) {
-        ss << " AND rating >= " << filter.rating_min;
+    if (!filterCondition.empty()) {
+        condition += " AND " + filterCondition;
     }
+    return condition;
+}
+
+std::vector<Game> DatabaseManager::getFilteredGames(int user_id, const GameFilter& filter) {
+    return selectGames(user_id, &filter, nullptr);
+}
+
+std::vector<Game> DatabaseManager::getFilteredGames(int user_id, const FilterExpression& expression) {
+    return selectGames(user_id, nullptr, &expression);
+}
+
+std::vector<Game> DatabaseManager::selectGames(int user_id, const GameFilter* filter,
+                                               const FilterExpression* expression) {
+    TraceSpan span("DatabaseManager::selectGames", "db");
+    std::vector<Game> games;
+    cancelled_ = false;
     
-    if (filter.filter_rating_max) {
-        ss << " AND rating <= " << filter.rating_max << " AND rating >= 0";
+    if (remote_) {
+        if (expression) {
+            remoteCall(RpcOp::GetFilteredGamesExpression, games, user_id, *expression);
+        } else {
+            remoteCall(RpcOp::GetFilteredGames, games, user_id, filter ? *filter : GameFilter());
+        }
+        return games;
     }
     
-    if (filter.filter_has_rating) {
-        if (filter.has_rating_value) {
-            ss << " AND rating >= 0";  
-        } else {
-            ss << " AND rating = -1";  
+    CancelRequestReset resetCancel(cancel_requested_);
+    try {
+        pqxx::work txn(*conn_);
+        
+        pqxx::params params;
+        std::string query = std::string("SELECT ") + GAME_COLUMNS +
+            " FROM games WHERE " + buildFilterCondition(filter, expression, user_id, params) + " ORDER BY name";
+        
+        pqxx::result r;
+        {
+            TraceSpan query_span("postgres: SELECT games", "db");
+            r = fetchGamesBinary(txn, query, params);
+        }
+        
+        {
+            TraceSpan decode_span("decode rows", "db");
+            decode_span.setValue("rows", static_cast<int64_t>(r.size()));
+            games.reserve(r.size());
+            for (const auto& row : r) {
+                games.push_back(readGameRowBinary(row));
+            }
         }
+        
+        txn.commit();
+    } catch (const pqxx::query_canceled& e) {
+        reportCanceled("Get filtered games", e);
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Get filtered games error: ") + e.what();
     }
     
-    return ss.str();
+    return games;
 }
 
-std::vector<Game> DatabaseManager::getFilteredGames(int user_id, const GameFilter& filter) {
-    std::vector<Game> games;
+bool DatabaseManager::streamGames(int user_id, const GameFilter* filter,
+                                  const FilterExpression* expression,
+                                  size_t first_chunk, size_t chunk_size,
+                                  const GameChunkCallback& callback) {
+    TraceSpan span("DatabaseManager::streamGames", "db");
+    cancelled_ = false;
+    if (remote_) {
+        // Порции приходят отдельными кадрами по мере выборки на сервере
+        remote_->begin();
+        remote_->add(RpcOp::StreamGames, user_id, filter, expression,
+                     static_cast<uint64_t>(first_chunk), static_cast<uint64_t>(chunk_size));
+        bool malformed = false;
+        bool sent = remote_->callStream([&](RpcReader& in) {
+            CompactGameCollection chunk;
+            in >> chunk;
+            if (!in.ok()) {
+                malformed = true;
+                return false;
+            }
+            return callback(std::move(chunk));
+        });
+        if (!sent) {
+            cancelled_ = cancel_requested_.exchange(false);
+            last_error_ = cancelled_ ? "Stream games cancelled" : remote_->lastError();
+            return false;
+        }
+        bool ok = false;
+        remoteReply(ok);
+        if (malformed) {
+            last_error_ = "Stream games error: malformed chunk from server";
+            return false;
+        }
+        return ok;
+    }
     
+    CancelRequestReset resetCancel(cancel_requested_);
     try {
         pqxx::work txn(*conn_);
         
-        std::string query = 
-            "SELECT id, name, disk_space, ram_usage, vram_required, genre, completed, url, user_id, "
-            "rating, is_favorite, is_installed, notes, tags "
-            "FROM games WHERE " + buildFilterCondition(filter, user_id) + " ORDER BY name";
+        pqxx::params params;
+        std::string condition = buildFilterCondition(filter, expression, user_id, params);
         
-        pqxx::result r = txn.exec(query);
+        // Серверный курсор живёт до конца транзакции; порции приходят
+        // в двоичном формате
+        txn.exec_params(
+            "DECLARE games_stream BINARY NO SCROLL CURSOR FOR "
+            "SELECT " + std::string(GAME_COLUMNS) + " FROM games WHERE " + condition + " ORDER BY name",
+            params
+        );
         
-        for (const auto& row : r) {
-            Game game;
-            game.id = row["id"].as<int>();
-            game.name = row["name"].as<std::string>();
-            game.disk_space = row["disk_space"].as<double>();
-            game.ram_usage = row["ram_usage"].as<double>();
-            game.vram_required = row["vram_required"].as<double>();
-            game.genre = row["genre"].as<std::string>();
-            game.completed = row["completed"].as<bool>();
-            game.url = row["url"].is_null() ? "" : row["url"].as<std::string>();
-            game.user_id = row["user_id"].as<int>();
-            game.rating = row["rating"].is_null() ? -1 : row["rating"].as<int>();
-            game.is_favorite = row["is_favorite"].is_null() ? false : row["is_favorite"].as<bool>();
-            game.is_installed = row["is_installed"].is_null() ? false : row["is_installed"].as<bool>();
-            game.notes = row["notes"].is_null() ? "" : row["notes"].as<std::string>();
-            game.tags = row["tags"].is_null() ? "" : row["tags"].as<std::string>();
-            games.push_back(game);
+        size_t fetch_size = std::max<size_t>(first_chunk, 1);
+        while (true) {
+            pqxx::result r;
+            {
+                TraceSpan fetch_span("postgres: FETCH games_stream", "db");
+                r = txn.exec("FETCH " + std::to_string(fetch_size) + " FROM games_stream");
+            }
+            checkGameColumns(r);
+            
+            CompactGameCollection chunk;
+            {
+                TraceSpan decode_span("decode rows", "db");
+                decode_span.setValue("rows", static_cast<int64_t>(r.size()));
+                chunk.reserve(r.size());
+                for (const auto& row : r) {
+                    chunk.append(readGameFields(row));
+                }
+            }
+            
+            bool last = static_cast<size_t>(r.size()) < fetch_size;
+            if (!chunk.empty() && !callback(std::move(chunk))) {
+                break;  // Загрузка отменена
+            }
+            if (last) {
+                break;
+            }
+            
+            fetch_size = std::max<size_t>(chunk_size, 1);
         }
         
+        txn.exec("CLOSE games_stream");
         txn.commit();
+        return true;
+    } catch (const pqxx::query_canceled& e) {
+        reportCanceled("Stream games", e);
+        return false;
     } catch (const std::exception& e) {
-        last_error_ = std::string("Get filtered games error: ") + e.what();
+        last_error_ = std::string("Stream games error: ") + e.what();
+        return false;
     }
-    
-    return games;
 }
 
 Game DatabaseManager::getGameById(int game_id, int user_id) {
     Game game;
     
+    if (remote_) {
+        remoteCall(RpcOp::GetGameById, game, game_id, user_id);
+        return game;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -655,6 +1512,11 @@ Game DatabaseManager::getGameById(int game_id, int user_id) {
 Game DatabaseManager::getGameByName(const std::string& name, int user_id) {
     Game game;
     
+    if (remote_) {
+        remoteCall(RpcOp::GetGameByName, game, name, user_id);
+        return game;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -690,64 +1552,62 @@ Game DatabaseManager::getGameByName(const std::string& name, int user_id) {
     return game;
 }
 
-bool DatabaseManager::writeGamesToFile(const std::string& filename, const std::vector<Game>& games) {
+bool DatabaseManager::writeGamesToFile(const std::string& filename, const CompactGameCollection& games) {
+    TraceSpan span("DatabaseManager::writeGamesToFile", "file");
     try {
-        std::vector<BinaryGameRecord> records;
-        records.reserve(games.size());
-        
-        for (const auto& game : games) {
-            BinaryGameRecord record;
-            std::memset(&record, 0, sizeof(record));
+        ExportWriter writer(filename);
+        if (!writer.open(sizeof(BinaryFileHeader))) {
+            last_error_ = writer.lastError();
+            return false;
+        }
+        span.setValue("io_uring", std::strcmp(writer.backendName(), "io_uring") == 0 ? 1 : 0);
+        
+        // Записи кодируются порциями прямо в буферы записи: пока одна
+        // порция пишется на диск, следующая кодируется и хэшируется.
+        // Хэш в заголовке известен только в конце — заголовок пишется последним
+        const size_t per_buffer = ExportWriter::BUFFER_SIZE / sizeof(BinaryGameRecord);
+        HashUtils::Sha256 hash;
+        for (size_t first = 0; first < games.size(); first += per_buffer) {
+            size_t count = std::min(per_buffer, games.size() - first);
+            char* buffer = writer.buffer();
+            if (!buffer) {
+                last_error_ = writer.lastError();
+                return false;
+            }
             
-            record.id = game.id;
-            std::strncpy(record.name, game.name.c_str(), sizeof(record.name) - 1);
-            record.disk_space = game.disk_space;
-            record.ram_usage = game.ram_usage;
-            record.vram_required = game.vram_required;
-            std::strncpy(record.genre, game.genre.c_str(), sizeof(record.genre) - 1);
-            record.completed = game.completed ? 1 : 0;
-            std::strncpy(record.url, game.url.c_str(), sizeof(record.url) - 1);
-            record.user_id = game.user_id;
-            record.rating = game.rating;
-            record.is_favorite = game.is_favorite ? 1 : 0;
-            record.is_installed = game.is_installed ? 1 : 0;
-            std::strncpy(record.notes, game.notes.c_str(), sizeof(record.notes) - 1);
-            std::strncpy(record.tags, game.tags.c_str(), sizeof(record.tags) - 1);
+            auto* records = reinterpret_cast<BinaryGameRecord*>(buffer);
+            {
+                TraceSpan encode_span("encode records", "file");
+                encode_span.setValue("records", static_cast<int64_t>(count));
+                parallelFor(0, count, EXPORT_RECORDS_PER_TASK, [&games, records, first](size_t lo, size_t hi) {
+                    std::string tags;
+                    for (size_t i = lo; i < hi; ++i) {
+                        encodeRecord(games.fields(first + i, tags), records[i]);
+                    }
+                }, TaskPriority::Background);
+            }
             
-            records.push_back(record);
-        }
-        
-        std::string hash;
-        if (!records.empty()) {
-            hash = HashUtils::sha256(
-                reinterpret_cast<const char*>(records.data()), 
-                records.size() * sizeof(BinaryGameRecord)
-            );
-        } else {
-            hash = HashUtils::sha256("", 0);
+            size_t bytes = count * sizeof(BinaryGameRecord);
+            hash.update(buffer, bytes);
+            if (!writer.write(bytes)) {
+                last_error_ = writer.lastError();
+                return false;
+            }
         }
         
+        std::string digest = hash.hex();
         BinaryFileHeader header;
         header.magic = FILE_MAGIC;
         header.version = FILE_VERSION;
         header.record_count = static_cast<uint32_t>(games.size());
         std::memset(header.hash, 0, sizeof(header.hash));
-        std::memcpy(header.hash, hash.c_str(), std::min(hash.length(), sizeof(header.hash)));
+        std::memcpy(header.hash, digest.c_str(), std::min(digest.length(), sizeof(header.hash)));
         
-        std::ofstream file(filename, std::ios::binary);
-        if (!file.is_open()) {
-            last_error_ = "Cannot open file for writing: " + filename;
+        TraceSpan commit_span("fsync and rename", "file");
+        if (!writer.commit(&header, sizeof(header))) {
+            last_error_ = writer.lastError();
             return false;
         }
-        
-        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
-        
-        if (!records.empty()) {
-            file.write(reinterpret_cast<const char*>(records.data()), 
-                       records.size() * sizeof(BinaryGameRecord));
-        }
-        
-        file.close();
         return true;
     } catch (const std::exception& e) {
         last_error_ = std::string("Write file error: ") + e.what();
@@ -755,18 +1615,36 @@ bool DatabaseManager::writeGamesToFile(const std::string& filename, const std::v
     }
 }
 
+bool DatabaseManager::exportGames(const std::string& filename, int user_id, const GameFilter* filter,
+                                  const FilterExpression* expression) {
+    // Выборка порциями в компактную коллекцию: строки копируются в арены
+    // загрузки, без std::string на поле; ошибка выборки не даёт записать
+    // пустой файл вместо старого
+    CompactGameCollection games;
+    bool ok = streamGames(user_id, filter, expression, EXPORT_FETCH_ROWS, EXPORT_FETCH_ROWS,
+                          [&games](CompactGameCollection&& chunk) {
+                              games.append(std::move(chunk));
+                              return true;
+                          });
+    return ok && writeGamesToFile(filename, games);
+}
+
 bool DatabaseManager::exportToBinaryFile(const std::string& filename, int user_id) {
-    std::vector<Game> games = getAllGames(user_id);
-    return writeGamesToFile(filename, games);
+    return exportGames(filename, user_id, nullptr, nullptr);
 }
 
 bool DatabaseManager::exportFilteredToBinaryFile(const std::string& filename, int user_id,
                                                   const GameFilter& filter) {
-    std::vector<Game> games = getFilteredGames(user_id, filter);
-    return writeGamesToFile(filename, games);
+    return exportGames(filename, user_id, &filter, nullptr);
+}
+
+bool DatabaseManager::exportFilteredToBinaryFile(const std::string& filename, int user_id,
+                                                  const FilterExpression& expression) {
+    return exportGames(filename, user_id, nullptr, &expression);
 }
 
 FileVerificationResult DatabaseManager::verifyBinaryFile(const std::string& filename) {
+    TraceSpan span("DatabaseManager::verifyBinaryFile", "file");
     try {
         std::ifstream file(filename, std::ios::binary);
         if (!file.is_open()) {
@@ -845,40 +1723,52 @@ std::string DatabaseManager::getVerificationErrorText(FileVerificationResult res
 }
 
 bool DatabaseManager::importFromBinaryFile(const std::string& filename, int user_id) {
-    FileVerificationResult verification = verifyBinaryFile(filename);
+    FileVerificationResult verification;
+    std::vector<Game> games = readBinaryFile(filename, &verification);
     if (verification != FileVerificationResult::OK) {
         last_error_ = getVerificationErrorText(verification);
         return false;
     }
     
-    try {
-        std::ifstream file(filename, std::ios::binary);
-        if (!file.is_open()) {
-            last_error_ = "Cannot open file for reading: " + filename;
+    return importGames(games, user_id);
+}
+
+bool DatabaseManager::importGames(const std::vector<Game>& games, int user_id, size_t* inserted) {
+    TraceSpan span("DatabaseManager::importGames", "db");
+    if (remote_) {
+        std::tuple<bool, uint64_t> reply(false, 0);
+        remoteCall(RpcOp::ImportGames, reply, games, user_id);
+        if (!std::get<0>(reply)) {
             return false;
         }
+        ++data_version_;
+        if (inserted) {
+            *inserted = static_cast<size_t>(std::get<1>(reply));
+        }
+        return true;
+    }
+    
+    try {
+        pqxx::work txn(*conn_);
         
-        BinaryFileHeader header;
-        file.read(reinterpret_cast<char*>(&header), sizeof(header));
-        
-        for (uint32_t i = 0; i < header.record_count; ++i) {
-            BinaryGameRecord record;
-            file.read(reinterpret_cast<char*>(&record), sizeof(record));
-            
-            Game game;
-            game.name = record.name;
-            game.disk_space = record.disk_space;
-            game.ram_usage = record.ram_usage;
-            game.vram_required = record.vram_required;
-            game.genre = record.genre;
-            game.completed = record.completed != 0;
-            game.url = record.url;
-            game.user_id = user_id;
-            
-            addGame(game);
+        // Совпадение названия не прерывает импорт исключением на каждой строке:
+        // такие записи пропускаются по ограничению UNIQUE(name, user_id)
+        size_t count = 0;
+        for (const auto& game : games) {
+            pqxx::result r = txn.exec_params(
+                "INSERT INTO games (name, disk_space, ram_usage, vram_required, genre, completed, url, user_id) "
+                "VALUES ($1, $2, $3, $4, $5, $6, $7, $8) ON CONFLICT (name, user_id) DO NOTHING",
+                game.name, game.disk_space, game.ram_usage, game.vram_required,
+                game.genre, game.completed, game.url, user_id
+            );
+            count += static_cast<size_t>(r.affected_rows());
         }
         
-        file.close();
+        txn.commit();
+        ++data_version_;
+        if (inserted) {
+            *inserted = count;
+        }
         return true;
     } catch (const std::exception& e) {
         last_error_ = std::string("Import error: ") + e.what();
@@ -886,58 +1776,126 @@ bool DatabaseManager::importFromBinaryFile(const std::string& filename, int user
     }
 }
 
-std::vector<Game> DatabaseManager::readBinaryFile(const std::string& filename) {
+std::vector<std::string> DatabaseManager::getGameNames(int user_id) {
+    std::vector<std::string> names;
+    
+    if (remote_) {
+        remoteCall(RpcOp::GetGameNames, names, user_id);
+        return names;
+    }
+    
+    try {
+        pqxx::work txn(*conn_);
+        
+        pqxx::result r = txn.exec_params("SELECT name FROM games WHERE user_id = $1", user_id);
+        names.reserve(r.size());
+        for (const auto& row : r) {
+            names.push_back(row[0].as<std::string>());
+        }
+        
+        txn.commit();
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Get game names error: ") + e.what();
+    }
+    
+    return names;
+}
+
+std::vector<Game> DatabaseManager::readBinaryFile(const std::string& filename,
+                                                  FileVerificationResult* verification) {
+    TraceSpan span("DatabaseManager::readBinaryFile", "file");
     std::vector<Game> games;
     
     try {
         std::ifstream file(filename, std::ios::binary);
         if (!file.is_open()) {
             last_error_ = "Cannot open file for reading: " + filename;
+            if (verification) *verification = FileVerificationResult::FILE_NOT_FOUND;
             return games;
         }
         
         BinaryFileHeader header;
         file.read(reinterpret_cast<char*>(&header), sizeof(header));
         
+        if (!file.good()) {
+            last_error_ = "Cannot read file header";
+            if (verification) *verification = FileVerificationResult::READ_ERROR;
+            return games;
+        }
+        
         if (header.magic != FILE_MAGIC) {
             last_error_ = "Invalid file format";
+            if (verification) *verification = FileVerificationResult::INVALID_MAGIC;
             file.close();
             return games;
         }
         
-        for (uint32_t i = 0; i < header.record_count; ++i) {
-            BinaryGameRecord record;
-            file.read(reinterpret_cast<char*>(&record), sizeof(record));
-            
-            Game game;
-            game.id = record.id;
-            game.name = record.name;
-            game.disk_space = record.disk_space;
-            game.ram_usage = record.ram_usage;
-            game.vram_required = record.vram_required;
-            game.genre = record.genre;
-            game.completed = record.completed != 0;
-            game.url = record.url;
-            game.user_id = record.user_id;
-            game.rating = record.rating;
-            game.is_favorite = record.is_favorite != 0;
-            game.is_installed = record.is_installed != 0;
-            game.notes = record.notes;
-            game.tags = record.tags;
-            
-            games.push_back(game);
+        if (verification && header.version != FILE_VERSION && header.version != 1) {
+            *verification = FileVerificationResult::INVALID_VERSION;
+            return games;
         }
         
+        // Размер по файлу, а не по заголовку (он может быть повреждён)
+        std::streampos dataStart = file.tellg();
+        file.seekg(0, std::ios::end);
+        size_t recordsInFile = static_cast<size_t>(file.tellg() - dataStart) / sizeof(BinaryGameRecord);
+        file.seekg(dataStart);
+        
+        std::vector<BinaryGameRecord> records(std::min<size_t>(header.record_count, recordsInFile));
+        if (!records.empty()) {
+            file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(BinaryGameRecord));
+        }
         file.close();
+        
+        // Контрольная сумма считается одной задачей одновременно с разбором записей
+        TaskGroup hashing(TaskPriority::Background);
+        std::string calculatedHash;
+        bool complete = records.size() == header.record_count;
+        if (verification && complete) {
+            hashing.run([&records, &calculatedHash]() {
+                TraceSpan hash_span("sha256", "file");
+                calculatedHash = HashUtils::sha256(reinterpret_cast<const char*>(records.data()),
+                                                   records.size() * sizeof(BinaryGameRecord));
+            });
+        }
+        
+        {
+            TraceSpan decode_span("decode records", "file");
+            decode_span.setValue("records", static_cast<int64_t>(records.size()));
+            games.resize(records.size());
+            parallelFor(0, records.size(), RECORDS_PER_TASK, [&records, &games](size_t lo, size_t hi) {
+                for (size_t i = lo; i < hi; ++i) {
+                    decodeRecord(records[i], games[i]);
+                }
+            }, TaskPriority::Background);
+        }
+        hashing.wait();
+        
+        if (verification) {
+            if (!complete) {
+                *verification = FileVerificationResult::READ_ERROR;
+            } else if (calculatedHash != std::string(header.hash, sizeof(header.hash))) {
+                *verification = FileVerificationResult::HASH_MISMATCH;
+            } else {
+                *verification = FileVerificationResult::OK;
+            }
+        }
     } catch (const std::exception& e) {
         last_error_ = std::string("Read binary file error: ") + e.what();
+        if (verification) *verification = FileVerificationResult::READ_ERROR;
     }
     
     return games;
 }
 
 std::vector<std::string> DatabaseManager::getUserTags(int user_id) {
+    TraceSpan span("DatabaseManager::getUserTags", "db");
     std::vector<std::string> tags;
+    if (remote_) {
+        remoteCall(RpcOp::GetUserTags, tags, user_id);
+        return tags;
+    }
+    
     std::set<std::string> uniqueTags;
     
     try {
@@ -973,7 +1931,47 @@ std::vector<std::string> DatabaseManager::getUserTags(int user_id) {
     return tags;
 }
 
+std::map<std::string, int> DatabaseManager::getUserTagCounts(int user_id) {
+    TraceSpan span("DatabaseManager::getUserTagCounts", "db");
+    std::map<std::string, int> counts;
+    
+    if (remote_) {
+        remoteCall(RpcOp::GetUserTagCounts, counts, user_id);
+        return counts;
+    }
+    
+    try {
+        pqxx::nontransaction txn(*conn_);
+        
+        // Разбиение по запятой и обрезка пробелов — как в getUserTags
+        pqxx::result r = txn.exec_params(
+            "SELECT tag, COUNT(*) FROM ("
+            "    SELECT btrim(t, E' \\t') AS tag"
+            "    FROM games, unnest(string_to_array(tags, ',')) AS t"
+            "    WHERE user_id = $1 AND tags != ''"
+            ") s WHERE tag != '' GROUP BY tag",
+            user_id
+        );
+        
+        for (const auto& row : r) {
+            counts[row[0].as<std::string>()] = row[1].as<int>();
+        }
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Get user tags error: ") + e.what();
+    }
+    
+    return counts;
+}
+
 bool DatabaseManager::updateGameNotes(int game_id, int user_id, const std::string& notes) {
+    TraceSpan span("DatabaseManager::updateGameNotes", "db");
+    if (remote_) {
+        bool ok = false;
+        remoteCall(RpcOp::UpdateGameNotes, ok, game_id, user_id, notes);
+        if (ok) ++data_version_;
+        return ok;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -983,6 +1981,7 @@ bool DatabaseManager::updateGameNotes(int game_id, int user_id, const std::strin
         );
         
         txn.commit();
+        ++data_version_;
         return true;
     } catch (const std::exception& e) {
         last_error_ = std::string("Update notes error: ") + e.what();
@@ -993,6 +1992,11 @@ bool DatabaseManager::updateGameNotes(int game_id, int user_id, const std::strin
 GameStats DatabaseManager::getGameStats(int user_id) {
     GameStats stats;
     
+    if (remote_) {
+        remoteCall(RpcOp::GetGameStats, stats, user_id);
+        return stats;
+    }
+    
     try {
         pqxx::work txn(*conn_);
         
@@ -1053,6 +2057,262 @@ GameStats DatabaseManager::getGameStats(int user_id) {
     return stats;
 }
 
+std::vector<int> DatabaseManager::countFittingGames(int user_id, const std::vector<MachineProfile>& profiles) {
+    std::vector<int> counts;
+    if (profiles.empty()) {
+        return counts;
+    }
+    
+    if (remote_) {
+        remoteCall(RpcOp::CountFittingGames, counts, user_id, profiles);
+        return counts;
+    }
+    
+    try {
+        pqxx::work txn(*conn_);
+        
+        // Профили передаются списком VALUES: один проход соединения
+        // по индексу idx_games_requirements вместо запроса на профиль
+        pqxx::params params;
+        params.append(user_id);
+        std::string values;
+        int placeholder = 2;
+        for (size_t i = 0; i < profiles.size(); ++i) {
+            if (i > 0) values += ", ";
+            values += "(" + std::to_string(i) + ", $" + std::to_string(placeholder) +
+                      "::double precision, $" + std::to_string(placeholder + 1) +
+                      "::double precision, $" + std::to_string(placeholder + 2) + "::double precision)";
+            placeholder += 3;
+            params.append(static_cast<double>(profiles[i].ram));
+            params.append(static_cast<double>(profiles[i].vram));
+            params.append(static_cast<double>(profiles[i].disk));
+        }
+        
+        pqxx::result r = txn.exec_params(
+            "SELECT p.i, COUNT(g.id) FROM (VALUES " + values + ") AS p(i, ram, vram, disk) "
+            "LEFT JOIN games g ON g.user_id = $1 AND g.ram_usage <= p.ram "
+            "AND g.vram_required <= p.vram AND g.disk_space <= p.disk "
+            "GROUP BY p.i ORDER BY p.i",
+            params
+        );
+        
+        counts.assign(profiles.size(), 0);
+        for (const auto& row : r) {
+            counts[row[0].as<size_t>()] = row[1].as<int>();
+        }
+        
+        txn.commit();
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Count fitting games error: ") + e.what();
+        counts.clear();
+    }
+    
+    return counts;
+}
+
+namespace {
+
+const char* aggregateColumn(AggregateGroup group) {
+    switch (group) {
+        case AggregateGroup::Genre:     return "genre";
+        case AggregateGroup::Rating:    return "rating";
+        case AggregateGroup::Completed: return "completed";
+        case AggregateGroup::Favorite:  return "is_favorite";
+        case AggregateGroup::Installed: return "is_installed";
+        case AggregateGroup::Tag:       break;
+    }
+    return "";
+}
+
+const char* aggregateExpression(AggregateMetric metric) {
+    switch (metric) {
+        case AggregateMetric::Count:              return "COUNT(*)";
+        case AggregateMetric::DiskSpaceTotal:     return "SUM(disk_space)";
+        case AggregateMetric::InstalledDiskSpace: return "SUM(disk_space) FILTER (WHERE is_installed)";
+        case AggregateMetric::AverageRating:      return "AVG(rating) FILTER (WHERE rating >= 0)";
+        case AggregateMetric::CompletionRate:     return "AVG(CASE WHEN completed THEN 1.0 ELSE 0.0 END)";
+        case AggregateMetric::AverageRam:         return "AVG(ram_usage)";
+        case AggregateMetric::AverageVram:        return "AVG(vram_required)";
+    }
+    return "NULL";
+}
+
+std::vector<double> aggregateValues(const pqxx::row& row, size_t first, size_t count) {
+    std::vector<double> values;
+    values.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const pqxx::field field = row[static_cast<pqxx::row::size_type>(first + i)];
+        values.push_back(field.is_null() ? std::numeric_limits<double>::quiet_NaN()
+                                         : field.as<double>());
+    }
+    return values;
+}
+
+} // namespace
+
+AggregateResult DatabaseManager::aggregate(int user_id, const std::vector<AggregateGroup>& group_by,
+                                           const std::vector<AggregateMetric>& metrics,
+                                           const GameFilter* filter,
+                                           const FilterExpression* expression) {
+    TraceSpan span("DatabaseManager::aggregate", "db");
+    AggregateResult result;
+    result.metrics = metrics;
+    if (metrics.empty()) {
+        return result;
+    }
+    
+    // Ключ кэша: пользователь, разрезы, показатели и нормализованное условие
+    std::string key = std::to_string(user_id) + "|";
+    for (AggregateGroup group : group_by) key += std::to_string(static_cast<int>(group)) + ",";
+    key += "|";
+    for (AggregateMetric metric : metrics) key += std::to_string(static_cast<int>(metric)) + ",";
+    key += "|";
+    if (filter) {
+        key += CompiledFilter::compile(*filter).cacheKey();
+    } else if (expression && !expression->empty()) {
+        key += expression->cacheKey();
+    }
+    
+    // Любое изменение данных делает все сохранённые результаты устаревшими
+    if (aggregate_cache_version_ != data_version_) {
+        aggregate_cache_.clear();
+        aggregate_cache_version_ = data_version_;
+    }
+    auto cached = aggregate_cache_.find(key);
+    if (cached != aggregate_cache_.end()) {
+        return cached->second;
+    }
+    
+    if (remote_) {
+        if (!remoteCall(RpcOp::Aggregate, result, user_id, group_by, metrics, filter, expression)) {
+            return result;
+        }
+        if (aggregate_cache_.size() >= MAX_AGGREGATE_CACHE) {
+            aggregate_cache_.clear();
+        }
+        aggregate_cache_.emplace(key, result);
+        return result;
+    }
+    
+    std::string metricsSql;
+    for (AggregateMetric metric : metrics) {
+        metricsSql += std::string(", ") + aggregateExpression(metric);
+    }
+    
+    std::vector<AggregateGroup> columns;
+    bool byTag = false;
+    for (AggregateGroup group : group_by) {
+        if (group == AggregateGroup::Tag) {
+            byTag = true;
+        } else if (std::find(columns.begin(), columns.end(), group) == columns.end()) {
+            columns.push_back(group);
+        }
+    }
+    
+    try {
+        // Оба запроса видят один снимок данных
+        pqxx::transaction<pqxx::isolation_level::repeatable_read, pqxx::write_policy::read_only> txn(*conn_);
+        
+        // Все разрезы по столбцам и итог — один проход по таблице:
+        // GROUPING(столбец) = 0 в строках группы по этому столбцу
+        pqxx::params params;
+        std::string condition = buildFilterCondition(filter, expression, user_id, params);
+        std::string query = "SELECT 0";
+        for (AggregateGroup group : columns) {
+            query += std::string(", GROUPING(") + aggregateColumn(group) + ")";
+        }
+        for (AggregateGroup group : columns) {
+            query += std::string(", ") + aggregateColumn(group) + "::text";
+        }
+        query += metricsSql + " FROM games WHERE " + condition;
+        if (!columns.empty()) {
+            std::string sets;
+            std::string order;
+            for (AggregateGroup group : columns) {
+                sets += std::string("(") + aggregateColumn(group) + "), ";
+                order += std::string(order.empty() ? "" : ", ") + aggregateColumn(group);
+            }
+            query += " GROUP BY GROUPING SETS (" + sets + "()) ORDER BY " + order;
+        }
+        
+        pqxx::result r = txn.exec_params(query, params);
+        size_t keysFirst = 1 + columns.size();
+        size_t valuesFirst = keysFirst + columns.size();
+        
+        std::vector<std::vector<AggregateRow>> byColumn(columns.size());
+        AggregateRow total;
+        total.is_total = true;
+        total.values.assign(metrics.size(), std::numeric_limits<double>::quiet_NaN());
+        for (const auto& row : r) {
+            AggregateRow out;
+            out.values = aggregateValues(row, valuesFirst, metrics.size());
+            
+            size_t column = columns.size();
+            for (size_t i = 0; i < columns.size(); ++i) {
+                if (row[static_cast<pqxx::row::size_type>(1 + i)].as<int>() == 0) {
+                    column = i;
+                    break;
+                }
+            }
+            if (column == columns.size()) {
+                out.is_total = true;
+                total = std::move(out);
+                continue;
+            }
+            
+            out.group = columns[column];
+            out.key = row[static_cast<pqxx::row::size_type>(keysFirst + column)].c_str();
+            byColumn[column].push_back(std::move(out));
+        }
+        
+        // Теги хранятся строкой через запятую: разворачиваются отдельным
+        // запросом, чтобы не размножать строки остальных разрезов
+        std::vector<AggregateRow> tagRows;
+        if (byTag) {
+            pqxx::params tagParams;
+            std::string tagCondition = buildFilterCondition(filter, expression, user_id, tagParams);
+            pqxx::result tags = txn.exec_params(
+                std::string("SELECT t.tag") + metricsSql +
+                " FROM games CROSS JOIN LATERAL unnest(" + FilterExpression::TAGS_ARRAY_SQL + ") AS t(tag)"
+                " WHERE " + tagCondition + " AND t.tag <> '' GROUP BY t.tag ORDER BY t.tag",
+                tagParams
+            );
+            for (const auto& row : tags) {
+                AggregateRow out;
+                out.group = AggregateGroup::Tag;
+                out.key = row[0].c_str();
+                out.values = aggregateValues(row, 1, metrics.size());
+                tagRows.push_back(std::move(out));
+            }
+        }
+        
+        txn.commit();
+        
+        // Порядок разрезов — как в group_by, итог последним
+        for (AggregateGroup group : group_by) {
+            if (group == AggregateGroup::Tag) {
+                std::move(tagRows.begin(), tagRows.end(), std::back_inserter(result.rows));
+                tagRows.clear();
+                continue;
+            }
+            auto it = std::find(columns.begin(), columns.end(), group);
+            auto& rows = byColumn[static_cast<size_t>(it - columns.begin())];
+            std::move(rows.begin(), rows.end(), std::back_inserter(result.rows));
+            rows.clear();
+        }
+        result.rows.push_back(std::move(total));
+    } catch (const std::exception& e) {
+        last_error_ = std::string("Aggregate error: ") + e.what();
+        return result;
+    }
+    
+    if (aggregate_cache_.size() >= MAX_AGGREGATE_CACHE) {
+        aggregate_cache_.clear();
+    }
+    aggregate_cache_.emplace(key, result);
+    return result;
+}
+
 std::string DatabaseManager::getLastError() const {
     return last_error_;
 }
@@ -0,0 +1,455 @@
+#include "export_writer.h"
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef TEMPORIUM_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+namespace Temporium {
+
+namespace {
+
+struct FreeDeleter {
+    void operator()(char* data) const { std::free(data); }
+};
+
+bool writeFully(int fd, const char* data, size_t size, off_t offset, std::string& error) {
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            error = std::string("Write error: ") + std::strerror(errno);
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+} // namespace
+
+struct ExportWriter::Buffer {
+    std::unique_ptr<char, FreeDeleter> data;
+    bool pending = false;
+};
+
+// Способ асинхронной записи. Буфер с номером slot пишется не более чем
+// одной операцией одновременно
+class ExportWriter::Backend {
+public:
+    virtual ~Backend() = default;
+    virtual const char* name() const = 0;
+    // Начать запись size байт из data по смещению offset
+    virtual bool submit(size_t slot, const char* data, size_t size, off_t offset, std::string& error) = 0;
+    // Дождаться окончания записи буфера slot
+    virtual bool wait(size_t slot, std::string& error) = 0;
+};
+
+namespace {
+
+// pwrite в отдельном потоке; деструктор дописывает очередь до конца
+class ThreadBackend : public ExportWriter::Backend {
+public:
+    ThreadBackend(int fd, size_t slots)
+        : fd_(fd)
+        , done_(slots, true)
+        , errors_(slots)
+        , stopping_(false)
+        , thread_([this]() { loop(); })
+    {}
+
+    ~ThreadBackend() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeUp_.notify_all();
+        thread_.join();
+    }
+
+    const char* name() const override { return "pwrite"; }
+
+    bool submit(size_t slot, const char* data, size_t size, off_t offset, std::string&) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_[slot] = false;
+            errors_[slot].clear();
+            queue_.push_back({slot, data, size, offset});
+        }
+        wakeUp_.notify_all();
+        return true;
+    }
+
+    bool wait(size_t slot, std::string& error) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [&]() { return static_cast<bool>(done_[slot]); });
+        if (!errors_[slot].empty()) {
+            error = errors_[slot];
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Request {
+        size_t slot;
+        const char* data;
+        size_t size;
+        off_t offset;
+    };
+
+    void loop() {
+        for (;;) {
+            Request request;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wakeUp_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                request = queue_.front();
+                queue_.pop_front();
+            }
+
+            std::string error;
+            writeFully(fd_, request.data, request.size, request.offset, error);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_[request.slot] = true;
+                errors_[request.slot] = error;
+            }
+            finished_.notify_all();
+        }
+    }
+
+    int fd_;
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    std::condition_variable finished_;
+    std::deque<Request> queue_;
+    std::vector<bool> done_;
+    std::vector<std::string> errors_;
+    bool stopping_;
+    std::thread thread_;
+};
+
+#ifdef TEMPORIUM_HAVE_LIBURING
+
+// io_uring: запись без отдельного потока и копирования в page cache
+// из пользовательского потока; короткая запись дописывается повтором
+class UringBackend : public ExportWriter::Backend {
+public:
+    // nullptr — io_uring недоступен (старое ядро, запрет в контейнере)
+    static std::unique_ptr<UringBackend> create(int fd, size_t slots) {
+        std::unique_ptr<UringBackend> backend(new UringBackend(fd, slots));
+        if (io_uring_queue_init(static_cast<unsigned>(slots), &backend->ring_, 0) < 0) {
+            return nullptr;
+        }
+        backend->initialized_ = true;
+
+        // IORING_OP_WRITE появился в ядре 5.6
+        io_uring_probe* probe = io_uring_get_probe_ring(&backend->ring_);
+        bool supported = probe && io_uring_opcode_supported(probe, IORING_OP_WRITE);
+        if (probe) {
+            io_uring_free_probe(probe);
+        }
+        if (!supported) {
+            return nullptr;
+        }
+        return backend;
+    }
+
+    ~UringBackend() override {
+        // Буферы освобождаются после деструктора: ядро не должно писать из них
+        std::string error;
+        for (size_t slot = 0; slot < writes_.size(); ++slot) {
+            wait(slot, error);
+        }
+        if (initialized_) {
+            io_uring_queue_exit(&ring_);
+        }
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    bool submit(size_t slot, const char* data, size_t size, off_t offset, std::string& error) override {
+        Write& write = writes_[slot];
+        write.data = data;
+        write.size = size;
+        write.offset = offset;
+        write.error.clear();
+        write.pending = true;
+        if (!enqueue(write)) {
+            error = write.error;
+            return false;
+        }
+        return true;
+    }
+
+    bool wait(size_t slot, std::string& error) override {
+        while (writes_[slot].pending) {
+            io_uring_cqe* cqe = nullptr;
+            int result = io_uring_wait_cqe(&ring_, &cqe);
+            if (result == -EINTR) continue;
+            if (result < 0) {
+                // Очередь завершений недоступна: дальше ждать нечего
+                for (Write& write : writes_) {
+                    if (write.pending) {
+                        write.pending = false;
+                        write.error = std::string("io_uring wait error: ") + std::strerror(-result);
+                    }
+                }
+                break;
+            }
+            auto* write = static_cast<Write*>(io_uring_cqe_get_data(cqe));
+            int written = cqe->res;
+            io_uring_cqe_seen(&ring_, cqe);
+            complete(*write, written);
+        }
+        if (!writes_[slot].error.empty()) {
+            error = writes_[slot].error;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Write {
+        const char* data = nullptr;
+        size_t size = 0;
+        off_t offset = 0;
+        bool pending = false;
+        std::string error;
+    };
+
+    UringBackend(int fd, size_t slots)
+        : fd_(fd)
+        , initialized_(false)
+        , writes_(slots)
+    {}
+
+    bool enqueue(Write& write) {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+        if (!sqe) {
+            write.pending = false;
+            write.error = "io_uring submission queue is full";
+            return false;
+        }
+        io_uring_prep_write(sqe, fd_, write.data, static_cast<unsigned>(write.size),
+                            static_cast<uint64_t>(write.offset));
+        io_uring_sqe_set_data(sqe, &write);
+        int result = io_uring_submit(&ring_);
+        if (result < 0) {
+            write.pending = false;
+            write.error = std::string("io_uring submit error: ") + std::strerror(-result);
+            return false;
+        }
+        return true;
+    }
+
+    void complete(Write& write, int written) {
+        if (written == -EINTR || written == -EAGAIN) {
+            enqueue(write);
+            return;
+        }
+        if (written <= 0) {
+            write.pending = false;
+            write.error = written < 0 ? std::string("Write error: ") + std::strerror(-written)
+                                      : std::string("Write error: no progress");
+            return;
+        }
+        write.data += written;
+        write.size -= static_cast<size_t>(written);
+        write.offset += written;
+        if (write.size == 0) {
+            write.pending = false;
+        } else {
+            enqueue(write);
+        }
+    }
+
+    int fd_;
+    io_uring ring_;
+    bool initialized_;
+    std::vector<Write> writes_;
+};
+
+#endif
+
+} // namespace
+
+ExportWriter::ExportWriter(const std::string& path)
+    : path_(path)
+    , fd_(-1)
+    , offset_(0)
+    , next_(0)
+{}
+
+ExportWriter::~ExportWriter() {
+    discard();
+}
+
+bool ExportWriter::open(size_t headerSize) {
+    discard();
+    // Рядом с целевым: rename() атомарен только в пределах файловой системы.
+    // Уникальное имя: два экспорта в один файл не пишут в общий временный
+    std::string pattern = path_ + ".XXXXXX";
+    fd_ = ::mkostemp(&pattern[0], O_CLOEXEC);
+    if (fd_ < 0) {
+        int error = errno;
+        return fail("Cannot open file for writing: " + path_ + ": " + std::strerror(error));
+    }
+    tempPath_ = pattern;
+
+    // mkstemp создаёт файл с правами 0600: права заменяемого файла
+    // сохраняются, новый получает обычные 0644
+    struct stat existing;
+    mode_t mode = ::stat(path_.c_str(), &existing) == 0 ? existing.st_mode & 07777 : 0644;
+    if (::fchmod(fd_, mode) != 0) {
+        int error = errno;
+        discard();
+        return fail("Cannot set permissions of " + path_ + ": " + std::strerror(error));
+    }
+
+    offset_ = headerSize;
+    next_ = 0;
+    buffers_.clear();
+    buffers_.resize(BUFFER_COUNT);
+#ifdef TEMPORIUM_HAVE_LIBURING
+    backend_ = UringBackend::create(fd_, BUFFER_COUNT);
+#endif
+    if (!backend_) {
+        backend_ = std::make_unique<ThreadBackend>(fd_, BUFFER_COUNT);
+    }
+    return true;
+}
+
+char* ExportWriter::buffer() {
+    if (!backend_) {
+        fail("Export file is not open");
+        return nullptr;
+    }
+    Buffer& buffer = buffers_[next_];
+    if (buffer.pending) {
+        buffer.pending = false;
+        std::string error;
+        if (!backend_->wait(next_, error)) {
+            fail(error);
+            return nullptr;
+        }
+    }
+    // Память выделяется при первом использовании: небольшой экспорт
+    // обходится одним буфером
+    if (!buffer.data) {
+        buffer.data.reset(static_cast<char*>(std::aligned_alloc(BUFFER_ALIGNMENT, BUFFER_SIZE)));
+        if (!buffer.data) {
+            fail("Out of memory for export buffer");
+            return nullptr;
+        }
+    }
+    return buffer.data.get();
+}
+
+bool ExportWriter::write(size_t size) {
+    Buffer& buffer = buffers_[next_];
+    std::string error;
+    if (!backend_->submit(next_, buffer.data.get(), size, static_cast<off_t>(offset_), error)) {
+        return fail(error);
+    }
+    buffer.pending = true;
+    offset_ += size;
+    next_ = (next_ + 1) % buffers_.size();
+    return true;
+}
+
+bool ExportWriter::commit(const void* header, size_t headerSize) {
+    if (!backend_) {
+        return fail("Export file is not open");
+    }
+    if (!waitAll()) {
+        discard();
+        return false;
+    }
+    backend_.reset();
+
+    std::string error;
+    if (!writeFully(fd_, static_cast<const char*>(header), headerSize, 0, error)) {
+        discard();
+        return fail(error);
+    }
+    // Данные на диске раньше, чем новое имя: после сбоя остаётся либо
+    // старый файл, либо новый целиком
+    if (::fsync(fd_) != 0 || ::close(fd_) != 0) {
+        int code = errno;
+        fd_ = -1;
+        discard();
+        return fail(std::string("Cannot flush export file: ") + std::strerror(code));
+    }
+    fd_ = -1;
+    if (std::rename(tempPath_.c_str(), path_.c_str()) != 0) {
+        int code = errno;
+        discard();
+        return fail("Cannot replace " + path_ + ": " + std::strerror(code));
+    }
+    tempPath_.clear();
+    buffers_.clear();
+
+    // Сохранность самого переименования
+    size_t slash = path_.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path_.substr(0, slash);
+    int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+    return true;
+}
+
+const char* ExportWriter::backendName() const {
+    return backend_ ? backend_->name() : "none";
+}
+
+bool ExportWriter::fail(const std::string& error) {
+    lastError_ = error;
+    return false;
+}
+
+bool ExportWriter::waitAll() {
+    bool ok = true;
+    for (size_t slot = 0; slot < buffers_.size(); ++slot) {
+        if (!buffers_[slot].pending) continue;
+        buffers_[slot].pending = false;
+        std::string error;
+        if (!backend_->wait(slot, error) && ok) {
+            ok = fail(error);
+        }
+    }
+    return ok;
+}
+
+void ExportWriter::discard() {
+    // Сначала дождаться записи: ядро или поток ещё могут читать буферы
+    backend_.reset();
+    buffers_.clear();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (!tempPath_.empty()) {
+        ::unlink(tempPath_.c_str());
+        tempPath_.clear();
+    }
+}
+
+}
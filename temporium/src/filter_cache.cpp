@@ -0,0 +1,137 @@
+#include "filter_cache.h"
+#include "hash_utils.h"
+#include <algorithm>
+
+namespace Temporium {
+
+FilterResultCache::FilterResultCache(size_t budget_bytes)
+    : budget_(budget_bytes)
+    , bytes_(0)
+    , hits_(0)
+    , misses_(0)
+{}
+
+uint64_t FilterResultCache::hashKey(const std::string& key) {
+    return HashUtils::fnv1a(key);
+}
+
+size_t FilterResultCache::entryBytes(const Entry& entry) {
+    return sizeof(Entry) + entry.key.capacity() + entry.rows.capacity() * sizeof(uint32_t);
+}
+
+const std::vector<uint32_t>* FilterResultCache::find(const RowPredicate& predicate) {
+    std::string key = predicate.cacheKey();
+    auto it = index_.find(hashKey(key));
+    // Совпадение хэша проверяется по полной записи условия
+    if (it == index_.end() || it->second->key != key) {
+        ++misses_;
+        return nullptr;
+    }
+
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &entries_.front().rows;
+}
+
+void FilterResultCache::insert(std::shared_ptr<const RowPredicate> predicate, std::vector<uint32_t> rows) {
+    Entry entry;
+    entry.key = predicate->cacheKey();
+    entry.hash = hashKey(entry.key);
+    entry.fields = predicate->fieldMask();
+    entry.predicate = std::move(predicate);
+    entry.rows = std::move(rows);
+    entry.bytes = entryBytes(entry);
+
+    // Результат больше всего бюджета не кэшируется
+    if (entry.bytes > budget_) return;
+
+    auto existing = index_.find(entry.hash);
+    if (existing != index_.end()) {
+        bytes_ -= existing->second->bytes;
+        entries_.erase(existing->second);
+        index_.erase(existing);
+    }
+
+    bytes_ += entry.bytes;
+    entries_.push_front(std::move(entry));
+    index_[entries_.front().hash] = entries_.begin();
+    evict();
+}
+
+void FilterResultCache::resize(Entry& entry) {
+    bytes_ -= entry.bytes;
+    entry.bytes = entryBytes(entry);
+    bytes_ += entry.bytes;
+}
+
+void FilterResultCache::evict() {
+    while (bytes_ > budget_ && !entries_.empty()) {
+        bytes_ -= entries_.back().bytes;
+        index_.erase(entries_.back().hash);
+        entries_.pop_back();
+    }
+}
+
+void FilterResultCache::rowUpdated(const CompactGameCollection& games, uint32_t row, uint32_t changed_fields) {
+    for (Entry& entry : entries_) {
+        if (!(entry.fields & changed_fields)) continue;
+
+        auto it = std::lower_bound(entry.rows.begin(), entry.rows.end(), row);
+        bool listed = it != entry.rows.end() && *it == row;
+        bool matches = entry.predicate->matches(games, row);
+        if (matches && !listed) {
+            entry.rows.insert(it, row);
+        } else if (!matches && listed) {
+            entry.rows.erase(it);
+        }
+        resize(entry);
+    }
+    evict();
+}
+
+void FilterResultCache::rowAppended(const CompactGameCollection& games, uint32_t row) {
+    for (Entry& entry : entries_) {
+        if (entry.predicate->matches(games, row)) {
+            entry.rows.push_back(row);
+            resize(entry);
+        }
+    }
+    evict();
+}
+
+void FilterResultCache::rowRemoved(uint32_t row) {
+    for (Entry& entry : entries_) {
+        auto it = std::lower_bound(entry.rows.begin(), entry.rows.end(), row);
+        if (it != entry.rows.end() && *it == row) {
+            it = entry.rows.erase(it);
+        }
+        for (; it != entry.rows.end(); ++it) {
+            --*it;
+        }
+    }
+}
+
+void FilterResultCache::clear() {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+uint32_t FilterResultCache::changedFields(const Game& before, const Game& after) {
+    uint32_t fields = 0;
+    if (before.name != after.name) fields |= FIELD_NAME;
+    if (before.genre != after.genre) fields |= FIELD_GENRE;
+    if (before.tags != after.tags) fields |= FIELD_TAGS;
+    if (before.notes != after.notes) fields |= FIELD_NOTES;
+    if (before.url != after.url) fields |= FIELD_URL;
+    if (before.rating != after.rating) fields |= FIELD_RATING;
+    if (before.disk_space != after.disk_space) fields |= FIELD_DISK_SPACE;
+    if (before.ram_usage != after.ram_usage) fields |= FIELD_RAM_USAGE;
+    if (before.vram_required != after.vram_required) fields |= FIELD_VRAM_REQUIRED;
+    if (before.completed != after.completed) fields |= FIELD_COMPLETED;
+    if (before.is_favorite != after.is_favorite) fields |= FIELD_FAVORITE;
+    if (before.is_installed != after.is_installed) fields |= FIELD_INSTALLED;
+    return fields;
+}
+
+}
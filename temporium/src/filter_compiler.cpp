@@ -0,0 +1,406 @@
+#include "filter_compiler.h"
+#include "tag_dictionary.h"
+#include <algorithm>
+
+namespace Temporium {
+
+namespace {
+
+using Instruction = CompiledFilter::Instruction;
+using Field = CompiledFilter::Field;
+using Op = CompiledFilter::Op;
+
+// Ограничение одного столбца; несколько условий сливаются в пересечение
+struct Bounds {
+    bool has_low = false;
+    bool has_high = false;
+    double low = 0.0;
+    double high = 0.0;
+
+    void atLeast(double value) {
+        if (!has_low || value > low) {
+            low = value;
+            has_low = true;
+        }
+    }
+
+    void atMost(double value) {
+        if (!has_high || value < high) {
+            high = value;
+            has_high = true;
+        }
+    }
+
+    bool active() const { return has_low || has_high; }
+    bool empty() const { return has_low && has_high && low > high; }
+};
+
+// Стоимость проверки: дешёвые инструкции выполняются первыми
+int cost(Op op) {
+    switch (op) {
+        case Op::False:       return 0;
+        case Op::Flags:       return 1;
+        case Op::Range:       return 2;
+        case Op::GenreEquals: return 3;
+        case Op::TagContains: return 4;
+    }
+    return 5;
+}
+
+// Столбцы без NOT NULL читаются так же, как их загружает клиент
+// (readGameFields): NULL — оценка -1, флаг false
+const char* columnName(Field field) {
+    switch (field) {
+        case Field::DiskSpace:    return "disk_space";
+        case Field::RamUsage:     return "ram_usage";
+        case Field::VramRequired: return "vram_required";
+        case Field::Rating:       return "COALESCE(rating, -1)";
+    }
+    return "";
+}
+
+uint8_t flagsOf(const Game& game) {
+    return (game.completed ? CompactGame::FLAG_COMPLETED : 0) |
+           (game.is_favorite ? CompactGame::FLAG_FAVORITE : 0) |
+           (game.is_installed ? CompactGame::FLAG_INSTALLED : 0);
+}
+
+// Доступ к полям строки для интерпретатора: Game и компактная коллекция
+struct GameRow {
+    const Game& game;
+
+    uint8_t flags() const { return flagsOf(game); }
+
+    double field(Field field) const {
+        switch (field) {
+            case Field::DiskSpace:    return game.disk_space;
+            case Field::RamUsage:     return game.ram_usage;
+            case Field::VramRequired: return game.vram_required;
+            case Field::Rating:       return game.rating;
+        }
+        return 0.0;
+    }
+
+    bool genreEquals(const Instruction& ins) const {
+        return game.genre == ins.text;
+    }
+
+    bool tagContains(const Instruction& ins) const {
+        // Строка из формы редактирования может быть ещё не приведена
+        thread_local std::string tags;
+        TagDictionary::canonical(game.tags, tags);
+        return tags.find(ins.text) != std::string::npos;
+    }
+};
+
+struct CompactRow {
+    const CompactGameCollection& games;
+    size_t index;
+
+    uint8_t flags() const { return games.at(index).flags; }
+
+    double field(Field field) const {
+        const CompactGame& game = games.at(index);
+        switch (field) {
+            case Field::DiskSpace:    return game.disk_space;
+            case Field::RamUsage:     return game.ram_usage;
+            case Field::VramRequired: return game.vram_required;
+            case Field::Rating:       return game.rating;
+        }
+        return 0.0;
+    }
+
+    bool genreEquals(const Instruction& ins) const {
+        // Стандартный жанр сравнивается по индексу, без строк
+        if (ins.genre_index < GENRES.size()) {
+            return games.at(index).genre == ins.genre_index;
+        }
+        return games.genre(index) == ins.text;
+    }
+
+    bool tagContains(const Instruction& ins) const {
+        thread_local std::string tags;
+        games.tags(index, tags);
+        return tags.find(ins.text) != std::string::npos;
+    }
+};
+
+template <typename Row>
+bool run(const std::vector<Instruction>& code, const Row& row) {
+    for (const Instruction& ins : code) {
+        switch (ins.op) {
+            case Op::False:
+                return false;
+            case Op::Flags:
+                if ((row.flags() & ins.mask) != ins.expected) return false;
+                break;
+            case Op::Range: {
+                double value = row.field(ins.field);
+                if ((ins.has_low && value < ins.low) || (ins.has_high && value > ins.high)) return false;
+                break;
+            }
+            case Op::GenreEquals:
+                if (!row.genreEquals(ins)) return false;
+                break;
+            case Op::TagContains:
+                if (!row.tagContains(ins)) return false;
+                break;
+        }
+    }
+    return true;
+}
+
+CompiledFilter::SqlParam numberParam(Field field, double value) {
+    CompiledFilter::SqlParam param;
+    if (field == Field::Rating) {
+        param.type = CompiledFilter::SqlParam::Type::Int;
+        param.int_value = static_cast<int>(value);
+    } else {
+        param.type = CompiledFilter::SqlParam::Type::Double;
+        param.double_value = value;
+    }
+    return param;
+}
+
+} // namespace
+
+CompiledFilter CompiledFilter::compile(const GameFilter& filter) {
+    CompiledFilter compiled;
+    std::vector<Instruction>& code = compiled.code_;
+
+    // Флаги — одна проверка маски
+    Instruction flags;
+    flags.op = Op::Flags;
+    auto addFlag = [&flags](bool enabled, uint8_t bit, bool value) {
+        if (!enabled) return;
+        flags.mask |= bit;
+        if (value) flags.expected |= bit;
+    };
+    addFlag(filter.filter_completed, CompactGame::FLAG_COMPLETED, filter.completed_value);
+    addFlag(filter.filter_favorite, CompactGame::FLAG_FAVORITE, filter.favorite_value);
+    addFlag(filter.filter_installed, CompactGame::FLAG_INSTALLED, filter.installed_value);
+    if (flags.mask != 0) {
+        code.push_back(flags);
+    }
+
+    // Числовые ограничения — по одному диапазону на столбец
+    Bounds disk, ram, vram, rating;
+    if (filter.filter_disk_space_min) disk.atLeast(filter.disk_space_min);
+    if (filter.filter_disk_space_max) disk.atMost(filter.disk_space_max);
+    if (filter.filter_ram_min) ram.atLeast(filter.ram_min);
+    if (filter.filter_ram_max) ram.atMost(filter.ram_max);
+    if (filter.filter_vram_min) vram.atLeast(filter.vram_min);
+    if (filter.filter_vram_max) vram.atMost(filter.vram_max);
+
+    // "Не больше N" исключает игры без оценки (-1)
+    if (filter.filter_rating_min) rating.atLeast(filter.rating_min);
+    if (filter.filter_rating_max) {
+        rating.atMost(filter.rating_max);
+        rating.atLeast(0);
+    }
+    if (filter.filter_has_rating) {
+        if (filter.has_rating_value) {
+            rating.atLeast(0);
+        } else {
+            rating.atLeast(-1);
+            rating.atMost(-1);
+        }
+    }
+
+    const std::pair<Field, const Bounds*> ranges[] = {
+        {Field::Rating, &rating},
+        {Field::DiskSpace, &disk},
+        {Field::RamUsage, &ram},
+        {Field::VramRequired, &vram},
+    };
+    for (const auto& range : ranges) {
+        const Bounds& bounds = *range.second;
+        if (bounds.empty()) {
+            // Пустой диапазон: фильтр не пропустит ни одной строки
+            Instruction never;
+            never.op = Op::False;
+            code.assign(1, never);
+            return compiled;
+        }
+        if (!bounds.active()) continue;
+
+        Instruction ins;
+        ins.op = Op::Range;
+        ins.field = range.first;
+        ins.has_low = bounds.has_low;
+        ins.has_high = bounds.has_high;
+        ins.low = bounds.low;
+        ins.high = bounds.high;
+        code.push_back(ins);
+    }
+
+    if (filter.filter_genre && !filter.genre_value.empty()) {
+        Instruction ins;
+        ins.op = Op::GenreEquals;
+        ins.text = filter.genre_value;
+        ins.genre_index = static_cast<uint16_t>(
+            std::find(GENRES.begin(), GENRES.end(), filter.genre_value) - GENRES.begin());
+        code.push_back(ins);
+    }
+
+    if (filter.filter_tag && !filter.tag_value.empty()) {
+        Instruction ins;
+        ins.op = Op::TagContains;
+        ins.text = filter.tag_value;
+        code.push_back(ins);
+    }
+
+    std::stable_sort(code.begin(), code.end(), [](const Instruction& a, const Instruction& b) {
+        return cost(a.op) < cost(b.op);
+    });
+    return compiled;
+}
+
+std::string CompiledFilter::escapeLike(const std::string& text) {
+    std::string result;
+    result.reserve(text.size() + 2);
+    for (char c : text) {
+        if (c == '\\' || c == '%' || c == '_') {
+            result += '\\';
+        }
+        result += c;
+    }
+    return result;
+}
+
+bool CompiledFilter::matches(const Game& game) const {
+    return run(code_, GameRow{game});
+}
+
+bool CompiledFilter::matches(const CompactGameCollection& games, size_t index) const {
+    return run(code_, CompactRow{games, index});
+}
+
+std::string CompiledFilter::cacheKey() const {
+    // Программа уже нормализована: пустые условия отброшены,
+    // диапазоны слиты, порядок инструкций фиксирован
+    std::string key = "filter:";
+    for (const Instruction& ins : code_) {
+        key += std::to_string(static_cast<int>(ins.op));
+        switch (ins.op) {
+            case Op::False:
+                break;
+            case Op::Flags:
+                key += ":" + std::to_string(ins.mask) + ":" + std::to_string(ins.expected);
+                break;
+            case Op::Range:
+                key += ":" + std::to_string(static_cast<int>(ins.field));
+                key += ins.has_low ? ":" + std::to_string(ins.low) : ":-";
+                key += ins.has_high ? ":" + std::to_string(ins.high) : ":-";
+                break;
+            case Op::GenreEquals:
+            case Op::TagContains:
+                // Длина перед текстом исключает неоднозначность разделителей
+                key += ":" + std::to_string(ins.text.size()) + ":" + ins.text;
+                break;
+        }
+        key += ";";
+    }
+    return key;
+}
+
+uint32_t CompiledFilter::fieldMask() const {
+    uint32_t mask = 0;
+    for (const Instruction& ins : code_) {
+        switch (ins.op) {
+            case Op::False:
+                break;
+            case Op::Flags:
+                if (ins.mask & CompactGame::FLAG_COMPLETED) mask |= FIELD_COMPLETED;
+                if (ins.mask & CompactGame::FLAG_FAVORITE) mask |= FIELD_FAVORITE;
+                if (ins.mask & CompactGame::FLAG_INSTALLED) mask |= FIELD_INSTALLED;
+                break;
+            case Op::Range:
+                switch (ins.field) {
+                    case Field::DiskSpace:    mask |= FIELD_DISK_SPACE; break;
+                    case Field::RamUsage:     mask |= FIELD_RAM_USAGE; break;
+                    case Field::VramRequired: mask |= FIELD_VRAM_REQUIRED; break;
+                    case Field::Rating:       mask |= FIELD_RATING; break;
+                }
+                break;
+            case Op::GenreEquals:
+                mask |= FIELD_GENRE;
+                break;
+            case Op::TagContains:
+                mask |= FIELD_TAGS;
+                break;
+        }
+    }
+    return mask;
+}
+
+std::string CompiledFilter::sqlCondition(int first_placeholder, std::vector<SqlParam>& params) const {
+    std::vector<std::string> terms;
+    int placeholder = first_placeholder;
+    auto bind = [&params, &placeholder](SqlParam param) {
+        params.push_back(std::move(param));
+        return "$" + std::to_string(placeholder++);
+    };
+    auto boolParam = [](bool value) {
+        SqlParam param;
+        param.type = SqlParam::Type::Bool;
+        param.bool_value = value;
+        return param;
+    };
+    auto textParam = [](const std::string& value) {
+        SqlParam param;
+        param.type = SqlParam::Type::Text;
+        param.text_value = value;
+        return param;
+    };
+
+    for (const Instruction& ins : code_) {
+        switch (ins.op) {
+            case Op::False:
+                return "FALSE";
+            case Op::Flags: {
+                const std::pair<uint8_t, const char*> columns[] = {
+                    {CompactGame::FLAG_COMPLETED, "COALESCE(completed, FALSE)"},
+                    {CompactGame::FLAG_FAVORITE, "COALESCE(is_favorite, FALSE)"},
+                    {CompactGame::FLAG_INSTALLED, "COALESCE(is_installed, FALSE)"},
+                };
+                for (const auto& column : columns) {
+                    if (ins.mask & column.first) {
+                        terms.push_back(std::string(column.second) + " = " +
+                                        bind(boolParam((ins.expected & column.first) != 0)));
+                    }
+                }
+                break;
+            }
+            case Op::Range: {
+                std::string column = columnName(ins.field);
+                if (ins.has_low && ins.has_high && ins.low == ins.high) {
+                    terms.push_back(column + " = " + bind(numberParam(ins.field, ins.low)));
+                    break;
+                }
+                if (ins.has_low) {
+                    terms.push_back(column + " >= " + bind(numberParam(ins.field, ins.low)));
+                }
+                if (ins.has_high) {
+                    terms.push_back(column + " <= " + bind(numberParam(ins.field, ins.high)));
+                }
+                break;
+            }
+            case Op::GenreEquals:
+                terms.push_back("genre = " + bind(textParam(ins.text)));
+                break;
+            case Op::TagContains:
+                terms.push_back("tags LIKE " + bind(textParam("%" + escapeLike(ins.text) + "%")));
+                break;
+        }
+    }
+
+    std::string condition;
+    for (const std::string& term : terms) {
+        if (!condition.empty()) condition += " AND ";
+        condition += term;
+    }
+    return condition;
+}
+
+}
@@ -0,0 +1,799 @@
+#include "filter_expression.h"
+#include "tag_dictionary.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Temporium {
+
+const char* const FilterExpression::TAGS_ARRAY_SQL =
+    "array_remove(regexp_split_to_array(btrim(COALESCE(tags, ''), E' \\t'), E'[ \\t]*,[ \\t]*'), '')";
+
+namespace {
+
+using Field = FilterExpression::Field;
+using Op = FilterExpression::Op;
+using NodeType = FilterExpression::NodeType;
+using Node = FilterExpression::Node;
+using SqlParam = CompiledFilter::SqlParam;
+
+enum class FieldKind { Text, Genre, Tag, Number, Flag };
+
+struct FieldInfo {
+    Field field;
+    FieldKind kind;
+    const char* column;     // SQL-значение: NULL заменён тем же, что даёт загрузка строки
+    uint32_t bit;           // GameFieldBit
+    const char* names[4];   // Первое имя — каноническое
+};
+
+const FieldInfo FIELDS[] = {
+    {Field::Name,         FieldKind::Text,   "name",                          FIELD_NAME,          {"name", "название"}},
+    {Field::Genre,        FieldKind::Genre,  "genre",                         FIELD_GENRE,         {"genre", "жанр"}},
+    {Field::Tag,          FieldKind::Tag,    "tags",                          FIELD_TAGS,          {"tag", "tags", "тег", "теги"}},
+    {Field::Notes,        FieldKind::Text,   "COALESCE(notes, '')",           FIELD_NOTES,         {"notes", "заметки"}},
+    {Field::Url,          FieldKind::Text,   "COALESCE(url, '')",             FIELD_URL,           {"url", "ссылка"}},
+    {Field::Rating,       FieldKind::Number, "COALESCE(rating, -1)",          FIELD_RATING,        {"rating", "оценка"}},
+    {Field::DiskSpace,    FieldKind::Number, "disk_space",                    FIELD_DISK_SPACE,    {"disk", "диск"}},
+    {Field::RamUsage,     FieldKind::Number, "ram_usage",                     FIELD_RAM_USAGE,     {"ram", "озу"}},
+    {Field::VramRequired, FieldKind::Number, "vram_required",                 FIELD_VRAM_REQUIRED, {"vram", "видеопамять"}},
+    {Field::Completed,    FieldKind::Flag,   "COALESCE(completed, FALSE)",    FIELD_COMPLETED,     {"completed", "пройдена", "пройдено"}},
+    {Field::Favorite,     FieldKind::Flag,   "COALESCE(is_favorite, FALSE)",  FIELD_FAVORITE,      {"favorite", "избранное"}},
+    {Field::Installed,    FieldKind::Flag,   "COALESCE(is_installed, FALSE)", FIELD_INSTALLED,     {"installed", "установлена", "установлено"}},
+};
+
+const FieldInfo& fieldInfo(Field field) {
+    return FIELDS[static_cast<size_t>(field)];
+}
+
+const char* opText(Op op) {
+    switch (op) {
+        case Op::Equal:        return "=";
+        case Op::NotEqual:     return "!=";
+        case Op::Less:         return "<";
+        case Op::LessEqual:    return "<=";
+        case Op::Greater:      return ">";
+        case Op::GreaterEqual: return ">=";
+        case Op::Contains:     return "~";
+        case Op::Prefix:       return "^=";
+        case Op::In:           return "in";
+    }
+    return "";
+}
+
+bool opAllowed(FieldKind kind, Op op) {
+    switch (kind) {
+        case FieldKind::Text:
+            return op == Op::Equal || op == Op::NotEqual || op == Op::Contains ||
+                   op == Op::Prefix || op == Op::In;
+        case FieldKind::Genre:
+            return op == Op::Equal || op == Op::NotEqual || op == Op::In;
+        case FieldKind::Tag:
+            return op == Op::Equal || op == Op::NotEqual || op == Op::Contains || op == Op::In;
+        case FieldKind::Number:
+            return op != Op::Contains && op != Op::Prefix && op != Op::In;
+        case FieldKind::Flag:
+            return op == Op::Equal || op == Op::NotEqual;
+    }
+    return false;
+}
+
+std::string asciiLower(std::string text) {
+    for (char& c : text) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return text;
+}
+
+std::string quoted(const std::string& value) {
+    std::string result = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') result += '\\';
+        result += c;
+    }
+    return result + "\"";
+}
+
+std::string numberText(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+    return buffer;
+}
+
+// ==================== Разбор ====================
+
+struct Token {
+    enum class Type { Word, String, Operator, LParen, RParen, Comma, End } type;
+    std::string text;
+    size_t position;
+};
+
+bool isDelimiter(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+           c == '(' || c == ')' || c == ',' || c == '"' || c == '\'' ||
+           c == '=' || c == '!' || c == '<' || c == '>' || c == '~' || c == '^';
+}
+
+bool tokenize(const std::string& text, std::vector<Token>& tokens, std::string& error) {
+    size_t i = 0;
+    while (i < text.size()) {
+        char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            ++i;
+            continue;
+        }
+
+        size_t start = i;
+        if (c == '(' || c == ')' || c == ',') {
+            Token::Type type = c == '(' ? Token::Type::LParen
+                             : c == ')' ? Token::Type::RParen : Token::Type::Comma;
+            tokens.push_back({type, std::string(1, c), start});
+            ++i;
+        } else if (c == '"' || c == '\'') {
+            std::string value;
+            ++i;
+            while (i < text.size() && text[i] != c) {
+                if (text[i] == '\\' && i + 1 < text.size()) ++i;
+                value += text[i++];
+            }
+            if (i >= text.size()) {
+                error = "Незакрытая кавычка (позиция " + std::to_string(start + 1) + ")";
+                return false;
+            }
+            ++i;
+            tokens.push_back({Token::Type::String, value, start});
+        } else if (c == '=' || c == '~') {
+            tokens.push_back({Token::Type::Operator, std::string(1, c), start});
+            ++i;
+        } else if (c == '!' || c == '<' || c == '>' || c == '^') {
+            bool withEquals = i + 1 < text.size() && text[i + 1] == '=';
+            if ((c == '!' || c == '^') && !withEquals) {
+                error = "Ожидалось \"" + std::string(1, c) + "=\" (позиция " + std::to_string(start + 1) + ")";
+                return false;
+            }
+            tokens.push_back({Token::Type::Operator, text.substr(i, withEquals ? 2 : 1), start});
+            i += withEquals ? 2 : 1;
+        } else {
+            while (i < text.size() && !isDelimiter(text[i])) ++i;
+            tokens.push_back({Token::Type::Word, text.substr(start, i - start), start});
+        }
+    }
+    tokens.push_back({Token::Type::End, "", text.size()});
+    return true;
+}
+
+class Parser {
+public:
+    Parser(const std::vector<Token>& tokens, std::vector<Node>& nodes, std::string& error)
+        : tokens_(tokens), nodes_(nodes), error_(error) {}
+
+    int parse() {
+        int root = parseOr();
+        if (root >= 0 && peek().type != Token::Type::End) {
+            return fail("Лишний текст \"" + peek().text + "\"");
+        }
+        return root;
+    }
+
+private:
+    const Token& peek() const { return tokens_[pos_]; }
+    const Token& next() { return tokens_[pos_++]; }
+
+    bool isKeyword(const Token& token, const char* keyword) const {
+        return token.type == Token::Type::Word && asciiLower(token.text) == keyword;
+    }
+
+    int fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message + " (позиция " + std::to_string(peek().position + 1) + ")";
+        }
+        return -1;
+    }
+
+    int add(Node node) {
+        nodes_.push_back(std::move(node));
+        return static_cast<int>(nodes_.size()) - 1;
+    }
+
+    int parseOr() {
+        Node node;
+        node.type = NodeType::Or;
+        int child = parseAnd();
+        if (child < 0) return -1;
+        node.children.push_back(child);
+        while (isKeyword(peek(), "or")) {
+            next();
+            child = parseAnd();
+            if (child < 0) return -1;
+            node.children.push_back(child);
+        }
+        return node.children.size() == 1 ? node.children.front() : add(std::move(node));
+    }
+
+    // "a and b" можно записать как "a b"
+    bool startsTerm(const Token& token) const {
+        return token.type == Token::Type::LParen ||
+               (token.type == Token::Type::Word && !isKeyword(token, "or"));
+    }
+
+    int parseAnd() {
+        Node node;
+        node.type = NodeType::And;
+        int child = parseNot();
+        if (child < 0) return -1;
+        node.children.push_back(child);
+        while (isKeyword(peek(), "and") || startsTerm(peek())) {
+            if (isKeyword(peek(), "and")) next();
+            child = parseNot();
+            if (child < 0) return -1;
+            node.children.push_back(child);
+        }
+        return node.children.size() == 1 ? node.children.front() : add(std::move(node));
+    }
+
+    int parseNot() {
+        if (isKeyword(peek(), "not")) {
+            next();
+            int child = parseNot();
+            if (child < 0) return -1;
+            Node node;
+            node.type = NodeType::Not;
+            node.children.push_back(child);
+            return add(std::move(node));
+        }
+        return parsePrimary();
+    }
+
+    int parsePrimary() {
+        if (peek().type == Token::Type::LParen) {
+            next();
+            int inner = parseOr();
+            if (inner < 0) return -1;
+            if (peek().type != Token::Type::RParen) {
+                return fail("Ожидалась закрывающая скобка");
+            }
+            next();
+            return inner;
+        }
+        if (peek().type != Token::Type::Word) {
+            return fail("Ожидалось имя поля");
+        }
+        return parseComparison();
+    }
+
+    int parseComparison() {
+        const Token& name = next();
+        const FieldInfo* info = findField(name.text);
+        if (!info) {
+            --pos_;
+            return fail("Неизвестное поле \"" + name.text + "\"");
+        }
+
+        Node node;
+        node.field = info->field;
+
+        // Логическое поле без оператора: "favorite" означает "favorite = true"
+        const Token& opToken = peek();
+        if (opToken.type != Token::Type::Operator && !isKeyword(opToken, "in")) {
+            if (info->kind != FieldKind::Flag) {
+                return fail("Ожидался оператор после поля \"" + name.text + "\"");
+            }
+            node.flag = true;
+            return add(std::move(node));
+        }
+        next();
+        node.op = parseOp(opToken.text);
+        if (!opAllowed(info->kind, node.op)) {
+            --pos_;
+            return fail("Оператор \"" + opToken.text + "\" не применим к полю \"" + name.text + "\"");
+        }
+
+        std::vector<Token> values;
+        if (node.op == Op::In) {
+            if (peek().type != Token::Type::LParen) {
+                return fail("Ожидался список значений в скобках");
+            }
+            next();
+            while (true) {
+                if (!isValue(peek())) return fail("Ожидалось значение");
+                values.push_back(next());
+                if (peek().type == Token::Type::Comma) {
+                    next();
+                    continue;
+                }
+                if (peek().type != Token::Type::RParen) {
+                    return fail("Ожидалась запятая или закрывающая скобка");
+                }
+                next();
+                break;
+            }
+        } else {
+            if (!isValue(peek())) return fail("Ожидалось значение");
+            values.push_back(next());
+        }
+
+        switch (info->kind) {
+            case FieldKind::Number: {
+                const std::string& text = values.front().text;
+                char* end = nullptr;
+                node.number = std::strtod(text.c_str(), &end);
+                if (text.empty() || *end != '\0') {
+                    --pos_;
+                    return fail("Ожидалось число");
+                }
+                break;
+            }
+            case FieldKind::Flag: {
+                std::string text = asciiLower(values.front().text);
+                if (text == "true" || text == "yes" || text == "1" || text == "да") {
+                    node.flag = true;
+                } else if (text == "false" || text == "no" || text == "0" || text == "нет") {
+                    node.flag = false;
+                } else {
+                    --pos_;
+                    return fail("Ожидалось true или false");
+                }
+                // "!= true" сводится к "= false"
+                if (node.op == Op::NotEqual) {
+                    node.flag = !node.flag;
+                }
+                node.op = Op::Equal;
+                break;
+            }
+            default:
+                for (const Token& value : values) {
+                    node.values.push_back(value.text);
+                }
+                // Порядок и повторы в списке не влияют на результат
+                std::sort(node.values.begin(), node.values.end());
+                node.values.erase(std::unique(node.values.begin(), node.values.end()), node.values.end());
+                if (info->kind == FieldKind::Genre) {
+                    for (const std::string& value : node.values) {
+                        node.genres.push_back(static_cast<uint16_t>(
+                            std::find(GENRES.begin(), GENRES.end(), value) - GENRES.begin()));
+                    }
+                }
+                break;
+        }
+        return add(std::move(node));
+    }
+
+    static bool isValue(const Token& token) {
+        return token.type == Token::Type::Word || token.type == Token::Type::String;
+    }
+
+    static const FieldInfo* findField(const std::string& name) {
+        std::string lower = asciiLower(name);
+        for (const FieldInfo& info : FIELDS) {
+            for (const char* alias : info.names) {
+                if (alias && lower == alias) return &info;
+            }
+        }
+        return nullptr;
+    }
+
+    static Op parseOp(const std::string& text) {
+        if (text == "=") return Op::Equal;
+        if (text == "!=") return Op::NotEqual;
+        if (text == "<") return Op::Less;
+        if (text == "<=") return Op::LessEqual;
+        if (text == ">") return Op::Greater;
+        if (text == ">=") return Op::GreaterEqual;
+        if (text == "~") return Op::Contains;
+        if (text == "^=") return Op::Prefix;
+        return Op::In;
+    }
+
+    const std::vector<Token>& tokens_;
+    std::vector<Node>& nodes_;
+    std::string& error_;
+    size_t pos_ = 0;
+};
+
+// Оценка стоимости проверки на клиенте: дешёвые операнды AND/OR идут первыми
+int cost(const std::vector<Node>& nodes, int index) {
+    const Node& node = nodes[index];
+    if (node.type != NodeType::Compare) {
+        int total = 0;
+        for (int child : node.children) total += cost(nodes, child);
+        return total;
+    }
+    switch (fieldInfo(node.field).kind) {
+        case FieldKind::Flag:   return 1;
+        case FieldKind::Number: return 2;
+        case FieldKind::Genre:  return 3;
+        case FieldKind::Text:   return node.op == Op::Contains ? 6 : 4;
+        case FieldKind::Tag:    return node.op == Op::Contains ? 6 : 5;
+    }
+    return 6;
+}
+
+// ==================== Доступ к строке ====================
+
+struct GameRow {
+    const Game& game;
+
+    std::string_view text(Field field) const {
+        switch (field) {
+            case Field::Name:  return game.name;
+            case Field::Notes: return game.notes;
+            default:           return game.url;
+        }
+    }
+
+    bool genreIn(const Node& node) const {
+        return std::find(node.values.begin(), node.values.end(), game.genre) != node.values.end();
+    }
+
+    template <typename Predicate>
+    bool anyTag(Predicate predicate) const {
+        bool found = false;
+        TagDictionary::forEachTag(game.tags, [&found, &predicate](std::string_view tag) {
+            if (!found && predicate(tag)) found = true;
+        });
+        return found;
+    }
+
+    double number(Field field) const {
+        switch (field) {
+            case Field::Rating:    return game.rating;
+            case Field::DiskSpace: return game.disk_space;
+            case Field::RamUsage:  return game.ram_usage;
+            default:               return game.vram_required;
+        }
+    }
+
+    bool flag(Field field) const {
+        switch (field) {
+            case Field::Completed: return game.completed;
+            case Field::Favorite:  return game.is_favorite;
+            default:               return game.is_installed;
+        }
+    }
+};
+
+struct CompactRow {
+    const CompactGameCollection& games;
+    size_t index;
+
+    std::string_view text(Field field) const {
+        switch (field) {
+            case Field::Name:  return games.name(index);
+            case Field::Notes: return games.notes(index);
+            default:           return games.url(index);
+        }
+    }
+
+    bool genreIn(const Node& node) const {
+        uint16_t genre = games.at(index).genre;
+        if (genre < GENRES.size()) {
+            // Стандартный жанр сравнивается по индексу
+            return std::find(node.genres.begin(), node.genres.end(), genre) != node.genres.end();
+        }
+        std::string_view name = games.genre(index);
+        return std::find(node.values.begin(), node.values.end(), name) != node.values.end();
+    }
+
+    template <typename Predicate>
+    bool anyTag(Predicate predicate) const {
+        uint16_t count = games.at(index).tags_count;
+        for (size_t i = 0; i < count; ++i) {
+            if (predicate(games.tag(index, i))) return true;
+        }
+        return false;
+    }
+
+    double number(Field field) const {
+        const CompactGame& game = games.at(index);
+        switch (field) {
+            case Field::Rating:    return game.rating;
+            case Field::DiskSpace: return game.disk_space;
+            case Field::RamUsage:  return game.ram_usage;
+            default:               return game.vram_required;
+        }
+    }
+
+    bool flag(Field field) const {
+        const CompactGame& game = games.at(index);
+        switch (field) {
+            case Field::Completed: return game.completed();
+            case Field::Favorite:  return game.isFavorite();
+            default:               return game.isInstalled();
+        }
+    }
+};
+
+bool compareNumber(Op op, double value, double operand) {
+    switch (op) {
+        case Op::Equal:        return value == operand;
+        case Op::NotEqual:     return value != operand;
+        case Op::Less:         return value < operand;
+        case Op::LessEqual:    return value <= operand;
+        case Op::Greater:      return value > operand;
+        case Op::GreaterEqual: return value >= operand;
+        default:               return false;
+    }
+}
+
+bool isOrdering(Op op) {
+    return op == Op::Less || op == Op::LessEqual || op == Op::Greater || op == Op::GreaterEqual;
+}
+
+} // namespace
+
+bool FilterExpression::parse(const std::string& text, FilterExpression& out, std::string& error) {
+    error.clear();
+    out.nodes_.clear();
+    out.root_ = -1;
+
+    std::vector<Token> tokens;
+    if (!tokenize(text, tokens, error)) {
+        return false;
+    }
+    if (tokens.size() == 1) {
+        error = "Пустое выражение";
+        return false;
+    }
+
+    std::vector<Node> nodes;
+    Parser parser(tokens, nodes, error);
+    int root = parser.parse();
+    if (root < 0) {
+        return false;
+    }
+
+    // Упрощение: вложенные AND/OR одного типа сливаются, NOT NOT снимается.
+    // Потомки упорядочиваются по стоимости, при равной — по записи, поэтому
+    // равные по смыслу перестановки дают одинаковый toString()
+    out.nodes_ = std::move(nodes);
+    for (Node& node : out.nodes_) {
+        while (node.type == NodeType::Not) {
+            const Node& inner = out.nodes_[node.children.front()];
+            if (inner.type != NodeType::Not) break;
+            node = Node(out.nodes_[inner.children.front()]);
+        }
+    }
+    for (Node& node : out.nodes_) {
+        if (node.type != NodeType::And && node.type != NodeType::Or) continue;
+        std::vector<int> flat;
+        std::vector<int> pending(node.children.rbegin(), node.children.rend());
+        while (!pending.empty()) {
+            int child = pending.back();
+            pending.pop_back();
+            if (out.nodes_[child].type == node.type) {
+                pending.insert(pending.end(), out.nodes_[child].children.rbegin(),
+                               out.nodes_[child].children.rend());
+            } else {
+                flat.push_back(child);
+            }
+        }
+        node.children = std::move(flat);
+    }
+    out.root_ = root;
+
+    // Узлы создаются после своих потомков — сортировка снизу вверх
+    for (Node& node : out.nodes_) {
+        if (node.type != NodeType::And && node.type != NodeType::Or) continue;
+        std::vector<std::pair<std::pair<int, std::string>, int>> keyed;
+        for (int child : node.children) {
+            keyed.push_back({{cost(out.nodes_, child), out.text(child)}, child});
+        }
+        std::sort(keyed.begin(), keyed.end());
+        for (size_t i = 0; i < keyed.size(); ++i) {
+            node.children[i] = keyed[i].second;
+        }
+    }
+    return true;
+}
+
+template <typename Row>
+bool FilterExpression::evaluate(int index, const Row& row) const {
+    const Node& node = nodes_[index];
+    switch (node.type) {
+        case NodeType::And:
+            for (int child : node.children) {
+                if (!evaluate(child, row)) return false;
+            }
+            return true;
+        case NodeType::Or:
+            for (int child : node.children) {
+                if (evaluate(child, row)) return true;
+            }
+            return false;
+        case NodeType::Not:
+            return !evaluate(node.children.front(), row);
+        case NodeType::Compare:
+            break;
+    }
+
+    const auto& values = node.values;
+    auto isValue = [&values](std::string_view text) {
+        return std::find(values.begin(), values.end(), text) != values.end();
+    };
+
+    switch (fieldInfo(node.field).kind) {
+        case FieldKind::Text: {
+            std::string_view text = row.text(node.field);
+            switch (node.op) {
+                case Op::NotEqual: return text != values.front();
+                case Op::Contains: return text.find(values.front()) != std::string_view::npos;
+                case Op::Prefix:   return text.substr(0, values.front().size()) == values.front();
+                default:           return isValue(text);
+            }
+        }
+        case FieldKind::Genre:
+            return row.genreIn(node) != (node.op == Op::NotEqual);
+        case FieldKind::Tag:
+            if (node.op == Op::Contains) {
+                const std::string& part = values.front();
+                return row.anyTag([&part](std::string_view tag) {
+                    return tag.find(part) != std::string_view::npos;
+                });
+            }
+            return row.anyTag(isValue) != (node.op == Op::NotEqual);
+        case FieldKind::Number: {
+            double value = row.number(node.field);
+            if (node.field == Field::Rating && isOrdering(node.op) && value < 0) {
+                return false;
+            }
+            return compareNumber(node.op, value, node.number);
+        }
+        case FieldKind::Flag:
+            return row.flag(node.field) == node.flag;
+    }
+    return false;
+}
+
+bool FilterExpression::matches(const Game& game) const {
+    return root_ < 0 || evaluate(root_, GameRow{game});
+}
+
+bool FilterExpression::matches(const CompactGameCollection& games, size_t index) const {
+    return root_ < 0 || evaluate(root_, CompactRow{games, index});
+}
+
+uint32_t FilterExpression::fieldMask() const {
+    uint32_t mask = 0;
+    for (const Node& node : nodes_) {
+        if (node.type == NodeType::Compare) {
+            mask |= fieldInfo(node.field).bit;
+        }
+    }
+    return mask;
+}
+
+std::string FilterExpression::sqlCondition(int first_placeholder, std::vector<SqlParam>& params) const {
+    if (root_ < 0) return "";
+    int placeholder = first_placeholder;
+    return sql(root_, placeholder, params);
+}
+
+std::string FilterExpression::sql(int index, int& placeholder, std::vector<SqlParam>& params) const {
+    const Node& node = nodes_[index];
+    if (node.type == NodeType::And || node.type == NodeType::Or) {
+        std::string result = "(";
+        for (size_t i = 0; i < node.children.size(); ++i) {
+            if (i > 0) result += node.type == NodeType::And ? " AND " : " OR ";
+            result += sql(node.children[i], placeholder, params);
+        }
+        return result + ")";
+    }
+    if (node.type == NodeType::Not) {
+        return "NOT " + sql(node.children.front(), placeholder, params);
+    }
+
+    auto bindText = [&params, &placeholder](const std::string& value) {
+        SqlParam param;
+        param.type = SqlParam::Type::Text;
+        param.text_value = value;
+        params.push_back(std::move(param));
+        return "$" + std::to_string(placeholder++) + "::text";
+    };
+    auto bindList = [&node, &bindText]() {
+        std::string list;
+        for (const std::string& value : node.values) {
+            if (!list.empty()) list += ", ";
+            list += bindText(value);
+        }
+        return list;
+    };
+
+    const FieldInfo& info = fieldInfo(node.field);
+    std::string column = info.column;
+    switch (info.kind) {
+        case FieldKind::Text:
+        case FieldKind::Genre:
+            switch (node.op) {
+                case Op::NotEqual:
+                    return "(" + column + " <> " + bindText(node.values.front()) + ")";
+                case Op::Contains:
+                    return "(" + column + " LIKE " + bindText("%" + CompiledFilter::escapeLike(node.values.front()) + "%") + ")";
+                case Op::Prefix:
+                    // Префикс без ведущего % использует индекс text_pattern_ops
+                    return "(" + column + " LIKE " + bindText(CompiledFilter::escapeLike(node.values.front()) + "%") + ")";
+                default:
+                    if (node.values.size() == 1) {
+                        return "(" + column + " = " + bindText(node.values.front()) + ")";
+                    }
+                    return "(" + column + " IN (" + bindList() + "))";
+            }
+        case FieldKind::Tag:
+            switch (node.op) {
+                case Op::Contains:
+                    // Подстрока ищется в каждом теге, а не во всей строке
+                    // тегов: "a ~ ','" не должно находить разделитель
+                    return "(EXISTS (SELECT 1 FROM unnest(" + std::string(TAGS_ARRAY_SQL) + ") AS t(tag) WHERE t.tag LIKE " +
+                           bindText("%" + CompiledFilter::escapeLike(node.values.front()) + "%") + "))";
+                case Op::NotEqual:
+                    return "(NOT " + std::string(TAGS_ARRAY_SQL) + " && ARRAY[" + bindList() + "])";
+                default:
+                    // Операторы массивов проверяются по GIN-индексу
+                    return "(" + std::string(TAGS_ARRAY_SQL) + " && ARRAY[" + bindList() + "])";
+            }
+        case FieldKind::Number: {
+            SqlParam param;
+            if (node.field == Field::Rating) {
+                param.type = SqlParam::Type::Int;
+                param.int_value = static_cast<int>(node.number);
+            } else {
+                param.type = SqlParam::Type::Double;
+                param.double_value = node.number;
+            }
+            params.push_back(param);
+            std::string op = node.op == Op::NotEqual ? "<>" : opText(node.op);
+            std::string condition = column + " " + op + " $" + std::to_string(placeholder++);
+            if (node.field == Field::Rating && isOrdering(node.op)) {
+                condition = column + " >= 0 AND " + condition;
+            }
+            return "(" + condition + ")";
+        }
+        case FieldKind::Flag: {
+            SqlParam param;
+            param.type = SqlParam::Type::Bool;
+            param.bool_value = node.flag;
+            params.push_back(param);
+            return "(" + column + " = $" + std::to_string(placeholder++) + ")";
+        }
+    }
+    return "FALSE";
+}
+
+std::string FilterExpression::toString() const {
+    return root_ < 0 ? "" : text(root_);
+}
+
+std::string FilterExpression::text(int index) const {
+    const Node& node = nodes_[index];
+    if (node.type == NodeType::And || node.type == NodeType::Or) {
+        std::string result = "(";
+        for (size_t i = 0; i < node.children.size(); ++i) {
+            if (i > 0) result += node.type == NodeType::And ? " and " : " or ";
+            result += text(node.children[i]);
+        }
+        return result + ")";
+    }
+    if (node.type == NodeType::Not) {
+        return "not " + text(node.children.front());
+    }
+
+    const FieldInfo& info = fieldInfo(node.field);
+    std::string result = std::string(info.names[0]) + " " + opText(node.op) + " ";
+    switch (info.kind) {
+        case FieldKind::Number:
+            return result + numberText(node.number);
+        case FieldKind::Flag:
+            return result + (node.flag ? "true" : "false");
+        default:
+            if (node.op != Op::In) {
+                return result + quoted(node.values.front());
+            }
+            result += "(";
+            for (size_t i = 0; i < node.values.size(); ++i) {
+                if (i > 0) result += ", ";
+                result += quoted(node.values[i]);
+            }
+            return result + ")";
+    }
+}
+
+}
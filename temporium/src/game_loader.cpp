@@ -0,0 +1,128 @@
+#include "game_loader.h"
+#include <tuple>
+#include <utility>
+
+namespace Temporium {
+
+GameLoader::GameLoader(QObject* parent)
+    : QObject(parent)
+    , worker_(new QObject())
+    , generation_(0)
+    , running_(0)
+    , statementTimeout_(0)
+{
+    qRegisterMetaType<std::shared_ptr<Temporium::CompactGameCollection>>("std::shared_ptr<Temporium::CompactGameCollection>");
+
+    worker_->moveToThread(&thread_);
+    connect(&thread_, &QThread::finished, worker_, &QObject::deleteLater);
+    thread_.start();
+}
+
+GameLoader::~GameLoader() {
+    cancel();
+    thread_.quit();
+    thread_.wait();
+}
+
+void GameLoader::setConnectionString(const std::string& conn_str) {
+    conn_str_ = conn_str;
+}
+
+void GameLoader::setStatementTimeout(int ms) {
+    statementTimeout_ = ms;
+}
+
+void GameLoader::preconnect() {
+    std::string conn_str = conn_str_;
+    QMetaObject::invokeMethod(worker_, [this, conn_str]() {
+        ensureConnected(conn_str);
+    }, Qt::QueuedConnection);
+}
+
+quint64 GameLoader::loadAll(int user_id) {
+    return start(user_id, false, GameFilter(), nullptr);
+}
+
+quint64 GameLoader::loadFiltered(int user_id, const GameFilter& filter) {
+    return start(user_id, true, filter, nullptr);
+}
+
+quint64 GameLoader::loadFiltered(int user_id, std::shared_ptr<const FilterExpression> expression) {
+    return start(user_id, false, GameFilter(), std::move(expression));
+}
+
+void GameLoader::cancel() {
+    ++generation_;
+    interruptRunning();
+}
+
+void GameLoader::interruptRunning() {
+    // Без выполняющейся загрузки отмену не посылаем: она досталась бы
+    // следующему запросу этого соединения
+    if (running_.load() != 0) {
+        db_.cancelQuery();
+    }
+}
+
+quint64 GameLoader::start(int user_id, bool filtered, const GameFilter& filter,
+                          std::shared_ptr<const FilterExpression> expression) {
+    quint64 generation = ++generation_;
+    interruptRunning();
+    std::string conn_str = conn_str_;
+
+    QMetaObject::invokeMethod(worker_, [this, generation, conn_str, user_id, filtered, filter, expression]() {
+        run(generation, conn_str, user_id, filtered, filter, expression.get());
+    }, Qt::QueuedConnection);
+
+    return generation;
+}
+
+bool GameLoader::ensureConnected(const std::string& conn_str) {
+    int timeout = statementTimeout_.load();
+    if (db_.statementTimeout() != timeout) {
+        db_.setStatementTimeout(timeout);
+    }
+    if (db_.isConnected() && db_.getConnectionString() == conn_str) {
+        return true;
+    }
+    return db_.connectSecondary(conn_str);
+}
+
+void GameLoader::run(quint64 generation, const std::string& conn_str,
+                     int user_id, bool filtered, const GameFilter& filter,
+                     const FilterExpression* expression) {
+    // Загрузка уже устарела, пока ждала в очереди
+    if (generation != generation_) return;
+
+    if (!ensureConnected(conn_str)) {
+        emit loadFinished(generation, false, QString::fromStdString(db_.getLastError()));
+        return;
+    }
+
+    auto stream = [&]() {
+        bool delivered = false;
+        running_ = generation;
+        bool ok = db_.streamGames(user_id, filtered ? &filter : nullptr, expression,
+                                  FIRST_CHUNK_SIZE, CHUNK_SIZE,
+                                  [this, generation, &delivered](CompactGameCollection&& chunk) {
+            if (generation != generation_) return false;
+            delivered = true;
+            emit chunkLoaded(generation, std::make_shared<CompactGameCollection>(std::move(chunk)));
+            return true;
+        });
+        running_ = 0;
+        return std::make_pair(ok, delivered);
+    };
+    
+    auto [ok, delivered] = stream();
+    // Отмена предыдущей загрузки могла дойти до сервера, когда он уже
+    // выполнял эту: она не отменена — запускаем ещё раз
+    if (!ok && !delivered && db_.wasCancelled() && generation == generation_ &&
+        ensureConnected(conn_str)) {
+        std::tie(ok, delivered) = stream();
+    }
+
+    emit loadFinished(generation, ok, ok ? QString() : QString::fromStdString(db_.getLastError()));
+}
+
+}
@@ -0,0 +1,237 @@
+#include "game_sorter.h"
+#include "task_scheduler.h"
+#include "trace.h"
+#include <QLocale>
+#include <QString>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace Temporium {
+
+namespace {
+
+// Резерв под добавление порции с геометрическим ростом: точный
+// reserve(size + n) на каждой порции копировал бы весь вектор каждый раз
+template <typename Vector>
+void reserveMore(Vector& vector, size_t extra) {
+    size_t needed = vector.size() + extra;
+    if (needed > vector.capacity()) {
+        vector.reserve(std::max(needed, vector.capacity() * 2));
+    }
+}
+
+// Ключ столбца для требования игры: те же биты, что у float, с поправкой
+// знака, чтобы беззнаковое сравнение ключей совпадало с числовым.
+// Дробная часть (1.5 ГБ) сохраняется, а не отбрасывается
+uint32_t numberKey(double value) {
+    float narrowed = static_cast<float>(value);
+    uint32_t bits;
+    std::memcpy(&bits, &narrowed, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+} // namespace
+
+GameSorter::GameSorter()
+    : collator_(QLocale())
+    , count_(0)
+    , ranksDirty_(false)
+{
+    collator_.setCaseSensitivity(Qt::CaseInsensitive);
+    collator_.setNumericMode(true);  // "Witcher 2" < "Witcher 10"
+}
+
+void GameSorter::DistinctKeys::clear() {
+    ids.clear();
+    texts.clear();
+    keys.clear();
+    rows.clear();
+}
+
+void GameSorter::clear() {
+    count_ = 0;
+    nameKeys_.clear();
+    genres_.clear();
+    tags_.clear();
+    for (auto& column : columns_) {
+        column.clear();
+    }
+    ranksDirty_ = false;
+}
+
+void GameSorter::reserve(size_t count) {
+    size_t extra = count > count_ ? count - count_ : 0;
+    reserveMore(nameKeys_, extra);
+    reserveMore(genres_.rows, extra);
+    reserveMore(tags_.rows, extra);
+    for (auto& column : columns_) {
+        reserveMore(column, extra);
+    }
+}
+
+uint32_t GameSorter::distinctId(DistinctKeys& column, std::string_view text) {
+    // Поиск по string_view: строка копируется только для нового значения
+    auto it = column.ids.find(text);
+    if (it != column.ids.end()) {
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(column.keys.size());
+    column.keys.push_back(collator_.sortKey(QString::fromUtf8(text.data(), static_cast<int>(text.size()))));
+    column.ids.emplace(column.texts.emplace_back(text), id);
+    return id;
+}
+
+void GameSorter::appendRow(const GameFields& game) {
+    nameKeys_.push_back(collator_.sortKey(QString::fromUtf8(game.name.data(), static_cast<int>(game.name.size()))));
+    genres_.rows.push_back(0);
+    tags_.rows.push_back(0);
+    for (auto& column : columns_) {
+        column.push_back(0);
+    }
+
+    ++count_;
+    writeRow(count_ - 1, game);
+}
+
+void GameSorter::writeRow(size_t row, const GameFields& game) {
+    auto column = [this, row](SortColumn c) -> uint32_t& {
+        return columns_[static_cast<size_t>(c)][row];
+    };
+
+    genres_.rows[row] = distinctId(genres_, game.genre);
+    tags_.rows[row] = distinctId(tags_, game.tags);
+
+    // Строковые столбцы (Name, Genre, Tags) заполняются рангами в ensureRanks()
+    column(SortColumn::Id) = static_cast<uint32_t>(game.id);
+    column(SortColumn::DiskSpace) = numberKey(game.disk_space);
+    column(SortColumn::RamUsage) = numberKey(game.ram_usage);
+    column(SortColumn::VramRequired) = numberKey(game.vram_required);
+    column(SortColumn::Completed) = game.completed ? 1 : 0;
+    // -1 (нет оценки) -> 0, оценки 0-10 -> 1-11
+    column(SortColumn::Rating) = static_cast<uint32_t>(std::max(game.rating, -1) + 1);
+    column(SortColumn::Favorite) = game.is_favorite ? 1 : 0;
+    column(SortColumn::Installed) = game.is_installed ? 1 : 0;
+
+    ranksDirty_ = true;
+}
+
+void GameSorter::update(size_t row, const Game& game) {
+    GameFields fields = gameFields(game);
+    nameKeys_[row] = collator_.sortKey(QString::fromUtf8(fields.name.data(), static_cast<int>(fields.name.size())));
+    writeRow(row, fields);
+}
+
+void GameSorter::erase(size_t row) {
+    auto at = [row](auto& vector) { return vector.begin() + static_cast<std::ptrdiff_t>(row); };
+    nameKeys_.erase(at(nameKeys_));
+    genres_.rows.erase(at(genres_.rows));
+    tags_.rows.erase(at(tags_.rows));
+    for (auto& column : columns_) {
+        column.erase(at(column));
+    }
+
+    --count_;
+    ranksDirty_ = true;
+}
+
+void GameSorter::append(const Game& game) {
+    appendRow(gameFields(game));
+}
+
+void GameSorter::append(const std::vector<Game>& games) {
+    reserve(count_ + games.size());
+    for (const auto& game : games) {
+        appendRow(gameFields(game));
+    }
+}
+
+void GameSorter::append(const CompactGameCollection& games, size_t first) {
+    reserve(count_ + games.size() - std::min(first, games.size()));
+    std::string tags;
+    for (size_t i = first; i < games.size(); ++i) {
+        appendRow(games.fields(i, tags));
+    }
+}
+
+void GameSorter::rankKeys(const std::vector<QCollatorSortKey>& keys, std::vector<uint32_t>& ranks) {
+    std::vector<int> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    parallelStableSort(order, [&keys](int a, int b) {
+        return keys[a].compare(keys[b]) < 0;
+    });
+
+    // Плотные ранги: равные строки получают одинаковый ранг
+    uint32_t rank = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && keys[order[i - 1]].compare(keys[order[i]]) != 0) {
+            ++rank;
+        }
+        ranks[order[i]] = rank;
+    }
+}
+
+void GameSorter::rankDistinct(const DistinctKeys& column, std::vector<uint32_t>& ranks) {
+    std::vector<uint32_t> distinctRanks(column.keys.size());
+    rankKeys(column.keys, distinctRanks);
+    for (size_t row = 0; row < column.rows.size(); ++row) {
+        ranks[row] = distinctRanks[column.rows[row]];
+    }
+}
+
+void GameSorter::ensureRanks() const {
+    if (!ranksDirty_) return;
+
+    rankKeys(nameKeys_, columns_[static_cast<size_t>(SortColumn::Name)]);
+    rankDistinct(genres_, columns_[static_cast<size_t>(SortColumn::Genre)]);
+    rankDistinct(tags_, columns_[static_cast<size_t>(SortColumn::Tags)]);
+    ranksDirty_ = false;
+}
+
+std::vector<int> GameSorter::sort(const std::vector<SortKey>& keys) const {
+    TraceSpan span("GameSorter::sort", "model");
+    std::vector<int> order(count_);
+    std::iota(order.begin(), order.end(), 0);
+
+    struct ActiveKey {
+        const uint32_t* values;
+        bool ascending;
+    };
+
+    // Повторы столбца в списке ключей ничего не меняют — отбрасываем
+    std::vector<ActiveKey> active;
+    std::array<bool, COLUMN_COUNT> used{};
+    for (const auto& key : keys) {
+        size_t index = static_cast<size_t>(key.column);
+        if (index >= COLUMN_COUNT || used[index]) continue;
+        used[index] = true;
+        active.push_back({columns_[index].data(), key.ascending});
+    }
+
+    if (active.empty() || count_ < 2) {
+        return order;
+    }
+
+    // Ранги пересчитываются на месте, указатели на данные столбцов остаются валидными
+    if (used[static_cast<size_t>(SortColumn::Name)] ||
+        used[static_cast<size_t>(SortColumn::Genre)] ||
+        used[static_cast<size_t>(SortColumn::Tags)]) {
+        ensureRanks();
+    }
+
+    parallelStableSort(order, [&active](int a, int b) {
+        for (const auto& key : active) {
+            uint32_t va = key.values[a];
+            uint32_t vb = key.values[b];
+            if (va != vb) {
+                return key.ascending ? va < vb : va > vb;
+            }
+        }
+        return false;
+    });
+
+    return order;
+}
+
+}
@@ -0,0 +1,444 @@
+#include "games_table_model.h"
+#include "theme.h"
+#include "task_scheduler.h"
+#include "trace.h"
+#include <QColor>
+#include <QFont>
+#include <algorithm>
+
+namespace Temporium {
+
+namespace {
+
+// Строк на одну задачу пула при проверке фильтра
+constexpr size_t FILTER_ROWS_PER_TASK = 16384;
+
+QString toQString(std::string_view text) {
+    return QString::fromUtf8(text.data(), static_cast<int>(text.size()));
+}
+
+QString displayText(const CompactGameCollection& games, size_t index, int column) {
+    const CompactGame& game = games.at(index);
+    switch (column) {
+        case GamesTableModel::COL_ID:
+            return QString::number(game.id);
+        case GamesTableModel::COL_NAME: {
+            // Название с индикатором заметок
+            QString name = toQString(games.name(index));
+            if (game.notes.length > 0) {
+                name += " 📝";
+            }
+            return name;
+        }
+        case GamesTableModel::COL_DISK:
+            return QString::number(game.disk_space, 'f', 1);
+        case GamesTableModel::COL_RAM:
+            return QString::number(game.ram_usage, 'f', 1);
+        case GamesTableModel::COL_VRAM:
+            return QString::number(game.vram_required, 'f', 1);
+        case GamesTableModel::COL_GENRE:
+            return QString::fromStdString(games.genre(index));
+        case GamesTableModel::COL_COMPLETED:
+            return game.completed() ? "Да ✓" : "Нет";
+        case GamesTableModel::COL_RATING:
+            return (game.rating < 0) ? "—" : QString::number(game.rating);
+        case GamesTableModel::COL_FAVORITE:
+            return game.isFavorite() ? "★" : "";
+        case GamesTableModel::COL_INSTALLED:
+            return game.isInstalled() ? "📥" : "";
+        case GamesTableModel::COL_TAGS:
+            return QString::fromStdString(games.tags(index));
+        case GamesTableModel::COL_URL:
+            return game.url.length == 0 ? "" : "🔗 Открыть";
+        default:
+            return QString();
+    }
+}
+
+QVariant foreground(const CompactGame& game, int column) {
+    switch (column) {
+        case GamesTableModel::COL_RATING:
+            if (game.rating >= 8) return QColor("#4CAF50");
+            if (game.rating >= 5) return QColor("#FFC107");
+            if (game.rating >= 0) return QColor("#F44336");
+            return QVariant();
+        case GamesTableModel::COL_FAVORITE:
+            return game.isFavorite() ? QVariant(QColor("#FFD700")) : QVariant();
+        case GamesTableModel::COL_INSTALLED:
+            return game.isInstalled() ? QVariant(QColor("#2196F3")) : QVariant();
+        case GamesTableModel::COL_TAGS:
+            return QColor(TEXT_SECONDARY);
+        case GamesTableModel::COL_URL:
+            return game.url.length == 0 ? QVariant() : QVariant(QColor(ACCENT_COLOR));
+        default:
+            return QVariant();
+    }
+}
+
+QVariant font(const CompactGame& game, int column) {
+    QFont cellFont;
+    switch (column) {
+        case GamesTableModel::COL_FAVORITE:
+            if (!game.isFavorite()) return QVariant();
+            cellFont.setPointSize(14);
+            return cellFont;
+        case GamesTableModel::COL_INSTALLED:
+            if (!game.isInstalled()) return QVariant();
+            cellFont.setPointSize(12);
+            return cellFont;
+        case GamesTableModel::COL_URL:
+            if (game.url.length == 0) return QVariant();
+            cellFont.setUnderline(true);
+            return cellFont;
+        default:
+            return QVariant();
+    }
+}
+
+QVariant toolTip(const CompactGameCollection& games, size_t index, int column) {
+    const CompactGame& game = games.at(index);
+    if (column == GamesTableModel::COL_NAME && game.notes.length > 0) {
+        return "Есть заметки: " + toQString(games.notes(index)).left(100) + "...";
+    }
+    if (column == GamesTableModel::COL_URL && game.url.length > 0) {
+        return toQString(games.url(index));
+    }
+    return QVariant();
+}
+
+QVariant background(const CompactGame& game) {
+    if (game.completed()) {
+        return QColor(30, 60, 30, 180);
+    }
+    if (game.isFavorite()) {
+        return QColor(60, 50, 20, 150);
+    }
+    return QVariant();
+}
+
+} // namespace
+
+GamesTableModel::GamesTableModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int GamesTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(order_.size());
+}
+
+int GamesTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant GamesTableModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= static_cast<int>(order_.size())) {
+        return QVariant();
+    }
+
+    size_t gameIndex = static_cast<size_t>(order_[index.row()]);
+    const CompactGame& game = games_.at(gameIndex);
+    int column = index.column();
+
+    switch (role) {
+        case Qt::DisplayRole:
+            return displayText(games_, gameIndex, column);
+        case Qt::ForegroundRole:
+            return foreground(game, column);
+        case Qt::FontRole:
+            return font(game, column);
+        case Qt::ToolTipRole:
+            return toolTip(games_, gameIndex, column);
+        case Qt::BackgroundRole:
+            return background(game);
+        case Qt::TextAlignmentRole:
+            if (column == COL_RATING || column == COL_FAVORITE || column == COL_INSTALLED) {
+                return static_cast<int>(Qt::AlignCenter);
+            }
+            return QVariant();
+        case UrlRole:
+            return toQString(games_.url(gameIndex));
+        case NotesRole:
+            return toQString(games_.notes(gameIndex));
+        default:
+            return QVariant();
+    }
+}
+
+QVariant GamesTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    static const QStringList HEADERS = {
+        "ID", "Название", "Диск (ГБ)", "ОЗУ (ГБ)", "VRAM (ГБ)", "Жанр", "Пройдено", "Оценка", "★", "📥", "Теги", "Ссылка"
+    };
+
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole &&
+        section >= 0 && section < HEADERS.size()) {
+        return HEADERS[section];
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+void GamesTableModel::setGames(const std::vector<Game>& games) {
+    beginResetModel();
+    games_.clear();
+    games_.append(games);
+    stats_.reset();
+    stats_.add(games);
+    sorter_.clear();
+    sorter_.append(games);
+    rowFilter_.reset();
+    invalidateOrder();
+    filterCache_.clear();
+    machineIndexValid_ = false;
+    similarIndexValid_ = false;
+    order_ = visibleOrder();
+    endResetModel();
+}
+
+void GamesTableModel::clear() {
+    beginResetModel();
+    games_.clear();
+    order_.clear();
+    sorter_.clear();
+    rowFilter_.reset();
+    invalidateOrder();
+    filterCache_.clear();
+    machineIndexValid_ = false;
+    similarIndexValid_ = false;
+    stats_.reset();
+    endResetModel();
+}
+
+void GamesTableModel::appendGames(CompactGameCollection&& games) {
+    if (games.empty()) return;
+
+    int first = static_cast<int>(order_.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(games.size()) - 1);
+
+    // Ключи и статистика — до присоединения, пока порция отдельно
+    size_t base = games_.size();
+    sorter_.append(games);
+    stats_.add(games);
+    games_.append(std::move(games));
+    invalidateOrder();
+    filterCache_.clear();
+    machineIndexValid_ = false;
+    similarIndexValid_ = false;
+    order_.reserve(games_.size());
+    for (size_t i = base; i < games_.size(); ++i) {
+        order_.push_back(static_cast<int>(i));
+    }
+
+    endInsertRows();
+}
+
+void GamesTableModel::finishLoading() {
+    if (rowFilter_) {
+        // Порции добавлялись без фильтра — набор строк меняется
+        beginResetModel();
+        order_ = visibleOrder();
+        endResetModel();
+    } else if (!sortKeys_.empty()) {
+        applySort();
+    }
+}
+
+Game GamesTableModel::gameAt(int row) const {
+    return games_.toGame(static_cast<size_t>(order_[row]));
+}
+
+void GamesTableModel::setGameNotes(int row, const std::string& notes) {
+    if (row < 0 || row >= static_cast<int>(order_.size())) return;
+
+    size_t gameIndex = static_cast<size_t>(order_[row]);
+    games_.setNotes(gameIndex, notes);
+    filterCache_.rowUpdated(games_, static_cast<uint32_t>(gameIndex), FIELD_NOTES);
+    emit dataChanged(index(row, 0), index(row, COLUMN_COUNT - 1));
+}
+
+void GamesTableModel::addGame(const Game& game) {
+    uint32_t gameIndex = static_cast<uint32_t>(games_.size());
+    games_.append(game);
+    sorter_.append(game);
+    stats_.add(game);
+    filterCache_.rowAppended(games_, gameIndex);
+    machineIndexValid_ = false;
+    similarIndexValid_ = false;
+    invalidateOrder();
+
+    // Порядок остальных строк не меняется: новая строка вставляется на своё место
+    std::vector<int> newOrder = visibleOrder();
+    auto it = std::find(newOrder.begin(), newOrder.end(), static_cast<int>(gameIndex));
+    if (it == newOrder.end()) return;
+
+    int row = static_cast<int>(it - newOrder.begin());
+    beginInsertRows(QModelIndex(), row, row);
+    order_.swap(newOrder);
+    endInsertRows();
+}
+
+void GamesTableModel::updateGame(int row, const Game& game) {
+    if (row < 0 || row >= static_cast<int>(order_.size())) return;
+
+    size_t gameIndex = static_cast<size_t>(order_[row]);
+    Game before = games_.toGame(gameIndex);
+    games_.replace(gameIndex, game);
+    sorter_.update(gameIndex, game);
+    stats_.remove(before);
+    stats_.add(game);
+    uint32_t changed = FilterResultCache::changedFields(before, game);
+    filterCache_.rowUpdated(games_, static_cast<uint32_t>(gameIndex), changed);
+    if (changed & (FIELD_RAM_USAGE | FIELD_VRAM_REQUIRED | FIELD_DISK_SPACE)) {
+        machineIndexValid_ = false;
+    }
+    if (changed & (FIELD_TAGS | FIELD_GENRE | FIELD_RAM_USAGE | FIELD_VRAM_REQUIRED | FIELD_DISK_SPACE)) {
+        similarIndexValid_ = false;
+    }
+    invalidateOrder();
+
+    std::vector<int> newOrder = visibleOrder();
+    auto it = std::find(newOrder.begin(), newOrder.end(), static_cast<int>(gameIndex));
+    if (it == newOrder.end()) {
+        // Игра больше не проходит фильтр
+        beginRemoveRows(QModelIndex(), row, row);
+        order_.swap(newOrder);
+        endRemoveRows();
+        return;
+    }
+
+    int newRow = static_cast<int>(it - newOrder.begin());
+    relayout(std::move(newOrder));
+    emit dataChanged(index(newRow, 0), index(newRow, COLUMN_COUNT - 1));
+}
+
+void GamesTableModel::removeGame(int row) {
+    if (row < 0 || row >= static_cast<int>(order_.size())) return;
+
+    int gameIndex = order_[row];
+    stats_.remove(games_.toGame(static_cast<size_t>(gameIndex)));
+
+    beginRemoveRows(QModelIndex(), row, row);
+    games_.erase(static_cast<size_t>(gameIndex));
+    sorter_.erase(static_cast<size_t>(gameIndex));
+    filterCache_.rowRemoved(static_cast<uint32_t>(gameIndex));
+    machineIndexValid_ = false;
+    similarIndexValid_ = false;
+    invalidateOrder();
+    order_.erase(order_.begin() + row);
+    for (int& i : order_) {
+        if (i > gameIndex) --i;
+    }
+    endRemoveRows();
+}
+
+bool GamesTableModel::isSortable(int column) {
+    return column >= 0 && column < static_cast<int>(SortColumn::Count);
+}
+
+void GamesTableModel::setSortKeys(const std::vector<SortKey>& keys) {
+    sortKeys_ = keys;
+    invalidateOrder();
+    applySort();
+}
+
+void GamesTableModel::setRowFilter(std::shared_ptr<const RowPredicate> filter) {
+    // Меняется набор строк, а не только их порядок
+    beginResetModel();
+    rowFilter_ = std::move(filter);
+    order_ = visibleOrder();
+    endResetModel();
+}
+
+const MachineFitIndex& GamesTableModel::machineIndex() {
+    if (!machineIndexValid_) {
+        machineIndex_.build(games_);
+        machineIndexValid_ = true;
+    }
+    return machineIndex_;
+}
+
+const SimilarGamesIndex& GamesTableModel::similarIndex() {
+    if (!similarIndexValid_) {
+        similarIndex_.build(games_);
+        similarIndexValid_ = true;
+    }
+    return similarIndex_;
+}
+
+void GamesTableModel::invalidateOrder() {
+    sortedValid_ = false;
+}
+
+std::vector<int> GamesTableModel::visibleOrder() {
+    if (!sortedValid_) {
+        sorted_ = sorter_.sort(sortKeys_);
+        sortedValid_ = true;
+    }
+    if (!rowFilter_) {
+        return sorted_;
+    }
+
+    // Недавний фильтр берётся из кэша без проверки строк
+    std::vector<uint32_t> matched;
+    const std::vector<uint32_t>* rows = filterCache_.find(*rowFilter_);
+    if (!rows) {
+        TraceSpan span("GamesTableModel: filter rows", "model");
+        // Строки проверяются кусками параллельно; куски склеиваются по порядку
+        const size_t chunk = FILTER_ROWS_PER_TASK;
+        std::vector<std::vector<uint32_t>> parts((games_.size() + chunk - 1) / chunk);
+        const RowPredicate& filter = *rowFilter_;
+        parallelFor(0, parts.size(), 1, [this, &filter, &parts, chunk](size_t lo, size_t hi) {
+            for (size_t part = lo; part < hi; ++part) {
+                size_t end = std::min(games_.size(), (part + 1) * chunk);
+                for (size_t i = part * chunk; i < end; ++i) {
+                    if (filter.matches(games_, i)) {
+                        parts[part].push_back(static_cast<uint32_t>(i));
+                    }
+                }
+            }
+        });
+        for (const auto& part : parts) {
+            matched.insert(matched.end(), part.begin(), part.end());
+        }
+        filterCache_.insert(rowFilter_, matched);
+        rows = &matched;
+    }
+
+    std::vector<char> visible(games_.size(), 0);
+    for (uint32_t row : *rows) {
+        visible[row] = 1;
+    }
+    std::vector<int> order;
+    order.reserve(rows->size());
+    for (int i : sorted_) {
+        if (visible[i]) order.push_back(i);
+    }
+    return order;
+}
+
+void GamesTableModel::applySort() {
+    relayout(visibleOrder());
+}
+
+void GamesTableModel::relayout(std::vector<int> newOrder) {
+    emit layoutAboutToBeChanged();
+
+    // Выделение и текущая строка следуют за своими играми
+    std::vector<int> rowOf(games_.size(), -1);
+    for (size_t row = 0; row < newOrder.size(); ++row) {
+        rowOf[newOrder[row]] = static_cast<int>(row);
+    }
+
+    QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    to.reserve(from.size());
+    for (const QModelIndex& index : from) {
+        int row = rowOf[order_[index.row()]];
+        to.append(row >= 0 ? this->index(row, index.column()) : QModelIndex());
+    }
+    changePersistentIndexList(from, to);
+
+    order_.swap(newOrder);
+    emit layoutChanged();
+}
+
+}
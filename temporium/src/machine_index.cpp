@@ -0,0 +1,146 @@
+#include "machine_index.h"
+#include <algorithm>
+#include <limits>
+
+namespace Temporium {
+
+void MachineFitIndex::build(const CompactGameCollection& games) {
+    clear();
+    points_.reserve(games.size());
+    for (size_t i = 0; i < games.size(); ++i) {
+        const CompactGame& game = games.at(i);
+        points_.push_back({{game.ram_usage, game.vram_required, game.disk_space}, static_cast<uint32_t>(i)});
+    }
+    if (!points_.empty()) {
+        nodes_.reserve(2 * (points_.size() / LEAF_SIZE + 1));
+        buildNode(0, static_cast<uint32_t>(points_.size()), 0);
+    }
+}
+
+void MachineFitIndex::clear() {
+    points_.clear();
+    nodes_.clear();
+}
+
+int32_t MachineFitIndex::buildNode(uint32_t begin, uint32_t end, int depth) {
+    int32_t id = static_cast<int32_t>(nodes_.size());
+    nodes_.emplace_back();
+
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.min.fill(std::numeric_limits<double>::infinity());
+    node.max.fill(-std::numeric_limits<double>::infinity());
+    for (uint32_t i = begin; i < end; ++i) {
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            node.min[d] = std::min(node.min[d], points_[i].point[d]);
+            node.max[d] = std::max(node.max[d], points_[i].point[d]);
+        }
+    }
+
+    if (end - begin > LEAF_SIZE) {
+        // Делим по медиане измерения с наибольшим разбросом
+        // (требования сильно коррелируют, чередование осей хуже)
+        int axis = depth % DIMENSIONS;
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            if (node.max[d] - node.min[d] > node.max[axis] - node.min[axis]) axis = d;
+        }
+        uint32_t mid = begin + (end - begin) / 2;
+        std::nth_element(points_.begin() + begin, points_.begin() + mid, points_.begin() + end,
+                         [axis](const Entry& a, const Entry& b) { return a.point[axis] < b.point[axis]; });
+        node.left = buildNode(begin, mid, depth + 1);
+        node.right = buildNode(mid, end, depth + 1);
+    }
+
+    nodes_[id] = node;
+    return id;
+}
+
+MachineFitIndex::Point MachineFitIndex::limits(const MachineProfile& profile) {
+    return {{static_cast<double>(profile.ram), static_cast<double>(profile.vram),
+             static_cast<double>(profile.disk)}};
+}
+
+void MachineFitIndex::query(int32_t id, std::vector<uint32_t>& active, const std::vector<Point>& limits,
+                            std::vector<std::vector<uint32_t>>* rows, std::vector<size_t>& counts) const {
+    const Node& node = nodes_[id];
+
+    // Профили, для которых поддерево надо просматривать дальше
+    std::vector<uint32_t> partial;
+    for (uint32_t p : active) {
+        const Point& limit = limits[p];
+        bool outside = false;
+        bool inside = true;
+        for (int d = 0; d < DIMENSIONS; ++d) {
+            if (node.min[d] > limit[d]) outside = true;
+            if (node.max[d] > limit[d]) inside = false;
+        }
+        if (outside) continue;
+
+        if (inside) {
+            counts[p] += node.end - node.begin;
+            if (rows) {
+                for (uint32_t i = node.begin; i < node.end; ++i) {
+                    (*rows)[p].push_back(points_[i].row);
+                }
+            }
+        } else if (node.left < 0) {
+            for (uint32_t i = node.begin; i < node.end; ++i) {
+                const Point& point = points_[i].point;
+                if (point[0] <= limit[0] && point[1] <= limit[1] && point[2] <= limit[2]) {
+                    ++counts[p];
+                    if (rows) (*rows)[p].push_back(points_[i].row);
+                }
+            }
+        } else {
+            partial.push_back(p);
+        }
+    }
+
+    if (!partial.empty()) {
+        query(node.left, partial, limits, rows, counts);
+        query(node.right, partial, limits, rows, counts);
+    }
+}
+
+std::vector<uint32_t> MachineFitIndex::fits(const MachineProfile& profile) const {
+    return std::move(fits(std::vector<MachineProfile>{profile}).front());
+}
+
+size_t MachineFitIndex::count(const MachineProfile& profile) const {
+    return count(std::vector<MachineProfile>{profile}).front();
+}
+
+std::vector<std::vector<uint32_t>> MachineFitIndex::fits(const std::vector<MachineProfile>& profiles) const {
+    std::vector<std::vector<uint32_t>> rows(profiles.size());
+    std::vector<size_t> counts(profiles.size(), 0);
+    if (!nodes_.empty() && !profiles.empty()) {
+        std::vector<Point> bounds;
+        std::vector<uint32_t> active;
+        for (uint32_t p = 0; p < profiles.size(); ++p) {
+            bounds.push_back(limits(profiles[p]));
+            active.push_back(p);
+        }
+        query(0, active, bounds, &rows, counts);
+    }
+    for (auto& list : rows) {
+        std::sort(list.begin(), list.end());
+    }
+    return rows;
+}
+
+std::vector<size_t> MachineFitIndex::count(const std::vector<MachineProfile>& profiles) const {
+    std::vector<size_t> counts(profiles.size(), 0);
+    if (!nodes_.empty() && !profiles.empty()) {
+        std::vector<Point> bounds;
+        std::vector<uint32_t> active;
+        for (uint32_t p = 0; p < profiles.size(); ++p) {
+            bounds.push_back(limits(profiles[p]));
+            active.push_back(p);
+        }
+        query(0, active, bounds, nullptr, counts);
+    }
+    return counts;
+}
+
+}
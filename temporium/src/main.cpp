@@ -2,16 +2,27 @@
 #include <QStyleFactory>
 #include <QLoggingCategory>
 #include <QIcon>
+#include <QTimer>
 #include <iostream>
 #include "mainwindow.h"
+#include "startup_profiler.h"
+#include "trace.h"
 
 int main(int argc, char *argv[]) {
+    Temporium::StartupProfiler::instance().start();
+    
+    // Трассировку можно включить с запуска, чтобы поймать и вход
+    if (!qEnvironmentVariableIsEmpty("TEMPORIUM_TRACE")) {
+        Temporium::Tracer::instance().setEnabled(true);
+    }
+    
     QLoggingCategory::setFilterRules(
         "qt.qpa.wayland.warning=false\n"
         "qt.qpa.wayland=false"
     );
     
     QApplication app(argc, argv);
+    Temporium::StartupProfiler::instance().mark("QApplication создан");
     
     app.setStyle(QStyleFactory::create("Fusion"));
     
@@ -29,6 +40,12 @@ int main(int argc, char *argv[]) {
         Temporium::MainWindow mainWindow;
         mainWindow.setWindowIcon(appIcon);
         mainWindow.show();
+        Temporium::StartupProfiler::instance().mark("Окно показано");
+        
+        // Первая итерация цикла событий — окно входа готово к вводу
+        QTimer::singleShot(0, []() {
+            Temporium::StartupProfiler::instance().mark("Окно входа интерактивно");
+        });
         
         return app.exec();
     } catch (const std::exception& e) {
@@ -1,4 +1,7 @@
 #include "mainwindow.h"
+#include "theme.h"
+#include "startup_profiler.h"
+#include "trace.h"
 #include <QApplication>
 #include <QStyle>
 #include <QScreen>
@@ -6,20 +9,13 @@
 #include <QInputDialog>
 #include <QDir>
 #include <QFileInfo>
+#include <QStandardPaths>
+#include <QShortcut>
 #include <algorithm>
+#include <cmath>
 
 namespace Temporium {
 
-// Цвета темы
-const QString DARK_BG = "#303030";
-const QString DARK_LIGHTER = "#404040";
-const QString DARK_BORDER = "#505050";
-const QString ACCENT_COLOR = "#03fce8";
-const QString ACCENT_DARKER = "#02d4c4";
-const QString TEXT_COLOR = "#ffffff";
-const QString TEXT_SECONDARY = "#b0b0b0";
-const QString TEXT_PRIMARY  = "#ffffff";
-const QString BORDER_COLOR  = "#444444";
 static void setupSpinBox(QDoubleSpinBox* spinBox, double min, double max, double defaultVal = 0) {
     spinBox->setDecimals(1);
     spinBox->setRange(-99999, 99999);
@@ -34,9 +30,17 @@ static void setupSpinBox(QDoubleSpinBox* spinBox, double min, double max, double
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
+    , mainPage_(nullptr)
+    , gameLoader_(new GameLoader(this))
+    , loadGeneration_(0)
+    , gamesLoading_(false)
+    , fullCollectionLoaded_(false)
+    , dbConnectThread_(nullptr)
+    , dbConnecting_(false)
     , filterActive_(false)
     , lastClickedRow_(-1)
     , settings_("NSTU", "Temporium")
+    , stallWatchdog_(nullptr)
 {
     setWindowTitle("Temporium - СУБД Компьютерные Игры");
     setMinimumSize(1200, 700);
@@ -47,20 +51,57 @@ MainWindow::MainWindow(QWidget *parent)
     int y = (screenGeometry.height() - height()) / 2;
     move(x, y);
     
-    applyDarkTheme();
-    setupUI();
-    setupMenuBar();
-    setupToolBar();
-    setupConnections();
+    {
+        StartupPhase phase("Тема оформления");
+        applyDarkTheme();
+    }
+    {
+        // Главная страница строится лениво после входа (ensureMainPage)
+        StartupPhase phase("Страница входа, меню и панель инструментов");
+        setupUI();
+        setupMenuBar();
+        setupToolBar();
+        setupConnections();
+    }
+    
+    // Сторож зависаний; TEMPORIUM_STALL_MS задаёт порог, 0 отключает
+    bool thresholdSet = false;
+    int stallThreshold = qEnvironmentVariableIntValue("TEMPORIUM_STALL_MS", &thresholdSet);
+    if (!thresholdSet) {
+        stallThreshold = StallWatchdog::DEFAULT_THRESHOLD_MS;
+    }
+    if (stallThreshold > 0) {
+        QString logPath = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/stalls.log";
+        stallWatchdog_ = new StallWatchdog(logPath.toStdString(), stallThreshold, this);
+    }
+    
+    // Предел одного запроса к БД; TEMPORIUM_STATEMENT_TIMEOUT_MS, 0 — без предела
+    bool timeoutSet = false;
+    int statementTimeout = qEnvironmentVariableIntValue("TEMPORIUM_STATEMENT_TIMEOUT_MS", &timeoutSet);
+    if (!timeoutSet) {
+        statementTimeout = DatabaseManager::DEFAULT_STATEMENT_TIMEOUT_MS;
+    }
+    dbManager_.setStatementTimeout(statementTimeout);
+    gameLoader_->setStatementTimeout(statementTimeout);
     
+    // Подключение к БД идёт в фоне, пока пользователь вводит логин и пароль
     connectToDatabase();
-    loadLastUsername();
+    
+    {
+        StartupPhase phase("Загрузка настроек");
+        loadLastUsername();
+    }
     showLoginPage();
     
     statusBar()->showMessage("Добро пожаловать в Temporium!");
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow() {
+    // Фоновое подключение обращается к dbManager_ — дожидаемся его
+    if (dbConnectThread_) {
+        dbConnectThread_->wait();
+    }
+}
 
 void MainWindow::applyDarkTheme() {
     QString styleSheet = QString(R"(
@@ -160,7 +201,7 @@ void MainWindow::applyDarkTheme() {
             selection-color: #000000;
         }
         
-        QTableWidget {
+        QTableView {
             background-color: %3;
             color: %2;
             gridline-color: %4;
@@ -170,12 +211,12 @@ void MainWindow::applyDarkTheme() {
             selection-color: #000000;
         }
         
-        QTableWidget::item {
+        QTableView::item {
             padding: 5px;
             border-right: 1px solid %4;
         }
         
-        QTableWidget::item:selected {
+        QTableView::item:selected {
             background-color: %5;
             color: #000000;
         }
@@ -323,6 +364,8 @@ bool MainWindow::eventFilter(QObject* obj, QEvent* event) {
 }
 
 void MainWindow::connectToDatabase() {
+    if (dbConnecting_) return;
+    
     QString host = qgetenv("DB_HOST");
     QString port = qgetenv("DB_PORT");
     QString dbname = qgetenv("DB_NAME");
@@ -335,15 +378,70 @@ void MainWindow::connectToDatabase() {
     if (user.isEmpty()) user = "postgres";
     if (password.isEmpty()) password = "postgres";
     
-    if (!dbManager_.connect(host.toStdString(), port.toInt(), 
-                            dbname.toStdString(), user.toStdString(), 
-                            password.toStdString())) {
+    // С адресом temporium-server все операции с базой идут через него
+    QString server = qgetenv("TEMPORIUM_SERVER");
+    
+    // Пока идёт подключение, dbManager_ используется только фоновым потоком
+    dbConnecting_ = true;
+    dbConnectThread_ = QThread::create([this, server = server.toStdString(),
+                                        host = host.toStdString(), port = port.toInt(),
+                                        dbname = dbname.toStdString(), user = user.toStdString(),
+                                        password = password.toStdString()]() {
+        StartupPhase phase("Подключение к БД");
+        if (!server.empty()) {
+            dbManager_.connectRemote(server);
+        } else {
+            dbManager_.connect(host, port, dbname, user, password);
+        }
+    });
+    connect(dbConnectThread_, &QThread::finished, this, &MainWindow::onDatabaseConnectFinished);
+    connect(dbConnectThread_, &QThread::finished, dbConnectThread_, &QObject::deleteLater);
+    dbConnectThread_->start();
+}
+
+void MainWindow::onDatabaseConnectFinished() {
+    dbConnecting_ = false;
+    dbConnectThread_ = nullptr;
+    
+    loginButton_->setEnabled(true);
+    registerButton_->setEnabled(true);
+    
+    std::function<void()> action = std::move(pendingDbAction_);
+    pendingDbAction_ = nullptr;
+    
+    if (!dbManager_.isConnected()) {
+        statusBar()->clearMessage();
+        QString hint = dbManager_.isRemote() ?
+            "Убедитесь, что сервер запущен:\n./run.sh server" :
+            "Убедитесь, что PostgreSQL запущен:\n./run.sh db-start";
         QMessageBox::critical(this, "Ошибка подключения",
-            QString("Не удалось подключиться к базе данных:\n%1\n\n"
-                    "Убедитесь, что PostgreSQL запущен:\n"
-                    "./run.sh db-start")
-                .arg(QString::fromStdString(dbManager_.getLastError())));
+            QString("Не удалось подключиться к базе данных:\n%1\n\n%2")
+                .arg(QString::fromStdString(dbManager_.getLastError()), hint));
+        return;
     }
+    
+    // Соединение фонового загрузчика открываем, пока пользователь вводит пароль
+    gameLoader_->setConnectionString(dbManager_.getConnectionString());
+    gameLoader_->preconnect();
+    
+    // Вход или регистрация, нажатые во время подключения
+    if (action) {
+        action();
+    }
+}
+
+bool MainWindow::ensureDatabaseReady(std::function<void()> retry) {
+    if (!dbConnecting_ && dbManager_.isConnected()) {
+        return true;
+    }
+    
+    // Действие повторится, как только фоновое подключение завершится
+    pendingDbAction_ = std::move(retry);
+    loginButton_->setEnabled(false);
+    registerButton_->setEnabled(false);
+    statusBar()->showMessage("Подключение к базе данных...");
+    connectToDatabase();
+    return false;
 }
 
 void MainWindow::saveLastUsername() {
@@ -369,7 +467,37 @@ void MainWindow::setupUI() {
     setCentralWidget(stackedWidget_);
     
     setupLoginPage();
+    
+    // Число игр в таблице: постоянный виджет, временные сообщения его не скрывают
+    collectionCountLabel_ = new QLabel();
+    collectionCountLabel_->setVisible(false);
+    statusBar()->addPermanentWidget(collectionCountLabel_);
+    
+    // Счётчик строк во время потоковой загрузки таблицы
+    loadingLabel_ = new QLabel();
+    loadingLabel_->setStyleSheet(QString("color: %1;").arg(ACCENT_COLOR));
+    loadingLabel_->setVisible(false);
+    statusBar()->addPermanentWidget(loadingLabel_);
+    
+    // Остановка загрузки: запрос прерывается и на сервере БД
+    cancelLoadButton_ = new QToolButton();
+    cancelLoadButton_->setText("✕");
+    cancelLoadButton_->setToolTip("Остановить загрузку (Esc)");
+    cancelLoadButton_->setAutoRaise(true);
+    cancelLoadButton_->setVisible(false);
+    statusBar()->addPermanentWidget(cancelLoadButton_);
+    connect(cancelLoadButton_, &QToolButton::clicked, this, &MainWindow::onCancelLoading);
+    
+    auto* cancelShortcut = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+    connect(cancelShortcut, &QShortcut::activated, this, &MainWindow::onCancelLoading);
+}
+
+void MainWindow::ensureMainPage() {
+    if (mainPage_) return;
+    
+    StartupPhase phase("Главная страница");
     setupMainPage();
+    setupMainPageConnections();
 }
 
 void MainWindow::setupLoginPage() {
@@ -602,6 +730,20 @@ void MainWindow::setupMainPage() {
     ratingLayout->addWidget(filterRatingSpin_);
     filterLayout->addLayout(ratingLayout);
     
+    // Расширенный фильтр: выражение с AND, OR, NOT вместо условий выше
+    filterExpressionCheck_ = new QCheckBox("Выражение:");
+    filterExpressionEdit_ = new QLineEdit();
+    filterExpressionEdit_->setPlaceholderText("genre in (RPG, Strategy) and not completed");
+    filterExpressionEdit_->setToolTip(
+        "Поля: name, genre, tag, notes, url, rating, disk, ram, vram,\n"
+        "completed, favorite, installed\n"
+        "Операторы: = != < <= > >= ~ (содержит) ^= (начинается с) in (...)\n"
+        "Связки: and, or, not, скобки\n"
+        "Пример: (tag = Co-op or tag in (Indie, Roguelike)) and rating >= 7");
+    filterExpressionEdit_->setEnabled(false);
+    filterLayout->addWidget(filterExpressionCheck_);
+    filterLayout->addWidget(filterExpressionEdit_);
+    
     QHBoxLayout* filterButtonLayout = new QHBoxLayout();
     applyFilterButton_ = new QPushButton("Применить");
     resetFilterButton_ = new QPushButton("Сбросить");
@@ -617,11 +759,9 @@ void MainWindow::setupMainPage() {
     QVBoxLayout* rightLayout = new QVBoxLayout(rightPanel);
     rightLayout->setContentsMargins(0, 0, 0, 0);
     
-    gamesTable_ = new QTableWidget();
-    gamesTable_->setColumnCount(12);
-    gamesTable_->setHorizontalHeaderLabels({
-        "ID", "Название", "Диск (ГБ)", "ОЗУ (ГБ)", "VRAM (ГБ)", "Жанр", "Пройдено", "Оценка", "★", "📥", "Теги", "Ссылка"
-    });
+    gamesModel_ = new GamesTableModel(this);
+    gamesTable_ = new QTableView();
+    gamesTable_->setModel(gamesModel_);
     gamesTable_->setSelectionBehavior(QAbstractItemView::SelectRows);
     gamesTable_->setSelectionMode(QAbstractItemView::SingleSelection);
     gamesTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -632,13 +772,17 @@ void MainWindow::setupMainPage() {
     gamesTable_->horizontalHeader()->setStretchLastSection(true);
     gamesTable_->horizontalHeader()->setMinimumSectionSize(40);
     
+    // Сортировка на клиенте: клик — по столбцу, Shift+клик — добавить столбец
+    gamesTable_->horizontalHeader()->setSectionsClickable(true);
+    gamesTable_->horizontalHeader()->setSortIndicatorShown(false);
+    
     // Установка начальных размеров столбцов
     resetTableColumnWidths();
     
     gamesTable_->verticalHeader()->setVisible(false);
     gamesTable_->setAlternatingRowColors(true);
     gamesTable_->setStyleSheet(QString(
-        "QTableWidget { alternate-background-color: %1; }"
+        "QTableView { alternate-background-color: %1; }"
     ).arg(DARK_LIGHTER));
     
     QHBoxLayout* controlLayout = new QHBoxLayout();
@@ -757,6 +901,8 @@ void MainWindow::setupMenuBar() {
     editAction_ = gamesMenu->addAction("Редактировать игру");
     deleteAction_ = gamesMenu->addAction("Удалить игру");
     deleteAction_->setShortcut(QKeySequence::Delete);
+    gamesMenu->addSeparator();
+    similarAction_ = gamesMenu->addAction("Похожие игры...");
     
     QMenu* dataMenu = menuBar->addMenu("Данные");
     
@@ -765,6 +911,9 @@ void MainWindow::setupMenuBar() {
     importAction_ = dataMenu->addAction("Импорт из файла...");
     dataMenu->addSeparator();
     viewExportedAction_ = dataMenu->addAction("Просмотр экспортированного файла...");
+    dataMenu->addSeparator();
+    analyticsAction_ = dataMenu->addAction("Аналитика коллекции...");
+    machineFitAction_ = dataMenu->addAction("Что пойдёт на компьютере...");
     
     // Меню администратора - будет показано/скрыто в зависимости от прав
     adminMenu_ = menuBar->addMenu("Администрирование");
@@ -772,6 +921,11 @@ void MainWindow::setupMenuBar() {
     adminMenu_->menuAction()->setVisible(false);  // Изначально скрыто
     
     QMenu* helpMenu = menuBar->addMenu("Справка");
+    diagnosticsAction_ = helpMenu->addAction("Диагностика запуска");
+    traceAction_ = helpMenu->addAction("Записывать трассировку");
+    traceAction_->setCheckable(true);
+    traceAction_->setChecked(Tracer::instance().enabled());
+    saveTraceAction_ = helpMenu->addAction("Сохранить трассировку...");
     aboutAction_ = helpMenu->addAction("О программе");
 }
 
@@ -786,7 +940,7 @@ void MainWindow::setupToolBar() {
     toolBar->addAction(importAction_);
 }
 
-void MainWindow::setupConnections() {
+void MainWindow::setupMainPageConnections() {
     connect(filterCompletedCheck_, &QCheckBox::toggled, filterCompletedCombo_, &QComboBox::setEnabled);
     connect(filterGenreCheck_, &QCheckBox::toggled, filterGenreCombo_, &QComboBox::setEnabled);
     connect(filterDiskMinCheck_, &QCheckBox::toggled, filterDiskMinSpin_, &QDoubleSpinBox::setEnabled);
@@ -802,11 +956,8 @@ void MainWindow::setupConnections() {
     connect(filterInstalledCheck_, &QCheckBox::toggled, filterInstalledCombo_, &QComboBox::setEnabled);
     connect(filterRatingCheck_, &QCheckBox::toggled, filterRatingModeCombo_, &QComboBox::setEnabled);
     connect(filterRatingCheck_, &QCheckBox::toggled, filterRatingSpin_, &QSpinBox::setEnabled);
-    
-    connect(loginButton_, &QPushButton::clicked, this, &MainWindow::onLogin);
-    connect(registerButton_, &QPushButton::clicked, this, &MainWindow::onRegister);
-    connect(passwordEdit_, &QLineEdit::returnPressed, this, &MainWindow::onLogin);
-    connect(usernameEdit_, &QLineEdit::returnPressed, [this]() { passwordEdit_->setFocus(); });
+    connect(filterExpressionCheck_, &QCheckBox::toggled, filterExpressionEdit_, &QLineEdit::setEnabled);
+    connect(filterExpressionEdit_, &QLineEdit::returnPressed, this, &MainWindow::onApplyFilter);
     
     connect(addButton_, &QPushButton::clicked, this, &MainWindow::onAddGame);
     connect(editButton_, &QPushButton::clicked, this, &MainWindow::onEditGame);
@@ -818,39 +969,57 @@ void MainWindow::setupConnections() {
     connect(applyFilterButton_, &QPushButton::clicked, this, &MainWindow::onApplyFilter);
     connect(resetFilterButton_, &QPushButton::clicked, this, &MainWindow::onResetFilter);
     
+    connect(gamesTable_->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::onTableSelectionChanged);
+    connect(gamesTable_, &QTableView::clicked, this, &MainWindow::onTableCellClicked);
+    connect(gamesTable_, &QTableView::doubleClicked, this, &MainWindow::onTableCellDoubleClicked);
+    connect(gamesTable_->horizontalHeader(), &QHeaderView::sectionClicked, this, &MainWindow::onSortColumnClicked);
+}
+
+void MainWindow::setupConnections() {
+    connect(loginButton_, &QPushButton::clicked, this, &MainWindow::onLogin);
+    connect(registerButton_, &QPushButton::clicked, this, &MainWindow::onRegister);
+    connect(passwordEdit_, &QLineEdit::returnPressed, this, &MainWindow::onLogin);
+    connect(usernameEdit_, &QLineEdit::returnPressed, [this]() { passwordEdit_->setFocus(); });
+    
     connect(loginAction_, &QAction::triggered, this, &MainWindow::showLoginPage);
     connect(logoutAction_, &QAction::triggered, this, &MainWindow::onLogout);
     connect(exitAction_, &QAction::triggered, this, &QWidget::close);
     connect(addAction_, &QAction::triggered, this, &MainWindow::onAddGame);
     connect(editAction_, &QAction::triggered, this, &MainWindow::onEditGame);
     connect(deleteAction_, &QAction::triggered, this, &MainWindow::onDeleteGame);
+    connect(similarAction_, &QAction::triggered, this, &MainWindow::onShowSimilar);
     connect(exportAction_, &QAction::triggered, this, &MainWindow::onExportToFile);
     connect(exportFilteredAction_, &QAction::triggered, this, &MainWindow::onExportFilteredToFile);
     connect(importAction_, &QAction::triggered, this, &MainWindow::onImportFromFile);
     connect(viewExportedAction_, &QAction::triggered, this, &MainWindow::onViewExportedFile);
+    connect(analyticsAction_, &QAction::triggered, this, &MainWindow::onShowAnalytics);
+    connect(machineFitAction_, &QAction::triggered, this, &MainWindow::onMachineFit);
     connect(aboutAction_, &QAction::triggered, this, &MainWindow::onAbout);
     connect(adminAction_, &QAction::triggered, this, &MainWindow::onAdminPanel);
+    connect(diagnosticsAction_, &QAction::triggered, this, &MainWindow::onShowDiagnostics);
+    connect(traceAction_, &QAction::toggled, [](bool checked) {
+        Tracer::instance().setEnabled(checked);
+    });
+    connect(saveTraceAction_, &QAction::triggered, this, &MainWindow::onSaveTrace);
     
-    connect(gamesTable_, &QTableWidget::itemSelectionChanged, this, &MainWindow::onTableSelectionChanged);
-    connect(gamesTable_, &QTableWidget::cellClicked, this, &MainWindow::onTableCellClicked);
-    connect(gamesTable_, &QTableWidget::cellDoubleClicked, this, &MainWindow::onTableCellDoubleClicked);
-}
-
-void MainWindow::onTableCellClicked(int row, int column) {
-    // Если клик на колонке "Ссылка" (тк индекс 11) - открыть URL
-    if (column == 11) {
-        QTableWidgetItem* item = gamesTable_->item(row, 11);
-        if (item) {
-            QString url = item->data(Qt::UserRole).toString();
-            if (!url.isEmpty()) {
-                // Добавляем схему если отсутствует
-                if (!url.startsWith("http://") && !url.startsWith("https://")) {
-                    url = "https://" + url;
-                }
-                QDesktopServices::openUrl(QUrl(url));
-                // Не меняем выделение при клике на ссылку
-                return;
+    connect(gameLoader_, &GameLoader::chunkLoaded, this, &MainWindow::onGamesChunkLoaded);
+    connect(gameLoader_, &GameLoader::loadFinished, this, &MainWindow::onGamesLoadFinished);
+}
+
+void MainWindow::onTableCellClicked(const QModelIndex& index) {
+    int row = index.row();
+    
+    // Если клик на колонке "Ссылка" - открыть URL
+    if (index.column() == GamesTableModel::COL_URL) {
+        QString url = index.data(GamesTableModel::UrlRole).toString();
+        if (!url.isEmpty()) {
+            // Добавляем схему если отсутствует
+            if (!url.startsWith("http://") && !url.startsWith("https://")) {
+                url = "https://" + url;
             }
+            QDesktopServices::openUrl(QUrl(url));
+            // Не меняем выделение при клике на ссылку
+            return;
         }
     }
     
@@ -865,24 +1034,72 @@ void MainWindow::onTableCellClicked(int row, int column) {
     updateButtonStates();
 }
 
-void MainWindow::onTableCellDoubleClicked(int row, int column) {
+void MainWindow::onTableCellDoubleClicked(const QModelIndex& index) {
     // Если двойной клик на колонке "Ссылка" - открыть URL
-    if (column == 11) {
-        QTableWidgetItem* item = gamesTable_->item(row, column);
-        if (item && !item->text().isEmpty()) {
-            QString url = item->data(Qt::UserRole).toString();
-            if (!url.isEmpty()) {
-                QDesktopServices::openUrl(QUrl(url));
-                return;
-            }
+    if (index.column() == GamesTableModel::COL_URL) {
+        QString url = index.data(GamesTableModel::UrlRole).toString();
+        if (!url.isEmpty()) {
+            QDesktopServices::openUrl(QUrl(url));
+            return;
         }
     }
     // Иначе - редактирование
     onEditGame();
 }
 
+void MainWindow::onSortColumnClicked(int column) {
+    TraceSpan span("MainWindow::onSortColumnClicked", "ui");
+    if (!GamesTableModel::isSortable(column)) {
+        return;
+    }
+    
+    std::vector<SortKey> keys = gamesModel_->sortKeys();
+    SortColumn sortColumn = static_cast<SortColumn>(column);
+    auto it = std::find_if(keys.begin(), keys.end(),
+                           [sortColumn](const SortKey& key) { return key.column == sortColumn; });
+    
+    if (QApplication::keyboardModifiers() & Qt::ShiftModifier) {
+        // Shift+клик: добавить столбец как следующий ключ или сменить его направление
+        if (it == keys.end()) {
+            keys.emplace_back(sortColumn, true);
+        } else {
+            it->ascending = !it->ascending;
+        }
+    } else if (keys.size() == 1 && it != keys.end()) {
+        // Повторный клик: по возрастанию -> по убыванию -> порядок с сервера
+        if (it->ascending) {
+            it->ascending = false;
+        } else {
+            keys.clear();
+        }
+    } else {
+        keys.assign(1, SortKey(sortColumn, true));
+    }
+    
+    gamesModel_->setSortKeys(keys);
+    
+    QHeaderView* header = gamesTable_->horizontalHeader();
+    if (keys.empty()) {
+        header->setSortIndicatorShown(false);
+        statusBar()->showMessage("Сортировка сброшена", 3000);
+        return;
+    }
+    
+    header->setSortIndicatorShown(true);
+    header->setSortIndicator(static_cast<int>(keys.front().column),
+                             keys.front().ascending ? Qt::AscendingOrder : Qt::DescendingOrder);
+    
+    QStringList parts;
+    for (const auto& key : keys) {
+        parts << QString("%1 %2")
+            .arg(gamesModel_->headerData(static_cast<int>(key.column), Qt::Horizontal).toString())
+            .arg(QString(key.ascending ? "↑" : "↓"));
+    }
+    statusBar()->showMessage(QString("Сортировка: %1").arg(parts.join(", ")), 3000);
+}
+
 void MainWindow::onToggleNotesPanel() {
-    int row = gamesTable_->currentRow();
+    int row = gamesTable_->currentIndex().row();
     if (row < 0) {
         notesPanel_->setVisible(false);
         notesButton_->setChecked(false);
@@ -894,23 +1111,18 @@ void MainWindow::onToggleNotesPanel() {
     
     if (showPanel) {
         // Загружаем заметки для выбранной игры
-        QTableWidgetItem* idItem = gamesTable_->item(row, 0);
-        if (idItem) {
-            int gameId = idItem->text().toInt();
-            QString gameName = gamesTable_->item(row, 1)->text();
-            QString notes = idItem->data(Qt::UserRole + 1).toString();
-            
-            currentNotesGameId_ = gameId;
-            notesPanelTitle_->setText(QString("📝 Заметки: %1").arg(gameName));
-            notesPanelEdit_->setPlainText(notes);
-            notesPanelEdit_->setFocus();
-        }
+        Game game = gamesModel_->gameAt(row);
+        currentNotesGameId_ = game.id;
+        notesPanelTitle_->setText(QString("📝 Заметки: %1").arg(QString::fromStdString(game.name)));
+        notesPanelEdit_->setPlainText(QString::fromStdString(game.notes));
+        notesPanelEdit_->setFocus();
     } else {
         currentNotesGameId_ = -1;
     }
 }
 
 void MainWindow::onSaveNotes() {
+    TraceSpan span("MainWindow::onSaveNotes", "ui");
     if (currentNotesGameId_ <= 0) {
         QMessageBox::warning(this, "Ошибка", "Не выбрана игра для сохранения заметок.");
         return;
@@ -920,12 +1132,9 @@ void MainWindow::onSaveNotes() {
     
     if (dbManager_.updateGameNotes(currentNotesGameId_, currentUser_.id, notes.toStdString())) {
         // Обновляем данные в таблице
-        int row = gamesTable_->currentRow();
+        int row = gamesTable_->currentIndex().row();
         if (row >= 0) {
-            QTableWidgetItem* idItem = gamesTable_->item(row, 0);
-            if (idItem) {
-                idItem->setData(Qt::UserRole + 1, notes);
-            }
+            gamesModel_->setGameNotes(row, notes.toStdString());
         }
         
         statusBar()->showMessage("Заметки сохранены", 3000);
@@ -937,13 +1146,14 @@ void MainWindow::onSaveNotes() {
 }
 
 void MainWindow::updateButtonStates() {
-    bool hasSelection = gamesTable_->currentRow() >= 0 && 
+    bool hasSelection = gamesTable_->currentIndex().row() >= 0 && 
                         gamesTable_->selectionModel()->hasSelection();
     editButton_->setEnabled(hasSelection);
     deleteButton_->setEnabled(hasSelection);
     notesButton_->setEnabled(hasSelection);
     editAction_->setEnabled(hasSelection);
     deleteAction_->setEnabled(hasSelection);
+    similarAction_->setEnabled(hasSelection);
     
     // Если выбор снят, закрыть панель заметок
     if (!hasSelection && notesPanel_->isVisible()) {
@@ -960,10 +1170,13 @@ void MainWindow::showLoginPage() {
     addAction_->setEnabled(false);
     editAction_->setEnabled(false);
     deleteAction_->setEnabled(false);
+    similarAction_->setEnabled(false);
     exportAction_->setEnabled(false);
     exportFilteredAction_->setEnabled(false);
     importAction_->setEnabled(false);
     viewExportedAction_->setEnabled(false);
+    analyticsAction_->setEnabled(false);
+    machineFitAction_->setEnabled(false);
     adminMenu_->menuAction()->setVisible(false);
     
     passwordEdit_->clear();
@@ -974,6 +1187,7 @@ void MainWindow::showLoginPage() {
 }
 
 void MainWindow::showMainPage() {
+    ensureMainPage();
     stackedWidget_->setCurrentWidget(mainPage_);
     loginAction_->setEnabled(false);
     logoutAction_->setEnabled(true);
@@ -982,6 +1196,8 @@ void MainWindow::showMainPage() {
     exportFilteredAction_->setEnabled(true);
     importAction_->setEnabled(true);
     viewExportedAction_->setEnabled(true);
+    analyticsAction_->setEnabled(true);
+    machineFitAction_->setEnabled(true);
     
     // Показываем меню администратора только для админов
     adminMenu_->menuAction()->setVisible(currentUser_.is_admin);
@@ -992,13 +1208,14 @@ void MainWindow::showMainPage() {
     
     lastClickedRow_ = -1;
     resetTableColumnWidths();
-    updateTagsCombo();
+    reloadTags();
     updateGamesTable();
     updateStatusBar();
     updateStats();
 }
 
 void MainWindow::onLogin() {
+    TraceSpan span("MainWindow::onLogin", "ui");
     QString username = usernameEdit_->text().trimmed();
     QString password = passwordEdit_->text();
     
@@ -1007,11 +1224,8 @@ void MainWindow::onLogin() {
         return;
     }
     
-    if (!dbManager_.isConnected()) {
-        connectToDatabase();
-        if (!dbManager_.isConnected()) {
-            return;
-        }
+    if (!ensureDatabaseReady([this]() { onLogin(); })) {
+        return;
     }
     
     std::string passwordHash = HashUtils::hashPassword(password.toStdString(), username.toStdString());
@@ -1051,11 +1265,8 @@ void MainWindow::onRegister() {
         return;
     }
     
-    if (!dbManager_.isConnected()) {
-        connectToDatabase();
-        if (!dbManager_.isConnected()) {
-            return;
-        }
+    if (!ensureDatabaseReady([this]() { onRegister(); })) {
+        return;
     }
     
     if (dbManager_.userExists(username.toStdString())) {
@@ -1075,9 +1286,20 @@ void MainWindow::onRegister() {
 }
 
 void MainWindow::onLogout() {
+    gameLoader_->cancel();
+    gamesLoading_ = false;
+    fullCollectionLoaded_ = false;
+    loadingLabel_->setVisible(false);
+    cancelLoadButton_->setVisible(false);
+    collectionCountLabel_->setVisible(false);
+    gamesModel_->clear();
+    
     currentUser_ = User();
+    tagDictionary_.clear();
+    updateTagsCombo();
     filterActive_ = false;
     currentFilter_.reset();
+    currentExpression_.reset();
     lastClickedRow_ = -1;
     
     // Закрываем панель заметок
@@ -1090,14 +1312,23 @@ void MainWindow::onLogout() {
 }
 
 void MainWindow::onAddGame() {
+    TraceSpan span("MainWindow::onAddGame", "ui");
     GameEditDialog dialog(this);
+    dialog.setTagSuggestions(tagSuggestions());
     if (dialog.exec() == QDialog::Accepted) {
         Game game = dialog.getGame();
         game.user_id = currentUser_.id;
         
-        if (dbManager_.addGame(game)) {
-            updateTagsCombo();
-            updateGamesTable();
+        if (dbManager_.addGame(game, &game.id)) {
+            applyTagChange("", game.tags);
+            // Коллекция в памяти — строка добавляется без перезагрузки
+            if (fullCollectionLoaded_) {
+                gamesModel_->addGame(game);
+                updateButtonStates();
+            } else {
+                updateGamesTable();
+            }
+            updateStatusBar();
             updateStats();
             statusBar()->showMessage("Игра добавлена");
         } else {
@@ -1109,13 +1340,14 @@ void MainWindow::onAddGame() {
 }
 
 void MainWindow::onEditGame() {
-    int currentRow = gamesTable_->currentRow();
+    TraceSpan span("MainWindow::onEditGame", "ui");
+    int currentRow = gamesTable_->currentIndex().row();
     if (currentRow < 0 || !gamesTable_->selectionModel()->hasSelection()) {
         QMessageBox::warning(this, "Внимание", "Выберите игру для редактирования!");
         return;
     }
     
-    int gameId = gamesTable_->item(currentRow, 0)->text().toInt();
+    int gameId = gamesModel_->gameAt(currentRow).id;
     Game game = dbManager_.getGameById(gameId, currentUser_.id);
     
     if (game.id == 0) {
@@ -1124,14 +1356,21 @@ void MainWindow::onEditGame() {
     }
     
     GameEditDialog dialog(this, &game);
+    dialog.setTagSuggestions(tagSuggestions());
     if (dialog.exec() == QDialog::Accepted) {
         Game updatedGame = dialog.getGame();
         updatedGame.id = game.id;
         updatedGame.user_id = currentUser_.id;
         
         if (dbManager_.updateGame(updatedGame)) {
-            updateTagsCombo();
-            updateGamesTable();
+            applyTagChange(game.tags, updatedGame.tags);
+            if (fullCollectionLoaded_) {
+                gamesModel_->updateGame(currentRow, updatedGame);
+                updateButtonStates();
+            } else {
+                updateGamesTable();
+            }
+            updateStatusBar();
             updateStats();
             statusBar()->showMessage("Игра обновлена");
         } else {
@@ -1143,14 +1382,17 @@ void MainWindow::onEditGame() {
 }
 
 void MainWindow::onDeleteGame() {
-    int currentRow = gamesTable_->currentRow();
+    TraceSpan span("MainWindow::onDeleteGame", "ui");
+    int currentRow = gamesTable_->currentIndex().row();
     if (currentRow < 0 || !gamesTable_->selectionModel()->hasSelection()) {
         QMessageBox::warning(this, "Внимание", "Выберите игру для удаления!");
         return;
     }
     
-    QString gameName = gamesTable_->item(currentRow, 1)->text();
-    int gameId = gamesTable_->item(currentRow, 0)->text().toInt();
+    Game selected = gamesModel_->gameAt(currentRow);
+    QString gameName = QString::fromStdString(selected.name);
+    int gameId = selected.id;
+    std::string gameTags = selected.tags;
     
     QMessageBox::StandardButton reply = QMessageBox::question(this, "Подтверждение",
         QString("Вы уверены, что хотите удалить игру \"%1\"?").arg(gameName),
@@ -1159,8 +1401,15 @@ void MainWindow::onDeleteGame() {
     if (reply == QMessageBox::Yes) {
         if (dbManager_.deleteGame(gameId, currentUser_.id)) {
             lastClickedRow_ = -1;
-            updateTagsCombo();
-            updateGamesTable();
+            applyTagChange(gameTags, "");
+            if (fullCollectionLoaded_) {
+                gamesTable_->clearSelection();
+                gamesModel_->removeGame(currentRow);
+                updateButtonStates();
+            } else {
+                updateGamesTable();
+            }
+            updateStatusBar();
             updateStats();
             statusBar()->showMessage(QString("Игра \"%1\" удалена").arg(gameName));
         } else {
@@ -1172,16 +1421,54 @@ void MainWindow::onDeleteGame() {
 }
 
 void MainWindow::onRefreshGames() {
+    TraceSpan span("MainWindow::onRefreshGames", "ui");
     resetTableColumnWidths();
-    updateTagsCombo();
+    reloadTags();
     updateGamesTable();
     updateStats();
     statusBar()->showMessage("Данные обновлены, настройки отображения сброшены");
 }
 
 void MainWindow::onApplyFilter() {
+    TraceSpan span("MainWindow::onApplyFilter", "ui");
     currentFilter_.reset();
+    currentExpression_.reset();
+    
+    // Расширенный режим: выражение заменяет условия панели
+    if (filterExpressionCheck_->isChecked()) {
+        auto expression = std::make_shared<FilterExpression>();
+        std::string error;
+        if (!FilterExpression::parse(filterExpressionEdit_->text().toStdString(), *expression, error)) {
+            QMessageBox::warning(this, "Ошибка", 
+                QString("Ошибка в выражении фильтра: %1").arg(QString::fromStdString(error)));
+            return;
+        }
+        currentExpression_ = std::move(expression);
+    } else {
+        readFilterControls();
+    }
+    
+    filterActive_ = true;
+    lastClickedRow_ = -1;
     
+    // Вся коллекция уже загружена — фильтруем на клиенте без запроса к БД
+    if (fullCollectionLoaded_) {
+        gamesTable_->clearSelection();
+        std::shared_ptr<const RowPredicate> predicate = currentExpression_;
+        if (!predicate) {
+            auto compiled = std::make_shared<CompiledFilter>(CompiledFilter::compile(currentFilter_));
+            if (!compiled->matchesAll()) predicate = std::move(compiled);
+        }
+        gamesModel_->setRowFilter(std::move(predicate));
+        updateButtonStates();
+        updateStatusBar();
+    } else {
+        updateGamesTable();
+    }
+    statusBar()->showMessage("Фильтр применен");
+}
+
+void MainWindow::readFilterControls() {
     if (filterCompletedCheck_->isChecked()) {
         currentFilter_.filter_completed = true;
         currentFilter_.completed_value = filterCompletedCombo_->currentData().toBool();
@@ -1251,14 +1538,10 @@ void MainWindow::onApplyFilter() {
             currentFilter_.rating_max = ratingValue;
         }
     }
-    
-    filterActive_ = true;
-    lastClickedRow_ = -1;
-    updateGamesTable();
-    statusBar()->showMessage("Фильтр применен");
 }
 
 void MainWindow::onResetFilter() {
+    TraceSpan span("MainWindow::onResetFilter", "ui");
     filterCompletedCheck_->setChecked(false);
     filterGenreCheck_->setChecked(false);
     filterDiskMinCheck_->setChecked(false);
@@ -1276,15 +1559,26 @@ void MainWindow::onResetFilter() {
     filterTagCombo_->setCurrentIndex(0);
     filterRatingModeCombo_->setCurrentIndex(0);
     filterRatingSpin_->setValue(5);
+    filterExpressionCheck_->setChecked(false);
     
     currentFilter_.reset();
+    currentExpression_.reset();
     filterActive_ = false;
     lastClickedRow_ = -1;
-    updateGamesTable();
+    
+    if (fullCollectionLoaded_) {
+        gamesTable_->clearSelection();
+        gamesModel_->setRowFilter(nullptr);
+        updateButtonStates();
+        updateStatusBar();
+    } else {
+        updateGamesTable();
+    }
     statusBar()->showMessage("Фильтр сброшен");
 }
 
 void MainWindow::onExportToFile() {
+    TraceSpan span("MainWindow::onExportToFile", "ui");
     QString filename = QFileDialog::getSaveFileName(this, "Экспорт в файл",
         QDir::homePath() + "/games_export.bin", "Бинарные файлы (*.bin)");
     
@@ -1301,6 +1595,7 @@ void MainWindow::onExportToFile() {
 }
 
 void MainWindow::onExportFilteredToFile() {
+    TraceSpan span("MainWindow::onExportFilteredToFile", "ui");
     if (!filterActive_) {
         QMessageBox::information(this, "Информация", 
             "Сначала примените фильтр для экспорта отфильтрованных данных.");
@@ -1312,7 +1607,10 @@ void MainWindow::onExportFilteredToFile() {
     
     if (filename.isEmpty()) return;
     
-    if (dbManager_.exportFilteredToBinaryFile(filename.toStdString(), currentUser_.id, currentFilter_)) {
+    bool exported = currentExpression_
+        ? dbManager_.exportFilteredToBinaryFile(filename.toStdString(), currentUser_.id, *currentExpression_)
+        : dbManager_.exportFilteredToBinaryFile(filename.toStdString(), currentUser_.id, currentFilter_);
+    if (exported) {
         lastExportedFile_ = filename;
         QMessageBox::information(this, "Успех", 
             "Отфильтрованные данные успешно экспортированы!\n\nФайл защищен контрольной суммой SHA-256.");
@@ -1323,12 +1621,14 @@ void MainWindow::onExportFilteredToFile() {
 }
 
 void MainWindow::onImportFromFile() {
+    TraceSpan span("MainWindow::onImportFromFile", "ui");
     QString filename = QFileDialog::getOpenFileName(this, "Импорт из файла",
         QDir::homePath(), "Бинарные файлы (*.bin)");
     
     if (filename.isEmpty()) return;
     
-    FileVerificationResult verification = dbManager_.verifyBinaryFile(filename.toStdString());
+    FileVerificationResult verification;
+    std::vector<Game> games = dbManager_.readBinaryFile(filename.toStdString(), &verification);
     
     if (verification != FileVerificationResult::OK) {
         QMessageBox::critical(this, "Ошибка верификации",
@@ -1337,10 +1637,38 @@ void MainWindow::onImportFromFile() {
         return;
     }
     
-    if (dbManager_.importFromBinaryFile(filename.toStdString(), currentUser_.id)) {
+    // Похожие названия ищутся и среди игр пользователя, и внутри файла
+    std::vector<std::string> existing = dbManager_.getGameNames(currentUser_.id);
+    NearDuplicateDetector detector;
+    detector.reserve(existing.size() + games.size());
+    for (const auto& name : existing) {
+        detector.add(name);
+    }
+    for (const auto& game : games) {
+        detector.add(game.name);
+    }
+    std::vector<NearDuplicate> pairs = detector.findPairs(static_cast<uint32_t>(existing.size()));
+    
+    if (!pairs.empty()) {
+        NearDuplicatesDialog dialog(pairs, existing, games, this);
+        if (dialog.exec() != QDialog::Accepted) return;
+        
+        std::vector<bool> skipped = dialog.skipped();
+        std::vector<Game> kept;
+        kept.reserve(games.size());
+        for (size_t i = 0; i < games.size(); ++i) {
+            if (!skipped[i]) kept.push_back(std::move(games[i]));
+        }
+        games.swap(kept);
+    }
+    
+    size_t inserted = 0;
+    if (dbManager_.importGames(games, currentUser_.id, &inserted)) {
+        reloadTags();
         updateGamesTable();
         QMessageBox::information(this, "Успех", 
-            "Данные успешно импортированы!\n\nКонтрольная сумма файла подтверждена.");
+            QString("Данные успешно импортированы!\n\nДобавлено игр: %1 из %2.\n"
+                    "Контрольная сумма файла подтверждена.").arg(inserted).arg(games.size()));
     } else {
         QMessageBox::critical(this, "Ошибка", 
             QString("Ошибка импорта: %1").arg(QString::fromStdString(dbManager_.getLastError())));
@@ -1348,13 +1676,15 @@ void MainWindow::onImportFromFile() {
 }
 
 void MainWindow::onViewExportedFile() {
+    TraceSpan span("MainWindow::onViewExportedFile", "ui");
     QString filename = QFileDialog::getOpenFileName(this, "Открыть бинарный файл",
         lastExportedFile_.isEmpty() ? QDir::homePath() : lastExportedFile_, 
         "Бинарные файлы (*.bin)");
     
     if (filename.isEmpty()) return;
     
-    FileVerificationResult verification = dbManager_.verifyBinaryFile(filename.toStdString());
+    FileVerificationResult verification;
+    std::vector<Game> games = dbManager_.readBinaryFile(filename.toStdString(), &verification);
     
     if (verification != FileVerificationResult::OK) {
         QMessageBox::warning(this, "Предупреждение",
@@ -1362,8 +1692,6 @@ void MainWindow::onViewExportedFile() {
                 .arg(QString::fromStdString(DatabaseManager::getVerificationErrorText(verification))));
     }
     
-    std::vector<Game> games = dbManager_.readBinaryFile(filename.toStdString());
-    
     if (games.empty() && verification == FileVerificationResult::OK) {
         QMessageBox::information(this, "Информация", "Файл пуст.");
         return;
@@ -1378,20 +1706,14 @@ void MainWindow::onTableSelectionChanged() {
     
     // Обновляем панель заметок если она открыта
     if (notesPanel_->isVisible()) {
-        int row = gamesTable_->currentRow();
+        int row = gamesTable_->currentIndex().row();
         if (row >= 0) {
-            QTableWidgetItem* idItem = gamesTable_->item(row, 0);
-            if (idItem) {
-                int gameId = idItem->text().toInt();
-                // Если выбрана другая игра, обновляем заметки
-                if (gameId != currentNotesGameId_) {
-                    QString gameName = gamesTable_->item(row, 1)->text();
-                    QString notes = idItem->data(Qt::UserRole + 1).toString();
-                    
-                    currentNotesGameId_ = gameId;
-                    notesPanelTitle_->setText(QString("📝 Заметки: %1").arg(gameName));
-                    notesPanelEdit_->setPlainText(notes);
-                }
+            Game game = gamesModel_->gameAt(row);
+            // Если выбрана другая игра, обновляем заметки
+            if (game.id != currentNotesGameId_) {
+                currentNotesGameId_ = game.id;
+                notesPanelTitle_->setText(QString("📝 Заметки: %1").arg(QString::fromStdString(game.name)));
+                notesPanelEdit_->setPlainText(QString::fromStdString(game.notes));
             }
         }
     }
@@ -1415,6 +1737,125 @@ void MainWindow::onAdminPanel() {
     }
 }
 
+void MainWindow::onShowAnalytics() {
+    TraceSpan span("MainWindow::onShowAnalytics", "ui");
+    // Показатели считаются по тем же играм, что видны в таблице
+    const GameFilter* filter = filterActive_ && !currentExpression_ ? &currentFilter_ : nullptr;
+    AnalyticsDialog dialog(&dbManager_, currentUser_.id, filter,
+                           filterActive_ ? currentExpression_ : nullptr, this);
+    dialog.exec();
+}
+
+void MainWindow::onShowSimilar() {
+    TraceSpan span("MainWindow::onShowSimilar", "ui");
+    int currentRow = gamesTable_->currentIndex().row();
+    if (currentRow < 0 || !gamesTable_->selectionModel()->hasSelection()) {
+        QMessageBox::warning(this, "Внимание", "Выберите игру!");
+        return;
+    }
+    
+    Game game = gamesModel_->gameAt(currentRow);
+    SimilarGamesDialog dialog(&dbManager_, currentUser_.id, currentUser_.is_admin, game,
+                              fullCollectionLoaded_ ? gamesModel_ : nullptr, this);
+    dialog.exec();
+}
+
+void MainWindow::onMachineFit() {
+    TraceSpan span("MainWindow::onMachineFit", "ui");
+    std::vector<MachineProfile> profiles;
+    int count = settings_.beginReadArray("machineProfiles");
+    for (int i = 0; i < count; ++i) {
+        settings_.setArrayIndex(i);
+        MachineProfile profile;
+        profile.name = settings_.value("name").toString().toStdString();
+        profile.ram = settings_.value("ram").toUInt();
+        profile.vram = settings_.value("vram").toUInt();
+        profile.disk = settings_.value("disk").toUInt();
+        profiles.push_back(profile);
+    }
+    settings_.endArray();
+    if (profiles.empty()) {
+        profiles.push_back({"Мой компьютер", 16, 8, 500});
+    }
+    
+    // Локальный индекс годится, только если в модели вся коллекция
+    MachineFitDialog dialog(&dbManager_, currentUser_.id, currentUser_.is_admin,
+                            fullCollectionLoaded_ ? gamesModel_ : nullptr, profiles, this);
+    int result = dialog.exec();
+    
+    settings_.beginWriteArray("machineProfiles");
+    for (size_t i = 0; i < dialog.profiles().size(); ++i) {
+        const MachineProfile& profile = dialog.profiles()[i];
+        settings_.setArrayIndex(static_cast<int>(i));
+        settings_.setValue("name", QString::fromStdString(profile.name));
+        settings_.setValue("ram", profile.ram);
+        settings_.setValue("vram", profile.vram);
+        settings_.setValue("disk", profile.disk);
+    }
+    settings_.endArray();
+    
+    if (result != QDialog::Accepted) return;
+    
+    // Подбор — обычное выражение фильтра: работает и на клиенте, и на сервере
+    const MachineProfile& profile = dialog.shownProfile();
+    filterExpressionCheck_->setChecked(true);
+    filterExpressionEdit_->setText(QString("ram <= %1 and vram <= %2 and disk <= %3")
+        .arg(profile.ram).arg(profile.vram).arg(profile.disk));
+    onApplyFilter();
+}
+
+void MainWindow::onShowDiagnostics() {
+    QString report = StartupProfiler::instance().report();
+    
+    QString dbState = dbConnecting_ ? "подключение..." :
+                      dbManager_.isConnected() ? "подключено" : "нет подключения";
+    
+    QString stalls;
+    if (!stallWatchdog_) {
+        stalls = "сторож отключён (TEMPORIUM_STALL_MS=0)";
+    } else {
+        QStringList lines;
+        for (const auto& entry : stallWatchdog_->summary()) {
+            lines << QString("%1 — %2 раз, всего %3 мс, дольше всего %4 мс")
+                         .arg(QString::fromStdString(entry.call)).arg(entry.count)
+                         .arg(entry.total_ms).arg(entry.max_ms);
+        }
+        stalls = QString("%1\n\nПорог %2 мс, журнал: %3")
+            .arg(lines.isEmpty() ? "не было" : lines.join("\n"))
+            .arg(stallWatchdog_->thresholdMs())
+            .arg(QString::fromStdString(stallWatchdog_->logPath()));
+    }
+    
+    QMessageBox::information(this, "Диагностика запуска",
+        QString("Фазы запуска:\n\n%1\n\nБаза данных: %2\n\nЗависания интерфейса за сеанс:\n%3")
+            .arg(report.isEmpty() ? "нет данных" : report, dbState, stalls));
+}
+
+void MainWindow::onSaveTrace() {
+    Tracer& tracer = Tracer::instance();
+    if (tracer.size() == 0) {
+        QMessageBox::information(this, "Трассировка",
+            tracer.enabled() ? "Трассировка пока пуста: выполните действие, которое нужно разобрать."
+                             : "Трассировка не записывалась. Включите «Справка → Записывать трассировку» "
+                               "и повторите действие.");
+        return;
+    }
+    
+    QString filename = QFileDialog::getSaveFileName(this, "Сохранить трассировку",
+        QDir::homePath() + "/temporium_trace.json", "Chrome trace (*.json)");
+    if (filename.isEmpty()) return;
+    
+    std::string error;
+    if (tracer.exportChromeTrace(filename.toStdString(), &error)) {
+        QMessageBox::information(this, "Трассировка",
+            QString("Сохранено интервалов: %1.\n\nФайл открывается в chrome://tracing или ui.perfetto.dev.")
+                .arg(tracer.size()));
+    } else {
+        QMessageBox::critical(this, "Ошибка",
+            QString("Не удалось сохранить трассировку: %1").arg(QString::fromStdString(error)));
+    }
+}
+
 void MainWindow::onAbout() {
     QMessageBox aboutBox(this);
     aboutBox.setWindowTitle("О программе");
@@ -1458,140 +1899,95 @@ void MainWindow::resetTableColumnWidths() {
 }
 
 void MainWindow::updateGamesTable() {
-    std::vector<Game> games;
-    
-    if (filterActive_) {
-        games = dbManager_.getFilteredGames(currentUser_.id, currentFilter_);
+    TraceSpan span("MainWindow::updateGamesTable", "ui");
+    // Строки приходят порциями из фонового загрузчика (onGamesChunkLoaded)
+    gamesTable_->clearSelection();
+    gamesModel_->clear();
+    gamesLoading_ = true;
+    fullCollectionLoaded_ = false;
+    
+    gameLoader_->setConnectionString(dbManager_.getConnectionString());
+    if (filterActive_ && currentExpression_) {
+        loadGeneration_ = gameLoader_->loadFiltered(currentUser_.id, currentExpression_);
+    } else if (filterActive_) {
+        loadGeneration_ = gameLoader_->loadFiltered(currentUser_.id, currentFilter_);
     } else {
-        games = dbManager_.getAllGames(currentUser_.id);
+        loadGeneration_ = gameLoader_->loadAll(currentUser_.id);
     }
     
-    updateGamesTable(games);
+    loadingLabel_->setText("⏳ Загрузка...");
+    loadingLabel_->setVisible(true);
+    cancelLoadButton_->setVisible(true);
+    updateButtonStates();
 }
 
-void MainWindow::updateGamesTable(const std::vector<Game>& games) {
-    gamesTable_->setRowCount(0);
-    gamesTable_->clearSelection();
+void MainWindow::onGamesChunkLoaded(quint64 generation, std::shared_ptr<CompactGameCollection> games) {
+    TraceSpan span("MainWindow::onGamesChunkLoaded", "ui");
+    if (generation != loadGeneration_) return;  // Устаревшая загрузка
     
-    for (const auto& game : games) {
-        int row = gamesTable_->rowCount();
-        gamesTable_->insertRow(row);
-        
-        gamesTable_->setItem(row, 0, new QTableWidgetItem(QString::number(game.id)));
-        
-        // Название с индикатором заметок
-        QString gameName = QString::fromStdString(game.name);
-        if (!game.notes.empty()) {
-            gameName += " 📝";  // Индикатор наличия заметок
-        }
-        QTableWidgetItem* nameItem = new QTableWidgetItem(gameName);
-        if (!game.notes.empty()) {
-            nameItem->setToolTip("Есть заметки: " + QString::fromStdString(game.notes).left(100) + "...");
-        }
-        gamesTable_->setItem(row, 1, nameItem);
-        
-        gamesTable_->setItem(row, 2, new QTableWidgetItem(QString::number(game.disk_space, 'f', 1)));
-        gamesTable_->setItem(row, 3, new QTableWidgetItem(QString::number(game.ram_usage, 'f', 1)));
-        gamesTable_->setItem(row, 4, new QTableWidgetItem(QString::number(game.vram_required, 'f', 1)));
-        gamesTable_->setItem(row, 5, new QTableWidgetItem(QString::fromStdString(game.genre)));
-        gamesTable_->setItem(row, 6, new QTableWidgetItem(game.completed ? "Да ✓" : "Нет"));
-        
-        // Оценка (колонка 7)
-        QString ratingStr = (game.rating < 0) ? "—" : QString::number(game.rating);
-        QTableWidgetItem* ratingItem = new QTableWidgetItem(ratingStr);
-        ratingItem->setTextAlignment(Qt::AlignCenter);
-        if (game.rating >= 8) {
-            ratingItem->setForeground(QColor("#4CAF50"));  
-        } else if (game.rating >= 5 && game.rating < 8) {
-            ratingItem->setForeground(QColor("#FFC107"));  
-        } else if (game.rating >= 0) {
-            ratingItem->setForeground(QColor("#F44336"));  
-        }
-        gamesTable_->setItem(row, 7, ratingItem);
-        
-        // Избранное (колонка 8)
-        QTableWidgetItem* favItem = new QTableWidgetItem(game.is_favorite ? "★" : "");
-        favItem->setTextAlignment(Qt::AlignCenter);
-        if (game.is_favorite) {
-            favItem->setForeground(QColor("#FFD700"));  
-            QFont favFont = favItem->font();
-            favFont.setPointSize(14);
-            favItem->setFont(favFont);
-        }
-        gamesTable_->setItem(row, 8, favItem);
-        
-        // Установлено (колонка 9)
-        QTableWidgetItem* installedItem = new QTableWidgetItem(game.is_installed ? "📥" : "");
-        installedItem->setTextAlignment(Qt::AlignCenter);
-        if (game.is_installed) {
-            installedItem->setForeground(QColor("#2196F3"));  
-            QFont instFont = installedItem->font();
-            instFont.setPointSize(12);
-            installedItem->setFont(instFont);
-        }
-        gamesTable_->setItem(row, 9, installedItem);
-        
-        // Теги (колонка 10)
-        QTableWidgetItem* tagsItem = new QTableWidgetItem(QString::fromStdString(game.tags));
-        tagsItem->setForeground(QColor(TEXT_SECONDARY));
-        gamesTable_->setItem(row, 10, tagsItem);
-        
-        // Ссылка (колонка 11)
-        QTableWidgetItem* urlItem = new QTableWidgetItem();
-        if (!game.url.empty()) {
-            urlItem->setText("🔗 Открыть");
-            urlItem->setData(Qt::UserRole, QString::fromStdString(game.url));
-            urlItem->setForeground(QColor(ACCENT_COLOR));
-            urlItem->setToolTip(QString::fromStdString(game.url));
-            QFont linkFont = urlItem->font();
-            linkFont.setUnderline(true);
-            urlItem->setFont(linkFont);
-        }
-        gamesTable_->setItem(row, 11, urlItem);
-        
-        // Сохраняем ID игры для редактирования заметок
-        gamesTable_->item(row, 0)->setData(Qt::UserRole + 1, QString::fromStdString(game.notes));
-        
-        if (game.completed) {
-            QColor completedColor(30, 60, 30, 180);
-            for (int col = 0; col < gamesTable_->columnCount(); ++col) {
-                QTableWidgetItem* item = gamesTable_->item(row, col);
-                if (item) {
-                    item->setBackground(completedColor);
-                }
-            }
-        }
-        
-        if (game.is_favorite && !game.completed) {
-            QColor favoriteColor(60, 50, 20, 150);
-            for (int col = 0; col < gamesTable_->columnCount(); ++col) {
-                QTableWidgetItem* item = gamesTable_->item(row, col);
-                if (item) {
-                    item->setBackground(favoriteColor);
-                }
-            }
-        }
+    gamesModel_->appendGames(std::move(*games));
+    loadingLabel_->setText(QString("⏳ Загружено строк: %1").arg(gamesModel_->rowCount()));
+}
+
+void MainWindow::onGamesLoadFinished(quint64 generation, bool ok, const QString& error) {
+    TraceSpan span("MainWindow::onGamesLoadFinished", "ui");
+    if (generation != loadGeneration_) return;
+    
+    gamesLoading_ = false;
+    fullCollectionLoaded_ = ok && !filterActive_;
+    gamesModel_->finishLoading();
+    loadingLabel_->setVisible(false);
+    cancelLoadButton_->setVisible(false);
+    
+    updateButtonStates();
+    updateStatusBar();
+    updateStats();
+    
+    if (!ok) {
+        statusBar()->showMessage(QString("Ошибка загрузки игр: %1").arg(error));
     }
+}
+
+void MainWindow::onCancelLoading() {
+    if (!gamesLoading_) return;
+    
+    // Поздние порции и итог отменённой загрузки отбрасываются по номеру
+    gameLoader_->cancel();
+    loadGeneration_ = 0;
+    gamesLoading_ = false;
+    fullCollectionLoaded_ = false;
+    gamesModel_->finishLoading();
+    loadingLabel_->setVisible(false);
+    cancelLoadButton_->setVisible(false);
     
     updateButtonStates();
     updateStatusBar();
     updateStats();
+    statusBar()->showMessage(QString("Загрузка остановлена, показано строк: %1").arg(gamesModel_->rowCount()));
 }
 
 void MainWindow::updateStatusBar() {
-    QString status = QString("Игр в коллекции: %1").arg(gamesTable_->rowCount());
+    QString status = QString("Игр в коллекции: %1").arg(gamesModel_->rowCount());
     
     if (filterActive_) {
         status += " (фильтр активен)";
     }
     
-    statusBar()->showMessage(status);
+    // Во время загрузки строки считает loadingLabel_
+    collectionCountLabel_->setText(status);
+    collectionCountLabel_->setVisible(!gamesLoading_);
 }
 
 void MainWindow::updateStats() {
     if (currentUser_.id == 0) return;
     
-    GameStats stats = dbManager_.getGameStats(currentUser_.id);
+    // Статистика обновится по окончании загрузки (onGamesLoadFinished)
+    if (gamesLoading_) return;
+    
+    // Вся коллекция уже в таблице — считаем на клиенте,
+    // запрос к БД нужен только для отфильтрованного представления
+    GameStats stats = fullCollectionLoaded_ ? gamesModel_->stats()
+                                            : dbManager_.getGameStats(currentUser_.id);
     
     QString statsText = QString(
         "★ Избранное: %1  |  ✓ Пройдено: %2  |  📊 Без оценки: %3  |  "
@@ -1607,15 +2003,62 @@ void MainWindow::updateStats() {
 }
 
 void MainWindow::updateTagsCombo() {
+    // Сохраняем выбранный тег, если он остался в словаре
+    QString selected = filterTagCombo_->currentData().toString();
+    
     filterTagCombo_->clear();
     filterTagCombo_->addItem("Все теги", "");
     
-    if (currentUser_.id == 0) return;
-    
-    std::vector<std::string> tags = dbManager_.getUserTags(currentUser_.id);
-    for (const auto& tag : tags) {
+    for (const auto& tag : tagDictionary_.tags()) {
         filterTagCombo_->addItem(QString::fromStdString(tag), QString::fromStdString(tag));
     }
+    
+    int index = selected.isEmpty() ? 0 : filterTagCombo_->findData(selected);
+    filterTagCombo_->setCurrentIndex(index < 0 ? 0 : index);
+}
+
+void MainWindow::reloadTags() {
+    // Полная выборка тегов — только при входе, обновлении и импорте
+    tagDictionary_.assign(dbManager_.getUserTagCounts(currentUser_.id));
+    updateTagsCombo();
+}
+
+void MainWindow::applyTagChange(const std::string& old_tags, const std::string& new_tags) {
+    if (tagDictionary_.applyChange(old_tags, new_tags)) {
+        updateTagsCombo();
+    }
+}
+
+QStringList MainWindow::tagSuggestions() const {
+    QStringList result;
+    for (const auto& tag : tagDictionary_.tags()) {
+        result << QString::fromStdString(tag);
+    }
+    return result;
+}
+
+
+TagCompleter::TagCompleter(const QStringList& tags, QObject* parent)
+    : QCompleter(tags, parent)
+{
+    setCaseSensitivity(Qt::CaseInsensitive);
+    setCompletionMode(QCompleter::PopupCompletion);
+}
+
+QStringList TagCompleter::splitPath(const QString& path) const {
+    // Дополняется только тег после последней запятой
+    return QStringList() << path.section(',', -1).trimmed();
+}
+
+QString TagCompleter::pathFromIndex(const QModelIndex& index) const {
+    QString text = static_cast<QLineEdit*>(widget())->text();
+    QString tag = QCompleter::pathFromIndex(index);
+    
+    int comma = text.lastIndexOf(',');
+    if (comma < 0) {
+        return tag;
+    }
+    return text.left(comma + 1) + " " + tag;
 }
 
 
@@ -1779,6 +2222,10 @@ GameEditDialog::GameEditDialog(QWidget* parent, const Game* game)
     }
 }
 
+void GameEditDialog::setTagSuggestions(const QStringList& tags) {
+    tagsEdit_->setCompleter(new TagCompleter(tags, tagsEdit_));
+}
+
 Game GameEditDialog::getGame() const {
     Game game;
     game.id = gameId_;
@@ -1794,7 +2241,7 @@ Game GameEditDialog::getGame() const {
     game.rating = ratingCombo_->currentData().toInt();
     game.is_favorite = favoriteCheck_->isChecked();
     game.is_installed = installedCheck_->isChecked();
-    game.tags = tagsEdit_->text().trimmed().toStdString();
+    game.tags = TagDictionary::canonical(tagsEdit_->text().toStdString());
     game.notes = notesEdit_->toPlainText().toStdString();
     
     return game;
@@ -1847,6 +2294,199 @@ BinaryFileViewDialog::BinaryFileViewDialog(const std::vector<Game>& games,
     layout->addWidget(closeButton);
 }
 
+SimilarGamesDialog::SimilarGamesDialog(DatabaseManager* dbManager, int userId, bool isAdmin,
+                                       const Game& target, GamesTableModel* model, QWidget* parent)
+    : QDialog(parent, Qt::Dialog | Qt::WindowTitleHint | Qt::WindowCloseButtonHint)
+    , dbManager_(dbManager)
+    , userId_(userId)
+    , target_(target)
+    , model_(model)
+    , scopeCombo_(nullptr)
+    , ownScope_(-1)
+{
+    setWindowTitle("Похожие игры");
+    setMinimumSize(900, 450);
+    setModal(true);
+    
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    
+    QHBoxLayout* headerLayout = new QHBoxLayout();
+    headerLayout->addWidget(new QLabel(QString("Похожие на «%1»").arg(QString::fromStdString(target.name))));
+    headerLayout->addStretch();
+    if (isAdmin) {
+        scopeCombo_ = new QComboBox();
+        scopeCombo_->addItem("В моей коллекции");
+        scopeCombo_->addItem("У всех пользователей");
+        headerLayout->addWidget(scopeCombo_);
+    }
+    layout->addLayout(headerLayout);
+    
+    table_ = new QTableWidget();
+    table_->setColumnCount(6);
+    table_->setHorizontalHeaderLabels({"Название", "Жанр", "Теги", "Совпадение тегов", "Сходство", "Пользователь"});
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table_->horizontalHeader()->setStretchLastSection(true);
+    table_->setColumnWidth(0, 250);
+    table_->setColumnWidth(2, 220);
+    table_->verticalHeader()->setVisible(false);
+    layout->addWidget(table_);
+    
+    statusLabel_ = new QLabel();
+    layout->addWidget(statusLabel_);
+    
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    QPushButton* closeButton = new QPushButton("Закрыть");
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(closeButton);
+    layout->addLayout(buttonLayout);
+    
+    if (scopeCombo_) {
+        connect(scopeCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SimilarGamesDialog::onScopeChanged);
+    }
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::accept);
+    
+    onScopeChanged();
+}
+
+void SimilarGamesDialog::onScopeChanged() {
+    int scope = scopeCombo_ ? scopeCombo_->currentIndex() : 0;
+    table_->setColumnHidden(5, scope == 0);
+    
+    // Вся коллекция пользователя уже в модели — её индекс общий с таблицей
+    if (scope == 0 && model_) {
+        showSimilar(model_->collection(), model_->similarIndex());
+        return;
+    }
+    
+    if (ownScope_ != scope) {
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        bool loaded = true;
+        if (scope == 1) {
+            loaded = dbManager_->loadAllUsersGames(ownGames_);
+            usernames_.clear();
+            for (const auto& user : dbManager_->getAllUsers()) {
+                usernames_[user.id] = QString::fromStdString(user.username);
+            }
+        } else {
+            ownGames_.clear();
+            loaded = dbManager_->streamGames(userId_, nullptr, nullptr,
+                                             GameLoader::CHUNK_SIZE, GameLoader::CHUNK_SIZE,
+                                             [this](CompactGameCollection&& chunk) {
+                                                 ownGames_.append(std::move(chunk));
+                                                 return true;
+                                             });
+        }
+        ownIndex_.build(ownGames_);
+        ownScope_ = loaded ? scope : -1;
+        QApplication::restoreOverrideCursor();
+        
+        if (!loaded) {
+            table_->setRowCount(0);
+            statusLabel_->setText(QString("Ошибка загрузки: %1").arg(QString::fromStdString(dbManager_->getLastError())));
+            return;
+        }
+    }
+    showSimilar(ownGames_, ownIndex_);
+}
+
+void SimilarGamesDialog::showSimilar(const CompactGameCollection& games, const SimilarGamesIndex& index) {
+    table_->setRowCount(0);
+    
+    int targetRow = index.rowOf(target_.id);
+    if (targetRow < 0) {
+        statusLabel_->setText("Игра не найдена в коллекции");
+        return;
+    }
+    
+    std::vector<SimilarGame> similar = index.similar(static_cast<uint32_t>(targetRow), SimilarGamesIndex::DEFAULT_RESULTS);
+    for (const auto& game : similar) {
+        int row = table_->rowCount();
+        table_->insertRow(row);
+        table_->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(std::string(games.name(game.row)))));
+        table_->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(std::string(games.genre(game.row)))));
+        table_->setItem(row, 2, new QTableWidgetItem(QString::fromStdString(games.tags(game.row))));
+        table_->setItem(row, 3, new QTableWidgetItem(QString("%1%").arg(game.tags_similarity * 100.0, 0, 'f', 0)));
+        table_->setItem(row, 4, new QTableWidgetItem(QString("%1%").arg(game.score * 100.0, 0, 'f', 0)));
+        table_->setItem(row, 5, new QTableWidgetItem(usernames_.value(games.at(game.row).user_id)));
+    }
+    
+    statusLabel_->setText(similar.empty() ? "Похожих игр не найдено"
+                                          : QString("Игр в поиске: %1").arg(games.size()));
+}
+
+NearDuplicatesDialog::NearDuplicatesDialog(const std::vector<NearDuplicate>& pairs,
+                                           const std::vector<std::string>& existingNames,
+                                           const std::vector<Game>& imported,
+                                           QWidget* parent)
+    : QDialog(parent, Qt::Dialog | Qt::WindowTitleHint | Qt::WindowCloseButtonHint)
+    , importCount_(imported.size())
+{
+    setWindowTitle("Похожие названия");
+    setMinimumSize(900, 500);
+    setModal(true);
+    
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    
+    QLabel* infoLabel = new QLabel(QString(
+        "Найдено похожих названий: %1. Отмеченные игры из файла не будут импортированы.")
+        .arg(pairs.size()));
+    infoLabel->setWordWrap(true);
+    layout->addWidget(infoLabel);
+    
+    table_ = new QTableWidget();
+    table_->setColumnCount(4);
+    table_->setHorizontalHeaderLabels({"Импортируемая игра", "Похожая игра", "Где", "Сходство"});
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->horizontalHeader()->setStretchLastSection(true);
+    table_->setColumnWidth(0, 300);
+    table_->setColumnWidth(1, 300);
+    table_->verticalHeader()->setVisible(false);
+    table_->setRowCount(static_cast<int>(pairs.size()));
+    
+    size_t existingCount = existingNames.size();
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const NearDuplicate& pair = pairs[i];
+        int row = static_cast<int>(i);
+        
+        // Второй в паре всегда из файла; первый — из коллекции или тоже из файла
+        size_t importIndex = pair.second - existingCount;
+        importIndexes_.push_back(importIndex);
+        bool inCollection = pair.first < existingCount;
+        const std::string& similar = inCollection ? existingNames[pair.first]
+                                                  : imported[pair.first - existingCount].name;
+        
+        QTableWidgetItem* nameItem = new QTableWidgetItem(QString::fromStdString(imported[importIndex].name));
+        nameItem->setFlags(nameItem->flags() | Qt::ItemIsUserCheckable);
+        nameItem->setCheckState(inCollection ? Qt::Checked : Qt::Unchecked);
+        table_->setItem(row, 0, nameItem);
+        table_->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(similar)));
+        table_->setItem(row, 2, new QTableWidgetItem(inCollection ? "В коллекции" : "В этом файле"));
+        table_->setItem(row, 3, new QTableWidgetItem(QString("%1%").arg(pair.similarity * 100.0, 0, 'f', 0)));
+    }
+    layout->addWidget(table_);
+    
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    QPushButton* importButton = new QPushButton("📥 Импортировать");
+    QPushButton* cancelButton = new QPushButton("Отмена");
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(importButton);
+    buttonLayout->addWidget(cancelButton);
+    layout->addLayout(buttonLayout);
+    
+    connect(importButton, &QPushButton::clicked, this, &QDialog::accept);
+    connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+}
+
+std::vector<bool> NearDuplicatesDialog::skipped() const {
+    std::vector<bool> result(importCount_, false);
+    for (int row = 0; row < table_->rowCount(); ++row) {
+        if (table_->item(row, 0)->checkState() == Qt::Checked) {
+            result[importIndexes_[static_cast<size_t>(row)]] = true;
+        }
+    }
+    return result;
+}
 
 AdminPanelDialog::AdminPanelDialog(DatabaseManager* dbManager, int adminUserId, QWidget* parent)
     : QDialog(parent, Qt::Dialog | Qt::WindowTitleHint | Qt::WindowCloseButtonHint | Qt::WindowStaysOnTopHint)
@@ -1854,7 +2494,7 @@ AdminPanelDialog::AdminPanelDialog(DatabaseManager* dbManager, int adminUserId,
     , adminUserId_(adminUserId)
 {
     setWindowTitle("Панель администратора");
-    setMinimumSize(800, 600);
+    setMinimumSize(800, 760);
     setModal(true);
     
     QVBoxLayout* layout = new QVBoxLayout(this);
@@ -1899,6 +2539,33 @@ AdminPanelDialog::AdminPanelDialog(DatabaseManager* dbManager, int adminUserId,
     
     layout->addWidget(usersTable_);
     
+    // Сводка строится по приближённым структурам и обновляется по изменениям
+    // с прошлого раза, а не полным просмотром всех игр
+    QGroupBox* summaryBox = new QGroupBox("Сводка по всем пользователям (приближённо)");
+    QVBoxLayout* summaryLayout = new QVBoxLayout(summaryBox);
+    
+    QHBoxLayout* summaryHeader = new QHBoxLayout();
+    summaryLabel_ = new QLabel();
+    summaryLabel_->setWordWrap(true);
+    QPushButton* summaryButton = new QPushButton("🔄 Обновить сводку");
+    summaryHeader->addWidget(summaryLabel_, 1);
+    summaryHeader->addWidget(summaryButton);
+    summaryLayout->addLayout(summaryHeader);
+    
+    commonTable_ = new QTableWidget();
+    commonTable_->setColumnCount(3);
+    commonTable_->setHorizontalHeaderLabels({"Игра", "Копий (оценка)", "Погрешность"});
+    commonTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    commonTable_->setSelectionMode(QAbstractItemView::NoSelection);
+    commonTable_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    commonTable_->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    commonTable_->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
+    commonTable_->verticalHeader()->setVisible(false);
+    commonTable_->setMaximumHeight(220);
+    summaryLayout->addWidget(commonTable_);
+    
+    layout->addWidget(summaryBox);
+    
     QHBoxLayout* buttonLayout = new QHBoxLayout();
     
     deleteButton_ = new QPushButton("🗑️ Удалить пользователя");
@@ -1920,6 +2587,7 @@ AdminPanelDialog::AdminPanelDialog(DatabaseManager* dbManager, int adminUserId,
     connect(changeUsernameButton_, &QPushButton::clicked, this, &AdminPanelDialog::onChangeUsername);
     connect(changePasswordButton_, &QPushButton::clicked, this, &AdminPanelDialog::onChangePassword);
     connect(resetAdminButton_, &QPushButton::clicked, this, &AdminPanelDialog::onResetAdmin);
+    connect(summaryButton, &QPushButton::clicked, this, &AdminPanelDialog::onRefreshSummary);
     connect(closeButton, &QPushButton::clicked, this, &QDialog::accept);
     connect(usersTable_, &QTableWidget::itemSelectionChanged, [this]() {
         int row = usersTable_->currentRow();
@@ -1932,6 +2600,45 @@ AdminPanelDialog::AdminPanelDialog(DatabaseManager* dbManager, int adminUserId,
     });
     
     updateUsersList();
+    updateSummary();
+}
+
+void AdminPanelDialog::updateSummary() {
+    commonTable_->setRowCount(0);
+    
+    std::string rebuiltAt;
+    if (!dbManager_->refreshNameSketch(nameSketch_, &rebuiltAt)) {
+        summaryLabel_->setText(QString("Не удалось обновить сводку: %1")
+            .arg(QString::fromStdString(dbManager_->getLastError())));
+        return;
+    }
+    
+    const CountMinSketch& counts = nameSketch_.counts();
+    const HyperLogLog& distinct = nameSketch_.distinct();
+    double distinctCount = distinct.estimate();
+    // Погрешность частот: не больше ε·N с вероятностью 1−δ
+    long long countError = static_cast<long long>(std::ceil(counts.epsilon() * counts.total()));
+    
+    summaryLabel_->setText(QString("Всего игр: %1. Различных названий: ≈ %2 ± %3.\n"
+                                   "Полный пересчёт: %4")
+        .arg(counts.total())
+        .arg(std::llround(distinctCount))
+        .arg(std::llround(distinct.standardError() * distinctCount))
+        .arg(QString::fromStdString(rebuiltAt)));
+    
+    for (const auto& frequent : nameSketch_.mostCommon(10)) {
+        int row = commonTable_->rowCount();
+        commonTable_->insertRow(row);
+        commonTable_->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(frequent.name)));
+        commonTable_->setItem(row, 1, new QTableWidgetItem(QString::number(frequent.estimate)));
+        commonTable_->setItem(row, 2, new QTableWidgetItem(QString("+%1 (вероятность %2%)")
+            .arg(countError)
+            .arg((1.0 - counts.delta()) * 100.0, 0, 'f', 1)));
+    }
+}
+
+void AdminPanelDialog::onRefreshSummary() {
+    updateSummary();
 }
 
 void AdminPanelDialog::updateUsersList() {
@@ -1939,7 +2646,22 @@ void AdminPanelDialog::updateUsersList() {
     
     std::vector<User> users = dbManager_->getAllUsers();
     
+    // Число игр всех пользователей — один запрос (через сервер — один обмен)
+    std::vector<int> userIds;
+    userIds.reserve(users.size());
     for (const auto& user : users) {
+        userIds.push_back(user.id);
+    }
+    std::vector<int> gamesCounts;
+    bool countsLoaded = dbManager_->getUserGamesCounts(userIds, gamesCounts);
+    if (!countsLoaded) {
+        QMessageBox::warning(this, "Ошибка",
+            QString("Не удалось получить число игр пользователей: %1")
+                .arg(QString::fromStdString(dbManager_->getLastError())));
+    }
+    
+    for (size_t i = 0; i < users.size(); ++i) {
+        const User& user = users[i];
         int row = usersTable_->rowCount();
         usersTable_->insertRow(row);
         
@@ -1947,8 +2669,8 @@ void AdminPanelDialog::updateUsersList() {
         usersTable_->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(user.username)));
         usersTable_->setItem(row, 2, new QTableWidgetItem(user.is_admin ? "Администратор" : "Пользователь"));
         
-        int gamesCount = dbManager_->getUserGamesCount(user.id);
-        usersTable_->setItem(row, 3, new QTableWidgetItem(QString::number(gamesCount)));
+        // Без ответа БД число неизвестно, а не ноль
+        usersTable_->setItem(row, 3, new QTableWidgetItem(countsLoaded ? QString::number(gamesCounts[i]) : "—"));
         
         if (user.is_admin) {
             for (int col = 0; col < usersTable_->columnCount(); ++col) {
@@ -2168,4 +2890,285 @@ void AdminPanelDialog::onResetAdmin() {
     }
 }
 
+MachineFitDialog::MachineFitDialog(DatabaseManager* dbManager, int userId, bool isAdmin, GamesTableModel* model,
+                                   const std::vector<MachineProfile>& profiles, QWidget* parent)
+    : QDialog(parent, Qt::Dialog | Qt::WindowTitleHint | Qt::WindowCloseButtonHint)
+    , dbManager_(dbManager)
+    , userId_(userId)
+    , model_(model)
+    , profiles_(profiles)
+    , shownProfile_(0)
+    , usersTable_(nullptr)
+{
+    setWindowTitle("Что пойдёт на компьютере");
+    setMinimumSize(700, isAdmin ? 600 : 400);
+    setModal(true);
+    
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    
+    QGroupBox* profileBox = new QGroupBox("Новый профиль");
+    QHBoxLayout* profileLayout = new QHBoxLayout(profileBox);
+    nameEdit_ = new QLineEdit();
+    nameEdit_->setPlaceholderText("Название");
+    ramSpin_ = new QSpinBox();
+    ramSpin_->setRange(0, 1024);
+    ramSpin_->setValue(16);
+    ramSpin_->setSuffix(" ГБ ОЗУ");
+    vramSpin_ = new QSpinBox();
+    vramSpin_->setRange(0, 256);
+    vramSpin_->setValue(8);
+    vramSpin_->setSuffix(" ГБ видео");
+    diskSpin_ = new QSpinBox();
+    diskSpin_->setRange(0, 100000);
+    diskSpin_->setValue(500);
+    diskSpin_->setSuffix(" ГБ на диске");
+    QPushButton* addButton = new QPushButton("➕ Добавить");
+    profileLayout->addWidget(nameEdit_);
+    profileLayout->addWidget(ramSpin_);
+    profileLayout->addWidget(vramSpin_);
+    profileLayout->addWidget(diskSpin_);
+    profileLayout->addWidget(addButton);
+    layout->addWidget(profileBox);
+    
+    profilesTable_ = new QTableWidget();
+    profilesTable_->setColumnCount(5);
+    profilesTable_->setHorizontalHeaderLabels({"Профиль", "ОЗУ (ГБ)", "Видео (ГБ)", "Диск (ГБ)", "Подходит игр"});
+    profilesTable_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    profilesTable_->setSelectionMode(QAbstractItemView::SingleSelection);
+    profilesTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    profilesTable_->horizontalHeader()->setStretchLastSection(true);
+    profilesTable_->setColumnWidth(0, 200);
+    profilesTable_->verticalHeader()->setVisible(false);
+    layout->addWidget(profilesTable_);
+    
+    if (isAdmin) {
+        layout->addWidget(new QLabel("Подходит выбранному профилю у пользователей:"));
+        usersTable_ = new QTableWidget();
+        usersTable_->setColumnCount(2);
+        usersTable_->setHorizontalHeaderLabels({"Пользователь", "Игр"});
+        usersTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        usersTable_->horizontalHeader()->setStretchLastSection(true);
+        usersTable_->setColumnWidth(0, 200);
+        usersTable_->verticalHeader()->setVisible(false);
+        layout->addWidget(usersTable_);
+    }
+    
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    removeButton_ = new QPushButton("🗑️ Удалить профиль");
+    removeButton_->setEnabled(false);
+    showButton_ = new QPushButton("🔍 Показать в таблице");
+    showButton_->setEnabled(false);
+    QPushButton* closeButton = new QPushButton("Закрыть");
+    buttonLayout->addWidget(removeButton_);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(showButton_);
+    buttonLayout->addWidget(closeButton);
+    layout->addLayout(buttonLayout);
+    
+    connect(addButton, &QPushButton::clicked, this, &MachineFitDialog::onAddProfile);
+    connect(nameEdit_, &QLineEdit::returnPressed, this, &MachineFitDialog::onAddProfile);
+    connect(removeButton_, &QPushButton::clicked, this, &MachineFitDialog::onRemoveProfile);
+    connect(showButton_, &QPushButton::clicked, this, &MachineFitDialog::onShowInTable);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::reject);
+    connect(profilesTable_, &QTableWidget::itemSelectionChanged, this, &MachineFitDialog::onProfileSelected);
+    
+    updateCounts();
+}
+
+void MachineFitDialog::updateCounts() {
+    // Все профили считаются за один проход (по дереву или запросом)
+    std::vector<int> counts;
+    if (model_) {
+        for (size_t count : model_->machineIndex().count(profiles_)) {
+            counts.push_back(static_cast<int>(count));
+        }
+    } else {
+        counts = dbManager_->countFittingGames(userId_, profiles_);
+    }
+    
+    profilesTable_->setRowCount(0);
+    for (size_t i = 0; i < profiles_.size(); ++i) {
+        const MachineProfile& profile = profiles_[i];
+        int row = profilesTable_->rowCount();
+        profilesTable_->insertRow(row);
+        profilesTable_->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(profile.name)));
+        profilesTable_->setItem(row, 1, new QTableWidgetItem(QString::number(profile.ram)));
+        profilesTable_->setItem(row, 2, new QTableWidgetItem(QString::number(profile.vram)));
+        profilesTable_->setItem(row, 3, new QTableWidgetItem(QString::number(profile.disk)));
+        profilesTable_->setItem(row, 4, new QTableWidgetItem(
+            i < counts.size() ? QString::number(counts[i]) : QString("—")));
+    }
+}
+
+void MachineFitDialog::onAddProfile() {
+    MachineProfile profile;
+    profile.name = nameEdit_->text().trimmed().toStdString();
+    if (profile.name.empty()) {
+        profile.name = "Профиль " + std::to_string(profiles_.size() + 1);
+    }
+    profile.ram = static_cast<unsigned int>(ramSpin_->value());
+    profile.vram = static_cast<unsigned int>(vramSpin_->value());
+    profile.disk = static_cast<unsigned int>(diskSpin_->value());
+    profiles_.push_back(profile);
+    nameEdit_->clear();
+    
+    updateCounts();
+    profilesTable_->selectRow(static_cast<int>(profiles_.size()) - 1);
+}
+
+void MachineFitDialog::onRemoveProfile() {
+    int row = profilesTable_->currentRow();
+    if (row < 0 || row >= static_cast<int>(profiles_.size())) return;
+    
+    profiles_.erase(profiles_.begin() + row);
+    updateCounts();
+}
+
+void MachineFitDialog::onShowInTable() {
+    int row = profilesTable_->currentRow();
+    if (row < 0 || row >= static_cast<int>(profiles_.size())) return;
+    
+    shownProfile_ = static_cast<size_t>(row);
+    accept();
+}
+
+void MachineFitDialog::onProfileSelected() {
+    int row = profilesTable_->currentRow();
+    bool selected = row >= 0 && row < static_cast<int>(profiles_.size()) &&
+                    !profilesTable_->selectedItems().isEmpty();
+    removeButton_->setEnabled(selected);
+    showButton_->setEnabled(selected);
+    
+    if (!usersTable_) return;
+    usersTable_->setRowCount(0);
+    if (!selected) return;
+    
+    for (const auto& count : dbManager_->getMachineFitCounts(profiles_[static_cast<size_t>(row)])) {
+        int userRow = usersTable_->rowCount();
+        usersTable_->insertRow(userRow);
+        usersTable_->setItem(userRow, 0, new QTableWidgetItem(QString::fromStdString(count.username)));
+        usersTable_->setItem(userRow, 1, new QTableWidgetItem(QString::number(count.games)));
+    }
+}
+
+AnalyticsDialog::AnalyticsDialog(DatabaseManager* dbManager, int userId, const GameFilter* filter,
+                                 std::shared_ptr<const FilterExpression> expression, QWidget* parent)
+    : QDialog(parent, Qt::Dialog | Qt::WindowTitleHint | Qt::WindowCloseButtonHint)
+    , dbManager_(dbManager)
+    , userId_(userId)
+    , hasFilter_(filter != nullptr)
+    , expression_(std::move(expression))
+{
+    if (filter) {
+        filter_ = *filter;
+    }
+    
+    setWindowTitle("Аналитика коллекции");
+    setMinimumSize(800, 500);
+    setModal(true);
+    
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    
+    QHBoxLayout* groupLayout = new QHBoxLayout();
+    groupLayout->addWidget(new QLabel("Группировать по:"));
+    groupCombo_ = new QComboBox();
+    groupCombo_->addItem("Жанру", static_cast<int>(AggregateGroup::Genre));
+    groupCombo_->addItem("Оценке", static_cast<int>(AggregateGroup::Rating));
+    groupCombo_->addItem("Тегу", static_cast<int>(AggregateGroup::Tag));
+    groupCombo_->addItem("Пройдено", static_cast<int>(AggregateGroup::Completed));
+    groupCombo_->addItem("Избранное", static_cast<int>(AggregateGroup::Favorite));
+    groupCombo_->addItem("Установлено", static_cast<int>(AggregateGroup::Installed));
+    groupLayout->addWidget(groupCombo_);
+    groupLayout->addStretch();
+    if (hasFilter_ || expression_) {
+        groupLayout->addWidget(new QLabel("🔍 С учётом текущего фильтра"));
+    }
+    layout->addLayout(groupLayout);
+    
+    table_ = new QTableWidget();
+    table_->setColumnCount(8);
+    table_->setHorizontalHeaderLabels({"Группа", "Игр", "Место (ГБ)", "Установлено (ГБ)",
+                                       "Средняя оценка", "Пройдено", "Средняя RAM (ГБ)", "Средняя VRAM (ГБ)"});
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table_->horizontalHeader()->setStretchLastSection(true);
+    table_->setColumnWidth(0, 180);
+    table_->verticalHeader()->setVisible(false);
+    layout->addWidget(table_);
+    
+    QHBoxLayout* buttonLayout = new QHBoxLayout();
+    QPushButton* closeButton = new QPushButton("Закрыть");
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(closeButton);
+    layout->addLayout(buttonLayout);
+    
+    connect(groupCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &AnalyticsDialog::onGroupChanged);
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::accept);
+    
+    onGroupChanged();
+}
+
+void AnalyticsDialog::onGroupChanged() {
+    static const std::vector<AggregateMetric> metrics = {
+        AggregateMetric::Count,
+        AggregateMetric::DiskSpaceTotal,
+        AggregateMetric::InstalledDiskSpace,
+        AggregateMetric::AverageRating,
+        AggregateMetric::CompletionRate,
+        AggregateMetric::AverageRam,
+        AggregateMetric::AverageVram
+    };
+    
+    AggregateGroup group = static_cast<AggregateGroup>(groupCombo_->currentData().toInt());
+    AggregateResult result = dbManager_->aggregate(userId_, {group}, metrics,
+                                                   hasFilter_ ? &filter_ : nullptr, expression_.get());
+    
+    table_->setRowCount(0);
+    if (result.rows.empty()) {
+        QMessageBox::critical(this, "Ошибка",
+            QString("Не удалось получить аналитику: %1").arg(QString::fromStdString(dbManager_->getLastError())));
+        return;
+    }
+    
+    for (const auto& row : result.rows) {
+        int tableRow = table_->rowCount();
+        table_->insertRow(tableRow);
+        
+        QString key = QString::fromStdString(row.key);
+        if (row.is_total) {
+            key = "Всего";
+        } else if (row.key == "true" || row.key == "false") {
+            key = row.key == "true" ? "Да" : "Нет";
+        } else if (row.group == AggregateGroup::Rating) {
+            key = row.key == "-1" ? "Без оценки" : key + "/10";
+        }
+        table_->setItem(tableRow, 0, new QTableWidgetItem(key));
+        
+        for (size_t i = 0; i < row.values.size(); ++i) {
+            double value = row.values[i];
+            QString text;
+            if (std::isnan(value)) {
+                text = "—";
+            } else if (result.metrics[i] == AggregateMetric::Count) {
+                text = QString::number(static_cast<long long>(value));
+            } else if (result.metrics[i] == AggregateMetric::CompletionRate) {
+                text = QString("%1%").arg(value * 100.0, 0, 'f', 0);
+            } else {
+                text = QString::number(value, 'f', 1);
+            }
+            QTableWidgetItem* item = new QTableWidgetItem(text);
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            table_->setItem(tableRow, static_cast<int>(i) + 1, item);
+        }
+        
+        if (row.is_total) {
+            for (int col = 0; col < table_->columnCount(); ++col) {
+                QFont font = table_->item(tableRow, col)->font();
+                font.setBold(true);
+                table_->item(tableRow, col)->setFont(font);
+            }
+        }
+    }
+}
+
 }
\ No newline at end of file
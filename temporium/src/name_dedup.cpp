@@ -0,0 +1,209 @@
+#include "name_dedup.h"
+#include "hash_utils.h"
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Temporium {
+
+namespace {
+
+// Римские цифры номера части пишутся арабскими ("Heroes III" = "Heroes 3").
+// Одиночные "v" и "x" не заменяются — слишком часто это не цифры
+const char* romanNumeral(const std::string& word) {
+    static const std::pair<const char*, const char*> numerals[] = {
+        {"ii", "2"}, {"iii", "3"}, {"iv", "4"}, {"vi", "6"},
+        {"vii", "7"}, {"viii", "8"}, {"ix", "9"}
+    };
+    for (const auto& numeral : numerals) {
+        if (word == numeral.first) return numeral.second;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+NearDuplicateDetector::NearDuplicateDetector(double threshold)
+    : threshold_(threshold)
+    , names_(0)
+{}
+
+void NearDuplicateDetector::reserve(size_t count) {
+    keys_.reserve(count * 2);
+}
+
+void NearDuplicateDetector::keys(const std::string& name, std::string& full, std::string& main) {
+    // Слова в нижнем регистре; подзаголовок начинается после ':', ' - ' или '('
+    std::vector<std::string> words;
+    size_t mainWords = std::numeric_limits<size_t>::max();
+    std::string word;
+    auto flush = [&]() {
+        if (!word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    };
+
+    for (size_t i = 0; i < name.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(name[i]);
+        if (c < 0x80) {
+            if (std::isalnum(c)) {
+                word += static_cast<char>(std::tolower(c));
+                continue;
+            }
+            flush();
+            bool subtitle = c == ':' || c == '(' ||
+                            (c == '-' && i > 0 && name[i - 1] == ' ' && i + 1 < name.size() && name[i + 1] == ' ');
+            if (subtitle && mainWords == std::numeric_limits<size_t>::max()) {
+                mainWords = words.size();
+            }
+        } else if ((c == 0xD0 || c == 0xD1) && i + 1 < name.size()) {
+            // Кириллица: заглавные А-Я и Ё приводятся к строчным, ё — к е
+            unsigned char next = static_cast<unsigned char>(name[i + 1]);
+            unsigned codepoint = ((c & 0x1Fu) << 6) | (next & 0x3Fu);
+            if (codepoint >= 0x410 && codepoint <= 0x42F) codepoint += 0x20;
+            if (codepoint == 0x401 || codepoint == 0x451) codepoint = 0x435;
+            word += static_cast<char>(0xC0 | (codepoint >> 6));
+            word += static_cast<char>(0x80 | (codepoint & 0x3F));
+            ++i;
+        } else if (c == 0xE2 && i + 2 < name.size() && static_cast<unsigned char>(name[i + 1]) == 0x80 &&
+                   (static_cast<unsigned char>(name[i + 2]) == 0x93 || static_cast<unsigned char>(name[i + 2]) == 0x94)) {
+            // Тире (– и —) отделяет подзаголовок
+            flush();
+            if (mainWords == std::numeric_limits<size_t>::max()) mainWords = words.size();
+            i += 2;
+        } else {
+            word += static_cast<char>(c);
+        }
+    }
+    flush();
+
+    size_t first = !words.empty() && words[0] == "the" && words.size() > 1 ? 1 : 0;
+    full.clear();
+    main.clear();
+    for (size_t i = first; i < words.size(); ++i) {
+        const char* numeral = romanNumeral(words[i]);
+        const std::string& part = numeral ? std::string(numeral) : words[i];
+        full += part;
+        if (i < mainWords) main += part;
+    }
+    if (main.size() == full.size() || main.empty()) {
+        main.clear();
+    }
+}
+
+std::string NearDuplicateDetector::normalize(const std::string& name) {
+    std::string full;
+    std::string main;
+    keys(name, full, main);
+    return full;
+}
+
+uint32_t NearDuplicateDetector::add(const std::string& name) {
+    uint32_t index = names_++;
+    std::string full;
+    std::string main;
+    keys(name, full, main);
+    addKey(index, full);
+    if (!main.empty()) {
+        addKey(index, main);
+    }
+    return index;
+}
+
+void NearDuplicateDetector::addKey(uint32_t name, const std::string& text) {
+    Key key;
+    key.name = name;
+
+    // Короткий ключ — одна "триграмма" целиком
+    if (text.size() < 3) {
+        uint64_t value = 0;
+        for (unsigned char c : text) value = (value << 8) | c;
+        key.trigrams.push_back(HashUtils::mix(value | (uint64_t(text.size()) << 56)));
+    } else {
+        key.trigrams.reserve(text.size() - 2);
+        for (size_t i = 0; i + 2 < text.size(); ++i) {
+            uint64_t value = (uint64_t(static_cast<unsigned char>(text[i])) << 16) |
+                             (uint64_t(static_cast<unsigned char>(text[i + 1])) << 8) |
+                             static_cast<unsigned char>(text[i + 2]);
+            key.trigrams.push_back(HashUtils::mix(value));
+        }
+        std::sort(key.trigrams.begin(), key.trigrams.end());
+        key.trigrams.erase(std::unique(key.trigrams.begin(), key.trigrams.end()), key.trigrams.end());
+    }
+
+    // Значение k-й хэш-функции — перемешанный хэш триграммы с солью k
+    key.signature.fill(std::numeric_limits<uint64_t>::max());
+    for (uint64_t trigram : key.trigrams) {
+        for (int k = 0; k < HASHES; ++k) {
+            uint64_t value = HashUtils::mix(trigram ^ (0x5851f42d4c957f2dull * static_cast<uint64_t>(k + 1)));
+            key.signature[k] = std::min(key.signature[k], value);
+        }
+    }
+
+    keys_.push_back(std::move(key));
+}
+
+std::vector<NearDuplicate> NearDuplicateDetector::findPairs(uint32_t first_checked) const {
+    // Сходство пары — лучшее по всем сочетаниям её ключей
+    std::unordered_map<uint64_t, double> best;
+
+    // Пары ключей, уже сравнённые в предыдущих полосах
+    std::unordered_set<uint64_t> compared;
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;
+    buckets.reserve(keys_.size());
+    for (int band = 0; band < BANDS; ++band) {
+        buckets.clear();
+        for (uint32_t k = 0; k < keys_.size(); ++k) {
+            uint64_t hash = HashUtils::mix(static_cast<uint64_t>(band));
+            for (int row = 0; row < ROWS; ++row) {
+                hash = HashUtils::mix(hash ^ keys_[k].signature[band * ROWS + row]);
+            }
+            buckets[hash].push_back(k);
+        }
+
+        for (const auto& bucket : buckets) {
+            const std::vector<uint32_t>& members = bucket.second;
+            if (members.size() < 2 || members.size() > MAX_BUCKET) continue;
+
+            for (size_t i = 0; i < members.size(); ++i) {
+                for (size_t j = i + 1; j < members.size(); ++j) {
+                    const Key& a = keys_[members[i]];
+                    const Key& b = keys_[members[j]];
+                    if (a.name == b.name) continue;
+                    uint32_t first = std::min(a.name, b.name);
+                    uint32_t second = std::max(a.name, b.name);
+                    if (second < first_checked) continue;
+
+                    if (!compared.insert((uint64_t(members[i]) << 32) | members[j]).second) continue;
+
+                    uint64_t pair = (uint64_t(first) << 32) | second;
+                    double similarity = HashUtils::jaccard(a.trigrams, b.trigrams);
+                    auto it = best.find(pair);
+                    if (it == best.end()) {
+                        best.emplace(pair, similarity);
+                    } else if (similarity > it->second) {
+                        it->second = similarity;
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<NearDuplicate> pairs;
+    for (const auto& entry : best) {
+        if (entry.second < threshold_) continue;
+        pairs.push_back({static_cast<uint32_t>(entry.first >> 32),
+                         static_cast<uint32_t>(entry.first & 0xFFFFFFFFu), entry.second});
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const NearDuplicate& a, const NearDuplicate& b) {
+        if (a.second != b.second) return a.second < b.second;
+        return a.first < b.first;
+    });
+    return pairs;
+}
+
+}
@@ -0,0 +1,147 @@
+#include "rpc_client.h"
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Temporium {
+
+RpcClient::~RpcClient() {
+    close();
+}
+
+bool RpcClient::connect(const std::string& address) {
+    close();
+    address_ = address;
+    int fd = rpcConnect(address, lastError_);
+    if (fd < 0) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(fdMutex_);
+        fd_ = fd;
+    }
+
+    begin();
+    add(RpcOp::Hello, static_cast<unsigned int>(RPC_VERSION));
+    std::string error;
+    bool accepted = false;
+    if (!call() || !nextReply(error)) {
+        return fail(error.empty() ? lastError_ : error);
+    }
+    reply_ >> accepted >> error;
+    if (!reply_.ok() || !accepted) {
+        return fail(error.empty() ? "Server rejected protocol version" : error);
+    }
+    return true;
+}
+
+void RpcClient::close() {
+    {
+        std::lock_guard<std::mutex> lock(fdMutex_);
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+    replies_ = 0;
+}
+
+void RpcClient::abort() {
+    // Сокет закрывает поток-владелец, когда его вызов получит ошибку
+    std::lock_guard<std::mutex> lock(fdMutex_);
+    if (fd_ >= 0) {
+        shutdown(fd_, SHUT_RDWR);
+    }
+}
+
+bool RpcClient::fail(const std::string& error) {
+    lastError_ = error;
+    close();
+    return false;
+}
+
+void RpcClient::begin() {
+    request_.beginFrame(++nextId_, 0);
+    calls_ = 0;
+    replies_ = 0;
+}
+
+bool RpcClient::call() {
+    if (fd_ < 0) {
+        lastError_ = "Not connected to server";
+        return false;
+    }
+    if (calls_ > RPC_MAX_BATCH) {
+        lastError_ = "Too many calls in one frame";
+        return false;
+    }
+    request_.setFrameCount(static_cast<uint16_t>(calls_));
+    request_.finishFrame();
+    if (!rpcSendFrame(fd_, request_.buffer(), lastError_)) {
+        return fail(lastError_);
+    }
+    return readResponse(static_cast<uint16_t>(calls_));
+}
+
+bool RpcClient::callStream(const std::function<bool(RpcReader& chunk)>& onChunk) {
+    if (fd_ < 0) {
+        lastError_ = "Not connected to server";
+        return false;
+    }
+    request_.setFrameCount(static_cast<uint16_t>(calls_));
+    request_.finishFrame();
+    if (!rpcSendFrame(fd_, request_.buffer(), lastError_)) {
+        return fail(lastError_);
+    }
+
+    bool wanted = true;
+    while (readResponse(1)) {
+        // Статус читает nextReply; здесь только заглядываем в него
+        RpcReader peek = reply_;
+        if (static_cast<RpcStatus>(peek.u8()) != RpcStatus::More) {
+            return true;
+        }
+        if (wanted) {
+            wanted = onChunk(peek);
+            if (wanted && !peek.ok()) {
+                return fail("Malformed server reply");
+            }
+        }
+    }
+    return false;
+}
+
+bool RpcClient::readResponse(uint16_t expected) {
+    if (!rpcReadFrame(fd_, response_, lastError_)) {
+        return fail(lastError_.empty() ? "Server closed the connection" : lastError_);
+    }
+    reply_ = RpcReader(response_);
+    uint32_t id = reply_.u32();
+    uint16_t count = reply_.u16();
+    if (!reply_.ok() || id != nextId_ || count != expected) {
+        return fail("Malformed server reply");
+    }
+    replies_ = count;
+    return true;
+}
+
+bool RpcClient::nextReply(std::string& error) {
+    if (replies_ == 0) {
+        error = "No more replies";
+        return false;
+    }
+    --replies_;
+    auto status = static_cast<RpcStatus>(reply_.u8());
+    if (!reply_.ok()) {
+        error = "Malformed server reply";
+        return false;
+    }
+    if (status != RpcStatus::Ok) {
+        reply_ >> error;
+        if (error.empty()) error = "Request rejected by server";
+        // Отказ не оставляет результата — следующий ответ идёт сразу за текстом
+        return false;
+    }
+    return true;
+}
+
+}
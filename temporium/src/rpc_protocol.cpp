@@ -0,0 +1,581 @@
+#include "rpc_protocol.h"
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Temporium {
+
+namespace {
+
+constexpr size_t FRAME_HEADER = 4;
+
+// Флаги GameFilter по порядку полей
+constexpr int FILTER_FLAGS = 14;
+
+bool splitAddress(const std::string& address, std::string& kind, std::string& rest, std::string& error) {
+    size_t colon = address.find(':');
+    if (colon == std::string::npos) {
+        error = "Invalid server address: " + address;
+        return false;
+    }
+    kind = address.substr(0, colon);
+    rest = address.substr(colon + 1);
+    if ((kind != "unix" && kind != "tcp") || rest.empty()) {
+        error = "Invalid server address: " + address;
+        return false;
+    }
+    return true;
+}
+
+bool unixAddress(const std::string& path, sockaddr_un& addr, std::string& error) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        error = "Socket path too long: " + path;
+        return false;
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+addrinfo* resolve(const std::string& hostPort, bool passive, std::string& error) {
+    size_t colon = hostPort.rfind(':');
+    if (colon == std::string::npos) {
+        error = "Port missing in address: " + hostPort;
+        return nullptr;
+    }
+    std::string host = hostPort.substr(0, colon);
+    std::string port = hostPort.substr(colon + 1);
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (passive) hints.ai_flags = AI_PASSIVE;
+
+    addrinfo* result = nullptr;
+    int status = getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &result);
+    if (status != 0) {
+        error = "Cannot resolve " + hostPort + ": " + gai_strerror(status);
+        return nullptr;
+    }
+    return result;
+}
+
+std::string systemError(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+// Поля игры как ссылки в буфер кадра
+void readGameFields(RpcReader& in, GameFields& fields) {
+    in >> fields.id >> fields.user_id >> fields.disk_space >> fields.ram_usage >> fields.vram_required
+       >> fields.rating;
+    uint8_t flags = in.u8();
+    fields.completed = flags & 1;
+    fields.is_favorite = flags & 2;
+    fields.is_installed = flags & 4;
+    fields.name = in.bytes();
+    fields.genre = in.bytes();
+    fields.url = in.bytes();
+    fields.notes = in.bytes();
+    fields.tags = in.bytes();
+}
+
+bool readExactly(int fd, char* data, size_t size, bool& closed, std::string& error) {
+    size_t received = 0;
+    while (received < size) {
+        ssize_t n = recv(fd, data + received, size - received, 0);
+        if (n == 0) {
+            closed = true;
+            return false;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            error = systemError("Receive error");
+            return false;
+        }
+        received += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+const char* rpcOpName(RpcOp op) {
+    switch (op) {
+        case RpcOp::Hello: return "Hello";
+        case RpcOp::Attach: return "Attach";
+        case RpcOp::RegisterUser: return "RegisterUser";
+        case RpcOp::AuthenticateUser: return "AuthenticateUser";
+        case RpcOp::UserExists: return "UserExists";
+        case RpcOp::GetAllUsers: return "GetAllUsers";
+        case RpcOp::DeleteUser: return "DeleteUser";
+        case RpcOp::IsAdmin: return "IsAdmin";
+        case RpcOp::GetUserGamesCount: return "GetUserGamesCount";
+        case RpcOp::GetUserGamesCounts: return "GetUserGamesCounts";
+        case RpcOp::GetMachineFitCounts: return "GetMachineFitCounts";
+        case RpcOp::LoadAllUsersGames: return "LoadAllUsersGames";
+        case RpcOp::RefreshNameSketch: return "RefreshNameSketch";
+        case RpcOp::ChangeUsername: return "ChangeUsername";
+        case RpcOp::ChangePassword: return "ChangePassword";
+        case RpcOp::ResetAdminCredentials: return "ResetAdminCredentials";
+        case RpcOp::AddGame: return "AddGame";
+        case RpcOp::UpdateGame: return "UpdateGame";
+        case RpcOp::DeleteGame: return "DeleteGame";
+        case RpcOp::DeleteGameByName: return "DeleteGameByName";
+        case RpcOp::GetAllGames: return "GetAllGames";
+        case RpcOp::GetFilteredGames: return "GetFilteredGames";
+        case RpcOp::GetFilteredGamesExpression: return "GetFilteredGamesExpression";
+        case RpcOp::GetGameById: return "GetGameById";
+        case RpcOp::GetGameByName: return "GetGameByName";
+        case RpcOp::StreamGames: return "StreamGames";
+        case RpcOp::GetUserTags: return "GetUserTags";
+        case RpcOp::GetUserTagCounts: return "GetUserTagCounts";
+        case RpcOp::UpdateGameNotes: return "UpdateGameNotes";
+        case RpcOp::GetGameStats: return "GetGameStats";
+        case RpcOp::Aggregate: return "Aggregate";
+        case RpcOp::CountFittingGames: return "CountFittingGames";
+        case RpcOp::ImportGames: return "ImportGames";
+        case RpcOp::GetGameNames: return "GetGameNames";
+    }
+    return "Unknown";
+}
+
+// ===== RpcWriter =====
+
+void RpcWriter::u16(uint16_t value) {
+    u8(static_cast<uint8_t>(value));
+    u8(static_cast<uint8_t>(value >> 8));
+}
+
+void RpcWriter::u32(uint32_t value) {
+    u16(static_cast<uint16_t>(value));
+    u16(static_cast<uint16_t>(value >> 16));
+}
+
+void RpcWriter::u64(uint64_t value) {
+    u32(static_cast<uint32_t>(value));
+    u32(static_cast<uint32_t>(value >> 32));
+}
+
+void RpcWriter::f64(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    u64(bits);
+}
+
+void RpcWriter::bytes(std::string_view value) {
+    u32(static_cast<uint32_t>(value.size()));
+    buffer_.append(value.data(), value.size());
+}
+
+void RpcWriter::beginFrame(uint32_t id, uint16_t count) {
+    buffer_.clear();
+    buffer_.append(FRAME_HEADER, '\0');
+    u32(id);
+    u16(count);
+}
+
+void RpcWriter::setFrameCount(uint16_t count) {
+    buffer_[FRAME_HEADER + 4] = static_cast<char>(count);
+    buffer_[FRAME_HEADER + 5] = static_cast<char>(count >> 8);
+}
+
+void RpcWriter::finishFrame() {
+    uint32_t length = static_cast<uint32_t>(buffer_.size() - FRAME_HEADER);
+    for (size_t i = 0; i < FRAME_HEADER; ++i) {
+        buffer_[i] = static_cast<char>(length >> (8 * i));
+    }
+}
+
+// ===== RpcReader =====
+
+bool RpcReader::need(size_t count) {
+    if (!ok_ || size_ - position_ < count) {
+        ok_ = false;
+        return false;
+    }
+    return true;
+}
+
+uint8_t RpcReader::u8() {
+    if (!need(1)) return 0;
+    return static_cast<uint8_t>(data_[position_++]);
+}
+
+uint16_t RpcReader::u16() {
+    uint16_t low = u8();
+    return static_cast<uint16_t>(low | (uint16_t(u8()) << 8));
+}
+
+uint32_t RpcReader::u32() {
+    uint32_t low = u16();
+    return low | (uint32_t(u16()) << 16);
+}
+
+uint64_t RpcReader::u64() {
+    uint64_t low = u32();
+    return low | (uint64_t(u32()) << 32);
+}
+
+double RpcReader::f64() {
+    uint64_t bits = u64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string_view RpcReader::bytes() {
+    uint32_t length = u32();
+    if (!need(length)) return {};
+    std::string_view value(data_ + position_, length);
+    position_ += length;
+    return value;
+}
+
+uint32_t RpcReader::count() {
+    uint32_t value = u32();
+    if (ok_ && value > size_ - position_) {
+        ok_ = false;
+        return 0;
+    }
+    return value;
+}
+
+// ===== Значения =====
+
+RpcWriter& operator<<(RpcWriter& out, bool value) { out.u8(value ? 1 : 0); return out; }
+RpcWriter& operator<<(RpcWriter& out, int value) { out.u32(static_cast<uint32_t>(value)); return out; }
+RpcWriter& operator<<(RpcWriter& out, unsigned int value) { out.u32(value); return out; }
+RpcWriter& operator<<(RpcWriter& out, uint64_t value) { out.u64(value); return out; }
+RpcWriter& operator<<(RpcWriter& out, double value) { out.f64(value); return out; }
+RpcWriter& operator<<(RpcWriter& out, const std::string& value) { out.bytes(value); return out; }
+RpcWriter& operator<<(RpcWriter& out, RpcOp value) { out.u16(static_cast<uint16_t>(value)); return out; }
+RpcWriter& operator<<(RpcWriter& out, AggregateGroup value) { out.u8(static_cast<uint8_t>(value)); return out; }
+RpcWriter& operator<<(RpcWriter& out, AggregateMetric value) { out.u8(static_cast<uint8_t>(value)); return out; }
+
+RpcReader& operator>>(RpcReader& in, bool& value) { value = in.u8() != 0; return in; }
+RpcReader& operator>>(RpcReader& in, int& value) { value = static_cast<int>(in.u32()); return in; }
+RpcReader& operator>>(RpcReader& in, unsigned int& value) { value = in.u32(); return in; }
+RpcReader& operator>>(RpcReader& in, uint64_t& value) { value = in.u64(); return in; }
+RpcReader& operator>>(RpcReader& in, double& value) { value = in.f64(); return in; }
+RpcReader& operator>>(RpcReader& in, std::string& value) { value = std::string(in.bytes()); return in; }
+
+RpcReader& operator>>(RpcReader& in, AggregateGroup& value) {
+    uint8_t raw = in.u8();
+    if (raw > static_cast<uint8_t>(AggregateGroup::Installed)) in.fail();
+    value = static_cast<AggregateGroup>(raw);
+    return in;
+}
+
+RpcReader& operator>>(RpcReader& in, AggregateMetric& value) {
+    uint8_t raw = in.u8();
+    if (raw > static_cast<uint8_t>(AggregateMetric::AverageVram)) in.fail();
+    value = static_cast<AggregateMetric>(raw);
+    return in;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const GameFields& fields) {
+    out << fields.id << fields.user_id << fields.disk_space << fields.ram_usage << fields.vram_required
+        << fields.rating;
+    out.u8(static_cast<uint8_t>((fields.completed ? 1 : 0) | (fields.is_favorite ? 2 : 0) |
+                                (fields.is_installed ? 4 : 0)));
+    out.bytes(fields.name);
+    out.bytes(fields.genre);
+    out.bytes(fields.url);
+    out.bytes(fields.notes);
+    out.bytes(fields.tags);
+    return out;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const Game& game) {
+    return out << gameFields(game);
+}
+
+RpcReader& operator>>(RpcReader& in, Game& game) {
+    GameFields fields;
+    readGameFields(in, fields);
+    game = gameFromFields(fields);
+    return in;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const CompactGameCollection& games) {
+    out.u32(static_cast<uint32_t>(games.size()));
+    std::string tags;
+    for (size_t i = 0; i < games.size(); ++i) {
+        out << games.fields(i, tags);
+    }
+    return out;
+}
+
+RpcReader& operator>>(RpcReader& in, CompactGameCollection& games) {
+    uint32_t count = in.count();
+    games.reserve(games.size() + count);
+    GameFields fields;
+    for (uint32_t i = 0; i < count && in.ok(); ++i) {
+        readGameFields(in, fields);
+        if (in.ok()) games.append(fields);
+    }
+    return in;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const User& user) {
+    return out << user.id << user.username << user.password_hash << user.is_admin;
+}
+
+RpcReader& operator>>(RpcReader& in, User& user) {
+    return in >> user.id >> user.username >> user.password_hash >> user.is_admin;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const GameStats& stats) {
+    return out << stats.total_games << stats.favorites_count << stats.completed_count
+               << stats.no_rating_count << stats.installed_count << stats.installed_disk_space
+               << stats.no_url_count;
+}
+
+RpcReader& operator>>(RpcReader& in, GameStats& stats) {
+    return in >> stats.total_games >> stats.favorites_count >> stats.completed_count
+              >> stats.no_rating_count >> stats.installed_count >> stats.installed_disk_space
+              >> stats.no_url_count;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const GameFilter& filter) {
+    const bool flags[FILTER_FLAGS] = {
+        filter.filter_completed, filter.filter_genre, filter.filter_disk_space_min,
+        filter.filter_disk_space_max, filter.filter_ram_min, filter.filter_ram_max,
+        filter.filter_vram_min, filter.filter_vram_max, filter.filter_tag, filter.filter_favorite,
+        filter.filter_installed, filter.filter_rating_min, filter.filter_rating_max,
+        filter.filter_has_rating
+    };
+    uint16_t mask = 0;
+    for (int i = 0; i < FILTER_FLAGS; ++i) {
+        if (flags[i]) mask |= uint16_t(1) << i;
+    }
+    out.u16(mask);
+    return out << filter.completed_value << filter.genre_value << filter.disk_space_min
+               << filter.disk_space_max << filter.ram_min << filter.ram_max << filter.vram_min
+               << filter.vram_max << filter.tag_value << filter.favorite_value
+               << filter.installed_value << filter.rating_min << filter.rating_max
+               << filter.has_rating_value;
+}
+
+RpcReader& operator>>(RpcReader& in, GameFilter& filter) {
+    uint16_t mask = in.u16();
+    bool* flags[FILTER_FLAGS] = {
+        &filter.filter_completed, &filter.filter_genre, &filter.filter_disk_space_min,
+        &filter.filter_disk_space_max, &filter.filter_ram_min, &filter.filter_ram_max,
+        &filter.filter_vram_min, &filter.filter_vram_max, &filter.filter_tag, &filter.filter_favorite,
+        &filter.filter_installed, &filter.filter_rating_min, &filter.filter_rating_max,
+        &filter.filter_has_rating
+    };
+    for (int i = 0; i < FILTER_FLAGS; ++i) {
+        *flags[i] = (mask >> i) & 1;
+    }
+    return in >> filter.completed_value >> filter.genre_value >> filter.disk_space_min
+              >> filter.disk_space_max >> filter.ram_min >> filter.ram_max >> filter.vram_min
+              >> filter.vram_max >> filter.tag_value >> filter.favorite_value
+              >> filter.installed_value >> filter.rating_min >> filter.rating_max
+              >> filter.has_rating_value;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const FilterExpression& expression) {
+    return out << expression.toString();
+}
+
+RpcReader& operator>>(RpcReader& in, FilterExpression& expression) {
+    std::string text;
+    std::string error;
+    in >> text;
+    if (in.ok() && !FilterExpression::parse(text, expression, error)) {
+        in.fail();
+    }
+    return in;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const GameFilter* filter) {
+    out << (filter != nullptr);
+    if (filter) out << *filter;
+    return out;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const FilterExpression* expression) {
+    out << (expression != nullptr);
+    if (expression) out << *expression;
+    return out;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const MachineProfile& profile) {
+    return out << profile.name << profile.ram << profile.vram << profile.disk;
+}
+
+RpcReader& operator>>(RpcReader& in, MachineProfile& profile) {
+    return in >> profile.name >> profile.ram >> profile.vram >> profile.disk;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const MachineFitCount& count) {
+    return out << count.user_id << count.username << count.games;
+}
+
+RpcReader& operator>>(RpcReader& in, MachineFitCount& count) {
+    return in >> count.user_id >> count.username >> count.games;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const AggregateRow& row) {
+    return out << row.is_total << row.group << row.key << row.values;
+}
+
+RpcReader& operator>>(RpcReader& in, AggregateRow& row) {
+    return in >> row.is_total >> row.group >> row.key >> row.values;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const AggregateResult& result) {
+    return out << result.metrics << result.rows;
+}
+
+RpcReader& operator>>(RpcReader& in, AggregateResult& result) {
+    return in >> result.metrics >> result.rows;
+}
+
+RpcWriter& operator<<(RpcWriter& out, const std::map<std::string, int>& counts) {
+    out.u32(static_cast<uint32_t>(counts.size()));
+    for (const auto& entry : counts) {
+        out << entry.first << entry.second;
+    }
+    return out;
+}
+
+RpcReader& operator>>(RpcReader& in, std::map<std::string, int>& counts) {
+    uint32_t count = in.count();
+    counts.clear();
+    for (uint32_t i = 0; i < count && in.ok(); ++i) {
+        std::string key;
+        int value = 0;
+        in >> key >> value;
+        counts[key] = value;
+    }
+    return in;
+}
+
+// ===== Сокеты =====
+
+int rpcListen(const std::string& address, std::string& error) {
+    std::string kind, rest;
+    if (!splitAddress(address, kind, rest, error)) return -1;
+
+    if (kind == "unix") {
+        sockaddr_un addr;
+        if (!unixAddress(rest, addr, error)) return -1;
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            error = systemError("socket");
+            return -1;
+        }
+        // Сокет, оставшийся от прошлого запуска
+        unlink(rest.c_str());
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+            error = systemError("Cannot listen on " + address);
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    addrinfo* list = resolve(rest, true, error);
+    if (!list) return -1;
+    int fd = -1;
+    for (addrinfo* info = list; info && fd < 0; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC, info->ai_protocol);
+        if (fd < 0) continue;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (bind(fd, info->ai_addr, info->ai_addrlen) != 0 || listen(fd, SOMAXCONN) != 0) {
+            error = systemError("Cannot listen on " + address);
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(list);
+    return fd;
+}
+
+int rpcConnect(const std::string& address, std::string& error) {
+    std::string kind, rest;
+    if (!splitAddress(address, kind, rest, error)) return -1;
+
+    if (kind == "unix") {
+        sockaddr_un addr;
+        if (!unixAddress(rest, addr, error)) return -1;
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            error = systemError("socket");
+            return -1;
+        }
+        if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            error = systemError("Cannot connect to " + address);
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    addrinfo* list = resolve(rest, false, error);
+    if (!list) return -1;
+    int fd = -1;
+    for (addrinfo* info = list; info && fd < 0; info = info->ai_next) {
+        fd = socket(info->ai_family, info->ai_socktype | SOCK_CLOEXEC, info->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, info->ai_addr, info->ai_addrlen) != 0) {
+            error = systemError("Cannot connect to " + address);
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(list);
+    if (fd >= 0) {
+        // Кадры пишутся целиком одним send — задержка Нейгла не нужна
+        int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    }
+    return fd;
+}
+
+bool rpcSendFrame(int fd, const std::string& frame, std::string& error) {
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t n = send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            error = systemError("Send error");
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool rpcReadFrame(int fd, std::string& frame, std::string& error) {
+    unsigned char header[FRAME_HEADER];
+    bool closed = false;
+    if (!readExactly(fd, reinterpret_cast<char*>(header), FRAME_HEADER, closed, error)) {
+        return false;
+    }
+    uint32_t length = header[0] | (uint32_t(header[1]) << 8) | (uint32_t(header[2]) << 16) |
+                      (uint32_t(header[3]) << 24);
+    if (length > RPC_MAX_FRAME) {
+        error = "Frame too large: " + std::to_string(length);
+        return false;
+    }
+    frame.resize(length);
+    if (!readExactly(fd, &frame[0], length, closed, error)) {
+        if (closed) error = "Connection closed in the middle of a frame";
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,1035 @@
+#include "rpc_server.h"
+#include "trace.h"
+#include <openssl/rand.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <tuple>
+
+namespace Temporium {
+
+namespace {
+
+constexpr int ACCEPT_POLL_MS = 200;
+
+// Новый занятый клиент попадает под наблюдение не позже
+constexpr int HANGUP_POLL_MS = 100;
+
+// Ответ больше этой доли кэша не сохраняется
+constexpr size_t MAX_ENTRY_FRACTION = 8;
+
+std::string randomToken() {
+    unsigned char bytes[16];
+    if (RAND_bytes(bytes, sizeof(bytes)) != 1) {
+        return "";
+    }
+    static const char* const HEX = "0123456789abcdef";
+    std::string token;
+    for (unsigned char byte : bytes) {
+        token += HEX[byte >> 4];
+        token += HEX[byte & 0x0f];
+    }
+    return token;
+}
+
+} // namespace
+
+// ===== Кэш =====
+
+uint64_t RpcServer::ResultCache::generation(int scope) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return scope == GLOBAL ? global_ : users_[scope];
+}
+
+bool RpcServer::ResultCache::find(const std::string& key, std::string& body) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = entries_.find(key);
+    if (found == entries_.end()) {
+        return false;
+    }
+
+    Entry& entry = found->second;
+    uint64_t current = entry.scope == GLOBAL ? global_ : users_[entry.scope];
+    auto age = std::chrono::steady_clock::now() - entry.stored;
+    if (entry.generation != current || age > std::chrono::seconds(CACHE_TTL_SECONDS)) {
+        bytes_ -= key.size() + entry.body.size();
+        order_.erase(entry.order);
+        entries_.erase(found);
+        return false;
+    }
+
+    order_.splice(order_.begin(), order_, entry.order);
+    body = entry.body;
+    return true;
+}
+
+void RpcServer::ResultCache::store(const std::string& key, int scope, uint64_t generation,
+                                   const std::string& body) {
+    size_t size = key.size() + body.size();
+    if (size > budget_ / MAX_ENTRY_FRACTION) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Пока выполнялся запрос, данные изменились — ответ мог устареть
+    uint64_t current = scope == GLOBAL ? global_ : users_[scope];
+    if (generation != current) {
+        return;
+    }
+
+    auto found = entries_.find(key);
+    if (found != entries_.end()) {
+        bytes_ -= key.size() + found->second.body.size();
+        order_.erase(found->second.order);
+        entries_.erase(found);
+    }
+
+    while (bytes_ + size > budget_ && !order_.empty()) {
+        auto oldest = entries_.find(order_.back());
+        bytes_ -= oldest->first.size() + oldest->second.body.size();
+        entries_.erase(oldest);
+        order_.pop_back();
+    }
+
+    order_.push_front(key);
+    entries_.emplace(key, Entry{body, scope, generation, std::chrono::steady_clock::now(), order_.begin()});
+    bytes_ += size;
+}
+
+void RpcServer::ResultCache::invalidate(int user_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++global_;
+    if (user_id != GLOBAL) {
+        ++users_[user_id];
+    }
+}
+
+size_t RpcServer::ResultCache::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+// ===== Пул =====
+
+RpcServer::Lease::~Lease() {
+    release();
+}
+
+void RpcServer::Lease::release() {
+    if (connection_) {
+        {
+            // До возврата в пул: отмена не должна достаться следующему кадру
+            std::lock_guard<std::mutex> lock(server_.busyMutex_);
+            server_.busy_.erase(fd_);
+        }
+        {
+            std::lock_guard<std::mutex> lock(server_.poolMutex_);
+            server_.idle_.push_back(connection_);
+        }
+        connection_ = nullptr;
+        server_.poolReleased_.notify_one();
+    }
+}
+
+DatabaseManager& RpcServer::Lease::db() {
+    if (!connection_) {
+        TraceSpan span("RpcServer: wait for pool", "rpc");
+        std::unique_lock<std::mutex> lock(server_.poolMutex_);
+        server_.poolReleased_.wait(lock, [this]() { return !server_.idle_.empty(); });
+        connection_ = server_.idle_.back();
+        server_.idle_.pop_back();
+        lock.unlock();
+
+        // Другое соединение пула изменило данные — кэш аналитики
+        // этого соединения устарел
+        uint64_t writes = server_.writes_.load();
+        if (connection_->seen_writes != writes) {
+            connection_->db->markDataChanged();
+            connection_->seen_writes = writes;
+        }
+        connection_->db->clearCancelRequest();
+
+        // PostgreSQL перезапускали — соединение восстанавливается при выдаче
+        if (!connection_->db->isConnected()) {
+            const Options& options = server_.options_;
+            connection_->db->connect(options.host, options.port, options.dbname,
+                                     options.user, options.password);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(server_.busyMutex_);
+            server_.busy_[fd_] = BusyClient{connection_->db.get(), ++server_.busySerial_};
+        }
+        server_.busyAdded_.notify_one();
+    }
+    return *connection_->db;
+}
+
+// ===== Сервер =====
+
+RpcServer::RpcServer(const Options& options)
+    : options_(options)
+    , listenFd_(-1)
+    , stopping_(false)
+    , writes_(0)
+    , busySerial_(0)
+    , cache_(options.cache_bytes)
+    , flights_(std::chrono::milliseconds(COALESCE_TTL_MS), options.cache_bytes / MAX_ENTRY_FRACTION)
+    // Ведущий ждёт соединение пула и выполняет запрос под statement_timeout
+    , followerWait_(options.statement_timeout_ms > 0 ? options.statement_timeout_ms : DEFAULT_STATEMENT_TIMEOUT_MS)
+    , connections_(0)
+    , frames_(0)
+    , calls_(0)
+    , cacheHits_(0)
+    , cacheMisses_(0)
+{}
+
+RpcServer::~RpcServer() {
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+    }
+}
+
+bool RpcServer::start() {
+    pool_.resize(std::max<size_t>(options_.pool_size, 1));
+    for (PooledConnection& connection : pool_) {
+        connection.db = std::make_unique<DatabaseManager>();
+        connection.db->setStatementTimeout(options_.statement_timeout_ms);
+        if (!connection.db->connect(options_.host, options_.port, options_.dbname,
+                                    options_.user, options_.password)) {
+            lastError_ = connection.db->getLastError();
+            return false;
+        }
+        idle_.push_back(&connection);
+    }
+
+    listenFd_ = rpcListen(options_.address, lastError_);
+    return listenFd_ >= 0;
+}
+
+void RpcServer::run() {
+    hangupWatcher_ = std::thread(&RpcServer::watchHangups, this);
+
+    pollfd listening = {listenFd_, POLLIN, 0};
+    while (!stopping_.load()) {
+        int ready = poll(&listening, 1, ACCEPT_POLL_MS);
+        if (ready <= 0) continue;
+
+        int fd = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex_);
+            clients_.insert(fd);
+        }
+        ++connections_;
+        std::thread(&RpcServer::serve, this, fd).detach();
+    }
+
+    close(listenFd_);
+    listenFd_ = -1;
+    if (options_.address.compare(0, 5, "unix:") == 0) {
+        unlink(options_.address.c_str() + 5);
+    }
+
+    // Потоки клиентов выходят из ожидания кадра, когда сокет закрыт
+    std::unique_lock<std::mutex> lock(clientsMutex_);
+    for (int fd : clients_) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    clientsClosed_.wait(lock, [this]() { return clients_.empty(); });
+    lock.unlock();
+
+    busyAdded_.notify_all();
+    hangupWatcher_.join();
+}
+
+void RpcServer::watchHangups() {
+    std::vector<pollfd> fds;
+    std::vector<uint64_t> serials;
+    while (!stopping_.load()) {
+        {
+            std::unique_lock<std::mutex> lock(busyMutex_);
+            busyAdded_.wait_for(lock, std::chrono::milliseconds(ACCEPT_POLL_MS),
+                                [this]() { return !busy_.empty() || stopping_.load(); });
+            fds.clear();
+            serials.clear();
+            for (const auto& entry : busy_) {
+                fds.push_back({entry.first, POLLRDHUP, 0});
+                serials.push_back(entry.second.serial);
+            }
+        }
+        if (fds.empty() || poll(fds.data(), fds.size(), HANGUP_POLL_MS) <= 0) {
+            continue;
+        }
+
+        // Кадр, закончившийся за время poll, уже вернул соединение в пул,
+        // а сокет с тем же номером мог открыть другой клиент: отменяется
+        // только та же выдача
+        std::lock_guard<std::mutex> lock(busyMutex_);
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (!(fds[i].revents & (POLLRDHUP | POLLHUP | POLLERR))) continue;
+            auto found = busy_.find(fds[i].fd);
+            if (found == busy_.end() || found->second.serial != serials[i]) continue;
+            TraceSpan span("RpcServer: cancel for disconnected client", "rpc");
+            found->second.db->cancelQuery();
+            // Соединение остаётся выданным до конца кадра, повторная отмена не нужна
+            busy_.erase(found);
+        }
+    }
+}
+
+RpcServer::Stats RpcServer::stats() const {
+    Stats stats;
+    stats.connections = connections_.load();
+    stats.frames = frames_.load();
+    stats.calls = calls_.load();
+    stats.cache_hits = cacheHits_.load();
+    stats.cache_misses = cacheMisses_.load();
+    stats.cache_bytes = cache_.bytes();
+    stats.coalesced = flights_.coalesced();
+    return stats;
+}
+
+void RpcServer::serve(int fd) {
+    Session session;
+    std::string frame;
+    std::string error;
+    RpcWriter out;
+
+    while (rpcReadFrame(fd, frame, error)) {
+        ++frames_;
+        if (!handleFrame(fd, session, frame, out)) {
+            break;
+        }
+        if (!rpcSendFrame(fd, out.buffer(), error)) {
+            break;
+        }
+    }
+
+    closeSession(session);
+
+    // Номер удаляется из списка до закрытия: иначе его может получить
+    // новое соединение. Оповещение под блокировкой — run() не вернёт
+    // управление, пока этот поток обращается к серверу
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    clients_.erase(fd);
+    close(fd);
+    clientsClosed_.notify_all();
+}
+
+bool RpcServer::handleFrame(int fd, Session& session, const std::string& frame, RpcWriter& out) {
+    RpcReader in(frame);
+    uint32_t id = in.u32();
+    uint16_t count = in.u16();
+    if (!in.ok() || count == 0 || count > RPC_MAX_BATCH) {
+        return false;
+    }
+
+    out.beginFrame(id, count);
+    Lease lease(*this, fd);
+    for (uint16_t i = 0; i < count; ++i) {
+        ++calls_;
+        size_t start = in.position();
+        auto op = static_cast<RpcOp>(in.u16());
+        Call call{op, in, start, out, session, lease};
+
+        bool understood;
+        if (op == RpcOp::StreamGames) {
+            if (count != 1) {
+                out.u8(static_cast<uint8_t>(RpcStatus::BadRequest));
+                out << std::string("StreamGames must be the only call in a frame");
+                understood = false;
+            } else if (!streamGames(fd, id, call)) {
+                return false;
+            } else {
+                understood = true;
+            }
+        } else {
+            size_t replyStart = out.buffer().size();
+            understood = dispatch(call);
+            // Испорченные аргументы: ответа на сам вызов ещё нет, а число
+            // ответов в кадре должно совпасть с заголовком
+            if (!understood && out.buffer().size() == replyStart) {
+                out.u8(static_cast<uint8_t>(RpcStatus::BadRequest));
+                out << std::string("Malformed arguments for ") + rpcOpName(op);
+            }
+        }
+
+        // Границы следующих вызовов неизвестны — на них тоже отказ
+        if (!understood) {
+            for (uint16_t rest = i + 1; rest < count; ++rest) {
+                out.u8(static_cast<uint8_t>(RpcStatus::BadRequest));
+                out << std::string("Previous call in the batch was malformed");
+            }
+            break;
+        }
+    }
+    out.finishFrame();
+    return true;
+}
+
+bool RpcServer::allowUser(const Session& session, int user_id) const {
+    return session.user_id > 0 && (session.user_id == user_id || session.is_admin);
+}
+
+void RpcServer::deny(Call& call, const std::string& reason) {
+    call.out.u8(static_cast<uint8_t>(RpcStatus::Denied));
+    call.out << reason;
+}
+
+template <typename Fn>
+void RpcServer::execute(Call& call, Fn&& fn) {
+    DatabaseManager& db = call.lease.db();
+    db.clearLastError();
+    call.out.u8(static_cast<uint8_t>(RpcStatus::Ok));
+    fn(db, call.out);
+    call.out << db.getLastError();
+}
+
+template <typename Fn>
+void RpcServer::cached(Call& call, int scope, Fn&& fn) {
+    std::string key(call.in.data() + call.args_start, call.in.position() - call.args_start);
+    std::string body;
+    if (cache_.find(key, body)) {
+        ++cacheHits_;
+        call.out.u8(static_cast<uint8_t>(RpcStatus::Ok));
+        call.out.buffer() += body;
+        return;
+    }
+    ++cacheMisses_;
+
+    // Такой же запрос при той же версии данных уже выполняется — его
+    // ответ получат все, кто успел присоединиться
+    uint64_t generation = cache_.generation(scope);
+    std::string flightKey = key + '@' + std::to_string(scope) + '#' + std::to_string(generation);
+    bool leader = false;
+    auto flight = flights_.join(flightKey, leader);
+    if (!leader) {
+        // Ждущий не держит соединение пула: оно может понадобиться ведущему.
+        // Ведущий ограничен statement_timeout; не дождавшись, выполняем сами
+        call.lease.release();
+        std::string shared;
+        if (flight->result(shared, followerWait_)) {
+            call.out.u8(static_cast<uint8_t>(RpcStatus::Ok));
+            call.out.buffer() += shared;
+            return;
+        }
+        flights_.leave(flight);
+        execute(call, std::forward<Fn>(fn));
+        return;
+    }
+
+    call.out.u8(static_cast<uint8_t>(RpcStatus::Ok));
+    DatabaseManager& db = call.lease.db();
+    db.clearLastError();
+    RpcWriter result;
+    fn(db, result);
+    std::string error = db.getLastError();
+    result << error;
+
+    call.out.buffer() += result.buffer();
+    if (error.empty()) {
+        cache_.store(key, scope, generation, result.buffer());
+    }
+    flights_.finish(flightKey, flight, result.buffer(), error.empty());
+}
+
+template <typename Fn>
+void RpcServer::mutate(Call& call, int user_id, Fn&& fn) {
+    execute(call, std::forward<Fn>(fn));
+    ++writes_;
+    cache_.invalidate(user_id);
+}
+
+bool RpcServer::dispatch(Call& call) {
+    RpcReader& in = call.in;
+    Session& session = call.session;
+    const char* const NOT_LOGGED_IN = "Not logged in";
+    const char* const NOT_ALLOWED = "Operation not allowed for this session";
+    const char* const ADMIN_ONLY = "Administrator rights required";
+
+    // Аргументы читаются целиком до проверки прав: иначе не найти следующий вызов
+    switch (call.op) {
+        case RpcOp::Hello: {
+            unsigned int version = 0;
+            in >> version;
+            if (!in.ok()) return false;
+            bool accepted = version == RPC_VERSION;
+            call.out.u8(static_cast<uint8_t>(RpcStatus::Ok));
+            call.out << accepted << std::string(accepted ? "" : "Unsupported protocol version");
+            return true;
+        }
+        case RpcOp::Attach: {
+            std::string token;
+            in >> token;
+            if (!in.ok()) return false;
+            bool attached = attachSession(session, token);
+            call.out.u8(static_cast<uint8_t>(RpcStatus::Ok));
+            call.out << attached << std::string(attached ? "" : "Unknown or expired session");
+            return true;
+        }
+        case RpcOp::RegisterUser: {
+            std::string username, password_hash;
+            bool is_admin = false;
+            in >> username >> password_hash >> is_admin;
+            if (!in.ok()) return false;
+            if (is_admin && !session.is_admin) {
+                deny(call, ADMIN_ONLY);
+                return true;
+            }
+            mutate(call, ResultCache::GLOBAL, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.registerUser(username, password_hash, is_admin);
+            });
+            return true;
+        }
+        case RpcOp::AuthenticateUser: {
+            std::string username, password_hash;
+            in >> username >> password_hash;
+            if (!in.ok()) return false;
+            execute(call, [&](DatabaseManager& db, RpcWriter& out) {
+                User user = db.authenticateUser(username, password_hash);
+                std::string token = user.id > 0 ? openSession(session, user) : "";
+                out << user << token;
+            });
+            return true;
+        }
+        case RpcOp::UserExists: {
+            std::string username;
+            in >> username;
+            if (!in.ok()) return false;
+            execute(call, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.userExists(username);
+            });
+            return true;
+        }
+        case RpcOp::GetAllUsers: {
+            if (!session.is_admin) {
+                deny(call, ADMIN_ONLY);
+                return true;
+            }
+            cached(call, ResultCache::GLOBAL, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getAllUsers();
+            });
+            return true;
+        }
+        case RpcOp::DeleteUser: {
+            int user_id = 0;
+            in >> user_id;
+            if (!in.ok()) return false;
+            if (!session.is_admin) {
+                deny(call, ADMIN_ONLY);
+                return true;
+            }
+            mutate(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.deleteUser(user_id);
+            });
+            return true;
+        }
+        case RpcOp::IsAdmin: {
+            int user_id = 0;
+            in >> user_id;
+            if (!in.ok()) return false;
+            if (session.user_id <= 0) {
+                deny(call, NOT_LOGGED_IN);
+                return true;
+            }
+            execute(call, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.isAdmin(user_id);
+            });
+            return true;
+        }
+        case RpcOp::GetUserGamesCount: {
+            int user_id = 0;
+            in >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getUserGamesCount(user_id);
+            });
+            return true;
+        }
+        case RpcOp::GetUserGamesCounts: {
+            std::vector<int> user_ids;
+            in >> user_ids;
+            if (!in.ok()) return false;
+            for (int user_id : user_ids) {
+                if (!allowUser(session, user_id)) {
+                    deny(call, NOT_ALLOWED);
+                    return true;
+                }
+            }
+            // Администратору — общий ответ (устаревает при любой записи)
+            int scope = session.is_admin ? ResultCache::GLOBAL : session.user_id;
+            cached(call, scope, [&](DatabaseManager& db, RpcWriter& out) {
+                std::vector<int> counts;
+                db.getUserGamesCounts(user_ids, counts);
+                out << counts;
+            });
+            return true;
+        }
+        case RpcOp::GetMachineFitCounts: {
+            MachineProfile profile;
+            in >> profile;
+            if (!in.ok()) return false;
+            if (!session.is_admin) {
+                deny(call, ADMIN_ONLY);
+                return true;
+            }
+            cached(call, ResultCache::GLOBAL, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getMachineFitCounts(profile);
+            });
+            return true;
+        }
+        case RpcOp::LoadAllUsersGames: {
+            if (!session.is_admin) {
+                deny(call, ADMIN_ONLY);
+                return true;
+            }
+            cached(call, ResultCache::GLOBAL, [&](DatabaseManager& db, RpcWriter& out) {
+                CompactGameCollection games;
+                bool ok = db.loadAllUsersGames(games);
+                out << ok << games;
+            });
+            return true;
+        }
+        case RpcOp::RefreshNameSketch: {
+            if (!session.is_admin) {
+                deny(call, ADMIN_ONLY);
+                return true;
+            }
+            execute(call, [&](DatabaseManager& db, RpcWriter& out) {
+                GameNameSketch sketch;
+                std::string rebuilt_at;
+                bool ok = db.refreshNameSketch(sketch, &rebuilt_at);
+                out << ok << (ok ? sketch.serialize() : std::string()) << rebuilt_at;
+            });
+            return true;
+        }
+        case RpcOp::ChangeUsername: {
+            int user_id = 0;
+            std::string new_username, current_password;
+            in >> user_id >> new_username >> current_password;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            mutate(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.changeUsername(user_id, new_username, current_password);
+            });
+            return true;
+        }
+        case RpcOp::ChangePassword: {
+            int user_id = 0;
+            std::string new_password_hash;
+            in >> user_id >> new_password_hash;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            mutate(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.changePassword(user_id, new_password_hash);
+            });
+            return true;
+        }
+        case RpcOp::ResetAdminCredentials: {
+            if (!session.is_admin) {
+                deny(call, ADMIN_ONLY);
+                return true;
+            }
+            mutate(call, ResultCache::GLOBAL, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.resetAdminCredentials();
+            });
+            return true;
+        }
+        case RpcOp::AddGame: {
+            Game game;
+            in >> game;
+            if (!in.ok()) return false;
+            if (!allowUser(session, game.user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            mutate(call, game.user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                int new_id = 0;
+                bool ok = db.addGame(game, &new_id);
+                out << ok << new_id;
+            });
+            return true;
+        }
+        case RpcOp::UpdateGame: {
+            Game game;
+            in >> game;
+            if (!in.ok()) return false;
+            if (!allowUser(session, game.user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            mutate(call, game.user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.updateGame(game);
+            });
+            return true;
+        }
+        case RpcOp::DeleteGame: {
+            int game_id = 0, user_id = 0;
+            in >> game_id >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            mutate(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.deleteGame(game_id, user_id);
+            });
+            return true;
+        }
+        case RpcOp::DeleteGameByName: {
+            std::string name;
+            int user_id = 0;
+            in >> name >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            mutate(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.deleteGameByName(name, user_id);
+            });
+            return true;
+        }
+        case RpcOp::GetAllGames: {
+            int user_id = 0;
+            in >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getAllGames(user_id);
+            });
+            return true;
+        }
+        case RpcOp::GetFilteredGames: {
+            int user_id = 0;
+            GameFilter filter;
+            in >> user_id >> filter;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getFilteredGames(user_id, filter);
+            });
+            return true;
+        }
+        case RpcOp::GetFilteredGamesExpression: {
+            int user_id = 0;
+            FilterExpression expression;
+            in >> user_id >> expression;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getFilteredGames(user_id, expression);
+            });
+            return true;
+        }
+        case RpcOp::GetGameById: {
+            int game_id = 0, user_id = 0;
+            in >> game_id >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getGameById(game_id, user_id);
+            });
+            return true;
+        }
+        case RpcOp::GetGameByName: {
+            std::string name;
+            int user_id = 0;
+            in >> name >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getGameByName(name, user_id);
+            });
+            return true;
+        }
+        case RpcOp::GetUserTags: {
+            int user_id = 0;
+            in >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getUserTags(user_id);
+            });
+            return true;
+        }
+        case RpcOp::GetUserTagCounts: {
+            int user_id = 0;
+            in >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getUserTagCounts(user_id);
+            });
+            return true;
+        }
+        case RpcOp::UpdateGameNotes: {
+            int game_id = 0, user_id = 0;
+            std::string notes;
+            in >> game_id >> user_id >> notes;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            mutate(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.updateGameNotes(game_id, user_id, notes);
+            });
+            return true;
+        }
+        case RpcOp::GetGameStats: {
+            int user_id = 0;
+            in >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getGameStats(user_id);
+            });
+            return true;
+        }
+        case RpcOp::Aggregate: {
+            int user_id = 0;
+            std::vector<AggregateGroup> group_by;
+            std::vector<AggregateMetric> metrics;
+            bool has_filter = false, has_expression = false;
+            GameFilter filter;
+            FilterExpression expression;
+            in >> user_id >> group_by >> metrics >> has_filter;
+            if (has_filter) in >> filter;
+            in >> has_expression;
+            if (has_expression) in >> expression;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.aggregate(user_id, group_by, metrics, has_filter ? &filter : nullptr,
+                                    has_expression ? &expression : nullptr);
+            });
+            return true;
+        }
+        case RpcOp::CountFittingGames: {
+            int user_id = 0;
+            std::vector<MachineProfile> profiles;
+            in >> user_id >> profiles;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.countFittingGames(user_id, profiles);
+            });
+            return true;
+        }
+        case RpcOp::ImportGames: {
+            std::vector<Game> games;
+            int user_id = 0;
+            in >> games >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            mutate(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                size_t inserted = 0;
+                bool ok = db.importGames(games, user_id, &inserted);
+                out << ok << static_cast<uint64_t>(inserted);
+            });
+            return true;
+        }
+        case RpcOp::GetGameNames: {
+            int user_id = 0;
+            in >> user_id;
+            if (!in.ok()) return false;
+            if (!allowUser(session, user_id)) {
+                deny(call, NOT_ALLOWED);
+                return true;
+            }
+            cached(call, user_id, [&](DatabaseManager& db, RpcWriter& out) {
+                out << db.getGameNames(user_id);
+            });
+            return true;
+        }
+        case RpcOp::StreamGames:
+            break;
+    }
+
+    call.out.u8(static_cast<uint8_t>(RpcStatus::BadRequest));
+    call.out << std::string("Unknown operation ") + std::to_string(static_cast<int>(call.op));
+    return false;
+}
+
+bool RpcServer::streamGames(int fd, uint32_t id, Call& call) {
+    RpcReader& in = call.in;
+    int user_id = 0;
+    bool has_filter = false, has_expression = false;
+    GameFilter filter;
+    FilterExpression expression;
+    uint64_t first_chunk = 0, chunk_size = 0;
+    in >> user_id >> has_filter;
+    if (has_filter) in >> filter;
+    in >> has_expression;
+    if (has_expression) in >> expression;
+    in >> first_chunk >> chunk_size;
+    if (!in.ok()) {
+        call.out.u8(static_cast<uint8_t>(RpcStatus::BadRequest));
+        call.out << std::string("Malformed StreamGames arguments");
+        return true;
+    }
+    if (!allowUser(call.session, user_id)) {
+        deny(call, "Operation not allowed for this session");
+        return true;
+    }
+
+    // Одинаковые выборки (несколько окон одного пользователя) читаются
+    // из базы один раз: присоединившиеся получают уже готовые и новые порции
+    std::string key(in.data() + call.args_start, in.position() - call.args_start);
+    std::string flightKey = key + '#' + std::to_string(cache_.generation(user_id));
+    bool leader = false;
+    auto flight = flights_.join(flightKey, leader);
+
+    RpcWriter chunkFrame;
+    std::string error;
+    auto sendChunk = [&](const std::string& part) {
+        chunkFrame.beginFrame(id, 1);
+        chunkFrame.buffer() += part;
+        chunkFrame.finishFrame();
+        return rpcSendFrame(fd, chunkFrame.buffer(), error);
+    };
+
+    if (!leader) {
+        // Порции уже ушли клиенту — повторить выборку самим нельзя;
+        // застрявший ведущий завершает загрузку ошибкой
+        std::string part;
+        std::string shared;
+        SingleFlight::Flight::Wait wait;
+        size_t index = 0;
+        while ((wait = flight->part(index, part, followerWait_)) == SingleFlight::Flight::Wait::Ready) {
+            if (!sendChunk(part)) {
+                flights_.leave(flight);
+                return false;
+            }
+            ++index;
+        }
+        if (wait == SingleFlight::Flight::Wait::TimedOut || !flight->result(shared, followerWait_)) {
+            flights_.leave(flight);
+            RpcWriter stalled;
+            stalled << false << std::string("Stream games error: shared query did not progress");
+            shared = stalled.buffer();
+        }
+        call.out.u8(static_cast<uint8_t>(RpcStatus::Ok));
+        call.out.buffer() += shared;
+        return true;
+    }
+
+    // Порции уходят клиенту сразу, каждая своим кадром. Если клиент
+    // отключился (или отменил загрузку), выборка прекращается, только
+    // если её не ждут присоединившиеся
+    bool delivered = true;
+    DatabaseManager& db = call.lease.db();
+    db.clearLastError();
+    bool ok = db.streamGames(user_id, has_filter ? &filter : nullptr, has_expression ? &expression : nullptr,
+                             std::min(first_chunk, MAX_STREAM_CHUNK), std::min(chunk_size, MAX_STREAM_CHUNK),
+                             [&](CompactGameCollection&& chunk) {
+        RpcWriter part;
+        part.u8(static_cast<uint8_t>(RpcStatus::More));
+        part << chunk;
+        if (delivered) {
+            delivered = sendChunk(part.buffer());
+        }
+        if (!delivered && flights_.abandon(flightKey, flight)) {
+            return false;
+        }
+        flights_.append(flightKey, flight, std::move(part.buffer()));
+        return true;
+    });
+
+    RpcWriter result;
+    result << ok << db.getLastError();
+    flights_.finish(flightKey, flight, result.buffer(), ok && db.getLastError().empty());
+    if (!delivered) {
+        return false;
+    }
+
+    call.out.u8(static_cast<uint8_t>(RpcStatus::Ok));
+    call.out.buffer() += result.buffer();
+    return true;
+}
+
+// ===== Сеансы =====
+
+std::string RpcServer::openSession(Session& session, const User& user) {
+    closeSession(session);
+    session.user_id = user.id;
+    session.is_admin = user.is_admin;
+    session.token = randomToken();
+
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    sessions_[session.token] = session;
+    return session.token;
+}
+
+void RpcServer::closeSession(Session& session) {
+    if (!session.token.empty()) {
+        std::lock_guard<std::mutex> lock(sessionsMutex_);
+        sessions_.erase(session.token);
+    }
+    session = Session();
+}
+
+bool RpcServer::attachSession(Session& session, const std::string& token) {
+    closeSession(session);
+    std::lock_guard<std::mutex> lock(sessionsMutex_);
+    auto found = sessions_.find(token);
+    if (token.empty() || found == sessions_.end()) {
+        return false;
+    }
+    // Присоединённое соединение не владеет ключом: сеанс закрывает
+    // соединение, которое выполнило вход
+    session.user_id = found->second.user_id;
+    session.is_admin = found->second.is_admin;
+    return true;
+}
+
+}
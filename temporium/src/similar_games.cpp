@@ -0,0 +1,142 @@
+#include "similar_games.h"
+#include "hash_utils.h"
+#include "task_scheduler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string_view>
+
+namespace Temporium {
+
+namespace {
+
+uint64_t hashText(std::string_view text, uint64_t seed) {
+    return HashUtils::mix(HashUtils::fnv1a(text, seed));
+}
+
+// Разные пространства признаков: тег "RPG" и жанр "RPG" — разные признаки
+constexpr uint64_t TAG_SEED = 0x7461670000000000ull;
+constexpr uint64_t GENRE_SEED = 0x67656e7265000000ull;
+
+} // namespace
+
+void SimilarGamesIndex::clear() {
+    rows_.clear();
+    buckets_.clear();
+    ids_.clear();
+}
+
+void SimilarGamesIndex::build(const CompactGameCollection& games) {
+    clear();
+    rows_.resize(games.size());
+    buckets_.resize(BANDS);
+    ids_.reserve(games.size());
+
+    // Признаки и подписи строк независимы — считаются параллельно,
+    // корзины заполняются затем по порядку строк
+    parallelFor(0, games.size(), ROWS_PER_TASK, [this, &games](size_t lo, size_t hi) {
+        for (size_t i = lo; i < hi; ++i) {
+            buildRow(games, i, rows_[i]);
+        }
+    });
+
+    for (uint32_t index = 0; index < rows_.size(); ++index) {
+        const Row& row = rows_[index];
+        for (int band = 0; band < BANDS; ++band) {
+            buckets_[band][row.bands[band]].push_back(index);
+        }
+        ids_.emplace(row.id, index);
+    }
+}
+
+void SimilarGamesIndex::buildRow(const CompactGameCollection& games, size_t i, Row& row) {
+    const CompactGame& game = games.at(i);
+    row.id = game.id;
+    row.ram = game.ram_usage;
+    row.vram = game.vram_required;
+    row.disk = game.disk_space;
+
+    row.features.reserve(game.tags_count + 1u);
+    for (uint16_t t = 0; t < game.tags_count; ++t) {
+        row.features.push_back(hashText(games.tag(i, t), TAG_SEED));
+    }
+    row.features.push_back(hashText(games.genre(i), GENRE_SEED));
+    std::sort(row.features.begin(), row.features.end());
+    row.features.erase(std::unique(row.features.begin(), row.features.end()), row.features.end());
+
+    std::array<uint64_t, HASHES> signature;
+    signature.fill(std::numeric_limits<uint64_t>::max());
+    for (uint64_t feature : row.features) {
+        for (int k = 0; k < HASHES; ++k) {
+            uint64_t value = HashUtils::mix(feature ^ (0x5851f42d4c957f2dull * static_cast<uint64_t>(k + 1)));
+            signature[k] = std::min(signature[k], value);
+        }
+    }
+
+    for (int band = 0; band < BANDS; ++band) {
+        uint64_t hash = HashUtils::mix(static_cast<uint64_t>(band));
+        for (int r = 0; r < ROWS; ++r) {
+            hash = HashUtils::mix(hash ^ signature[band * ROWS + r]);
+        }
+        row.bands[band] = hash;
+    }
+}
+
+int SimilarGamesIndex::rowOf(int game_id) const {
+    auto it = ids_.find(game_id);
+    return it == ids_.end() ? -1 : static_cast<int>(it->second);
+}
+
+double SimilarGamesIndex::hardwareSimilarity(const Row& a, const Row& b) {
+    // Требования сравниваются в логарифмической шкале: 8 и 16 ГБ различаются
+    // так же, как 16 и 32; разница в 2^8 раз и больше — полное несходство
+    auto distance = [](double x, double y) {
+        double d = std::fabs(std::log2(1.0 + x) - std::log2(1.0 + y)) / 8.0;
+        return std::min(d, 1.0);
+    };
+    return 1.0 - (distance(a.ram, b.ram) + distance(a.vram, b.vram) + distance(a.disk, b.disk)) / 3.0;
+}
+
+std::vector<SimilarGame> SimilarGamesIndex::similar(uint32_t row, size_t k) const {
+    std::vector<SimilarGame> result;
+    if (row >= rows_.size() || k == 0) {
+        return result;
+    }
+
+    // Кандидаты — соседи по корзинам всех полос
+    const Row& target = rows_[row];
+    std::vector<uint32_t> candidates;
+    for (int band = 0; band < BANDS && candidates.size() < MAX_CANDIDATES; ++band) {
+        const auto& bucket = buckets_[band].at(target.bands[band]);
+        for (uint32_t other : bucket) {
+            if (other != row) candidates.push_back(other);
+            if (candidates.size() >= MAX_CANDIDATES) break;
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    result.reserve(candidates.size());
+    for (uint32_t other : candidates) {
+        SimilarGame similarGame;
+        similarGame.row = other;
+        similarGame.tags_similarity = HashUtils::jaccard(target.features, rows_[other].features);
+        similarGame.score = TAGS_WEIGHT * similarGame.tags_similarity +
+                            (1.0 - TAGS_WEIGHT) * hardwareSimilarity(target, rows_[other]);
+        result.push_back(similarGame);
+    }
+
+    auto better = [](const SimilarGame& a, const SimilarGame& b) {
+        if (a.score != b.score) return a.score > b.score;
+        return a.row < b.row;
+    };
+    if (result.size() > k) {
+        std::partial_sort(result.begin(), result.begin() + static_cast<std::ptrdiff_t>(k), result.end(), better);
+        result.resize(k);
+    } else {
+        std::sort(result.begin(), result.end(), better);
+    }
+    return result;
+}
+
+}
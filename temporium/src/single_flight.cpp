@@ -0,0 +1,134 @@
+#include "single_flight.h"
+
+namespace Temporium {
+
+SingleFlight::Flight::Wait SingleFlight::Flight::part(size_t index, std::string& out,
+                                                      std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!changed_.wait_for(lock, timeout, [&]() { return index < parts_.size() || finished_; })) {
+        return Wait::TimedOut;
+    }
+    if (index >= parts_.size()) {
+        return Wait::Finished;
+    }
+    out = parts_[index];
+    return Wait::Ready;
+}
+
+bool SingleFlight::Flight::result(std::string& out, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!changed_.wait_for(lock, timeout, [&]() { return finished_; })) {
+        return false;
+    }
+    out = result_;
+    return true;
+}
+
+SingleFlight::SingleFlight(std::chrono::milliseconds ttl, size_t maxRetainedBytes)
+    : ttl_(ttl)
+    , maxRetainedBytes_(maxRetainedBytes)
+    , coalesced_(0)
+{}
+
+std::shared_ptr<SingleFlight::Flight> SingleFlight::join(const std::string& key, bool& leader) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = flights_.find(key);
+    if (found != flights_.end()) {
+        std::shared_ptr<Flight> flight = found->second;
+        std::lock_guard<std::mutex> flightLock(flight->mutex_);
+        bool expired = flight->finished_ &&
+                       std::chrono::steady_clock::now() - flight->finishedAt_ > ttl_;
+        if (!expired) {
+            ++flight->followers_;
+            ++coalesced_;
+            leader = false;
+            return flight;
+        }
+    }
+
+    auto flight = std::make_shared<Flight>();
+    flights_[key] = flight;
+    leader = true;
+    return flight;
+}
+
+void SingleFlight::append(const std::string& key, const std::shared_ptr<Flight>& flight, std::string part) {
+    bool overflow = false;
+    {
+        std::lock_guard<std::mutex> flightLock(flight->mutex_);
+        if (!flight->retaining_) {
+            return;
+        }
+        flight->bytes_ += part.size();
+        flight->parts_.push_back(std::move(part));
+        overflow = flight->bytes_ > maxRetainedBytes_;
+    }
+    flight->changed_.notify_all();
+
+    if (overflow) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        detach(key, flight);
+        // Новых присоединившихся не будет; если их не было и раньше,
+        // части хранить незачем
+        std::lock_guard<std::mutex> flightLock(flight->mutex_);
+        if (flight->followers_.load() == 0) {
+            flight->retaining_ = false;
+            flight->parts_.clear();
+            flight->parts_.shrink_to_fit();
+        }
+    }
+}
+
+void SingleFlight::finish(const std::string& key, const std::shared_ptr<Flight>& flight, std::string result,
+                          bool reusable) {
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> flightLock(flight->mutex_);
+        flight->bytes_ += result.size();
+        flight->result_ = std::move(result);
+        flight->finished_ = true;
+        flight->finishedAt_ = now;
+        reusable = reusable && flight->retaining_ && flight->bytes_ <= maxRetainedBytes_;
+    }
+    flight->changed_.notify_all();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!reusable) {
+        detach(key, flight);
+    }
+    // Устаревшие завершённые запросы убираются здесь: в карте остаются
+    // только выполняющиеся и завершённые за последние ttl
+    for (auto it = flights_.begin(); it != flights_.end();) {
+        Flight& other = *it->second;
+        std::lock_guard<std::mutex> otherLock(other.mutex_);
+        if (other.finished_ && now - other.finishedAt_ > ttl_) {
+            it = flights_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool SingleFlight::abandon(const std::string& key, const std::shared_ptr<Flight>& flight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (flight->followers_.load() > 0) {
+        return false;
+    }
+    // Под mutex_: после удаления из карты присоединиться уже нельзя
+    detach(key, flight);
+    return true;
+}
+
+void SingleFlight::leave(const std::shared_ptr<Flight>& flight) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --flight->followers_;
+}
+
+void SingleFlight::detach(const std::string& key, const std::shared_ptr<Flight>& flight) {
+    auto found = flights_.find(key);
+    if (found != flights_.end() && found->second == flight) {
+        flights_.erase(found);
+    }
+}
+
+}
@@ -0,0 +1,274 @@
+#include "sketches.h"
+#include "hash_utils.h"
+#include "name_dedup.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace Temporium {
+
+namespace {
+
+constexpr uint32_t SKETCH_MAGIC = 0x314B5354;  // "TSK1"
+
+template <typename T>
+void put(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool get(const std::string& in, size_t& offset, T& value) {
+    if (offset > in.size() || in.size() - offset < sizeof(value)) return false;
+    std::memcpy(&value, in.data() + offset, sizeof(value));
+    offset += sizeof(value);
+    return true;
+}
+
+void putString(std::string& out, const std::string& text) {
+    put(out, static_cast<uint32_t>(text.size()));
+    out += text;
+}
+
+bool getString(const std::string& in, size_t& offset, std::string& text) {
+    uint32_t size = 0;
+    if (!get(in, offset, size) || in.size() - offset < size) return false;
+    text.assign(in, offset, size);
+    offset += size;
+    return true;
+}
+
+} // namespace
+
+CountMinSketch::CountMinSketch(uint32_t width, uint32_t depth)
+    : width_(width)
+    , depth_(depth)
+    , total_(0)
+    , counters_(size_t(width) * depth, 0)
+{}
+
+void CountMinSketch::add(uint64_t hash, int64_t delta) {
+    total_ += delta;
+    for (uint32_t row = 0; row < depth_; ++row) {
+        uint64_t column = HashUtils::mix(hash + row * 0x9e3779b97f4a7c15ull) % width_;
+        counters_[size_t(row) * width_ + column] += static_cast<int32_t>(delta);
+    }
+}
+
+int64_t CountMinSketch::estimate(uint64_t hash) const {
+    int64_t result = INT64_MAX;
+    for (uint32_t row = 0; row < depth_; ++row) {
+        uint64_t column = HashUtils::mix(hash + row * 0x9e3779b97f4a7c15ull) % width_;
+        result = std::min<int64_t>(result, counters_[size_t(row) * width_ + column]);
+    }
+    return std::max<int64_t>(result, 0);
+}
+
+double CountMinSketch::epsilon() const {
+    return std::exp(1.0) / width_;
+}
+
+double CountMinSketch::delta() const {
+    return std::exp(-static_cast<double>(depth_));
+}
+
+void CountMinSketch::clear() {
+    std::fill(counters_.begin(), counters_.end(), 0);
+    total_ = 0;
+}
+
+void CountMinSketch::serialize(std::string& out) const {
+    put(out, width_);
+    put(out, depth_);
+    put(out, total_);
+    out.append(reinterpret_cast<const char*>(counters_.data()), counters_.size() * sizeof(int32_t));
+}
+
+bool CountMinSketch::deserialize(const std::string& in, size_t& offset) {
+    uint32_t width = 0;
+    uint32_t depth = 0;
+    int64_t total = 0;
+    if (!get(in, offset, width) || !get(in, offset, depth) || !get(in, offset, total)) return false;
+    if (width == 0 || depth == 0) return false;
+
+    size_t bytes = size_t(width) * depth * sizeof(int32_t);
+    if (in.size() - offset < bytes) return false;
+    width_ = width;
+    depth_ = depth;
+    total_ = total;
+    counters_.resize(size_t(width) * depth);
+    std::memcpy(counters_.data(), in.data() + offset, bytes);
+    offset += bytes;
+    return true;
+}
+
+HyperLogLog::HyperLogLog(uint8_t precision)
+    : precision_(precision)
+    , registers_(size_t(1) << precision, 0)
+{}
+
+void HyperLogLog::add(uint64_t hash) {
+    hash = HashUtils::mix(hash);
+    size_t index = hash >> (64 - precision_);
+    uint64_t rest = hash << precision_;
+    // Позиция первой единицы в оставшихся битах (64 - precision, если их нет)
+    uint8_t rank = 1;
+    while (rank <= 64 - precision_ && !(rest & (1ull << 63))) {
+        rest <<= 1;
+        ++rank;
+    }
+    registers_[index] = std::max(registers_[index], rank);
+}
+
+double HyperLogLog::estimate() const {
+    double m = static_cast<double>(registers_.size());
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t value : registers_) {
+        sum += std::ldexp(1.0, -value);
+        if (value == 0) ++zeros;
+    }
+
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double raw = alpha * m * m / sum;
+    // Малые значения точнее оцениваются по числу пустых регистров
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / static_cast<double>(zeros));
+    }
+    return raw;
+}
+
+double HyperLogLog::standardError() const {
+    return 1.04 / std::sqrt(static_cast<double>(registers_.size()));
+}
+
+void HyperLogLog::clear() {
+    std::fill(registers_.begin(), registers_.end(), 0);
+}
+
+void HyperLogLog::serialize(std::string& out) const {
+    put(out, precision_);
+    out.append(reinterpret_cast<const char*>(registers_.data()), registers_.size());
+}
+
+bool HyperLogLog::deserialize(const std::string& in, size_t& offset) {
+    uint8_t precision = 0;
+    if (!get(in, offset, precision) || precision < 4 || precision > 18) return false;
+
+    size_t count = size_t(1) << precision;
+    if (in.size() - offset < count) return false;
+    precision_ = precision;
+    registers_.assign(in.begin() + static_cast<std::ptrdiff_t>(offset),
+                      in.begin() + static_cast<std::ptrdiff_t>(offset + count));
+    offset += count;
+    return true;
+}
+
+uint64_t GameNameSketch::hashName(const std::string& normalized) {
+    return HashUtils::fnv1a(normalized);
+}
+
+void GameNameSketch::add(const std::string& name, int64_t delta) {
+    std::string normalized = NearDuplicateDetector::normalize(name);
+    if (normalized.empty()) return;
+
+    uint64_t hash = hashName(normalized);
+    counts_.add(hash, delta);
+    if (delta <= 0) return;
+    distinct_.add(hash);
+
+    // Кандидаты в частые: новое название вытесняет самое редкое из них,
+    // если встречается чаще него
+    if (candidates_.count(normalized)) return;
+    if (candidates_.size() < CANDIDATES) {
+        candidates_.emplace(normalized, name);
+        return;
+    }
+    // Порог — оценка самого редкого кандидата на момент последнего
+    // пересчёта; кандидатов перебираем, только если он превышен
+    if (counts_.estimate(hash) <= rarestEstimate_) return;
+
+    auto rarest = candidates_.end();
+    int64_t rarestCount = INT64_MAX;
+    for (auto it = candidates_.begin(); it != candidates_.end(); ++it) {
+        int64_t count = counts_.estimate(hashName(it->first));
+        if (count < rarestCount) {
+            rarestCount = count;
+            rarest = it;
+        }
+    }
+    if (counts_.estimate(hash) > rarestCount) {
+        candidates_.erase(rarest);
+        candidates_.emplace(normalized, name);
+        rarestCount = INT64_MAX;
+        for (const auto& candidate : candidates_) {
+            rarestCount = std::min(rarestCount, counts_.estimate(hashName(candidate.first)));
+        }
+    }
+    rarestEstimate_ = rarestCount;
+}
+
+void GameNameSketch::clear() {
+    counts_.clear();
+    distinct_.clear();
+    candidates_.clear();
+    rarestEstimate_ = 0;
+}
+
+std::vector<GameNameSketch::Frequent> GameNameSketch::mostCommon(size_t k) const {
+    std::vector<Frequent> result;
+    for (const auto& candidate : candidates_) {
+        int64_t estimate = counts_.estimate(hashName(candidate.first));
+        if (estimate > 0) {
+            result.push_back({candidate.second, estimate});
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const Frequent& a, const Frequent& b) {
+        if (a.estimate != b.estimate) return a.estimate > b.estimate;
+        return a.name < b.name;
+    });
+    if (result.size() > k) {
+        result.resize(k);
+    }
+    return result;
+}
+
+std::string GameNameSketch::serialize() const {
+    std::string out;
+    put(out, SKETCH_MAGIC);
+    counts_.serialize(out);
+    distinct_.serialize(out);
+    put(out, static_cast<uint32_t>(candidates_.size()));
+    for (const auto& candidate : candidates_) {
+        putString(out, candidate.first);
+        putString(out, candidate.second);
+    }
+    return out;
+}
+
+bool GameNameSketch::deserialize(const std::string& data) {
+    size_t offset = 0;
+    uint32_t magic = 0;
+    uint32_t count = 0;
+    if (!get(data, offset, magic) || magic != SKETCH_MAGIC ||
+        !counts_.deserialize(data, offset) || !distinct_.deserialize(data, offset) ||
+        !get(data, offset, count)) {
+        clear();
+        return false;
+    }
+
+    candidates_.clear();
+    rarestEstimate_ = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string normalized;
+        std::string name;
+        if (!getString(data, offset, normalized) || !getString(data, offset, name)) {
+            clear();
+            return false;
+        }
+        candidates_.emplace(std::move(normalized), std::move(name));
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,240 @@
+#include "stall_watchdog.h"
+#include "trace.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#if defined(__GLIBC__)
+#include <cerrno>
+#include <csignal>
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <pthread.h>
+#define TEMPORIUM_STALL_BACKTRACE 1
+#endif
+
+namespace Temporium {
+
+namespace {
+
+#ifdef TEMPORIUM_STALL_BACKTRACE
+// Стек потока GUI снимает он сам в обработчике сигнала, который ему
+// посылает сторож. Обработчик ставится с SA_RESTART; poll() внутри libpq
+// при прерывании возвращает EINTR, и libpq повторяет ожидание сам
+constexpr int BACKTRACE_SIGNAL = SIGUSR2;
+constexpr int MAX_FRAMES = 64;
+
+void* stallFrames[MAX_FRAMES];
+std::atomic<int> stallFrameCount{-1};
+pthread_t guiThread;
+
+void captureBacktrace(int) {
+    int savedErrno = errno;
+    stallFrameCount.store(backtrace(stallFrames, MAX_FRAMES), std::memory_order_release);
+    errno = savedErrno;
+}
+
+// "binary(_ZN9Temporium...+0x1f) [0x...]" -> "Temporium::... (binary+0x1f)"
+std::string symbolize(const char* line) {
+    std::string text(line);
+    size_t open = text.find('(');
+    size_t plus = text.find('+', open);
+    size_t close = text.find(')', open);
+    if (open == std::string::npos || plus == std::string::npos || close == std::string::npos ||
+        plus == open + 1) {
+        return text;
+    }
+
+    std::string mangled = text.substr(open + 1, plus - open - 1);
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status);
+    std::string name = status == 0 && demangled ? demangled : mangled;
+    std::free(demangled);
+    return name + "  (" + text.substr(0, open) + text.substr(plus, close - plus) + ")";
+}
+#endif
+
+std::string timestamp() {
+    return QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss").toStdString();
+}
+
+} // namespace
+
+StallWatchdog::StallWatchdog(const std::string& logPath, int thresholdMs, QObject* parent)
+    : QObject(parent)
+    , logPath_(logPath)
+    , thresholdMs_(std::max(thresholdMs, HEARTBEAT_MS))
+    , lastBeat_(Tracer::now())
+    , stopping_(false)
+    , stalled_(false)
+    , stallBeat_(0)
+{
+    Tracer::instance().watchCurrentThread();
+
+#ifdef TEMPORIUM_STALL_BACKTRACE
+    guiThread = pthread_self();
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = captureBacktrace;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(BACKTRACE_SIGNAL, &action, nullptr);
+
+    // Первый вызов backtrace() подгружает libgcc — не в обработчике сигнала
+    void* frame;
+    backtrace(&frame, 1);
+#endif
+
+    QDir().mkpath(QFileInfo(QString::fromStdString(logPath_)).absolutePath());
+
+    heartbeat_.setInterval(HEARTBEAT_MS);
+    connect(&heartbeat_, &QTimer::timeout, [this]() {
+        lastBeat_.store(Tracer::now(), std::memory_order_relaxed);
+    });
+    heartbeat_.start();
+
+    thread_ = std::thread(&StallWatchdog::watch, this);
+}
+
+StallWatchdog::~StallWatchdog() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+    thread_.join();
+}
+
+void StallWatchdog::watch() {
+    const uint64_t threshold = static_cast<uint64_t>(thresholdMs_) * 1000;
+    const auto period = std::chrono::milliseconds(HEARTBEAT_MS / 2);
+    uint64_t lastCheck = Tracer::now();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!wakeUp_.wait_for(lock, period, [this]() { return stopping_; })) {
+        uint64_t now = Tracer::now();
+        uint64_t beat = lastBeat_.load(std::memory_order_relaxed);
+
+        // Сторож сам проспал порог (сон ноутбука, перегрузка системы) —
+        // это не зависание интерфейса
+        bool overslept = now - lastCheck > threshold;
+        lastCheck = now;
+
+        if (stalled_) {
+            if (beat != stallBeat_) {
+                lock.unlock();
+                stallFinished(beat);
+                lock.lock();
+            }
+        } else if (!overslept && now > beat && now - beat > threshold) {
+            lock.unlock();
+            stallStarted(beat, now);
+            lock.lock();
+        }
+    }
+}
+
+void StallWatchdog::stallStarted(uint64_t beat, uint64_t now) {
+    stalled_ = true;
+    stallBeat_ = beat;
+    stallCall_.clear();
+
+    std::vector<Tracer::Activity> activity = Tracer::instance().activity();
+    std::ostringstream out;
+    out << "=== " << timestamp() << " — интерфейс не отвечает " << (now - beat) / 1000 << " мс\n";
+    if (activity.empty()) {
+        out << "Открытых интервалов нет (блокировка вне размеченных слотов)\n";
+    } else {
+        out << "Выполняются:\n";
+    }
+    const char* slot = nullptr;
+    const char* dbCall = nullptr;
+    for (const auto& entry : activity) {
+        out << "  [" << entry.category << "] " << entry.name
+            << " — " << (now - std::min(now, entry.start_us)) / 1000 << " мс\n";
+        if (std::strcmp(entry.category, "ui") == 0 && !slot) slot = entry.name;
+        if (std::strcmp(entry.category, "db") == 0 && !dbCall) dbCall = entry.name;
+    }
+    stallCall_ = dbCall ? dbCall : slot ? slot : "вне размеченных слотов";
+
+    std::vector<std::string> frames = guiBacktrace();
+    if (!frames.empty()) {
+        out << "Стек потока GUI:\n";
+        for (size_t i = 0; i < frames.size(); ++i) {
+            out << "  #" << i << " " << frames[i] << "\n";
+        }
+    }
+    appendLog(out.str());
+}
+
+void StallWatchdog::stallFinished(uint64_t beat) {
+    stalled_ = false;
+    uint64_t duration_ms = (beat - stallBeat_) / 1000;
+
+    appendLog("    длительность зависания: " + std::to_string(duration_ms) + " мс\n");
+
+    std::lock_guard<std::mutex> lock(summaryMutex_);
+    Summary& entry = summary_[stallCall_];
+    entry.call = stallCall_;
+    ++entry.count;
+    entry.total_ms += duration_ms;
+    entry.max_ms = std::max(entry.max_ms, duration_ms);
+}
+
+std::vector<std::string> StallWatchdog::guiBacktrace() {
+    std::vector<std::string> frames;
+#ifdef TEMPORIUM_STALL_BACKTRACE
+    stallFrameCount.store(-1, std::memory_order_relaxed);
+    if (pthread_kill(guiThread, BACKTRACE_SIGNAL) != 0) {
+        return frames;
+    }
+
+    // Поток GUI может быть в непрерываемом ожидании — ждём недолго
+    int count = -1;
+    for (int i = 0; i < 200 && count < 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        count = stallFrameCount.load(std::memory_order_acquire);
+    }
+    if (count <= 0) {
+        frames.push_back("(стек снять не удалось)");
+        return frames;
+    }
+
+    char** symbols = backtrace_symbols(stallFrames, count);
+    if (!symbols) return frames;
+    // Первые два кадра — обработчик сигнала и трамплин ядра
+    for (int i = std::min(2, count); i < count; ++i) {
+        frames.push_back(symbolize(symbols[i]));
+    }
+    std::free(symbols);
+#endif
+    return frames;
+}
+
+void StallWatchdog::appendLog(const std::string& text) {
+    std::ofstream log(logPath_, std::ios::app);
+    log << text;
+    log.flush();
+}
+
+std::vector<StallWatchdog::Summary> StallWatchdog::summary() const {
+    std::vector<Summary> result;
+    {
+        std::lock_guard<std::mutex> lock(summaryMutex_);
+        for (const auto& entry : summary_) {
+            result.push_back(entry.second);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const Summary& a, const Summary& b) {
+        return a.total_ms > b.total_ms;
+    });
+    return result;
+}
+
+}
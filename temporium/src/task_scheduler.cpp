@@ -0,0 +1,187 @@
+#include "task_scheduler.h"
+#include <chrono>
+
+namespace Temporium {
+
+namespace {
+
+// Номер рабочего потока пула в текущем потоке (-1 — поток не из пула)
+thread_local long currentWorker = -1;
+
+} // namespace
+
+TaskGroup::TaskGroup(TaskPriority priority)
+    : scheduler_(TaskScheduler::instance())
+    , priority_(priority)
+    , pending_(0)
+{}
+
+TaskGroup::~TaskGroup() {
+    // Задачи ссылаются на группу — она не может исчезнуть раньше них
+    if (pending_.load() != 0) {
+        try {
+            wait();
+        } catch (...) {
+        }
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    pending_.fetch_add(1);
+    scheduler_.push({std::move(task), this}, priority_);
+}
+
+void TaskGroup::finished(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error && !error_) {
+        error_ = error;
+    }
+    if (pending_.fetch_sub(1) == 1) {
+        done_.notify_all();
+    }
+}
+
+void TaskGroup::wait() {
+    while (pending_.load() != 0) {
+        if (scheduler_.runOne(priority_)) continue;
+
+        // Все задачи группы уже выполняются другими потоками
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait_for(lock, std::chrono::milliseconds(1), [this]() { return pending_.load() == 0; });
+    }
+    // Последняя задача уведомляет под блокировкой: после её захвата
+    // группу можно уничтожать
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+TaskScheduler& TaskScheduler::instance() {
+    // Вызывающий поток сам выполняет задачи, пока ждёт группу,
+    // поэтому рабочих потоков на один меньше числа ядер
+    static TaskScheduler scheduler(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler(size_t threads)
+    : nextQueue_(0)
+    , queued_(0)
+    , stopping_(false)
+{
+    threads = std::max<size_t>(threads, 1);
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers_[i]->thread = std::thread(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void TaskScheduler::submit(std::function<void()> task, TaskPriority priority) {
+    push({std::move(task), nullptr}, priority);
+}
+
+void TaskScheduler::push(Task task, TaskPriority priority) {
+    // Задачи из рабочего потока — в его очередь, остальные — по кругу
+    size_t index = currentWorker >= 0 ? static_cast<size_t>(currentWorker)
+                                      : nextQueue_.fetch_add(1) % workers_.size();
+    {
+        Worker& worker = *workers_[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[static_cast<int>(priority)].push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        queued_.fetch_add(1);
+    }
+    wakeUp_.notify_one();
+}
+
+bool TaskScheduler::take(Task& task, TaskPriority lowest) {
+    const size_t count = workers_.size();
+    const size_t self = currentWorker >= 0 ? static_cast<size_t>(currentWorker) : nextQueue_.load() % count;
+
+    for (int priority = 0; priority <= static_cast<int>(lowest); ++priority) {
+        if (currentWorker >= 0) {
+            Worker& worker = *workers_[self];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            std::deque<Task>& queue = worker.queues[priority];
+            if (!queue.empty()) {
+                task = std::move(queue.back());
+                queue.pop_back();
+                queued_.fetch_sub(1);
+                return true;
+            }
+        }
+        for (size_t offset = 0; offset < count; ++offset) {
+            size_t victim = (self + offset) % count;
+            if (currentWorker >= 0 && victim == self) continue;
+            Worker& worker = *workers_[victim];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            std::deque<Task>& queue = worker.queues[priority];
+            if (!queue.empty()) {
+                task = std::move(queue.front());
+                queue.pop_front();
+                queued_.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::execute(Task& task) {
+    std::exception_ptr error;
+    try {
+        task.function();
+    } catch (...) {
+        // Исключение задачи без группы передать некому
+        error = std::current_exception();
+    }
+    task.function = nullptr;
+    if (task.group) {
+        task.group->finished(error);
+    }
+}
+
+bool TaskScheduler::runOne(TaskPriority lowest) {
+    if (queued_.load() == 0) return false;
+    Task task;
+    if (!take(task, lowest)) return false;
+    execute(task);
+    return true;
+}
+
+void TaskScheduler::workerLoop(size_t index) {
+    currentWorker = static_cast<long>(index);
+    while (true) {
+        Task task;
+        if (take(task, TaskPriority::Background)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wakeUp_.wait(lock, [this]() { return stopping_ || queued_.load() != 0; });
+        if (stopping_) return;
+    }
+}
+
+}
@@ -0,0 +1,201 @@
+#include "trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace Temporium {
+
+namespace {
+
+const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+thread_local bool watchedThread = false;
+
+// Короткий номер потока для поля tid
+uint32_t threadNumber() {
+    static std::atomic<uint32_t> next{1};
+    thread_local uint32_t number = next.fetch_add(1);
+    return number;
+}
+
+void appendEscaped(std::string& out, const char* text) {
+    for (const char* p = text; *p; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+}
+
+} // namespace
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+    : mode_(0)
+    , head_(0)
+    , cleared_(0)
+    , slots_(new Slot[CAPACITY])
+    , depth_(0)
+{}
+
+void Tracer::setEnabled(bool enabled) {
+    if (enabled) {
+        mode_.fetch_or(RECORD, std::memory_order_relaxed);
+    } else {
+        mode_.fetch_and(~uint32_t(RECORD), std::memory_order_relaxed);
+    }
+}
+
+void Tracer::watchCurrentThread() {
+    watchedThread = true;
+    mode_.fetch_or(WATCH, std::memory_order_relaxed);
+}
+
+bool Tracer::onWatchedThread() {
+    return watchedThread;
+}
+
+void Tracer::enter(const char* name, const char* category, uint64_t start_us) {
+    uint32_t depth = depth_.load(std::memory_order_relaxed);
+    if (depth < ACTIVITY_DEPTH) {
+        ActivitySlot& slot = activity_[depth];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.category.store(category, std::memory_order_relaxed);
+        slot.start.store(start_us, std::memory_order_relaxed);
+    }
+    depth_.store(depth + 1, std::memory_order_release);
+}
+
+void Tracer::leave() {
+    depth_.store(depth_.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+}
+
+std::vector<Tracer::Activity> Tracer::activity() const {
+    // Пишет только наблюдаемый поток; пока он завис, стек не меняется
+    uint32_t depth = std::min<uint32_t>(depth_.load(std::memory_order_acquire), ACTIVITY_DEPTH);
+    std::vector<Activity> result;
+    result.reserve(depth);
+    for (uint32_t i = 0; i < depth; ++i) {
+        const ActivitySlot& slot = activity_[i];
+        result.push_back({slot.name.load(std::memory_order_relaxed),
+                          slot.category.load(std::memory_order_relaxed),
+                          slot.start.load(std::memory_order_relaxed)});
+    }
+    return result;
+}
+
+uint64_t Tracer::now() {
+    auto elapsed = std::chrono::steady_clock::now() - processStart;
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+void Tracer::record(const char* name, const char* category, uint64_t start_us, uint64_t duration_us,
+                    const char* key, int64_t value) {
+    uint64_t number = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[number % CAPACITY];
+
+    slot.seq.store(2 * number + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.category.store(category, std::memory_order_relaxed);
+    slot.key.store(key, std::memory_order_relaxed);
+    slot.start.store(start_us, std::memory_order_relaxed);
+    slot.duration.store(duration_us, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.thread.store(threadNumber(), std::memory_order_relaxed);
+    slot.seq.store(2 * number + 2, std::memory_order_release);
+}
+
+size_t Tracer::size() const {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t first = std::max(cleared_.load(std::memory_order_relaxed), head > CAPACITY ? head - CAPACITY : 0);
+    return static_cast<size_t>(head - first);
+}
+
+void Tracer::clear() {
+    cleared_.store(head_.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+bool Tracer::exportChromeTrace(const std::string& filename, std::string* error) const {
+    struct Event {
+        const char* name;
+        const char* category;
+        const char* key;
+        uint64_t start;
+        uint64_t duration;
+        int64_t value;
+        uint32_t thread;
+    };
+
+    // Снимок буфера: слот берётся, только если номер не изменился за время чтения
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t first = std::max(cleared_.load(std::memory_order_relaxed), head > CAPACITY ? head - CAPACITY : 0);
+    std::vector<Event> events;
+    events.reserve(static_cast<size_t>(head - first));
+    for (uint64_t number = first; number < head; ++number) {
+        const Slot& slot = slots_[number % CAPACITY];
+        uint64_t expected = 2 * number + 2;
+        if (slot.seq.load(std::memory_order_acquire) != expected) continue;
+
+        Event event;
+        event.name = slot.name.load(std::memory_order_relaxed);
+        event.category = slot.category.load(std::memory_order_relaxed);
+        event.key = slot.key.load(std::memory_order_relaxed);
+        event.start = slot.start.load(std::memory_order_relaxed);
+        event.duration = slot.duration.load(std::memory_order_relaxed);
+        event.value = slot.value.load(std::memory_order_relaxed);
+        event.thread = slot.thread.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != expected) continue;
+        events.push_back(event);
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool firstEvent = true;
+    for (const Event& event : events) {
+        if (!firstEvent) json += ",\n";
+        firstEvent = false;
+
+        json += "{\"name\":\"";
+        appendEscaped(json, event.name);
+        json += "\",\"cat\":\"";
+        appendEscaped(json, event.category);
+        json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(event.thread) +
+                ",\"ts\":" + std::to_string(event.start) +
+                ",\"dur\":" + std::to_string(event.duration);
+        if (event.key) {
+            json += ",\"args\":{\"";
+            appendEscaped(json, event.key);
+            json += "\":" + std::to_string(event.value) + "}";
+        }
+        json += "}";
+    }
+    json += "\n]}\n";
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        if (error) *error = "Cannot open file for writing: " + filename;
+        return false;
+    }
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    if (!file.good()) {
+        if (error) *error = "Write error: " + filename;
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,161 @@
+#include "compact_game.h"
+#include "tag_dictionary.h"
+#include "test_support.h"
+
+using namespace Temporium;
+
+namespace {
+
+// Эталонное сравнение: теги в коллекции хранятся в канонической форме
+bool sameGame(const Game& actual, const Game& expected) {
+    return actual.id == expected.id && actual.user_id == expected.user_id &&
+           actual.name == expected.name && actual.genre == expected.genre &&
+           actual.disk_space == expected.disk_space && actual.ram_usage == expected.ram_usage &&
+           actual.vram_required == expected.vram_required && actual.completed == expected.completed &&
+           actual.is_favorite == expected.is_favorite && actual.is_installed == expected.is_installed &&
+           actual.rating == expected.rating && actual.url == expected.url && actual.notes == expected.notes &&
+           actual.tags == TagDictionary::canonical(expected.tags);
+}
+
+bool sameCollection(const CompactGameCollection& collection, const std::vector<Game>& expected) {
+    if (collection.size() != expected.size()) return false;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (!sameGame(collection.toGame(i), expected[i])) return false;
+    }
+    return true;
+}
+
+// Игры с нестандартными жанрами, пустыми строками и неканоническими тегами
+std::vector<Game> unusualGames() {
+    std::vector<Game> games(4);
+    games[0].id = 101;
+    games[0].genre = "Old import genre";
+    games[0].tags = " coop ,indie,, ";
+    games[1].id = 102;
+    games[1].name = "Только название";
+    games[1].genre = "Another genre";
+    games[2].id = 103;
+    games[2].name = "N";
+    games[2].url = "u";
+    games[2].notes = std::string(1000, 'x');
+    games[2].genre = "Old import genre";
+    games[2].tags = "open world";
+    games[3].id = 104;
+    games[3].genre = "";
+    return games;
+}
+
+void testRoundTrip() {
+    std::vector<Game> games = Test::randomGames(500, 51);
+    std::vector<Game> unusual = unusualGames();
+    games.insert(games.end(), unusual.begin(), unusual.end());
+
+    CompactGameCollection collection;
+    collection.append(games);
+    CHECK(sameCollection(collection, games));
+
+    // Поштучный доступ совпадает с полями Game
+    bool same = true;
+    std::string buffer;
+    for (size_t i = 0; i < games.size(); ++i) {
+        std::vector<std::string> tags = TagDictionary::split(games[i].tags);
+        same = same && collection.name(i) == games[i].name && collection.url(i) == games[i].url &&
+               collection.notes(i) == games[i].notes && collection.genre(i) == games[i].genre &&
+               collection.at(i).tags_count == tags.size();
+        for (size_t t = 0; same && t < tags.size(); ++t) same = collection.tag(i, t) == tags[t];
+
+        GameFields fields = collection.fields(i, buffer);
+        same = same && fields.tags == TagDictionary::canonical(games[i].tags) && fields.name == games[i].name &&
+               sameGame(gameFromFields(fields), games[i]);
+    }
+    CHECK(same);
+
+    std::vector<Game> restored = collection.toGames();
+    CHECK(restored.size() == games.size());
+    same = true;
+    for (size_t i = 0; i < games.size(); ++i) same = same && sameGame(restored[i], games[i]);
+    CHECK(same);
+
+    collection.clear();
+    CHECK(collection.empty());
+    collection.append(unusual[1]);
+    CHECK(sameCollection(collection, {unusual[1]}));
+}
+
+// Порции с собственными пулами тегов и жанров: номера пересчитываются
+// при присоединении, строки порции остаются доступны после её очистки
+void testAppendChunks() {
+    std::vector<Game> games = Test::randomGames(1200, 52);
+    std::vector<Game> unusual = unusualGames();
+    games.insert(games.begin() + 700, unusual.begin(), unusual.end());
+
+    CompactGameCollection collection;
+    std::vector<Game> expected;
+    size_t offset = 0;
+    for (size_t chunkSize : {1, 100, 0, 350, 2000}) {
+        size_t end = std::min(games.size(), offset + chunkSize);
+        {
+            CompactGameCollection chunk;
+            chunk.append(std::vector<Game>(games.begin() + offset, games.begin() + end));
+            collection.append(std::move(chunk));
+            CHECK(chunk.empty());
+        }
+        expected.insert(expected.end(), games.begin() + offset, games.begin() + end);
+        offset = end;
+        CHECK(sameCollection(collection, expected));
+    }
+    CHECK(collection.size() == games.size());
+
+    // После присоединения новые строки пишутся в собственную арену коллекции
+    collection.append(unusual[0]);
+    expected.push_back(unusual[0]);
+    CHECK(sameCollection(collection, expected));
+}
+
+void testEdits() {
+    std::vector<Game> games = Test::randomGames(200, 53);
+    CompactGameCollection collection;
+    collection.append(games);
+
+    std::mt19937 random(54);
+    std::vector<Game> replacements = Test::randomGames(200, 55);
+    std::vector<Game> unusual = unusualGames();
+    bool same = true;
+    for (int step = 0; step < 600; ++step) {
+        size_t index = random() % games.size();
+        switch (random() % 4) {
+            case 0: {
+                Game game = random() % 4 == 0 ? unusual[random() % unusual.size()] : replacements[random() % 200];
+                games[index] = game;
+                collection.replace(index, game);
+                break;
+            }
+            case 1: {
+                std::string notes = random() % 3 == 0 ? "" : "правка " + std::to_string(step);
+                games[index].notes = notes;
+                collection.setNotes(index, notes);
+                break;
+            }
+            case 2:
+                games.erase(games.begin() + static_cast<std::ptrdiff_t>(index));
+                collection.erase(index);
+                break;
+            default:
+                // Добавление держит размер коллекции около исходного
+                games.push_back(replacements[random() % 200]);
+                collection.append(games.back());
+                break;
+        }
+        same = same && sameCollection(collection, games);
+    }
+    CHECK(same);
+}
+
+} // namespace
+
+int main() {
+    testRoundTrip();
+    testAppendChunks();
+    testEdits();
+    return Test::result();
+}
@@ -0,0 +1,106 @@
+#include "export_writer.h"
+#include "test_support.h"
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Temporium;
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// Файлы каталога, кроме . и ..
+size_t fileCount(const std::string& directory) {
+    size_t count = 0;
+    if (DIR* dir = opendir(directory.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (std::strcmp(entry->d_name, ".") != 0 && std::strcmp(entry->d_name, "..") != 0) ++count;
+        }
+        closedir(dir);
+    }
+    return count;
+}
+
+// Содержимое из нескольких буферов разного размера; эталон собирается
+// той же последовательностью в строку
+bool writeExport(const std::string& path, const std::string& header, size_t blocks, std::string& expected,
+                 bool commit) {
+    ExportWriter writer(path);
+    if (!writer.open(header.size())) return false;
+    expected = header;
+    for (size_t b = 0; b < blocks; ++b) {
+        char* buffer = writer.buffer();
+        if (!buffer) return false;
+        size_t size = b % 3 == 0 ? ExportWriter::BUFFER_SIZE : 4096 * (b + 1) + b;
+        for (size_t i = 0; i < size; ++i) buffer[i] = static_cast<char>('a' + (i + b) % 26);
+        expected.append(buffer, size);
+        if (!writer.write(size)) return false;
+    }
+    return !commit || writer.commit(header.data(), header.size());
+}
+
+void testCommit(const std::string& directory) {
+    std::string path = directory + "/games.bin";
+    std::string expected;
+    CHECK(writeExport(path, "HEADER", 7, expected, true));
+    CHECK(readFile(path) == expected);
+    // Временный файл переименован, других не осталось
+    CHECK(fileCount(directory) == 1);
+
+    struct stat info;
+    CHECK(stat(path.c_str(), &info) == 0 && (info.st_mode & 0777) == 0644);
+
+    // Замена существующего файла сохраняет его права
+    CHECK(chmod(path.c_str(), 0640) == 0);
+    CHECK(writeExport(path, "H2", 2, expected, true));
+    CHECK(readFile(path) == expected);
+    CHECK(stat(path.c_str(), &info) == 0 && (info.st_mode & 0777) == 0640);
+    unlink(path.c_str());
+}
+
+// Без commit() старый файл не тронут, временный удалён
+void testDiscard(const std::string& directory) {
+    std::string path = directory + "/keep.bin";
+    std::string original;
+    CHECK(writeExport(path, "OLD", 1, original, true));
+    std::string unused;
+    CHECK(writeExport(path, "NEW", 3, unused, false));
+    CHECK(readFile(path) == original);
+    CHECK(fileCount(directory) == 1);
+    unlink(path.c_str());
+}
+
+void testErrors(const std::string& directory) {
+    ExportWriter missing(directory + "/no/such/dir/file.bin");
+    CHECK(!missing.open(16));
+    CHECK(!missing.lastError().empty());
+
+    ExportWriter closed(directory + "/closed.bin");
+    CHECK(closed.buffer() == nullptr);
+    CHECK(!closed.commit("x", 1));
+    CHECK(fileCount(directory) == 0);
+}
+
+} // namespace
+
+int main() {
+    char pattern[] = "/tmp/temporium-export-test.XXXXXX";
+    const char* directory = mkdtemp(pattern);
+    CHECK(directory != nullptr);
+    if (!directory) return Test::result();
+
+    testCommit(directory);
+    testDiscard(directory);
+    testErrors(directory);
+    rmdir(directory);
+    return Test::result();
+}
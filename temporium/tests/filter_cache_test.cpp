@@ -0,0 +1,147 @@
+#include "filter_cache.h"
+#include "filter_expression.h"
+#include "test_support.h"
+
+using namespace Temporium;
+
+namespace {
+
+// Эталон: полный проход условия по коллекции
+std::vector<uint32_t> bruteForce(const CompactGameCollection& games, const RowPredicate& predicate) {
+    std::vector<uint32_t> rows;
+    for (uint32_t i = 0; i < games.size(); ++i) {
+        if (predicate.matches(games, i)) rows.push_back(i);
+    }
+    return rows;
+}
+
+std::vector<std::shared_ptr<const RowPredicate>> predicates() {
+    std::vector<std::shared_ptr<const RowPredicate>> result;
+
+    GameFilter favorites;
+    favorites.filter_favorite = true;
+    favorites.favorite_value = true;
+    result.push_back(std::make_shared<CompiledFilter>(CompiledFilter::compile(favorites)));
+
+    GameFilter heavy;
+    heavy.filter_ram_min = true;
+    heavy.ram_min = 16;
+    heavy.filter_disk_space_max = true;
+    heavy.disk_space_max = 80.5;
+    result.push_back(std::make_shared<CompiledFilter>(CompiledFilter::compile(heavy)));
+
+    GameFilter tagged;
+    tagged.filter_tag = true;
+    tagged.tag_value = "indie";
+    tagged.filter_genre = true;
+    tagged.genre_value = "RPG";
+    result.push_back(std::make_shared<CompiledFilter>(CompiledFilter::compile(tagged)));
+
+    for (const char* text : {"rating >= 7 or (installed and not completed)",
+                             "notes ~ заметка and url != \"\"",
+                             "name ^= \"Game 1\""}) {
+        auto expression = std::make_shared<FilterExpression>();
+        std::string error;
+        CHECK(FilterExpression::parse(text, *expression, error));
+        result.push_back(expression);
+    }
+    return result;
+}
+
+void checkEntries(FilterResultCache& cache, const CompactGameCollection& games,
+                  const std::vector<std::shared_ptr<const RowPredicate>>& all) {
+    for (const auto& predicate : all) {
+        const std::vector<uint32_t>* rows = cache.find(*predicate);
+        CHECK(rows != nullptr);
+        if (rows) CHECK(*rows == bruteForce(games, *predicate));
+    }
+}
+
+// Точечное обновление записей после правок, добавлений и удалений
+// должно совпадать с пересчётом с нуля
+void testIncrementalUpdates() {
+    std::vector<Game> games = Test::randomGames(2000, 3);
+    std::vector<Game> replacements = Test::randomGames(2000, 4);
+    CompactGameCollection compact;
+    compact.append(games);
+
+    FilterResultCache cache;
+    auto all = predicates();
+    for (const auto& predicate : all) {
+        cache.insert(predicate, bruteForce(compact, *predicate));
+    }
+    checkEntries(cache, compact, all);
+
+    std::mt19937 random(5);
+    for (int step = 0; step < 3000; ++step) {
+        int action = static_cast<int>(random() % 10);
+        if (action < 6 && !compact.empty()) {
+            uint32_t row = static_cast<uint32_t>(random() % compact.size());
+            Game before = compact.toGame(row);
+            Game after = replacements[random() % replacements.size()];
+            after.id = before.id;
+            // Часть правок меняет одно поле
+            if (action < 3) {
+                after = before;
+                after.is_favorite = !before.is_favorite;
+                after.notes = before.notes.empty() ? "заметка 1" : "";
+            }
+            compact.replace(row, after);
+            cache.rowUpdated(compact, row, FilterResultCache::changedFields(before, after));
+        } else if (action < 8) {
+            Game game = replacements[random() % replacements.size()];
+            game.id = 100000 + step;
+            compact.append(game);
+            cache.rowAppended(compact, static_cast<uint32_t>(compact.size() - 1));
+        } else if (!compact.empty()) {
+            uint32_t row = static_cast<uint32_t>(random() % compact.size());
+            compact.erase(row);
+            cache.rowRemoved(row);
+        }
+        if (step % 500 == 0) checkEntries(cache, compact, all);
+    }
+    checkEntries(cache, compact, all);
+}
+
+void testChangedFields() {
+    Game a;
+    a.name = "x";
+    a.tags = "coop";
+    Game b = a;
+    CHECK(FilterResultCache::changedFields(a, b) == 0);
+    b.ram_usage = 0.5;
+    b.tags = "coop, indie";
+    CHECK(FilterResultCache::changedFields(a, b) == (FIELD_RAM_USAGE | FIELD_TAGS));
+}
+
+// Вытеснение в пределах бюджета: свежие записи остаются
+void testEviction() {
+    std::vector<Game> games = Test::randomGames(1000, 9);
+    CompactGameCollection compact;
+    compact.append(games);
+    auto all = predicates();
+
+    FilterResultCache unlimited;
+    for (const auto& predicate : all) unlimited.insert(predicate, bruteForce(compact, *predicate));
+    size_t budget = unlimited.bytes() - 1;
+
+    FilterResultCache cache(budget);
+    for (const auto& predicate : all) cache.insert(predicate, bruteForce(compact, *predicate));
+    CHECK(cache.bytes() <= budget);
+    CHECK(cache.size() < all.size());
+    CHECK(cache.find(*all.back()) != nullptr);
+    CHECK(cache.find(*all.front()) == nullptr);
+    CHECK(cache.hits() == 1 && cache.misses() == 1);
+
+    cache.clear();
+    CHECK(cache.size() == 0 && cache.bytes() == 0);
+}
+
+} // namespace
+
+int main() {
+    testIncrementalUpdates();
+    testChangedFields();
+    testEviction();
+    return Test::result();
+}
@@ -0,0 +1,418 @@
+#include "filter_compiler.h"
+#include "tag_dictionary.h"
+#include "test_support.h"
+#include <optional>
+
+using namespace Temporium;
+
+namespace {
+
+using SqlParam = CompiledFilter::SqlParam;
+
+// Строка таблицы games: столбцы без NOT NULL могут быть NULL,
+// теги хранятся в канонической форме
+struct DbRow {
+    std::string genre;
+    double disk_space = 0;
+    double ram_usage = 0;
+    double vram_required = 0;
+    std::optional<std::string> tags;
+    std::optional<int> rating;
+    std::optional<bool> completed;
+    std::optional<bool> is_favorite;
+    std::optional<bool> is_installed;
+};
+
+DbRow stored(const Game& game) {
+    DbRow row;
+    row.genre = game.genre;
+    row.disk_space = game.disk_space;
+    row.ram_usage = game.ram_usage;
+    row.vram_required = game.vram_required;
+    row.tags = TagDictionary::canonical(game.tags);
+    row.rating = game.rating;
+    row.completed = game.completed;
+    row.is_favorite = game.is_favorite;
+    row.is_installed = game.is_installed;
+    return row;
+}
+
+// Та же строка после загрузки клиентом: NULL — пустое значение
+Game loaded(const DbRow& row) {
+    Game game;
+    game.genre = row.genre;
+    game.disk_space = row.disk_space;
+    game.ram_usage = row.ram_usage;
+    game.vram_required = row.vram_required;
+    game.tags = row.tags.value_or("");
+    game.rating = row.rating.value_or(-1);
+    game.completed = row.completed.value_or(false);
+    game.is_favorite = row.is_favorite.value_or(false);
+    game.is_installed = row.is_installed.value_or(false);
+    return game;
+}
+
+// Эталон: условия GameFilter по отдельности, как их описывает панель фильтра
+bool expected(const GameFilter& filter, const Game& game) {
+    if (filter.filter_completed && game.completed != filter.completed_value) return false;
+    if (filter.filter_favorite && game.is_favorite != filter.favorite_value) return false;
+    if (filter.filter_installed && game.is_installed != filter.installed_value) return false;
+    if (filter.filter_genre && !filter.genre_value.empty() && game.genre != filter.genre_value) return false;
+    if (filter.filter_disk_space_min && game.disk_space < filter.disk_space_min) return false;
+    if (filter.filter_disk_space_max && game.disk_space > filter.disk_space_max) return false;
+    if (filter.filter_ram_min && game.ram_usage < filter.ram_min) return false;
+    if (filter.filter_ram_max && game.ram_usage > filter.ram_max) return false;
+    if (filter.filter_vram_min && game.vram_required < filter.vram_min) return false;
+    if (filter.filter_vram_max && game.vram_required > filter.vram_max) return false;
+    if (filter.filter_rating_min && game.rating < filter.rating_min) return false;
+    if (filter.filter_rating_max && (game.rating == -1 || game.rating > filter.rating_max)) return false;
+    if (filter.filter_has_rating && (game.rating != -1) != filter.has_rating_value) return false;
+    if (filter.filter_tag && !filter.tag_value.empty() &&
+        TagDictionary::canonical(game.tags).find(filter.tag_value) == std::string::npos) {
+        return false;
+    }
+    return true;
+}
+
+// LIKE с символом экранирования '\'
+bool like(const std::string& text, size_t t, const std::string& pattern, size_t p) {
+    if (p == pattern.size()) return t == text.size();
+    if (pattern[p] == '%') {
+        for (size_t skip = t; skip <= text.size(); ++skip) {
+            if (like(text, skip, pattern, p + 1)) return true;
+        }
+        return false;
+    }
+    if (t == text.size()) return false;
+    if (pattern[p] == '_') return like(text, t + 1, pattern, p + 1);
+    if (pattern[p] == '\\' && p + 1 < pattern.size()) ++p;
+    return pattern[p] == text[t] && like(text, t + 1, pattern, p + 1);
+}
+
+// Значение сравнения SQL: NULL или число/строка
+struct Value {
+    bool null = true;
+    double number = 0;
+    std::string text;
+};
+
+Value number(std::optional<double> value) {
+    Value result;
+    result.null = !value;
+    result.number = value.value_or(0);
+    return result;
+}
+
+// Левая часть сравнения в условии sqlCondition(); тип параметра должен
+// совпадать с типом столбца
+bool column(const DbRow& row, const std::string& name, SqlParam::Type& type, Value& value) {
+    auto flag = [](const std::optional<bool>& column) {
+        return column ? std::optional<double>(*column ? 1 : 0) : std::nullopt;
+    };
+    auto coalesced = [](const std::optional<bool>& column) { return number(column.value_or(false) ? 1 : 0); };
+    type = SqlParam::Type::Bool;
+    if (name == "completed") { value = number(flag(row.completed)); return true; }
+    if (name == "is_favorite") { value = number(flag(row.is_favorite)); return true; }
+    if (name == "is_installed") { value = number(flag(row.is_installed)); return true; }
+    if (name == "COALESCE(completed, FALSE)") { value = coalesced(row.completed); return true; }
+    if (name == "COALESCE(is_favorite, FALSE)") { value = coalesced(row.is_favorite); return true; }
+    if (name == "COALESCE(is_installed, FALSE)") { value = coalesced(row.is_installed); return true; }
+    type = SqlParam::Type::Int;
+    if (name == "rating") {
+        value = number(row.rating ? std::optional<double>(*row.rating) : std::nullopt);
+        return true;
+    }
+    if (name == "COALESCE(rating, -1)") { value = number(row.rating.value_or(-1)); return true; }
+    type = SqlParam::Type::Double;
+    if (name == "disk_space") { value = number(row.disk_space); return true; }
+    if (name == "ram_usage") { value = number(row.ram_usage); return true; }
+    if (name == "vram_required") { value = number(row.vram_required); return true; }
+    type = SqlParam::Type::Text;
+    value.null = false;
+    if (name == "genre") { value.text = row.genre; return true; }
+    if (name == "tags") {
+        value.null = !row.tags;
+        value.text = row.tags.value_or("");
+        return true;
+    }
+    return false;
+}
+
+// Условие WHERE из sqlCondition(): "терм AND терм ...", терм — "столбец оп $N".
+// Строка отбирается, только если каждый терм TRUE (NULL отбрасывает строку)
+class SqlCondition {
+public:
+    SqlCondition(const std::string& condition, const std::vector<SqlParam>& params, int first)
+        : params_(params), first_(first) {
+        size_t pos = 0;
+        while (pos <= condition.size() && !condition.empty()) {
+            size_t end = condition.find(" AND ", pos);
+            if (end == std::string::npos) end = condition.size();
+            terms_.push_back(condition.substr(pos, end - pos));
+            pos = end + 5;
+        }
+    }
+
+    bool valid() const { return valid_; }
+
+    bool where(const DbRow& row) {
+        for (const std::string& term : terms_) {
+            if (!holds(term, row)) return false;
+        }
+        return true;
+    }
+
+private:
+    bool holds(const std::string& term, const DbRow& row) {
+        if (term == "FALSE") return false;
+        size_t dollar = term.rfind(" $");
+        size_t space = dollar == std::string::npos ? std::string::npos : term.rfind(' ', dollar - 1);
+        if (space == std::string::npos) return invalid();
+        std::string name = term.substr(0, space);
+        std::string op = term.substr(space + 1, dollar - space - 1);
+        int index = std::stoi(term.substr(dollar + 2)) - first_;
+        if (index < 0 || static_cast<size_t>(index) >= params_.size()) return invalid();
+        const SqlParam& param = params_[index];
+
+        SqlParam::Type type;
+        Value value;
+        if (!column(row, name, type, value) || type != param.type) return invalid();
+        if (value.null) return false;
+
+        if (op == "LIKE") return type == SqlParam::Type::Text && like(value.text, 0, param.text_value, 0);
+        if (type == SqlParam::Type::Text) {
+            return op == "=" ? value.text == param.text_value : invalid();
+        }
+        double right = type == SqlParam::Type::Bool ? (param.bool_value ? 1 : 0)
+                     : type == SqlParam::Type::Int ? param.int_value : param.double_value;
+        if (op == "=") return value.number == right;
+        if (op == ">=") return value.number >= right;
+        if (op == "<=") return value.number <= right;
+        return invalid();
+    }
+
+    bool invalid() {
+        valid_ = false;
+        return false;
+    }
+
+    const std::vector<SqlParam>& params_;
+    int first_;
+    std::vector<std::string> terms_;
+    bool valid_ = true;
+};
+
+// Случайный фильтр: значения из тех же диапазонов, что у коллекции,
+// чтобы попадать на границы; теги — целые, части тегов и с ", "
+GameFilter randomFilter(std::mt19937& random) {
+    static const char* const genres[] = {"RPG", "Strategy", "Puzzle", "Old Genre"};
+    static const char* const tags[] = {"coop", "indie", "open world", "co", "world", "p, s", "50%", "a_b", "a\\b"};
+    auto chance = [&random](int percent) { return static_cast<int>(random() % 100) < percent; };
+    auto half = [&random](uint32_t range) { return (random() % range) / 2.0; };
+
+    GameFilter filter;
+    filter.filter_completed = chance(25);
+    filter.completed_value = chance(50);
+    filter.filter_favorite = chance(20);
+    filter.favorite_value = chance(50);
+    filter.filter_installed = chance(20);
+    filter.installed_value = chance(50);
+    filter.filter_genre = chance(20);
+    filter.genre_value = chance(10) ? "" : genres[random() % 4];
+    filter.filter_disk_space_min = chance(25);
+    filter.disk_space_min = half(400);
+    filter.filter_disk_space_max = chance(25);
+    filter.disk_space_max = half(400);
+    filter.filter_ram_min = chance(20);
+    filter.ram_min = half(128);
+    filter.filter_ram_max = chance(20);
+    filter.ram_max = half(128);
+    filter.filter_vram_min = chance(20);
+    filter.vram_min = half(48);
+    filter.filter_vram_max = chance(20);
+    filter.vram_max = half(48);
+    filter.filter_rating_min = chance(20);
+    filter.rating_min = static_cast<int>(random() % 11);
+    filter.filter_rating_max = chance(20);
+    filter.rating_max = static_cast<int>(random() % 11);
+    filter.filter_has_rating = chance(15);
+    filter.has_rating_value = chance(50);
+    filter.filter_tag = chance(30);
+    filter.tag_value = tags[random() % (sizeof(tags) / sizeof(tags[0]))];
+    return filter;
+}
+
+// Строки БД: случайная коллекция, NULL в необязательных столбцах,
+// теги с метасимволами LIKE и нестандартный жанр
+std::vector<DbRow> makeRows() {
+    std::vector<DbRow> rows;
+    for (const Game& game : Test::randomGames(1500, 31)) rows.push_back(stored(game));
+
+    std::mt19937 random(32);
+    for (size_t i = 0; i < rows.size(); i += 7) {
+        switch (random() % 5) {
+            case 0: rows[i].rating.reset(); break;
+            case 1: rows[i].completed.reset(); break;
+            case 2: rows[i].is_favorite.reset(); break;
+            case 3: rows[i].is_installed.reset(); break;
+            default: rows[i].tags.reset(); break;
+        }
+    }
+
+    const char* const special[] = {"50%, indie", "a_b", "axb", "a\\b", "500, coop", "pixel art, story"};
+    for (const char* tags : special) {
+        DbRow row = rows[rows.size() / 2];
+        row.tags = tags;
+        rows.push_back(row);
+    }
+    DbRow custom = rows.front();
+    custom.genre = "Old Genre";
+    rows.push_back(custom);
+    return rows;
+}
+
+// Одни и те же строки отбираются эталоном, программой для Game и для
+// компактной коллекции, и условием SQL на строках БД
+void testAgainstReference() {
+    std::vector<DbRow> rows = makeRows();
+    std::vector<Game> games;
+    for (const DbRow& row : rows) games.push_back(loaded(row));
+    CompactGameCollection compact;
+    compact.append(games);
+
+    std::mt19937 random(33);
+    size_t matchedSomething = 0;
+    for (int iteration = 0; iteration < 400; ++iteration) {
+        GameFilter filter = randomFilter(random);
+        CompiledFilter compiled = CompiledFilter::compile(filter);
+
+        std::vector<SqlParam> params;
+        int first = 1 + iteration % 3;
+        std::string condition = compiled.sqlCondition(first, params);
+        SqlCondition sql(condition, params, first);
+
+        size_t matched = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            bool reference = expected(filter, games[i]);
+            matched += reference ? 1 : 0;
+            CHECK(compiled.matches(games[i]) == reference);
+            CHECK(compiled.matches(compact, i) == reference);
+            CHECK(sql.where(rows[i]) == reference);
+        }
+        CHECK(sql.valid());
+        CHECK(compiled.matchesAll() == condition.empty());
+        if (compiled.matchesNone()) CHECK(matched == 0);
+        if (matched > 0 && matched < rows.size()) ++matchedSomething;
+    }
+    // Фильтры действительно отсеивали часть строк
+    CHECK(matchedSomething > 100);
+}
+
+// Программа нормализована: слитые диапазоны, порядок от дешёвых проверок
+void testCompile() {
+    CHECK(CompiledFilter::compile(GameFilter()).matchesAll());
+
+    GameFilter filter;
+    filter.filter_tag = true;
+    filter.tag_value = "50%";
+    filter.filter_disk_space_min = true;
+    filter.disk_space_min = 10;
+    filter.filter_disk_space_max = true;
+    filter.disk_space_max = 20.5;
+    filter.filter_rating_max = true;
+    filter.rating_max = 5;
+    filter.filter_completed = true;
+    filter.completed_value = true;
+    CompiledFilter compiled = CompiledFilter::compile(filter);
+
+    const std::vector<CompiledFilter::Instruction>& code = compiled.code();
+    CHECK(code.size() == 4);
+    if (code.size() == 4) {
+        CHECK(code[0].op == CompiledFilter::Op::Flags && code[0].mask == CompactGame::FLAG_COMPLETED);
+        CHECK(code[1].op == CompiledFilter::Op::Range && code[1].field == CompiledFilter::Field::Rating);
+        CHECK(code[1].has_low && code[1].low == 0 && code[1].has_high && code[1].high == 5);
+        CHECK(code[2].op == CompiledFilter::Op::Range && code[2].field == CompiledFilter::Field::DiskSpace);
+        CHECK(code[3].op == CompiledFilter::Op::TagContains);
+    }
+    CHECK(compiled.fieldMask() == (FIELD_COMPLETED | FIELD_RATING | FIELD_DISK_SPACE | FIELD_TAGS));
+
+    std::vector<SqlParam> params;
+    CHECK(compiled.sqlCondition(2, params) ==
+          "COALESCE(completed, FALSE) = $2 AND COALESCE(rating, -1) >= $3 AND COALESCE(rating, -1) <= $4 "
+          "AND disk_space >= $5 AND disk_space <= $6 AND tags LIKE $7");
+    CHECK(params.size() == 6);
+    if (params.size() == 6) {
+        CHECK(params[0].type == SqlParam::Type::Bool && params[0].bool_value);
+        CHECK(params[1].type == SqlParam::Type::Int && params[1].int_value == 0);
+        CHECK(params[4].type == SqlParam::Type::Double && params[4].double_value == 20.5);
+        CHECK(params[5].type == SqlParam::Type::Text && params[5].text_value == "%50\\%%");
+    }
+
+    // "Без оценки" — один диапазон из точки
+    GameFilter unrated;
+    unrated.filter_has_rating = true;
+    unrated.has_rating_value = false;
+    params.clear();
+    CHECK(CompiledFilter::compile(unrated).sqlCondition(1, params) == "COALESCE(rating, -1) = $1");
+    CHECK(params.size() == 1 && params[0].int_value == -1);
+
+    // Пустой диапазон сворачивается в "ложь"
+    GameFilter empty;
+    empty.filter_ram_min = true;
+    empty.ram_min = 16;
+    empty.filter_ram_max = true;
+    empty.ram_max = 8;
+    empty.filter_completed = true;
+    CompiledFilter never = CompiledFilter::compile(empty);
+    CHECK(never.matchesNone());
+    params.clear();
+    CHECK(never.sqlCondition(1, params) == "FALSE");
+    CHECK(params.empty());
+
+    CHECK(CompiledFilter::escapeLike("a_b%c\\d") == "a\\_b\\%c\\\\d");
+}
+
+// Равные по смыслу фильтры дают один ключ кэша, разные — разные
+void testCacheKey() {
+    GameFilter atMost;
+    atMost.filter_rating_max = true;
+    atMost.rating_max = 5;
+    GameFilter between = atMost;
+    between.filter_rating_min = true;
+    between.rating_min = 0;
+    CHECK(CompiledFilter::compile(atMost).cacheKey() == CompiledFilter::compile(between).cacheKey());
+
+    // Жанр без значения не ограничивает
+    GameFilter noGenre;
+    noGenre.filter_genre = true;
+    CHECK(CompiledFilter::compile(noGenre).cacheKey() == CompiledFilter::compile(GameFilter()).cacheKey());
+
+    GameFilter tagA;
+    tagA.filter_tag = true;
+    tagA.tag_value = "a;1";
+    GameFilter tagB = tagA;
+    tagB.tag_value = "a";
+    CHECK(CompiledFilter::compile(tagA).cacheKey() != CompiledFilter::compile(tagB).cacheKey());
+    GameFilter genre;
+    genre.filter_genre = true;
+    genre.genre_value = "a;1";
+    CHECK(CompiledFilter::compile(tagA).cacheKey() != CompiledFilter::compile(genre).cacheKey());
+
+    GameFilter disk;
+    disk.filter_disk_space_min = true;
+    disk.disk_space_min = 1.5;
+    GameFilter ram = disk;
+    ram.filter_disk_space_min = false;
+    ram.filter_ram_min = true;
+    ram.ram_min = 1.5;
+    CHECK(CompiledFilter::compile(disk).cacheKey() != CompiledFilter::compile(ram).cacheKey());
+}
+
+} // namespace
+
+int main() {
+    testAgainstReference();
+    testCompile();
+    testCacheKey();
+    return Test::result();
+}
@@ -0,0 +1,753 @@
+#include "filter_expression.h"
+#include "test_support.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <regex>
+
+using namespace Temporium;
+
+namespace {
+
+// Строка таблицы games, как её видит PostgreSQL: необязательные столбцы
+// могут быть NULL
+struct DbRow {
+    std::string name;
+    std::string genre;
+    double disk_space = 0;
+    double ram_usage = 0;
+    double vram_required = 0;
+    std::optional<std::string> notes;
+    std::optional<std::string> url;
+    std::optional<std::string> tags;
+    std::optional<int> rating;
+    std::optional<bool> completed;
+    std::optional<bool> is_favorite;
+    std::optional<bool> is_installed;
+};
+
+// Та же строка после загрузки клиентом: NULL — пустое значение
+Game loaded(const DbRow& row) {
+    Game game;
+    game.name = row.name;
+    game.genre = row.genre;
+    game.disk_space = row.disk_space;
+    game.ram_usage = row.ram_usage;
+    game.vram_required = row.vram_required;
+    game.notes = row.notes.value_or("");
+    game.url = row.url.value_or("");
+    game.tags = row.tags.value_or("");
+    game.rating = row.rating.value_or(-1);
+    game.completed = row.completed.value_or(false);
+    game.is_favorite = row.is_favorite.value_or(false);
+    game.is_installed = row.is_installed.value_or(false);
+    return game;
+}
+
+// Значение SQL с NULL
+struct Value {
+    enum class Type { Null, Bool, Number, Text, Array } type = Type::Null;
+    bool flag = false;
+    double number = 0;
+    std::string text;
+    std::vector<std::string> array;
+
+    static Value boolean(bool value) {
+        Value result;
+        result.type = Type::Bool;
+        result.flag = value;
+        return result;
+    }
+    static Value numeric(double value) {
+        Value result;
+        result.type = Type::Number;
+        result.number = value;
+        return result;
+    }
+    static Value string(std::string value) {
+        Value result;
+        result.type = Type::Text;
+        result.text = std::move(value);
+        return result;
+    }
+    bool null() const { return type == Type::Null; }
+};
+
+// LIKE с экранированием по умолчанию ('\')
+bool like(const std::string& text, const std::string& pattern, size_t t = 0, size_t p = 0) {
+    while (p < pattern.size()) {
+        char c = pattern[p];
+        if (c == '%') {
+            for (size_t from = t; from <= text.size(); ++from) {
+                if (like(text, pattern, from, p + 1)) return true;
+            }
+            return false;
+        }
+        if (c == '\\' && p + 1 < pattern.size()) c = pattern[++p];
+        else if (c == '_') {
+            if (t >= text.size()) return false;
+            ++t;
+            ++p;
+            continue;
+        }
+        if (t >= text.size() || text[t] != c) return false;
+        ++t;
+        ++p;
+    }
+    return t == text.size();
+}
+
+// Интерпретатор подмножества SQL, которое порождает sqlCondition():
+// логика трёх значений, COALESCE, LIKE, IN, &&, ARRAY[...], EXISTS по
+// unnest и функции разбора строки тегов. Условие разбирается заново для
+// каждой строки, чтобы проверялся сам текст запроса
+class SqlInterpreter {
+public:
+    SqlInterpreter(const std::string& sql, const std::vector<CompiledFilter::SqlParam>& params, int first)
+        : params_(params), first_(first) {
+        tokenize(sql);
+    }
+
+    // true — строка проходит WHERE; ok() — текст разобран целиком
+    bool where(const DbRow& row) {
+        row_ = &row;
+        pos_ = 0;
+        ok_ = tokenized_;
+        Value value = orExpr();
+        if (pos_ != tokens_.size()) ok_ = false;
+        return value.type == Value::Type::Bool && value.flag;
+    }
+
+    bool ok() const { return ok_; }
+    // Сколько параметров использовано текстом условия
+    int usedParams() const { return used_; }
+
+private:
+    struct Token {
+        enum class Type { Word, String, Number, Param, Symbol } type;
+        std::string text;
+    };
+
+    void tokenize(const std::string& sql) {
+        size_t i = 0;
+        while (i < sql.size()) {
+            char c = sql[i];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                ++i;
+            } else if (c == '\'' || ((c == 'E' || c == 'e') && i + 1 < sql.size() && sql[i + 1] == '\'')) {
+                bool escapes = c != '\'';
+                i += escapes ? 2 : 1;
+                std::string value;
+                while (i < sql.size()) {
+                    if (sql[i] == '\'' && i + 1 < sql.size() && sql[i + 1] == '\'') {
+                        value += '\'';
+                        i += 2;
+                    } else if (sql[i] == '\'') {
+                        ++i;
+                        break;
+                    } else if (escapes && sql[i] == '\\' && i + 1 < sql.size()) {
+                        char next = sql[i + 1];
+                        value += next == 't' ? '\t' : next == 'n' ? '\n' : next;
+                        i += 2;
+                    } else {
+                        value += sql[i++];
+                    }
+                }
+                tokens_.push_back({Token::Type::String, value});
+            } else if (c == '$') {
+                size_t start = ++i;
+                while (i < sql.size() && std::isdigit(static_cast<unsigned char>(sql[i]))) ++i;
+                tokens_.push_back({Token::Type::Param, sql.substr(start, i - start)});
+            } else if (std::isdigit(static_cast<unsigned char>(c)) ||
+                       (c == '-' && i + 1 < sql.size() && std::isdigit(static_cast<unsigned char>(sql[i + 1])))) {
+                size_t start = i++;
+                while (i < sql.size() && (std::isdigit(static_cast<unsigned char>(sql[i])) || sql[i] == '.')) ++i;
+                tokens_.push_back({Token::Type::Number, sql.substr(start, i - start)});
+            } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+                size_t start = i;
+                while (i < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '_' ||
+                                          sql[i] == '.')) {
+                    ++i;
+                }
+                tokens_.push_back({Token::Type::Word, sql.substr(start, i - start)});
+            } else {
+                static const char* const symbols[] = {"::", "<>", "<=", ">=", "&&", "=", "<", ">",
+                                                      "(", ")", ",", "[", "]"};
+                bool found = false;
+                for (const char* symbol : symbols) {
+                    size_t length = std::strlen(symbol);
+                    if (sql.compare(i, length, symbol) == 0) {
+                        tokens_.push_back({Token::Type::Symbol, symbol});
+                        i += length;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    tokens_.push_back({Token::Type::Symbol, std::string(1, c)});
+                    ++i;
+                    tokenized_ = false;
+                }
+            }
+        }
+    }
+
+    bool isWord(const char* word) const {
+        if (pos_ >= tokens_.size() || tokens_[pos_].type != Token::Type::Word) return false;
+        const std::string& text = tokens_[pos_].text;
+        if (text.size() != std::strlen(word)) return false;
+        for (size_t i = 0; i < text.size(); ++i) {
+            if (std::toupper(static_cast<unsigned char>(text[i])) != std::toupper(static_cast<unsigned char>(word[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool isSymbol(const char* symbol) const {
+        return pos_ < tokens_.size() && tokens_[pos_].type == Token::Type::Symbol && tokens_[pos_].text == symbol;
+    }
+    void expectWord(const char* word) {
+        if (isWord(word)) ++pos_;
+        else ok_ = false;
+    }
+    void expectSymbol(const char* symbol) {
+        if (isSymbol(symbol)) ++pos_;
+        else ok_ = false;
+    }
+
+    static Value logicalAnd(const Value& a, const Value& b) {
+        if ((a.type == Value::Type::Bool && !a.flag) || (b.type == Value::Type::Bool && !b.flag)) {
+            return Value::boolean(false);
+        }
+        if (a.null() || b.null()) return Value();
+        return Value::boolean(true);
+    }
+    static Value logicalOr(const Value& a, const Value& b) {
+        if ((a.type == Value::Type::Bool && a.flag) || (b.type == Value::Type::Bool && b.flag)) {
+            return Value::boolean(true);
+        }
+        if (a.null() || b.null()) return Value();
+        return Value::boolean(false);
+    }
+
+    Value orExpr() {
+        Value result = andExpr();
+        while (ok_ && isWord("OR")) {
+            ++pos_;
+            result = logicalOr(result, andExpr());
+        }
+        return result;
+    }
+
+    Value andExpr() {
+        Value result = notExpr();
+        while (ok_ && isWord("AND")) {
+            ++pos_;
+            result = logicalAnd(result, notExpr());
+        }
+        return result;
+    }
+
+    Value notExpr() {
+        if (isWord("NOT")) {
+            ++pos_;
+            Value value = notExpr();
+            return value.null() ? value : Value::boolean(!value.flag);
+        }
+        return predicate();
+    }
+
+    Value predicate() {
+        if (isWord("EXISTS")) return exists();
+        if (isSymbol("(")) {
+            ++pos_;
+            Value value = orExpr();
+            expectSymbol(")");
+            return value;
+        }
+
+        Value left = value();
+        if (isWord("LIKE")) {
+            ++pos_;
+            Value pattern = value();
+            if (left.null() || pattern.null()) return Value();
+            return Value::boolean(like(left.text, pattern.text));
+        }
+        if (isWord("IN")) {
+            ++pos_;
+            expectSymbol("(");
+            std::vector<Value> list = values(")");
+            if (left.null()) return Value();
+            for (const Value& item : list) {
+                if (equal(left, item)) return Value::boolean(true);
+            }
+            return Value::boolean(false);
+        }
+        if (isSymbol("&&")) {
+            ++pos_;
+            Value right = value();
+            if (left.null() || right.null()) return Value();
+            for (const std::string& item : left.array) {
+                if (std::find(right.array.begin(), right.array.end(), item) != right.array.end()) {
+                    return Value::boolean(true);
+                }
+            }
+            return Value::boolean(false);
+        }
+        for (const char* op : {"=", "<>", "<", "<=", ">", ">="}) {
+            if (!isSymbol(op)) continue;
+            ++pos_;
+            Value right = value();
+            if (left.null() || right.null()) return Value();
+            std::string name = op;
+            if (name == "=") return Value::boolean(equal(left, right));
+            if (name == "<>") return Value::boolean(!equal(left, right));
+            if (left.type != Value::Type::Number || right.type != Value::Type::Number) ok_ = false;
+            if (name == "<") return Value::boolean(left.number < right.number);
+            if (name == "<=") return Value::boolean(left.number <= right.number);
+            if (name == ">") return Value::boolean(left.number > right.number);
+            return Value::boolean(left.number >= right.number);
+        }
+        if (left.type != Value::Type::Bool && !left.null()) ok_ = false;
+        return left;
+    }
+
+    bool equal(const Value& a, const Value& b) {
+        if (a.type != b.type) {
+            ok_ = false;
+            return false;
+        }
+        switch (a.type) {
+            case Value::Type::Bool: return a.flag == b.flag;
+            case Value::Type::Number: return a.number == b.number;
+            case Value::Type::Text: return a.text == b.text;
+            default: ok_ = false; return false;
+        }
+    }
+
+    // EXISTS (SELECT 1 FROM unnest(<массив>) AS t(tag) WHERE <условие>):
+    // условие разбирается для каждого элемента с привязкой t.tag
+    Value exists() {
+        ++pos_;
+        expectSymbol("(");
+        expectWord("SELECT");
+        if (pos_ < tokens_.size() && tokens_[pos_].text == "1") ++pos_;
+        else ok_ = false;
+        expectWord("FROM");
+        expectWord("unnest");
+        expectSymbol("(");
+        Value array = value();
+        expectSymbol(")");
+        expectWord("AS");
+        std::string alias = pos_ < tokens_.size() ? tokens_[pos_++].text : "";
+        expectSymbol("(");
+        std::string column = pos_ < tokens_.size() ? tokens_[pos_++].text : "";
+        expectSymbol(")");
+        expectWord("WHERE");
+        if (!ok_ || array.type != Value::Type::Array) {
+            ok_ = false;
+            return Value();
+        }
+
+        size_t condition = pos_;
+        bool found = false;
+        size_t end = condition;
+        if (array.array.empty()) {
+            // Пустой массив: условие только пропускается
+            bound_[alias + "." + column] = Value();
+            orExpr();
+            end = pos_;
+        }
+        for (const std::string& element : array.array) {
+            pos_ = condition;
+            bound_[alias + "." + column] = Value::string(element);
+            Value value = orExpr();
+            end = pos_;
+            found = found || (value.type == Value::Type::Bool && value.flag);
+        }
+        bound_.erase(alias + "." + column);
+        pos_ = end;
+        expectSymbol(")");
+        return Value::boolean(found);
+    }
+
+    std::vector<Value> values(const char* close) {
+        std::vector<Value> result;
+        while (ok_ && !isSymbol(close)) {
+            result.push_back(value());
+            if (isSymbol(",")) ++pos_;
+            else break;
+        }
+        expectSymbol(close);
+        return result;
+    }
+
+    Value value() {
+        if (pos_ >= tokens_.size()) {
+            ok_ = false;
+            return Value();
+        }
+        const Token token = tokens_[pos_++];
+        switch (token.type) {
+            case Token::Type::String:
+                return Value::string(token.text);
+            case Token::Type::Number:
+                return Value::numeric(std::strtod(token.text.c_str(), nullptr));
+            case Token::Type::Param:
+                return param(std::atoi(token.text.c_str()));
+            case Token::Type::Symbol:
+                ok_ = false;
+                return Value();
+            case Token::Type::Word:
+                break;
+        }
+
+        std::string word = token.text;
+        --pos_;
+        if (isWord("TRUE") || isWord("FALSE")) {
+            ++pos_;
+            return Value::boolean(isWordAt(pos_ - 1, "TRUE"));
+        }
+        if (isWord("NULL")) {
+            ++pos_;
+            return Value();
+        }
+        if (isWord("ARRAY")) {
+            ++pos_;
+            expectSymbol("[");
+            Value array;
+            array.type = Value::Type::Array;
+            for (const Value& item : values("]")) {
+                if (item.type != Value::Type::Text) ok_ = false;
+                array.array.push_back(item.text);
+            }
+            return array;
+        }
+        ++pos_;
+        if (isSymbol("(")) {
+            ++pos_;
+            return function(word, values(")"));
+        }
+        auto bound = bound_.find(word);
+        if (bound != bound_.end()) return bound->second;
+        return column(word);
+    }
+
+    bool isWordAt(size_t index, const char* word) {
+        size_t saved = pos_;
+        pos_ = index;
+        bool result = isWord(word);
+        pos_ = saved;
+        return result;
+    }
+
+    Value param(int number) {
+        int index = number - first_;
+        if (index < 0 || index >= static_cast<int>(params_.size())) {
+            ok_ = false;
+            return Value();
+        }
+        used_ = std::max(used_, index + 1);
+        const CompiledFilter::SqlParam& param = params_[index];
+        Value result;
+        switch (param.type) {
+            case CompiledFilter::SqlParam::Type::Bool: result = Value::boolean(param.bool_value); break;
+            case CompiledFilter::SqlParam::Type::Int: result = Value::numeric(param.int_value); break;
+            case CompiledFilter::SqlParam::Type::Double: result = Value::numeric(param.double_value); break;
+            case CompiledFilter::SqlParam::Type::Text: result = Value::string(param.text_value); break;
+        }
+        // Приведение ::text допустимо только к строковому параметру
+        if (isSymbol("::")) {
+            ++pos_;
+            expectWord("text");
+            if (result.type != Value::Type::Text) ok_ = false;
+        }
+        return result;
+    }
+
+    Value column(const std::string& name) {
+        const DbRow& row = *row_;
+        auto text = [](const std::optional<std::string>& value) {
+            return value ? Value::string(*value) : Value();
+        };
+        auto flag = [](const std::optional<bool>& value) {
+            return value ? Value::boolean(*value) : Value();
+        };
+        if (name == "name") return Value::string(row.name);
+        if (name == "genre") return Value::string(row.genre);
+        if (name == "disk_space") return Value::numeric(row.disk_space);
+        if (name == "ram_usage") return Value::numeric(row.ram_usage);
+        if (name == "vram_required") return Value::numeric(row.vram_required);
+        if (name == "notes") return text(row.notes);
+        if (name == "url") return text(row.url);
+        if (name == "tags") return text(row.tags);
+        if (name == "rating") return row.rating ? Value::numeric(*row.rating) : Value();
+        if (name == "completed") return flag(row.completed);
+        if (name == "is_favorite") return flag(row.is_favorite);
+        if (name == "is_installed") return flag(row.is_installed);
+        ok_ = false;
+        return Value();
+    }
+
+    Value function(const std::string& name, const std::vector<Value>& args) {
+        std::string upper = name;
+        for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        if (upper == "COALESCE") {
+            for (const Value& arg : args) {
+                if (!arg.null()) return arg;
+            }
+            return Value();
+        }
+        if (upper == "BTRIM" && args.size() == 2) {
+            if (args[0].null()) return Value();
+            const std::string& text = args[0].text;
+            size_t start = text.find_first_not_of(args[1].text);
+            if (start == std::string::npos) return Value::string("");
+            size_t end = text.find_last_not_of(args[1].text);
+            return Value::string(text.substr(start, end - start + 1));
+        }
+        if (upper == "REGEXP_SPLIT_TO_ARRAY" && args.size() == 2) {
+            if (args[0].null()) return Value();
+            Value array;
+            array.type = Value::Type::Array;
+            std::regex separator(args[1].text);
+            const std::string& text = args[0].text;
+            std::sregex_token_iterator it(text.begin(), text.end(), separator, -1);
+            for (; it != std::sregex_token_iterator(); ++it) array.array.push_back(*it);
+            // Пустая строка даёт массив из одного пустого элемента, как в PostgreSQL
+            if (text.empty()) array.array.assign(1, "");
+            return array;
+        }
+        if (upper == "ARRAY_REMOVE" && args.size() == 2) {
+            if (args[0].null()) return Value();
+            Value array = args[0];
+            array.array.erase(std::remove(array.array.begin(), array.array.end(), args[1].text), array.array.end());
+            return array;
+        }
+        ok_ = false;
+        return Value();
+    }
+
+    std::vector<Token> tokens_;
+    const std::vector<CompiledFilter::SqlParam>& params_;
+    int first_;
+    const DbRow* row_ = nullptr;
+    size_t pos_ = 0;
+    bool ok_ = true;
+    bool tokenized_ = true;
+    int used_ = 0;
+    std::map<std::string, Value> bound_;
+};
+
+// Строки с NULL, пустыми значениями и спецсимволами LIKE и разбора тегов
+std::vector<DbRow> rows() {
+    std::vector<DbRow> result;
+
+    DbRow empty;
+    empty.name = "Empty";
+    empty.genre = "RPG";
+    result.push_back(empty);
+
+    DbRow blank = empty;
+    blank.name = "Blank";
+    blank.notes = "";
+    blank.url = "";
+    blank.tags = "";
+    blank.completed = false;
+    blank.is_favorite = false;
+    blank.is_installed = false;
+    result.push_back(blank);
+
+    DbRow messy;
+    messy.name = "100% it's_a \\game";
+    messy.genre = "Visual Novel";
+    messy.disk_space = 7.5;
+    messy.ram_usage = 15.5;
+    messy.vram_required = 4;
+    messy.notes = "заметка: 50%";
+    messy.url = "https://store.example/1";
+    messy.tags = " coop ,,indie\t, open world ,";
+    messy.rating = 0;
+    messy.completed = true;
+    messy.is_favorite = true;
+    result.push_back(messy);
+
+    DbRow separators = empty;
+    separators.name = "Separators";
+    separators.tags = " , ,";
+    separators.rating = 10;
+    separators.is_installed = true;
+    result.push_back(separators);
+
+    // Случайные игры; пустые значения в части строк хранятся как NULL
+    std::mt19937 random(31);
+    for (const Game& game : Test::randomGames(300, 30)) {
+        DbRow row;
+        row.name = game.name;
+        row.genre = game.genre;
+        row.disk_space = game.disk_space;
+        row.ram_usage = game.ram_usage;
+        row.vram_required = game.vram_required;
+        bool nulls = random() % 2;
+        if (!nulls || !game.notes.empty()) row.notes = game.notes;
+        if (!nulls || !game.url.empty()) row.url = game.url;
+        if (!nulls || !game.tags.empty()) row.tags = game.tags;
+        if (!nulls || game.rating >= 0) row.rating = game.rating;
+        if (!nulls || game.completed) row.completed = game.completed;
+        if (!nulls || game.is_favorite) row.is_favorite = game.is_favorite;
+        if (!nulls || game.is_installed) row.is_installed = game.is_installed;
+        result.push_back(row);
+    }
+    return result;
+}
+
+const char* const EXPRESSIONS[] = {
+    // Необязательные строки: NULL — то же, что пустая строка
+    "notes = \"\"",
+    "notes != \"\"",
+    "not notes ~ заметка",
+    "notes ~ \"50%\"",
+    "url = \"\"",
+    "url != \"\"",
+    "not url ^= https",
+    "url in (\"\", \"https://store.example/1\")",
+    // Оценка: NULL — "без оценки"
+    "rating = -1",
+    "rating != 5",
+    "rating < 5",
+    "rating >= 0",
+    "not rating > 3",
+    "rating <= 10 and rating != 0",
+    // Флаги: NULL — false
+    "completed",
+    "not completed",
+    "completed = false",
+    "favorite != true",
+    "installed = false or favorite",
+    // Теги: разбор строки, пустые теги и NULL
+    "tag = coop",
+    "tag != coop",
+    "not tag = indie",
+    "tag in (coop, indie, \"open world\")",
+    "tag ~ o",
+    "tag ~ \",\"",
+    "tag ~ \" \"",
+    "tag = \"\"",
+    "not tag ~ rogue",
+    // Жанр и название, спецсимволы LIKE и кавычки
+    "genre = RPG",
+    "genre != RPG",
+    "genre in (RPG, \"Visual Novel\")",
+    "name ~ \"%\"",
+    "name ~ _",
+    "name ~ \"\\\\\"",
+    "name ^= \"Game 1\"",
+    "name = \"it's\"",
+    "name != Empty",
+    // Числа
+    "disk <= 7.5",
+    "ram > 15.5 and vram < 4",
+    "disk != 0",
+    // Приоритет и неявное and
+    "favorite installed or completed",
+    "favorite not completed",
+    "not (tag = coop or notes ~ заметка) and rating >= 7",
+    "(genre = RPG or genre = Strategy) and not (url = \"\" or completed)",
+};
+
+void testLocalMatchesSql() {
+    std::vector<DbRow> all = rows();
+    for (const char* text : EXPRESSIONS) {
+        FilterExpression expression;
+        std::string error;
+        if (!FilterExpression::parse(text, expression, error)) {
+            std::fprintf(stderr, "не разобрано: %s (%s)\n", text, error.c_str());
+            CHECK(false);
+            continue;
+        }
+
+        // Параметры нумеруются с произвольного номера (перед условием — user_id)
+        const int first = 2;
+        std::vector<CompiledFilter::SqlParam> params;
+        std::string sql = expression.sqlCondition(first, params);
+        SqlInterpreter interpreter(sql, params, first);
+
+        CompactGameCollection compact;
+        for (const DbRow& row : all) compact.append(loaded(row));
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < all.size(); ++i) {
+            bool server = interpreter.where(all[i]);
+            bool local = expression.matches(loaded(all[i]));
+            if (!interpreter.ok()) break;
+            if (server != local || expression.matches(compact, i) != local) ++mismatches;
+        }
+        if (!interpreter.ok() || mismatches != 0 || interpreter.usedParams() != static_cast<int>(params.size())) {
+            std::fprintf(stderr, "%s\n  SQL: %s\n  расхождений: %zu, разбор SQL: %s\n", text, sql.c_str(),
+                         mismatches, interpreter.ok() ? "да" : "нет");
+        }
+        CHECK(interpreter.ok());
+        CHECK(mismatches == 0);
+        CHECK(interpreter.usedParams() == static_cast<int>(params.size()));
+    }
+}
+
+// Пустые значения на сервере заменяются так же, как при загрузке
+void testSqlText() {
+    auto sql = [](const char* text, std::vector<CompiledFilter::SqlParam>& params) {
+        FilterExpression expression;
+        std::string error;
+        CHECK(FilterExpression::parse(text, expression, error));
+        params.clear();
+        return expression.sqlCondition(1, params);
+    };
+    std::vector<CompiledFilter::SqlParam> params;
+    CHECK(sql("notes != x", params) == "(COALESCE(notes, '') <> $1::text)");
+    CHECK(sql("not favorite", params) == "NOT (COALESCE(is_favorite, FALSE) = $1)");
+    CHECK(sql("rating < 5", params) == "(COALESCE(rating, -1) >= 0 AND COALESCE(rating, -1) < $1)");
+    CHECK(params.size() == 1 && params[0].type == CompiledFilter::SqlParam::Type::Int && params[0].int_value == 5);
+
+    std::string tags = FilterExpression::TAGS_ARRAY_SQL;
+    CHECK(sql("tag != coop", params) == "(NOT " + tags + " && ARRAY[$1::text])");
+    CHECK(sql("tag ~ \"a_b\"", params) ==
+          "(EXISTS (SELECT 1 FROM unnest(" + tags + ") AS t(tag) WHERE t.tag LIKE $1::text))");
+    CHECK(params.size() == 1 && params[0].text_value == "%a\\_b%");
+}
+
+// Неявное and связывает сильнее or; not — сильнее and
+void testPrecedence() {
+    auto normalized = [](const char* text) {
+        FilterExpression expression;
+        std::string error;
+        CHECK(FilterExpression::parse(text, expression, error));
+        return expression.toString();
+    };
+    CHECK(normalized("favorite installed or completed") ==
+          normalized("(favorite and installed) or completed"));
+    CHECK(normalized("favorite not completed") == normalized("favorite and (not completed)"));
+    CHECK(normalized("not favorite or installed") == normalized("(not favorite) or installed"));
+    CHECK(normalized("favorite and installed or completed") !=
+          normalized("favorite and (installed or completed)"));
+}
+
+void testParseErrors() {
+    for (const char* text : {"rating >= ", "genre ~ RPG", "(favorite", "disk = big", "unknown = 1",
+                             "completed = maybe", "tag in (coop,"}) {
+        FilterExpression expression;
+        std::string error;
+        CHECK(!FilterExpression::parse(text, expression, error));
+        CHECK(!error.empty());
+    }
+}
+
+} // namespace
+
+int main() {
+    testLocalMatchesSql();
+    testSqlText();
+    testPrecedence();
+    testParseErrors();
+    return Test::result();
+}
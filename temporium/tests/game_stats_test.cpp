@@ -0,0 +1,95 @@
+#include "game_stats.h"
+#include "test_support.h"
+
+using namespace Temporium;
+
+namespace {
+
+// Эталон: те же условия, что в запросах DatabaseManager::getGameStats
+GameStats bruteForce(const std::vector<Game>& games) {
+    GameStats stats;
+    for (const Game& game : games) {
+        ++stats.total_games;
+        if (game.is_favorite) ++stats.favorites_count;
+        if (game.completed) ++stats.completed_count;
+        if (game.rating == -1) ++stats.no_rating_count;
+        if (game.is_installed) {
+            ++stats.installed_count;
+            stats.installed_disk_space += game.disk_space;
+        }
+        if (game.url.empty()) ++stats.no_url_count;
+    }
+    return stats;
+}
+
+// Размеры кратны 0.5, поэтому суммы точны и сравниваются без допуска
+bool sameStats(const GameStats& actual, const GameStats& expected) {
+    return actual.total_games == expected.total_games && actual.favorites_count == expected.favorites_count &&
+           actual.completed_count == expected.completed_count &&
+           actual.no_rating_count == expected.no_rating_count &&
+           actual.installed_count == expected.installed_count &&
+           actual.installed_disk_space == expected.installed_disk_space &&
+           actual.no_url_count == expected.no_url_count;
+}
+
+void testCompute() {
+    CHECK(sameStats(GameStatsAccumulator::compute({}), GameStats()));
+
+    std::vector<Game> games = Test::randomGames(3000, 55);
+    GameStats expected = bruteForce(games);
+    CHECK(sameStats(GameStatsAccumulator::compute(games), expected));
+
+    // Компактная коллекция даёт ту же статистику, что и вектор Game
+    CompactGameCollection collection;
+    collection.append(games);
+    GameStatsAccumulator accumulator;
+    accumulator.add(collection);
+    CHECK(sameStats(accumulator.stats(), expected));
+
+    accumulator.reset();
+    CHECK(sameStats(accumulator.stats(), GameStats()));
+}
+
+// Добавление, правка (remove старой + add новой) и удаление совпадают
+// с пересчётом после каждого шага
+void testIncremental() {
+    std::vector<Game> games = Test::randomGames(300, 56);
+    std::vector<Game> replacements = Test::randomGames(300, 57);
+    GameStatsAccumulator accumulator;
+    accumulator.add(games);
+
+    std::mt19937 random(58);
+    bool same = true;
+    for (int step = 0; step < 3000; ++step) {
+        const Game& replacement = replacements[random() % replacements.size()];
+        switch (games.empty() ? 0 : random() % 3) {
+            case 0:
+                games.push_back(replacement);
+                accumulator.add(replacement);
+                break;
+            case 1: {
+                Game& game = games[random() % games.size()];
+                accumulator.remove(game);
+                game = replacement;
+                accumulator.add(game);
+                break;
+            }
+            default: {
+                size_t index = random() % games.size();
+                accumulator.remove(games[index]);
+                games.erase(games.begin() + static_cast<std::ptrdiff_t>(index));
+                break;
+            }
+        }
+        same = same && sameStats(accumulator.stats(), bruteForce(games));
+    }
+    CHECK(same);
+}
+
+} // namespace
+
+int main() {
+    testCompute();
+    testIncremental();
+    return Test::result();
+}
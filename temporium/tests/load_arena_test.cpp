@@ -0,0 +1,91 @@
+#include "compact_game.h"
+#include "load_arena.h"
+#include "test_support.h"
+#include <algorithm>
+
+using namespace Temporium;
+
+namespace {
+
+void testCopyAndAllocate() {
+    LoadArena arena;
+    CHECK(arena.copy("") == nullptr);
+    CHECK(arena.allocate(0) == nullptr);
+    CHECK(arena.systemAllocations() == 0);
+
+    // Строки не перекрываются и не меняются при следующих выделениях
+    std::vector<std::string> texts;
+    std::vector<const char*> copies;
+    std::mt19937 random(58);
+    size_t total = 0;
+    for (int i = 0; i < 20000; ++i) {
+        texts.push_back(std::string(1 + random() % 300, static_cast<char>('a' + i % 26)) + std::to_string(i));
+        copies.push_back(arena.copy(texts.back()));
+        total += texts.back().size();
+    }
+    char* block = arena.allocate(3 * LoadArena::INITIAL_BLOCK);
+    std::fill_n(block, 3 * LoadArena::INITIAL_BLOCK, '#');
+
+    bool same = true;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        same = same && std::string_view(copies[i], texts[i].size()) == texts[i];
+    }
+    CHECK(same);
+
+    // Блоки растут геометрически: единицы системных выделений на мегабайты строк
+    CHECK(arena.bytes() >= total + 3 * LoadArena::INITIAL_BLOCK);
+    CHECK(arena.systemAllocations() > 0 && arena.systemAllocations() <= 16);
+}
+
+void testCountingResource() {
+    CountingResource counter;
+    void* first = counter.allocate(100, 8);
+    void* second = counter.allocate(28, 4);
+    CHECK(counter.allocations() == 2 && counter.bytes() == 128);
+    counter.deallocate(first, 100, 8);
+    counter.deallocate(second, 28, 4);
+    // Освобождения не уменьшают счётчики
+    CHECK(counter.allocations() == 2 && counter.bytes() == 128);
+}
+
+// Порции загрузчика присоединяются вместе с аренами: строки не копируются,
+// а число системных выделений растёт на единицы на порцию, а не на игру
+void testCollectionArenas() {
+    std::vector<Game> games = Test::randomGames(20000, 59);
+    CompactGameCollection collection;
+    std::vector<const char*> names;
+    size_t offset = 0;
+    size_t chunks = 0;
+    while (offset < games.size()) {
+        size_t end = std::min(games.size(), offset + (offset == 0 ? 100 : 2000));
+        CompactGameCollection chunk;
+        chunk.append(std::vector<Game>(games.begin() + offset, games.begin() + end));
+        for (size_t i = 0; i < chunk.size(); ++i) names.push_back(chunk.name(i).data());
+        collection.append(std::move(chunk));
+        offset = end;
+        ++chunks;
+    }
+
+    bool same = collection.size() == games.size();
+    for (size_t i = 0; same && i < games.size(); ++i) {
+        same = collection.name(i).data() == names[i] && collection.name(i) == games[i].name;
+    }
+    CHECK(same);
+    CHECK(collection.arenaAllocations() <= 4 * chunks);
+    CHECK(collection.memoryUsage() >= collection.size() * sizeof(CompactGame));
+
+    // Очистка освобождает арены целиком
+    collection.clear();
+    CHECK(collection.arenaAllocations() == 0);
+    collection.append(games[0]);
+    CHECK(collection.arenaAllocations() == 1 && collection.name(0) == games[0].name);
+}
+
+} // namespace
+
+int main() {
+    testCopyAndAllocate();
+    testCountingResource();
+    testCollectionArenas();
+    return Test::result();
+}
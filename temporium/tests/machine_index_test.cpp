@@ -0,0 +1,92 @@
+#include "machine_index.h"
+#include "test_support.h"
+
+using namespace Temporium;
+
+namespace {
+
+// Эталон: проверка каждой игры, как в DatabaseManager::countFittingGames
+std::vector<uint32_t> bruteForce(const std::vector<Game>& games, const MachineProfile& profile) {
+    std::vector<uint32_t> rows;
+    for (uint32_t i = 0; i < games.size(); ++i) {
+        const Game& game = games[i];
+        if (game.ram_usage <= profile.ram && game.vram_required <= profile.vram &&
+            game.disk_space <= profile.disk) {
+            rows.push_back(i);
+        }
+    }
+    return rows;
+}
+
+std::vector<MachineProfile> profiles() {
+    std::vector<MachineProfile> result;
+    for (unsigned ram : {0u, 4u, 7u, 8u, 16u, 31u, 64u}) {
+        for (unsigned vram : {0u, 2u, 6u, 12u, 24u}) {
+            for (unsigned disk : {0u, 10u, 50u, 99u, 200u}) {
+                MachineProfile profile;
+                profile.ram = ram;
+                profile.vram = vram;
+                profile.disk = disk;
+                result.push_back(profile);
+            }
+        }
+    }
+    return result;
+}
+
+void testAgainstBruteForce(size_t count) {
+    std::vector<Game> games = Test::randomGames(count, static_cast<uint32_t>(count));
+    CompactGameCollection compact;
+    compact.append(games);
+    MachineFitIndex index;
+    index.build(compact);
+    CHECK(index.size() == count);
+
+    std::vector<MachineProfile> all = profiles();
+    std::vector<std::vector<uint32_t>> batch = index.fits(all);
+    std::vector<size_t> batchCounts = index.count(all);
+    CHECK(batch.size() == all.size() && batchCounts.size() == all.size());
+
+    for (size_t p = 0; p < all.size(); ++p) {
+        std::vector<uint32_t> expected = bruteForce(games, all[p]);
+        CHECK(index.fits(all[p]) == expected);
+        CHECK(index.count(all[p]) == expected.size());
+        if (p < batch.size()) {
+            CHECK(batch[p] == expected);
+            CHECK(batchCounts[p] == expected.size());
+        }
+    }
+}
+
+// Дробные требования не округляются: 7.5 ГБ не помещаются в 7 ГБ
+void testFractionalBoundary() {
+    std::vector<Game> games(3);
+    games[0].ram_usage = 7.0;
+    games[1].ram_usage = 7.5;
+    games[2].ram_usage = 6.999;
+    CompactGameCollection compact;
+    compact.append(games);
+    MachineFitIndex index;
+    index.build(compact);
+
+    MachineProfile profile;
+    profile.ram = 7;
+    profile.vram = 1;
+    profile.disk = 1;
+    CHECK(index.fits(profile) == (std::vector<uint32_t>{0, 2}));
+}
+
+} // namespace
+
+int main() {
+    testAgainstBruteForce(0);
+    testAgainstBruteForce(1);
+    testAgainstBruteForce(100);
+    testAgainstBruteForce(20000);
+    testFractionalBoundary();
+
+    MachineFitIndex empty;
+    CHECK(empty.empty());
+    CHECK(empty.fits(MachineProfile()).empty());
+    return Test::result();
+}
@@ -0,0 +1,151 @@
+#include "name_dedup.h"
+#include "test_support.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+using namespace Temporium;
+
+namespace {
+
+// Множество триграмм нормализованного названия; короткое — целиком
+std::vector<std::string> trigrams(const std::string& name) {
+    std::string key = NearDuplicateDetector::normalize(name);
+    std::vector<std::string> result;
+    if (key.size() < 3) {
+        result.push_back(key);
+    } else {
+        for (size_t i = 0; i + 2 < key.size(); ++i) result.push_back(key.substr(i, 3));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+double jaccard(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+    std::vector<std::string> common;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(common));
+    size_t united = a.size() + b.size() - common.size();
+    return united == 0 ? 1.0 : static_cast<double>(common.size()) / static_cast<double>(united);
+}
+
+// Названия без подзаголовков (у них один ключ) с вариантами написания:
+// опечатка, другой номер части, артикль, регистр
+std::vector<std::string> names(size_t count, uint32_t seed) {
+    static const char* const words[] = {"dark", "souls", "legend", "star", "empire", "shadow", "city",
+                                        "dragon", "quest", "space", "rogue", "night", "crown", "forest",
+                                        "ocean", "iron", "storm", "age", "hero", "kingdom"};
+    std::mt19937 random(seed);
+    auto word = [&]() { return std::string(words[random() % (sizeof(words) / sizeof(words[0]))]); };
+    std::vector<std::string> result;
+    while (result.size() < count) {
+        std::string base = word() + " " + word();
+        if (random() % 2) base += " " + word();
+        result.push_back(base);
+        switch (random() % 5) {
+        case 0:
+            result.push_back(base + " " + std::to_string(2 + random() % 3));
+            break;
+        case 1: {
+            std::string typo = base;
+            typo.erase(1 + random() % (typo.size() - 1), 1);
+            result.push_back(typo);
+            break;
+        }
+        case 2:
+            result.push_back("The " + base);
+            break;
+        case 3: {
+            std::string upper = base;
+            for (char& c : upper) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            result.push_back(upper);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    result.resize(count);
+    return result;
+}
+
+// LSH не даёт ложных пар (сходство проверяется точно) и находит
+// почти все пары с высоким сходством
+void testAgainstBruteForce() {
+    std::vector<std::string> all = names(1200, 17);
+    NearDuplicateDetector detector;
+    detector.reserve(all.size());
+    for (const std::string& name : all) detector.add(name);
+    CHECK(detector.size() == all.size());
+
+    std::vector<std::vector<std::string>> sets;
+    for (const std::string& name : all) sets.push_back(trigrams(name));
+
+    std::map<std::pair<uint32_t, uint32_t>, double> expected;
+    for (uint32_t i = 0; i < all.size(); ++i) {
+        for (uint32_t j = i + 1; j < all.size(); ++j) {
+            double similarity = jaccard(sets[i], sets[j]);
+            if (similarity >= NearDuplicateDetector::DEFAULT_THRESHOLD) expected[{i, j}] = similarity;
+        }
+    }
+
+    std::vector<NearDuplicate> pairs = detector.findPairs();
+    for (const NearDuplicate& pair : pairs) {
+        CHECK(pair.first < pair.second);
+        auto it = expected.find({pair.first, pair.second});
+        CHECK(it != expected.end());
+        if (it != expected.end()) CHECK(std::fabs(it->second - pair.similarity) < 1e-12);
+    }
+
+    size_t strong = 0;
+    size_t strongFound = 0;
+    std::map<std::pair<uint32_t, uint32_t>, bool> found;
+    for (const NearDuplicate& pair : pairs) found[{pair.first, pair.second}] = true;
+    for (const auto& entry : expected) {
+        if (entry.second < 0.8) continue;
+        ++strong;
+        if (found.count(entry.first)) ++strongFound;
+    }
+    CHECK(strong > 0);
+    // Вероятность пропуска пары со сходством 0.8 — около 1e-4
+    CHECK(strongFound + strong / 100 >= strong);
+    CHECK(static_cast<double>(pairs.size()) >= 0.85 * static_cast<double>(expected.size()));
+
+    // Проверка только новых названий — подмножество полного ответа
+    uint32_t firstChecked = static_cast<uint32_t>(all.size() - 100);
+    std::vector<NearDuplicate> recent = detector.findPairs(firstChecked);
+    for (const NearDuplicate& pair : recent) {
+        CHECK(pair.second >= firstChecked);
+        CHECK(found.count({pair.first, pair.second}));
+    }
+    size_t recentExpected = 0;
+    for (const NearDuplicate& pair : pairs) {
+        if (pair.second >= firstChecked) ++recentExpected;
+    }
+    CHECK(recent.size() == recentExpected);
+}
+
+void testNormalization() {
+    CHECK(NearDuplicateDetector::normalize("The Witcher III") == "witcher3");
+    CHECK(NearDuplicateDetector::normalize("WITCHER 3") == "witcher3");
+    CHECK(NearDuplicateDetector::normalize("Ведьмак Ёлка") == "ведьмакелка");
+
+    // Основная часть названия с подзаголовком сравнивается отдельно
+    NearDuplicateDetector detector;
+    detector.add("The Witcher 3");
+    detector.add("Witcher 3: Wild Hunt");
+    detector.add("Heroes of Might and Magic");
+    std::vector<NearDuplicate> pairs = detector.findPairs();
+    CHECK(pairs.size() == 1);
+    if (pairs.size() == 1) {
+        CHECK(pairs[0].first == 0 && pairs[0].second == 1 && pairs[0].similarity == 1.0);
+    }
+}
+
+} // namespace
+
+int main() {
+    testAgainstBruteForce();
+    testNormalization();
+    return Test::result();
+}
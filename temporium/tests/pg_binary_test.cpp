@@ -0,0 +1,107 @@
+#include "pg_binary.h"
+#include "test_support.h"
+#include <cmath>
+#include <limits>
+
+using namespace Temporium;
+
+namespace {
+
+// Эталонная запись в сетевом порядке байт, как её отдаёт сервер
+std::string bigEndian(uint64_t value, size_t size) {
+    std::string bytes(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        bytes[size - 1 - i] = static_cast<char>(value & 0xff);
+        value >>= 8;
+    }
+    return bytes;
+}
+
+std::string int4Bytes(int32_t value) {
+    return bigEndian(static_cast<uint32_t>(value), 4);
+}
+
+std::string float8Bytes(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bigEndian(bits, 8);
+}
+
+bool throws(const std::string& bytes, int type) {
+    try {
+        if (type == 0) PgBinary::int4(bytes.data(), bytes.size());
+        if (type == 1) PgBinary::float8(bytes.data(), bytes.size());
+        if (type == 2) PgBinary::boolean(bytes.data(), bytes.size());
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+void testInt4() {
+    std::string bytes("\x00\x00\x01\x02", 4);
+    CHECK(PgBinary::int4(bytes.data(), bytes.size()) == 258);
+    bytes = std::string("\xff\xff\xff\xff", 4);
+    CHECK(PgBinary::int4(bytes.data(), bytes.size()) == -1);
+
+    std::mt19937 random(73);
+    std::vector<int32_t> values = {0, 1, -1, 255, 256, -256, std::numeric_limits<int32_t>::min(),
+                                   std::numeric_limits<int32_t>::max()};
+    for (int i = 0; i < 1000; ++i) values.push_back(static_cast<int32_t>(random()));
+    bool same = true;
+    for (int32_t value : values) {
+        bytes = int4Bytes(value);
+        same = same && PgBinary::int4(bytes.data(), bytes.size()) == value;
+    }
+    CHECK(same);
+}
+
+void testFloat8() {
+    std::string bytes("\x3f\xf8\x00\x00\x00\x00\x00\x00", 8);
+    CHECK(PgBinary::float8(bytes.data(), bytes.size()) == 1.5);
+
+    std::mt19937_64 random(74);
+    std::vector<double> values = {0.0, 0.5, -2.25, 1e-300, 1e300, std::numeric_limits<double>::max(),
+                                  std::numeric_limits<double>::denorm_min(),
+                                  std::numeric_limits<double>::infinity()};
+    std::uniform_real_distribution<double> distribution(-1e6, 1e6);
+    for (int i = 0; i < 1000; ++i) values.push_back(distribution(random));
+    bool same = true;
+    for (double value : values) {
+        bytes = float8Bytes(value);
+        same = same && PgBinary::float8(bytes.data(), bytes.size()) == value;
+    }
+    CHECK(same);
+
+    // Знак нуля и NaN сохраняются побитово
+    bytes = float8Bytes(-0.0);
+    CHECK(std::signbit(PgBinary::float8(bytes.data(), bytes.size())));
+    bytes = float8Bytes(std::numeric_limits<double>::quiet_NaN());
+    CHECK(std::isnan(PgBinary::float8(bytes.data(), bytes.size())));
+}
+
+void testBoolean() {
+    CHECK(PgBinary::boolean("\x01", 1));
+    CHECK(!PgBinary::boolean("\x00", 1));
+}
+
+// Поле другого размера (сменили тип столбца) — ошибка, а не мусор
+void testSizeMismatch() {
+    CHECK(throws("", 0));
+    CHECK(throws(std::string(8, '\0'), 0));
+    CHECK(throws(int4Bytes(1), 1));
+    CHECK(throws("1.5", 1));
+    CHECK(throws(std::string(4, '\0'), 2));
+    CHECK(throws("t", 0));
+    CHECK(!throws(int4Bytes(7), 0) && !throws(float8Bytes(7), 1) && !throws("t", 2));
+}
+
+} // namespace
+
+int main() {
+    testInt4();
+    testFloat8();
+    testBoolean();
+    testSizeMismatch();
+    return Test::result();
+}
@@ -0,0 +1,235 @@
+#include "rpc_protocol.h"
+#include "test_support.h"
+#include <cmath>
+#include <limits>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace Temporium;
+
+namespace {
+
+bool sameGame(const Game& a, const Game& b) {
+    return a.id == b.id && a.user_id == b.user_id && a.name == b.name && a.genre == b.genre &&
+           a.disk_space == b.disk_space && a.ram_usage == b.ram_usage &&
+           a.vram_required == b.vram_required && a.completed == b.completed && a.url == b.url &&
+           a.rating == b.rating && a.is_favorite == b.is_favorite && a.is_installed == b.is_installed &&
+           a.notes == b.notes && a.tags == b.tags;
+}
+
+void testScalars() {
+    RpcWriter out;
+    out.u8(0xAB);
+    out.u16(0xBEEF);
+    out.u32(0xDEADBEEFu);
+    out.u64(0x0123456789ABCDEFull);
+    out << -7 << true << 7.25 << -0.0 << std::numeric_limits<double>::max() << std::string("текст")
+        << std::string();
+
+    RpcReader in(out.buffer());
+    CHECK(in.u8() == 0xAB);
+    CHECK(in.u16() == 0xBEEF);
+    CHECK(in.u32() == 0xDEADBEEFu);
+    CHECK(in.u64() == 0x0123456789ABCDEFull);
+    int negative = 0;
+    bool flag = false;
+    double fraction = 0;
+    double negativeZero = 0;
+    double largest = 0;
+    std::string text;
+    std::string empty = "x";
+    in >> negative >> flag >> fraction >> negativeZero >> largest >> text >> empty;
+    CHECK(negative == -7);
+    CHECK(flag);
+    CHECK(fraction == 7.25);
+    CHECK(negativeZero == 0.0 && std::signbit(negativeZero));
+    CHECK(largest == std::numeric_limits<double>::max());
+    CHECK(text == "текст");
+    CHECK(empty.empty());
+    CHECK(in.ok() && in.atEnd());
+}
+
+void testValues() {
+    std::vector<Game> games = Test::randomGames(200, 7);
+    games[0].disk_space = 7.3;          // Не представимо в float: должно прийти точно
+    games[0].name = std::string("a\0b", 3);
+
+    GameFilter filter;
+    filter.filter_genre = true;
+    filter.genre_value = "RPG";
+    filter.filter_ram_max = true;
+    filter.ram_max = 15.5;
+    filter.filter_has_rating = true;
+    filter.has_rating_value = true;
+
+    FilterExpression expression;
+    std::string error;
+    CHECK(FilterExpression::parse("genre in (RPG, Strategy) and not tag ~ coop", expression, error));
+
+    std::map<std::string, int> counts = {{"coop", 3}, {"indie", 1}};
+    CompactGameCollection compact;
+    compact.append(games);
+
+    RpcWriter out;
+    out << games << filter << &expression << static_cast<const GameFilter*>(nullptr) << counts << compact
+        << std::make_tuple(true, 42);
+
+    RpcReader in(out.buffer());
+    std::vector<Game> gamesBack;
+    GameFilter filterBack;
+    bool hasExpression = false;
+    FilterExpression expressionBack;
+    bool hasFilter = true;
+    std::map<std::string, int> countsBack;
+    CompactGameCollection compactBack;
+    std::tuple<bool, int> pair;
+    in >> gamesBack >> filterBack >> hasExpression >> expressionBack >> hasFilter >> countsBack >> compactBack
+       >> pair;
+    CHECK(in.ok() && in.atEnd());
+
+    CHECK(gamesBack.size() == games.size());
+    for (size_t i = 0; i < games.size() && i < gamesBack.size(); ++i) {
+        CHECK(sameGame(games[i], gamesBack[i]));
+    }
+    CHECK(filterBack.filter_genre && filterBack.genre_value == "RPG");
+    CHECK(filterBack.filter_ram_max && filterBack.ram_max == 15.5);
+    CHECK(filterBack.filter_has_rating && filterBack.has_rating_value);
+    CHECK(!filterBack.filter_completed && !filterBack.filter_tag);
+    CHECK(hasExpression && expressionBack.toString() == expression.toString());
+    CHECK(!hasFilter);
+    CHECK(countsBack == counts);
+    CHECK(compactBack.size() == compact.size());
+    for (size_t i = 0; i < compact.size() && i < compactBack.size(); ++i) {
+        CHECK(sameGame(compact.toGame(i), compactBack.toGame(i)));
+    }
+    CHECK(std::get<0>(pair) && std::get<1>(pair) == 42);
+}
+
+// Любой обрезанный буфер должен сбросить ok(), а не прочитать мусор
+void testTruncated() {
+    std::vector<Game> games = Test::randomGames(3, 11);
+    RpcWriter out;
+    out << games;
+    const std::string& full = out.buffer();
+    for (size_t length = 0; length < full.size(); ++length) {
+        RpcReader in(full.data(), length);
+        std::vector<Game> back;
+        in >> back;
+        if (in.ok()) {
+            CHECK(!"обрезанный буфер прочитан без ошибки");
+            break;
+        }
+    }
+}
+
+void testMalformed() {
+    // Длина вектора больше остатка буфера: ошибка без огромного выделения
+    {
+        RpcWriter out;
+        out.u32(0xFFFFFFF0u);
+        RpcReader in(out.buffer());
+        std::vector<Game> games;
+        in >> games;
+        CHECK(!in.ok());
+        CHECK(games.empty());
+    }
+    // Длина строки больше остатка
+    {
+        RpcWriter out;
+        out.u32(100);
+        out.u8('x');
+        RpcReader in(out.buffer());
+        CHECK(in.bytes().empty());
+        CHECK(!in.ok());
+    }
+    // Неизвестное значение перечисления
+    {
+        RpcWriter out;
+        out.u8(200);
+        RpcReader in(out.buffer());
+        AggregateGroup group;
+        in >> group;
+        CHECK(!in.ok());
+    }
+    // Выражение, которое не разбирается
+    {
+        RpcWriter out;
+        out << std::string("rating >= and (");
+        RpcReader in(out.buffer());
+        FilterExpression expression;
+        in >> expression;
+        CHECK(!in.ok());
+    }
+    // После ошибки значения читаются нулевыми
+    {
+        RpcWriter out;
+        out.u8(1);
+        RpcReader in(out.buffer());
+        in.u32();
+        CHECK(!in.ok());
+        CHECK(in.u8() == 0);
+        CHECK(in.f64() == 0.0);
+    }
+}
+
+void testFrames() {
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    std::string error;
+
+    RpcWriter out;
+    out.beginFrame(77, 0);
+    out << RpcOp::UserExists << std::string("player");
+    out << RpcOp::GetUserTags << 5;
+    out.setFrameCount(2);
+    out.finishFrame();
+    CHECK(rpcSendFrame(fds[0], out.buffer(), error));
+
+    std::string frame;
+    CHECK(rpcReadFrame(fds[1], frame, error));
+    CHECK(frame.size() + 4 == out.size());
+    RpcReader in(frame);
+    CHECK(in.u32() == 77);
+    CHECK(in.u16() == 2);
+    std::string name;
+    int userId = 0;
+    CHECK(static_cast<RpcOp>(in.u16()) == RpcOp::UserExists);
+    in >> name;
+    CHECK(static_cast<RpcOp>(in.u16()) == RpcOp::GetUserTags);
+    in >> userId;
+    CHECK(in.ok() && in.atEnd());
+    CHECK(name == "player" && userId == 5);
+
+    // Слишком длинный кадр отвергается по заголовку
+    RpcWriter huge;
+    huge.u32(RPC_MAX_FRAME + 1);
+    CHECK(rpcSendFrame(fds[0], huge.buffer(), error));
+    error.clear();
+    CHECK(!rpcReadFrame(fds[1], frame, error));
+    CHECK(error.find("too large") != std::string::npos);
+
+    // Соединение закрыто посреди кадра
+    std::string half = out.buffer().substr(0, out.size() / 2);
+    CHECK(rpcSendFrame(fds[0], half, error));
+    close(fds[0]);
+    error.clear();
+    CHECK(!rpcReadFrame(fds[1], frame, error));
+    CHECK(error.find("middle of a frame") != std::string::npos);
+
+    // Закрытие между кадрами — без текста ошибки
+    error.clear();
+    CHECK(!rpcReadFrame(fds[1], frame, error));
+    CHECK(error.empty());
+    close(fds[1]);
+}
+
+} // namespace
+
+int main() {
+    testScalars();
+    testValues();
+    testTruncated();
+    testMalformed();
+    testFrames();
+    return Test::result();
+}
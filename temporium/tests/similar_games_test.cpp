@@ -0,0 +1,119 @@
+#include "similar_games.h"
+#include "test_support.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Temporium;
+
+namespace {
+
+// Признаки игры, как в индексе: теги и отдельно жанр
+std::vector<std::string> features(const CompactGameCollection& games, size_t row) {
+    std::vector<std::string> result;
+    for (uint16_t t = 0; t < games.at(row).tags_count; ++t) {
+        result.push_back("tag:" + std::string(games.tag(row, t)));
+    }
+    result.push_back("genre:" + std::string(games.genre(row)));
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+double jaccard(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+    std::vector<std::string> common;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(common));
+    return static_cast<double>(common.size()) / static_cast<double>(a.size() + b.size() - common.size());
+}
+
+// Эталонная оценка: 0.75 — сходство признаков, 0.25 — близость
+// требований в логарифмической шкале
+double score(const Game& a, const Game& b, double tagsSimilarity) {
+    auto distance = [](double x, double y) {
+        return std::min(std::fabs(std::log2(1.0 + x) - std::log2(1.0 + y)) / 8.0, 1.0);
+    };
+    double hardware = 1.0 - (distance(a.ram_usage, b.ram_usage) + distance(a.vram_required, b.vram_required) +
+                             distance(a.disk_space, b.disk_space)) / 3.0;
+    return 0.75 * tagsSimilarity + 0.25 * hardware;
+}
+
+// Каждая найденная игра оценена точно, а игра с сильно совпадающими
+// признаками, не попавшая в ответ, оценена не выше последней в ответе
+void testAgainstBruteForce() {
+    std::vector<Game> games = Test::randomGames(3000, 21);
+    CompactGameCollection compact;
+    compact.append(games);
+    SimilarGamesIndex index;
+    index.build(compact);
+    CHECK(!index.empty());
+
+    std::vector<std::vector<std::string>> sets;
+    for (size_t i = 0; i < compact.size(); ++i) sets.push_back(features(compact, i));
+
+    const size_t k = SimilarGamesIndex::DEFAULT_RESULTS;
+    for (uint32_t row = 0; row < compact.size(); row += 37) {
+        std::vector<SimilarGame> result = index.similar(row, k);
+        CHECK(result.size() <= k);
+        for (size_t i = 0; i < result.size(); ++i) {
+            CHECK(result[i].row != row);
+            double tags = jaccard(sets[row], sets[result[i].row]);
+            CHECK(std::fabs(result[i].tags_similarity - tags) < 1e-12);
+            CHECK(std::fabs(result[i].score - score(games[row], games[result[i].row], tags)) < 1e-12);
+            if (i > 0) CHECK(result[i - 1].score >= result[i].score);
+        }
+
+        std::vector<bool> listed(compact.size(), false);
+        for (const SimilarGame& game : result) listed[game.row] = true;
+        double lowest = result.size() == k ? result.back().score : -1.0;
+        for (uint32_t other = 0; other < compact.size(); ++other) {
+            if (other == row || listed[other]) continue;
+            double tags = jaccard(sets[row], sets[other]);
+            if (tags < 0.75) continue;
+            // Похожая игра пропущена только потому, что ответ заполнен лучшими
+            CHECK(lowest >= score(games[row], games[other], tags) - 1e-12);
+        }
+    }
+
+    CHECK(index.rowOf(games[5].id) == 5);
+    CHECK(index.rowOf(-1) == -1);
+    CHECK(index.similar(static_cast<uint32_t>(compact.size()), k).empty());
+    CHECK(index.similar(0, 0).empty());
+}
+
+// Одинаковые теги и требования — полное сходство
+void testIdentical() {
+    std::vector<Game> games(3);
+    for (Game& game : games) {
+        game.genre = "RPG";
+        game.tags = "coop, story";
+        game.ram_usage = 8;
+        game.vram_required = 4;
+        game.disk_space = 50.5;
+    }
+    games[0].id = 1;
+    games[1].id = 2;
+    games[2].id = 3;
+    games[2].genre = "Puzzle";
+    games[2].tags = "pixel art";
+    CompactGameCollection compact;
+    compact.append(games);
+    SimilarGamesIndex index;
+    index.build(compact);
+
+    std::vector<SimilarGame> result = index.similar(0, 5);
+    CHECK(!result.empty());
+    if (!result.empty()) {
+        CHECK(result[0].row == 1);
+        CHECK(result[0].score == 1.0 && result[0].tags_similarity == 1.0);
+    }
+    for (const SimilarGame& game : result) {
+        if (game.row == 2) CHECK(game.tags_similarity == 0.0);
+    }
+}
+
+} // namespace
+
+int main() {
+    testAgainstBruteForce();
+    testIdentical();
+    return Test::result();
+}
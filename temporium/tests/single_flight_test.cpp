@@ -0,0 +1,132 @@
+#include "single_flight.h"
+#include "test_support.h"
+#include <thread>
+
+using namespace Temporium;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Wait = SingleFlight::Flight::Wait;
+
+// Одновременные одинаковые запросы: ведущий один, остальные получают
+// все его части по порядку и итог
+void testCoalescing() {
+    SingleFlight flights(1s, 1 << 20);
+    constexpr int THREADS = 16;
+    constexpr int PARTS = 5;
+    std::atomic<int> leaders{0};
+    std::atomic<int> complete{0};
+    std::atomic<bool> started{false};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&]() {
+            while (!started.load()) std::this_thread::yield();
+            bool leader = false;
+            auto flight = flights.join("query", leader);
+            if (leader) {
+                ++leaders;
+                for (int p = 0; p < PARTS; ++p) {
+                    std::this_thread::sleep_for(2ms);
+                    flights.append("query", flight, std::string(10, static_cast<char>('a' + p)));
+                }
+                flights.finish("query", flight, "done", true);
+                ++complete;
+                return;
+            }
+            std::string part;
+            size_t index = 0;
+            bool inOrder = true;
+            while (flight->part(index, part, 5s) == Wait::Ready) {
+                inOrder = inOrder && part == std::string(10, static_cast<char>('a' + index));
+                ++index;
+            }
+            std::string result;
+            if (inOrder && index == PARTS && flight->result(result, 5s) && result == "done") {
+                ++complete;
+            }
+        });
+    }
+    started = true;
+    for (std::thread& thread : threads) thread.join();
+
+    CHECK(complete.load() == THREADS);
+    CHECK(static_cast<int>(flights.coalesced()) == THREADS - leaders.load());
+    // Запросы могли разойтись во времени, но не все выполниться сами
+    CHECK(leaders.load() >= 1 && leaders.load() < THREADS);
+}
+
+void testTtl() {
+    SingleFlight flights(50ms, 1 << 20);
+    bool leader = false;
+    auto flight = flights.join("key", leader);
+    CHECK(leader);
+    flights.finish("key", flight, "value", true);
+
+    // Повтор в пределах ttl получает готовый ответ
+    auto again = flights.join("key", leader);
+    CHECK(!leader);
+    std::string result;
+    CHECK(again->result(result, 0ms) && result == "value");
+
+    std::this_thread::sleep_for(80ms);
+    flights.join("key", leader);
+    CHECK(leader);
+}
+
+void testNotReusable() {
+    SingleFlight flights(1s, 1 << 20);
+    bool leader = false;
+    auto flight = flights.join("error", leader);
+    flights.finish("error", flight, "failed", false);
+    flights.join("error", leader);
+    CHECK(leader);
+}
+
+// Ответ больше предела не хранится: к нему нельзя присоединиться
+void testRetainLimit() {
+    SingleFlight flights(1s, 1000);
+    bool leader = false;
+    auto flight = flights.join("big", leader);
+    flights.append("big", flight, std::string(2000, 'x'));
+    bool secondLeader = false;
+    auto second = flights.join("big", secondLeader);
+    CHECK(secondLeader);
+    CHECK(second != flight);
+    flights.finish("big", flight, "r", true);
+    flights.finish("big", second, "r", true);
+}
+
+// Присоединившийся, не дождавшийся ответа, уходит; после этого ведущий,
+// потерявший клиента, может прервать запрос
+void testLeaveAndAbandon() {
+    SingleFlight flights(1s, 1 << 20);
+    bool leader = false;
+    auto flight = flights.join("slow", leader);
+    bool followerLeader = true;
+    auto follower = flights.join("slow", followerLeader);
+    CHECK(!followerLeader);
+
+    std::string part;
+    CHECK(follower->part(0, part, 10ms) == Wait::TimedOut);
+    CHECK(!flights.abandon("slow", flight));
+    flights.leave(follower);
+    CHECK(flights.abandon("slow", flight));
+
+    // Прерванный запрос больше не находится по ключу
+    flights.join("slow", leader);
+    CHECK(leader);
+    flights.finish("slow", flight, "", false);
+}
+
+} // namespace
+
+int main() {
+    testCoalescing();
+    testTtl();
+    testNotReusable();
+    testRetainLimit();
+    testLeaveAndAbandon();
+    return Test::result();
+}
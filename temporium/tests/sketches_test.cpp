@@ -0,0 +1,132 @@
+#include "sketches.h"
+#include "hash_utils.h"
+#include "test_support.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+using namespace Temporium;
+
+namespace {
+
+// Частоты по закону Ципфа: немного частых ключей и длинный хвост
+std::vector<uint64_t> zipfStream(size_t keys, size_t length, uint32_t seed) {
+    std::vector<double> weights(keys);
+    for (size_t i = 0; i < keys; ++i) weights[i] = 1.0 / static_cast<double>(i + 1);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    std::mt19937 random(seed);
+    std::vector<uint64_t> stream(length);
+    for (uint64_t& key : stream) key = pick(random);
+    return stream;
+}
+
+// Оценка count-min никогда не меньше точной частоты и превышает её
+// больше чем на epsilon * total не чаще, чем с вероятностью delta
+void testCountMin() {
+    CountMinSketch sketch(1024, 5);
+    std::unordered_map<uint64_t, int64_t> exact;
+    for (uint64_t key : zipfStream(20000, 200000, 1)) {
+        sketch.add(HashUtils::mix(key));
+        ++exact[key];
+    }
+    // Удаления: частоты остаются неотрицательными
+    std::mt19937 random(2);
+    for (auto& entry : exact) {
+        int64_t removed = static_cast<int64_t>(random() % (entry.second + 1));
+        sketch.add(HashUtils::mix(entry.first), -removed);
+        entry.second -= removed;
+    }
+
+    int64_t total = 0;
+    for (const auto& entry : exact) total += entry.second;
+    CHECK(sketch.total() == total);
+
+    double bound = sketch.epsilon() * static_cast<double>(sketch.total());
+    size_t underestimates = 0;
+    size_t outside = 0;
+    for (const auto& entry : exact) {
+        int64_t estimate = sketch.estimate(HashUtils::mix(entry.first));
+        if (estimate < entry.second) ++underestimates;
+        if (static_cast<double>(estimate - entry.second) > bound) ++outside;
+    }
+    CHECK(underestimates == 0);
+    // Запас в два раза от delta: ключей много, доля случайна
+    CHECK(static_cast<double>(outside) <= 2.0 * sketch.delta() * static_cast<double>(exact.size()) + 1);
+
+    std::string data;
+    sketch.serialize(data);
+    CountMinSketch copy(16, 1);
+    size_t offset = 0;
+    CHECK(copy.deserialize(data, offset) && offset == data.size());
+    CHECK(copy.total() == sketch.total());
+    for (uint64_t key = 0; key < 100; ++key) {
+        CHECK(copy.estimate(HashUtils::mix(key)) == sketch.estimate(HashUtils::mix(key)));
+    }
+    offset = 0;
+    CHECK(!copy.deserialize(data.substr(0, data.size() / 2), offset));
+}
+
+// Оценка HyperLogLog в пределах четырёх стандартных ошибок от точного
+// числа различных ключей — и на малых (линейный подсчёт), и на больших
+void testHyperLogLog() {
+    for (size_t distinct : {0u, 10u, 1000u, 50000u, 500000u}) {
+        HyperLogLog hll;
+        for (size_t i = 0; i < distinct; ++i) {
+            hll.add(HashUtils::mix(i));
+            hll.add(HashUtils::mix(i));     // Повторы не учитываются
+        }
+        double error = std::fabs(hll.estimate() - static_cast<double>(distinct));
+        CHECK(error <= 4.0 * hll.standardError() * static_cast<double>(distinct) + 1.0);
+
+        std::string data;
+        hll.serialize(data);
+        HyperLogLog copy(4);
+        size_t offset = 0;
+        CHECK(copy.deserialize(data, offset));
+        CHECK(copy.estimate() == hll.estimate());
+    }
+}
+
+// Самые частые названия совпадают с точным подсчётом; варианты
+// написания считаются одним названием
+void testMostCommon() {
+    GameNameSketch sketch;
+    std::unordered_map<uint64_t, int64_t> exact;
+    for (uint64_t key : zipfStream(5000, 100000, 3)) {
+        sketch.add("Game " + std::to_string(key));
+        ++exact[key];
+    }
+    sketch.add("The Witcher 3", 10000);
+    sketch.add("witcher III", 10000);
+
+    std::vector<std::pair<int64_t, uint64_t>> sorted;
+    for (const auto& entry : exact) sorted.emplace_back(entry.second, entry.first);
+    std::sort(sorted.rbegin(), sorted.rend());
+
+    std::vector<GameNameSketch::Frequent> top = sketch.mostCommon(6);
+    CHECK(top.size() == 6);
+    if (top.size() == 6) {
+        CHECK(top[0].name == "The Witcher 3" && top[0].estimate >= 20000);
+        for (size_t i = 1; i < top.size(); ++i) {
+            CHECK(top[i].name == "Game " + std::to_string(sorted[i - 1].second));
+            CHECK(top[i].estimate >= sorted[i - 1].first);
+        }
+    }
+
+    GameNameSketch copy;
+    CHECK(copy.deserialize(sketch.serialize()));
+    std::vector<GameNameSketch::Frequent> copyTop = copy.mostCommon(6);
+    CHECK(copyTop.size() == top.size());
+    for (size_t i = 0; i < top.size() && i < copyTop.size(); ++i) {
+        CHECK(copyTop[i].name == top[i].name && copyTop[i].estimate == top[i].estimate);
+    }
+}
+
+} // namespace
+
+int main() {
+    testCountMin();
+    testHyperLogLog();
+    testMostCommon();
+    return Test::result();
+}
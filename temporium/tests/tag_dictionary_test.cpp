@@ -0,0 +1,131 @@
+#include "tag_dictionary.h"
+#include "test_support.h"
+
+using namespace Temporium;
+
+namespace {
+
+// Эталон: счётчики, пересчитанные по текущим строкам тегов всех игр
+std::map<std::string, int> recount(const std::vector<std::string>& collection) {
+    std::map<std::string, int> counts;
+    for (const std::string& tags : collection) {
+        for (const std::string& tag : TagDictionary::split(tags)) ++counts[tag];
+    }
+    return counts;
+}
+
+std::string randomTags(std::mt19937& random) {
+    static const char* const tags[] = {"coop", "indie", "open world", "story", "horror", "retro"};
+    static const char* const separators[] = {", ", ",", " , ", ",  \t"};
+    std::string result = random() % 4 == 0 ? " " : "";
+    size_t count = random() % 4;
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) result += separators[random() % 4];
+        result += tags[random() % 6];
+    }
+    if (random() % 5 == 0) result += ",";
+    return result;
+}
+
+// Обновления по разнице совпадают с пересчётом после каждой правки
+void testAgainstRecount() {
+    std::mt19937 random(41);
+    std::vector<std::string> collection;
+    for (int i = 0; i < 50; ++i) collection.push_back(randomTags(random));
+
+    TagDictionary dictionary;
+    dictionary.assign(recount(collection));
+
+    for (int step = 0; step < 5000; ++step) {
+        std::vector<std::string> before = dictionary.tags();
+        std::string oldTags;
+        std::string newTags;
+        switch (random() % 3) {
+            case 0:
+                newTags = randomTags(random);
+                collection.push_back(newTags);
+                break;
+            case 1:
+                if (collection.empty()) continue;
+                {
+                    size_t index = random() % collection.size();
+                    oldTags = collection[index];
+                    newTags = randomTags(random);
+                    collection[index] = newTags;
+                }
+                break;
+            default:
+                if (collection.empty()) continue;
+                {
+                    size_t index = random() % collection.size();
+                    oldTags = collection[index];
+                    collection.erase(collection.begin() + static_cast<std::ptrdiff_t>(index));
+                }
+                break;
+        }
+
+        bool changed = dictionary.applyChange(oldTags, newTags);
+        std::map<std::string, int> counts = recount(collection);
+        std::vector<std::string> tags;
+        bool same = true;
+        for (const auto& entry : counts) {
+            tags.push_back(entry.first);
+            same = same && dictionary.count(entry.first) == entry.second && dictionary.contains(entry.first);
+        }
+        CHECK(same);
+        CHECK(dictionary.tags() == tags);
+        // true — только если изменился набор тегов
+        CHECK(changed == (before != tags));
+    }
+}
+
+void testAssign() {
+    TagDictionary dictionary;
+    dictionary.assign({{"coop", 2}, {"empty", 0}, {"indie", 1}});
+    CHECK(dictionary.tags() == std::vector<std::string>({"coop", "indie"}));
+    CHECK(!dictionary.contains("empty"));
+    CHECK(dictionary.count("missing") == 0);
+
+    // Удаление тега, которого нет в словаре, не портит счётчики
+    CHECK(!dictionary.applyChange("unknown", ""));
+    CHECK(dictionary.applyChange("coop, indie", "coop"));
+    CHECK(dictionary.count("coop") == 2 && !dictionary.contains("indie"));
+
+    dictionary.clear();
+    CHECK(dictionary.tags().empty());
+}
+
+void testSplitAndCanonical() {
+    CHECK(TagDictionary::split("").empty());
+    CHECK(TagDictionary::split(" , ,\t,").empty());
+    CHECK(TagDictionary::split("a") == std::vector<std::string>({"a"}));
+    CHECK(TagDictionary::split(" open world ,coop,, \tindie\t") ==
+          std::vector<std::string>({"open world", "coop", "indie"}));
+
+    CHECK(TagDictionary::canonical("") == "");
+    CHECK(TagDictionary::canonical(" , ") == "");
+    CHECK(TagDictionary::canonical("coop,indie") == "coop, indie");
+    CHECK(TagDictionary::canonical("  open world , , story,") == "open world, story");
+    // Каноническая форма не меняется при повторном приведении
+    std::mt19937 random(42);
+    for (int i = 0; i < 500; ++i) {
+        std::string tags = randomTags(random);
+        std::string canonical = TagDictionary::canonical(tags);
+        CHECK(TagDictionary::canonical(canonical) == canonical);
+        CHECK(TagDictionary::split(canonical) == TagDictionary::split(tags));
+    }
+
+    // Перегрузка с буфером очищает его
+    std::string buffer = "old";
+    TagDictionary::canonical("a ,b", buffer);
+    CHECK(buffer == "a, b");
+}
+
+} // namespace
+
+int main() {
+    testAgainstRecount();
+    testAssign();
+    testSplitAndCanonical();
+    return Test::result();
+}
@@ -0,0 +1,107 @@
+#include "task_scheduler.h"
+#include "test_support.h"
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+using namespace Temporium;
+
+namespace {
+
+// Каждый индекс обрабатывается ровно один раз, сумма совпадает с последовательной
+void testParallelFor() {
+    for (size_t n : {0u, 1u, 7u, 1000u, 1000000u}) {
+        std::vector<std::atomic<int>> visits(n);
+        std::atomic<uint64_t> sum{0};
+        parallelFor(0, n, 1024, [&](size_t lo, size_t hi) {
+            uint64_t local = 0;
+            for (size_t i = lo; i < hi; ++i) {
+                ++visits[i];
+                local += i;
+            }
+            sum += local;
+        });
+        bool once = true;
+        for (const std::atomic<int>& count : visits) once = once && count.load() == 1;
+        CHECK(once);
+        CHECK(sum.load() == (n == 0 ? 0 : uint64_t(n) * (n - 1) / 2));
+    }
+}
+
+// Вложенные группы внутри задач не блокируют пул
+void testNested() {
+    constexpr size_t OUTER = 64;
+    constexpr size_t INNER = 10000;
+    std::vector<uint64_t> sums(OUTER, 0);
+    TaskGroup group;
+    for (size_t i = 0; i < OUTER; ++i) {
+        group.run([&sums, i]() {
+            std::atomic<uint64_t> sum{0};
+            parallelFor(0, INNER, 100, [&sum](size_t lo, size_t hi) {
+                uint64_t local = 0;
+                for (size_t j = lo; j < hi; ++j) local += j;
+                sum += local;
+            });
+            sums[i] = sum.load();
+        });
+    }
+    group.wait();
+    for (uint64_t sum : sums) CHECK(sum == uint64_t(INNER) * (INNER - 1) / 2);
+}
+
+void testExceptions() {
+    TaskGroup group;
+    std::atomic<int> finished{0};
+    for (int i = 0; i < 32; ++i) {
+        group.run([i, &finished]() {
+            if (i == 13) throw std::runtime_error("task failed");
+            ++finished;
+        });
+    }
+    bool caught = false;
+    try {
+        group.wait();
+    } catch (const std::runtime_error& error) {
+        caught = std::string(error.what()) == "task failed";
+    }
+    CHECK(caught);
+    // Остальные задачи группы всё равно выполнены
+    CHECK(finished.load() == 31);
+}
+
+// Эталон — std::stable_sort: порядок равных ключей сохраняется
+void testStableSort() {
+    std::mt19937 random(8);
+    std::vector<std::pair<int, uint32_t>> data(300000);
+    for (uint32_t i = 0; i < data.size(); ++i) data[i] = {static_cast<int>(random() % 1000), i};
+    std::vector<std::pair<int, uint32_t>> expected = data;
+    auto byKey = [](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) {
+        return a.first < b.first;
+    };
+    std::stable_sort(expected.begin(), expected.end(), byKey);
+    parallelStableSort(data, byKey);
+    CHECK(data == expected);
+}
+
+void testSubmit() {
+    std::atomic<int> done{0};
+    for (int i = 0; i < 100; ++i) {
+        TaskScheduler::instance().submit([&done]() { ++done; });
+    }
+    for (int spin = 0; spin < 10000 && done.load() < 100; ++spin) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(done.load() == 100);
+}
+
+} // namespace
+
+int main() {
+    CHECK(TaskScheduler::instance().threadCount() >= 1);
+    testParallelFor();
+    testNested();
+    testExceptions();
+    testStableSort();
+    testSubmit();
+    return Test::result();
+}
@@ -0,0 +1,77 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "types.h"
+
+namespace Temporium {
+namespace Test {
+
+// Число проваленных проверок теста
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline void fail(const char* file, int line, const char* condition) {
+    std::fprintf(stderr, "%s:%d: проверка не прошла: %s\n", file, line, condition);
+    ++failures();
+}
+
+// Код возврата main: 0 — все проверки прошли
+inline int result() {
+    if (failures() != 0) {
+        std::fprintf(stderr, "проваленных проверок: %d\n", failures());
+        return 1;
+    }
+    return 0;
+}
+
+// Случайная коллекция с повторяющимися значениями: равные требования
+// и общие теги нужны, чтобы проверить границы сравнений и корзины
+inline std::vector<Game> randomGames(size_t count, uint32_t seed) {
+    static const char* const genres[] = {"RPG", "Strategy", "Shooter", "Puzzle", "Racing", "Simulation"};
+    static const char* const tags[] = {"coop", "indie", "open world", "pixel art", "story", "roguelike",
+                                       "multiplayer", "horror", "sandbox", "retro"};
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<Game> games(count);
+    for (size_t i = 0; i < count; ++i) {
+        Game& game = games[i];
+        game.id = static_cast<int>(i + 1);
+        game.user_id = 1;
+        game.name = "Game " + std::to_string(random() % (count / 2 + 1));
+        game.genre = genres[random() % (sizeof(genres) / sizeof(genres[0]))];
+        // Половина значений — дробные (шаг 0.5), остальные целые
+        game.disk_space = (random() % 200) / (percent(random) < 50 ? 2.0 : 1.0);
+        game.ram_usage = (random() % 64) / (percent(random) < 50 ? 2.0 : 1.0);
+        game.vram_required = (random() % 24) / (percent(random) < 50 ? 2.0 : 1.0);
+        game.completed = percent(random) < 40;
+        game.is_favorite = percent(random) < 20;
+        game.is_installed = percent(random) < 30;
+        game.rating = percent(random) < 25 ? -1 : static_cast<int>(random() % 11);
+        if (percent(random) < 50) game.url = "https://store.example/" + std::to_string(i);
+        if (percent(random) < 30) game.notes = "заметка " + std::to_string(i % 7);
+        size_t tagCount = random() % 4;
+        for (size_t t = 0; t < tagCount; ++t) {
+            if (t > 0) game.tags += ", ";
+            game.tags += tags[random() % (sizeof(tags) / sizeof(tags[0]))];
+        }
+    }
+    return games;
+}
+
+}
+}
+
+// В отличие от assert работает и в Release-сборке; после провала
+// тест продолжается, чтобы показать все расхождения сразу
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) ::Temporium::Test::fail(__FILE__, __LINE__, #condition); \
+    } while (false)
+
+#endif
@@ -0,0 +1,673 @@
+// Нагрузочный тест: N пользователей одновременно работают с базой так же,
+// как приложение, — вход, загрузка коллекции, фильтры, правки, заметки,
+// статистика, экспорт и импорт. Нужен для оценки PostgreSQL (или
+// temporium-server) и поиска конкуренции перед развёртыванием.
+//
+//     ./run.sh loadgen [--users 50] [--duration 60] [--think-ms 3000]
+//                      [--ramp 0] [--games 500] [--session-ops 30]
+//                      [--mix load=10,filter=30,...] [--interval 5]
+//                      [--server unix:/tmp/temporium.sock] [--seed 1]
+//
+// Модель открытая: у каждого пользователя моменты операций заранее
+// разыгрываются с экспоненциальными паузами (--think-ms — среднее) и не
+// зависят от того, как быстро отвечает база. Если ответ задержался,
+// следующие операции выполняются подряд, а время ответа отсчитывается
+// от запланированного момента — очередь у клиента входит в задержку,
+// как её видит пользователь. Отдельно выводится время обслуживания.
+//
+// Пользователи loadgen_0..N-1 создаются при первом запуске и получают
+// --games игр; при повторных запусках используются те же данные.
+// Каждый пользователь держит своё соединение: больше max_connections
+// PostgreSQL пользователей подключайте через --server.
+//
+// Параметры подключения — те же переменные окружения, что у приложения
+// (DB_HOST, DB_PORT, DB_NAME, DB_USER, DB_PASSWORD).
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "database_manager.h"
+#include "hash_utils.h"
+
+namespace {
+
+using namespace Temporium;
+using Clock = std::chrono::steady_clock;
+
+enum Op {
+    OP_LOGIN,
+    OP_LOAD,
+    OP_FILTER,
+    OP_EDIT,
+    OP_NOTES,
+    OP_STATS,
+    OP_EXPORT,
+    OP_IMPORT,
+    OP_COUNT
+};
+
+const char* const OP_NAMES[OP_COUNT] = {
+    "login", "load", "filter", "edit", "notes", "stats", "export", "import"
+};
+
+// Доли операций внутри сеанса по умолчанию; вход — начало каждого сеанса
+const std::array<double, OP_COUNT> DEFAULT_MIX = {0, 10, 30, 10, 10, 25, 3, 2};
+
+const char* const LOADGEN_PASSWORD = "loadgen";
+
+// Выравнивание столбца по числу символов, а не байт UTF-8 (printf считает байты)
+std::string column(const std::string& text, size_t width, bool left = false) {
+    size_t chars = std::count_if(text.begin(), text.end(), [](char c) { return (c & 0xC0) != 0x80; });
+    std::string padding(width > chars ? width - chars : 0, ' ');
+    return left ? text + padding : padding + text;
+}
+
+// Гистограмма задержек в микросекундах: до 64 мкс точно, дальше
+// 32 интервала на каждую степень двойки (погрешность около 3%)
+class LatencyHistogram {
+public:
+    LatencyHistogram() : counts_(BUCKETS, 0) {}
+
+    void record(uint64_t micros) {
+        ++counts_[bucket(micros)];
+        ++count_;
+        max_ = std::max(max_, micros);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+
+    // Середина интервала, в который попал перцентиль p (0..1)
+    uint64_t percentile(double p) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * count_)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(middle(i), max_);
+            }
+        }
+        return max_;
+    }
+
+private:
+    static constexpr int EXACT_BITS = 6;
+    static constexpr int SUB_BITS = 5;
+    static constexpr int MAX_BAND = 35;     // До 2^40 мкс — больше суток
+    static constexpr size_t BUCKETS = (1u << EXACT_BITS) + MAX_BAND * (1u << SUB_BITS);
+
+    static size_t bucket(uint64_t micros) {
+        if (micros < (1u << EXACT_BITS)) {
+            return static_cast<size_t>(micros);
+        }
+        int band = std::min(63 - __builtin_clzll(micros) - SUB_BITS, MAX_BAND);
+        uint64_t sub = std::min<uint64_t>((micros >> band) - (1u << SUB_BITS), (1u << SUB_BITS) - 1);
+        return (1u << EXACT_BITS) + (band - 1) * (1u << SUB_BITS) + static_cast<size_t>(sub);
+    }
+
+    static uint64_t middle(size_t index) {
+        if (index < (1u << EXACT_BITS)) {
+            return index;
+        }
+        size_t offset = index - (1u << EXACT_BITS);
+        int band = static_cast<int>(offset >> SUB_BITS) + 1;
+        uint64_t sub = (offset & ((1u << SUB_BITS) - 1)) + (1u << SUB_BITS);
+        return (sub << band) + (uint64_t(1) << band) / 2;
+    }
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+};
+
+// Итоги по операциям за весь прогон и за текущий интервал отчёта
+class Recorder {
+public:
+    struct Interval {
+        std::array<uint64_t, OP_COUNT> counts{};
+        uint64_t errors = 0;
+        LatencyHistogram response;
+    };
+
+    void record(Op op, uint64_t response, uint64_t service, bool ok) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Totals& totals = totals_[op];
+        totals.response.record(response);
+        totals.service.record(service);
+        ++interval_.counts[op];
+        interval_.response.record(response);
+        if (!ok) {
+            ++totals.errors;
+            ++interval_.errors;
+        }
+    }
+
+    Interval takeInterval() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Interval interval = interval_;
+        interval_ = Interval();
+        return interval;
+    }
+
+    void addMissed(uint64_t missed) { missed_ += missed; }
+
+    void report(double seconds) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::printf("\n%s %s %s %s %s %s %s %s %s\n",
+                    column("операция", 8, true).c_str(), column("всего", 8).c_str(), column("ошибок", 7).c_str(),
+                    column("оп/с", 8).c_str(), column("p50,мс", 9).c_str(), column("p99,мс", 9).c_str(),
+                    column("p999,мс", 9).c_str(), column("макс,мс", 9).c_str(), column("p99 обсл.", 11).c_str());
+        LatencyHistogram all;
+        uint64_t errors = 0;
+        for (int op = 0; op < OP_COUNT; ++op) {
+            const Totals& totals = totals_[op];
+            all.merge(totals.response);
+            errors += totals.errors;
+            printRow(OP_NAMES[op], totals.response, totals.errors, seconds, &totals.service);
+        }
+        printRow("всего", all, errors, seconds, nullptr);
+        if (missed_ > 0) {
+            std::printf("Не начаты к концу прогона (клиенты не успевали): %llu\n",
+                        static_cast<unsigned long long>(missed_.load()));
+        }
+    }
+
+private:
+    struct Totals {
+        LatencyHistogram response;      // От запланированного момента
+        LatencyHistogram service;       // От фактического начала
+        uint64_t errors = 0;
+    };
+
+    static void printRow(const char* name, const LatencyHistogram& response, uint64_t errors,
+                         double seconds, const LatencyHistogram* service) {
+        if (response.count() == 0) {
+            return;
+        }
+        std::printf("%s %8llu %7llu %8.1f %9.1f %9.1f %9.1f %9.1f",
+                    column(name, 8, true).c_str(), static_cast<unsigned long long>(response.count()),
+                    static_cast<unsigned long long>(errors), response.count() / seconds,
+                    response.percentile(0.50) / 1000.0, response.percentile(0.99) / 1000.0,
+                    response.percentile(0.999) / 1000.0, response.max() / 1000.0);
+        if (service) {
+            std::printf(" %11.1f", service->percentile(0.99) / 1000.0);
+        }
+        std::printf("\n");
+    }
+
+    mutable std::mutex mutex_;
+    std::array<Totals, OP_COUNT> totals_;
+    Interval interval_;
+    std::atomic<uint64_t> missed_{0};
+};
+
+struct Options {
+    int users = 50;
+    double duration = 60;
+    double think_ms = 3000;
+    double ramp = 0;                // Пользователи начинают равномерно за ramp секунд
+    int games = 500;
+    double session_ops = 30;        // Среднее число операций между входами
+    double interval = 5;
+    std::array<double, OP_COUNT> mix = DEFAULT_MIX;
+    std::string server;
+    unsigned int seed = 1;
+    std::string host, dbname, user, password;
+    int port = 5432;
+};
+
+// Запуск всех пользователей одновременно после подготовки данных
+class StartGate {
+public:
+    explicit StartGate(int users) : waiting_(users) {}
+
+    void arrive() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --waiting_;
+        changed_.notify_all();
+    }
+
+    void waitReady() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() { return waiting_ == 0; });
+    }
+
+    void open(Clock::time_point start) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        start_ = start;
+        opened_ = true;
+        changed_.notify_all();
+    }
+
+    Clock::time_point waitOpen() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this]() { return opened_; });
+        return start_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    int waiting_;
+    bool opened_ = false;
+    Clock::time_point start_;
+};
+
+class VirtualUser {
+public:
+    VirtualUser(int index, const Options& options, Recorder& recorder)
+        : index_(index)
+        , options_(options)
+        , recorder_(recorder)
+        , random_(options.seed * 1000003u + static_cast<unsigned int>(index))
+        , username_("loadgen_" + std::to_string(index))
+        , passwordHash_(HashUtils::hashPassword(LOADGEN_PASSWORD, username_))
+        , exportPath_((std::filesystem::temp_directory_path() /
+                       ("temporium-loadgen-" + std::to_string(getpid()) + "-" + std::to_string(index) + ".bin"))
+                          .string())
+        , mix_(options.mix.begin(), options.mix.end())
+    {}
+
+    ~VirtualUser() {
+        std::error_code ignored;
+        std::filesystem::remove(exportPath_, ignored);
+    }
+
+    // Подключение, создание пользователя и его коллекции при первом запуске
+    bool prepare(std::string& error) {
+        bool connected = options_.server.empty()
+            ? db_.connect(options_.host, options_.port, options_.dbname, options_.user, options_.password)
+            : db_.connectRemote(options_.server);
+        if (!connected) {
+            error = db_.getLastError();
+            return false;
+        }
+        if (!db_.userExists(username_) && !db_.registerUser(username_, passwordHash_)) {
+            error = db_.getLastError();
+            return false;
+        }
+        if (!login()) {
+            error = "Вход " + username_ + ": " + db_.getLastError();
+            return false;
+        }
+
+        int existing = db_.getUserGamesCount(userId_);
+        if (existing < options_.games) {
+            std::vector<Game> games;
+            for (int i = existing; i < options_.games; ++i) {
+                games.push_back(makeGame(i));
+            }
+            if (!db_.importGames(games, userId_)) {
+                error = db_.getLastError();
+                return false;
+            }
+        }
+        // Файл для операции импорта
+        if (!db_.exportToBinaryFile(exportPath_, userId_)) {
+            error = db_.getLastError();
+            return false;
+        }
+        games_ = db_.getAllGames(userId_);
+        return true;
+    }
+
+    void run(Clock::time_point start, Clock::time_point deadline) {
+        std::exponential_distribution<double> think(1000.0 / std::max(options_.think_ms, 1.0));
+        std::bernoulli_distribution sessionEnd(1.0 / std::max(options_.session_ops, 1.0));
+        std::uniform_real_distribution<double> offset(0, std::max(options_.ramp, 0.0));
+
+        Clock::time_point intended = start + seconds(offset(random_));
+        Clock::time_point finished = start;
+        bool newSession = true;
+        while (intended < deadline) {
+            std::this_thread::sleep_until(intended);
+            if (Clock::now() >= deadline) {
+                break;
+            }
+
+            if (newSession) {
+                // Начало смены: вход и загрузка коллекции для главного окна
+                timed(OP_LOGIN, intended, [this]() { return login(); });
+                timed(OP_LOAD, Clock::now(), [this]() { return load(); });
+                newSession = false;
+            } else {
+                Op op = static_cast<Op>(mix_(random_));
+                timed(op, intended, [this, op]() { return perform(op); });
+                newSession = sessionEnd(random_);
+            }
+            finished = Clock::now();
+            intended += seconds(think(random_));
+        }
+
+        // Операции, которые к концу прогона уже должны были начаться, но
+        // ждали предыдущих, — признак перегрузки
+        uint64_t missed = 0;
+        for (; intended < std::min(deadline, finished); intended += seconds(think(random_))) {
+            ++missed;
+        }
+        recorder_.addMissed(missed);
+    }
+
+private:
+    static Clock::duration seconds(double value) {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(value));
+    }
+
+    template <typename Fn>
+    void timed(Op op, Clock::time_point intended, Fn&& fn) {
+        Clock::time_point started = Clock::now();
+        bool ok = fn();
+        Clock::time_point finished = Clock::now();
+        auto micros = [](Clock::duration d) {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+        };
+        recorder_.record(op, micros(finished - std::min(intended, started)), micros(finished - started), ok);
+    }
+
+    bool login() {
+        db_.clearLastError();
+        User user = db_.authenticateUser(username_, passwordHash_);
+        userId_ = user.id;
+        return user.id > 0;
+    }
+
+    bool load() {
+        db_.clearLastError();
+        games_ = db_.getAllGames(userId_);
+        return db_.getLastError().empty();
+    }
+
+    bool perform(Op op) {
+        db_.clearLastError();
+        switch (op) {
+            case OP_LOGIN:
+                return login();
+            case OP_LOAD:
+                return load();
+            case OP_FILTER: {
+                std::vector<Game> found = db_.getFilteredGames(userId_, makeFilter());
+                return db_.getLastError().empty();
+            }
+            case OP_EDIT: {
+                if (games_.empty()) return load();
+                Game game = games_[pick(games_.size())];
+                game.rating = static_cast<int>(pick(11));
+                game.is_favorite = pick(4) == 0;
+                return db_.updateGame(game);
+            }
+            case OP_NOTES: {
+                if (games_.empty()) return load();
+                const Game& game = games_[pick(games_.size())];
+                return db_.updateGameNotes(game.id, userId_, "loadgen " + std::to_string(++notes_));
+            }
+            case OP_STATS: {
+                db_.getGameStats(userId_);
+                db_.getUserTagCounts(userId_);
+                return db_.getLastError().empty();
+            }
+            case OP_EXPORT:
+                return db_.exportToBinaryFile(exportPath_, userId_);
+            case OP_IMPORT:
+                // Названия уже есть в коллекции — строки пропускаются по
+                // UNIQUE(name, user_id), данные между прогонами не растут
+                return db_.importFromBinaryFile(exportPath_, userId_);
+            case OP_COUNT:
+                break;
+        }
+        return false;
+    }
+
+    size_t pick(size_t count) {
+        return std::uniform_int_distribution<size_t>(0, count - 1)(random_);
+    }
+
+    Game makeGame(int number) {
+        static const char* const TAGS[] = {"Co-op", "Indie", "Roguelike", "Open World", "Story", "Multiplayer"};
+        Game game;
+        game.name = "Loadgen Game " + std::to_string(number);
+        game.genre = GENRES[pick(GENRES.size())];
+        game.disk_space = static_cast<double>(1 + pick(150));
+        game.ram_usage = static_cast<double>(2 + pick(31));
+        game.vram_required = static_cast<double>(1 + pick(16));
+        game.completed = pick(3) == 0;
+        game.url = "https://store.example/app/" + std::to_string(index_ * 100000 + number);
+        game.tags = std::string(TAGS[pick(6)]) + "," + TAGS[pick(6)];
+        game.user_id = userId_;
+        return game;
+    }
+
+    // Типичные фильтры панели: жанр, пройденные, избранное, оценка, размер
+    GameFilter makeFilter() {
+        GameFilter filter;
+        switch (pick(5)) {
+            case 0:
+                filter.filter_genre = true;
+                filter.genre_value = GENRES[pick(GENRES.size())];
+                break;
+            case 1:
+                filter.filter_completed = true;
+                filter.completed_value = pick(2) == 0;
+                break;
+            case 2:
+                filter.filter_favorite = true;
+                filter.favorite_value = true;
+                break;
+            case 3:
+                filter.filter_rating_min = true;
+                filter.rating_min = static_cast<int>(pick(10));
+                break;
+            default:
+                filter.filter_disk_space_max = true;
+                filter.disk_space_max = static_cast<double>(10 + pick(100));
+                filter.filter_ram_max = true;
+                filter.ram_max = static_cast<double>(8 + pick(24));
+                break;
+        }
+        return filter;
+    }
+
+    int index_;
+    const Options& options_;
+    Recorder& recorder_;
+    std::mt19937_64 random_;
+    std::string username_;
+    std::string passwordHash_;
+    std::string exportPath_;
+    std::discrete_distribution<int> mix_;
+
+    DatabaseManager db_;
+    int userId_ = 0;
+    std::vector<Game> games_;
+    uint64_t notes_ = 0;
+};
+
+std::string env(const char* name, const char* fallback) {
+    const char* value = std::getenv(name);
+    return value && *value ? value : fallback;
+}
+
+bool parseMix(const std::string& text, std::array<double, OP_COUNT>& mix) {
+    std::array<double, OP_COUNT> parsed{};
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t equals = item.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        std::string name = item.substr(0, equals);
+        auto found = std::find_if(std::begin(OP_NAMES), std::end(OP_NAMES),
+                                  [&](const char* op) { return name == op; });
+        if (found == std::end(OP_NAMES)) {
+            return false;
+        }
+        parsed[found - std::begin(OP_NAMES)] = std::max(0.0, std::atof(item.c_str() + equals + 1));
+    }
+    if (std::all_of(parsed.begin(), parsed.end(), [](double weight) { return weight == 0; })) {
+        return false;
+    }
+    mix = parsed;
+    return true;
+}
+
+void usage(const char* program) {
+    std::fprintf(stderr,
+                 "Использование: %s [параметры]\n"
+                 "  --users N        одновременных пользователей (50)\n"
+                 "  --duration С     длительность замера, секунд (60)\n"
+                 "  --think-ms МС    средняя пауза между операциями пользователя (3000)\n"
+                 "  --ramp С         пользователи начинают равномерно за С секунд (0 — все сразу)\n"
+                 "  --games N        игр у каждого пользователя (500)\n"
+                 "  --session-ops N  среднее число операций между повторными входами (30)\n"
+                 "  --mix СПИСОК     доли операций, например load=10,filter=30,edit=10,notes=10,\n"
+                 "                   stats=25,export=3,import=2 (также login)\n"
+                 "  --interval С     период строки пропускной способности (5)\n"
+                 "  --server АДРЕС   через temporium-server вместо прямого подключения\n"
+                 "  --seed N         зерно генератора (1)\n",
+                 program);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    options.host = env("DB_HOST", "localhost");
+    options.port = std::atoi(env("DB_PORT", "5432").c_str());
+    options.dbname = env("DB_NAME", "gamedb");
+    options.user = env("DB_USER", "postgres");
+    options.password = env("DB_PASSWORD", "postgres");
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--users") == 0 && hasValue) {
+            options.users = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--duration") == 0 && hasValue) {
+            options.duration = std::max(1.0, std::atof(argv[++i]));
+        } else if (std::strcmp(arg, "--think-ms") == 0 && hasValue) {
+            options.think_ms = std::max(1.0, std::atof(argv[++i]));
+        } else if (std::strcmp(arg, "--ramp") == 0 && hasValue) {
+            options.ramp = std::max(0.0, std::atof(argv[++i]));
+        } else if (std::strcmp(arg, "--games") == 0 && hasValue) {
+            options.games = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--session-ops") == 0 && hasValue) {
+            options.session_ops = std::max(1.0, std::atof(argv[++i]));
+        } else if (std::strcmp(arg, "--mix") == 0 && hasValue) {
+            if (!parseMix(argv[++i], options.mix)) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--interval") == 0 && hasValue) {
+            options.interval = std::max(0.1, std::atof(argv[++i]));
+        } else if (std::strcmp(arg, "--server") == 0 && hasValue) {
+            options.server = argv[++i];
+        } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            options.seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::printf("temporium-loadgen: %d пользователей, %.0f с, пауза %.0f мс, %s\n",
+                options.users, options.duration, options.think_ms,
+                options.server.empty() ? "PostgreSQL напрямую" : options.server.c_str());
+    std::printf("Подготовка данных...\n");
+    std::fflush(stdout);
+
+    Recorder recorder;
+    StartGate gate(options.users);
+    std::vector<std::unique_ptr<VirtualUser>> users;
+    std::atomic<int> failed{0};
+    std::mutex errorMutex;
+    std::string firstError;
+    Clock::time_point deadline;
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.users; ++i) {
+        users.push_back(std::make_unique<VirtualUser>(i, options, recorder));
+    }
+    for (int i = 0; i < options.users; ++i) {
+        threads.emplace_back([&, i]() {
+            std::string error;
+            bool ready = users[i]->prepare(error);
+            if (!ready) {
+                ++failed;
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (firstError.empty()) firstError = error;
+            }
+            gate.arrive();
+            Clock::time_point start = gate.waitOpen();
+            if (ready && failed.load() == 0) {
+                users[i]->run(start, deadline);
+            }
+        });
+    }
+
+    gate.waitReady();
+    Clock::time_point start = Clock::now();
+    deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+    gate.open(start);
+
+    if (failed.load() == 0) {
+        std::printf("\n%s %s", column("t,с", 7).c_str(), column("оп/с", 8).c_str());
+        for (const char* name : OP_NAMES) {
+            std::printf(" %7s", name);
+        }
+        std::printf(" %s %s\n", column("ошибок", 7).c_str(), column("p99,мс", 9).c_str());
+
+        auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.interval));
+        for (Clock::time_point next = start + interval; next <= deadline + interval / 2; next += interval) {
+            Clock::time_point end = std::min(next, deadline);
+            std::this_thread::sleep_until(end);
+            Recorder::Interval snapshot = recorder.takeInterval();
+            double elapsed = std::chrono::duration<double>(end - start).count();
+            double length = std::chrono::duration<double>(end - (next - interval)).count();
+            std::printf("%7.1f %8.1f", elapsed, snapshot.response.count() / length);
+            for (uint64_t count : snapshot.counts) {
+                std::printf(" %7llu", static_cast<unsigned long long>(count));
+            }
+            std::printf(" %7llu %9.1f\n", static_cast<unsigned long long>(snapshot.errors),
+                        snapshot.response.percentile(0.99) / 1000.0);
+            std::fflush(stdout);
+        }
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (failed.load() > 0) {
+        std::fprintf(stderr, "Ошибка подготовки (%d пользователей): %s\n", failed.load(), firstError.c_str());
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    recorder.report(std::min(seconds, options.duration));
+    return 0;
+}
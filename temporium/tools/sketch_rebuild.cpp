@@ -0,0 +1,51 @@
+// Офлайн-пересчёт сводки названий игр всех пользователей
+// (count-min и HyperLogLog для панели администратора).
+//
+// Панель применяет к сводке только накопленные изменения; удалённые
+// названия остаются в оценке числа различных до полного пересчёта.
+// Запускается по расписанию, например раз в сутки:
+//
+//     ./run.sh sketch-rebuild
+//
+// Параметры подключения — те же переменные окружения, что у приложения
+// (DB_HOST, DB_PORT, DB_NAME, DB_USER, DB_PASSWORD).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "database_manager.h"
+
+namespace {
+
+std::string env(const char* name, const char* fallback) {
+    const char* value = std::getenv(name);
+    return value && *value ? value : fallback;
+}
+
+} // namespace
+
+int main() {
+    Temporium::DatabaseManager db;
+    if (!db.connect(env("DB_HOST", "localhost"), std::atoi(env("DB_PORT", "5432").c_str()),
+                    env("DB_NAME", "gamedb"), env("DB_USER", "postgres"), env("DB_PASSWORD", "postgres"))) {
+        std::fprintf(stderr, "Ошибка подключения: %s\n", db.getLastError().c_str());
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Temporium::GameNameSketch sketch;
+    if (!db.rebuildNameSketch(sketch)) {
+        std::fprintf(stderr, "Ошибка пересчёта: %s\n", db.getLastError().c_str());
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("Сводка пересчитана за %.1f с\n", seconds);
+    std::printf("Игр: %lld, различных названий: ~%.0f\n",
+                static_cast<long long>(sketch.counts().total()), sketch.distinct().estimate());
+    for (const auto& frequent : sketch.mostCommon(10)) {
+        std::printf("  %6lld  %s\n", static_cast<long long>(frequent.estimate), frequent.name.c_str());
+    }
+    return 0;
+}
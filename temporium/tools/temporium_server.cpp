@@ -0,0 +1,100 @@
+// Сервер Temporium: операции с базой для многих клиентов через общий пул
+// соединений с PostgreSQL и общий кэш результатов.
+//
+//     ./run.sh server [--listen unix:/tmp/temporium.sock | tcp:0.0.0.0:7420]
+//                     [--pool 8] [--cache-mb 64] [--statement-timeout-ms 60000]
+//
+// Клиент подключается к серверу, если задана переменная TEMPORIUM_SERVER
+// с адресом сервера. Параметры подключения к PostgreSQL — те же переменные
+// окружения, что у приложения (DB_HOST, DB_PORT, DB_NAME, DB_USER, DB_PASSWORD).
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "rpc_server.h"
+
+namespace {
+
+Temporium::RpcServer* runningServer = nullptr;
+
+void requestStop(int) {
+    if (runningServer) {
+        runningServer->stop();
+    }
+}
+
+std::string env(const char* name, const char* fallback) {
+    const char* value = std::getenv(name);
+    return value && *value ? value : fallback;
+}
+
+void usage(const char* program) {
+    std::fprintf(stderr,
+                 "Использование: %s [--listen АДРЕС] [--pool N] [--cache-mb N] [--statement-timeout-ms N]\n"
+                 "  --listen    unix:/путь или tcp:хост:порт (по умолчанию %s)\n"
+                 "  --pool      соединений с PostgreSQL (по умолчанию %zu)\n"
+                 "  --cache-mb  размер кэша ответов (по умолчанию %zu)\n"
+                 "  --statement-timeout-ms  предел одного запроса к PostgreSQL, 0 — без предела\n"
+                 "              (по умолчанию %d)\n",
+                 program, Temporium::RPC_DEFAULT_ADDRESS, Temporium::RpcServer::DEFAULT_POOL_SIZE,
+                 Temporium::RpcServer::DEFAULT_CACHE_BYTES >> 20, Temporium::RpcServer::DEFAULT_STATEMENT_TIMEOUT_MS);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Temporium::RpcServer::Options options;
+    options.host = env("DB_HOST", "localhost");
+    options.port = std::atoi(env("DB_PORT", "5432").c_str());
+    options.dbname = env("DB_NAME", "gamedb");
+    options.user = env("DB_USER", "postgres");
+    options.password = env("DB_PASSWORD", "postgres");
+
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--listen") == 0 && hasValue) {
+            options.address = argv[++i];
+        } else if (std::strcmp(argv[i], "--pool") == 0 && hasValue) {
+            options.pool_size = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        } else if (std::strcmp(argv[i], "--cache-mb") == 0 && hasValue) {
+            options.cache_bytes = static_cast<size_t>(std::max(0, std::atoi(argv[++i]))) << 20;
+        } else if (std::strcmp(argv[i], "--statement-timeout-ms") == 0 && hasValue) {
+            options.statement_timeout_ms = std::max(0, std::atoi(argv[++i]));
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    Temporium::RpcServer server(options);
+    if (!server.start()) {
+        std::fprintf(stderr, "Ошибка запуска: %s\n", server.lastError().c_str());
+        return 1;
+    }
+
+    runningServer = &server;
+    std::signal(SIGINT, requestStop);
+    std::signal(SIGTERM, requestStop);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::printf("temporium-server: %s, соединений с PostgreSQL: %zu, кэш: %zu МБ\n",
+                options.address.c_str(), options.pool_size, options.cache_bytes >> 20);
+    std::fflush(stdout);
+
+    server.run();
+    runningServer = nullptr;
+
+    Temporium::RpcServer::Stats stats = server.stats();
+    std::printf("Остановлен. Соединений: %llu, кадров: %llu, вызовов: %llu, из кэша: %llu / %llu, "
+                "объединено: %llu\n",
+                static_cast<unsigned long long>(stats.connections),
+                static_cast<unsigned long long>(stats.frames),
+                static_cast<unsigned long long>(stats.calls),
+                static_cast<unsigned long long>(stats.cache_hits),
+                static_cast<unsigned long long>(stats.cache_hits + stats.cache_misses),
+                static_cast<unsigned long long>(stats.coalesced));
+    return 0;
+}